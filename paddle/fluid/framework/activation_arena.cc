@@ -0,0 +1,286 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/activation_arena.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace paddle {
+namespace framework {
+
+static constexpr size_t kArenaAlignment = 64;
+
+static size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+size_t PlanArenaOffsets(std::vector<ArenaBuffer> *buffers, size_t alignment) {
+  PADDLE_ENFORCE_GT(alignment, 0UL);
+  std::vector<size_t> order(buffers->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return (*buffers)[a].size > (*buffers)[b].size;
+  });
+
+  size_t arena_size = 0;
+  std::vector<const ArenaBuffer *> placed;
+  std::vector<const ArenaBuffer *> live;
+  for (size_t i : order) {
+    auto &buffer = (*buffers)[i];
+    live.clear();
+    for (auto *other : placed) {
+      if (other->first_use <= buffer.last_use &&
+          buffer.first_use <= other->last_use) {
+        live.push_back(other);
+      }
+    }
+    std::sort(live.begin(), live.end(),
+              [](const ArenaBuffer *a, const ArenaBuffer *b) {
+                return a->offset < b->offset;
+              });
+
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t top = 0;
+    for (auto *other : live) {
+      if (other->offset > top) {
+        size_t gap = other->offset - top;
+        if (gap >= buffer.size && gap < best_gap) {
+          best_offset = top;
+          best_gap = gap;
+        }
+      }
+      top = std::max(top, AlignUp(other->offset + other->size, alignment));
+    }
+    buffer.offset =
+        best_gap == std::numeric_limits<size_t>::max() ? top : best_offset;
+    arena_size = std::max(arena_size, buffer.offset + buffer.size);
+    placed.push_back(&buffer);
+  }
+  return arena_size;
+}
+
+// A slice of the arena, which keeps the arena alive while it is held by any
+// tensor.
+class ArenaSlice : public memory::Allocation {
+ public:
+  ArenaSlice(const std::shared_ptr<memory::Allocation> &arena, size_t offset,
+             size_t size)
+      : memory::Allocation(static_cast<uint8_t *>(arena->ptr()) + offset, size,
+                           arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+
+ActivationArena::ActivationArena(const BlockDesc &block,
+                                 const platform::Place &place)
+    : place_(place) {
+  for (auto *var : block.AllVars()) {
+    if (var->Persistable()) {
+      excluded_.insert(var->Name());
+    }
+  }
+  for (auto *op : block.AllOps()) {
+    if (op->Type() == "feed") {
+      for (auto &name : op->OutputArgumentNames()) excluded_.insert(name);
+    } else if (op->Type() == "fetch") {
+      for (auto &name : op->InputArgumentNames()) excluded_.insert(name);
+    }
+  }
+  excluded_.insert(kEmptyVarName);
+}
+
+void ActivationArena::Plan(
+    const std::vector<std::unique_ptr<OperatorBase>> &ops, Scope *scope) {
+  struct Lifetime {
+    int first_use;
+    int last_use;
+    bool consumed;
+  };
+  std::unordered_map<std::string, Lifetime> lifetimes;
+  std::unordered_set<std::string> skipped(excluded_);
+  for (size_t i = 0; i < ops.size(); ++i) {
+    int id = static_cast<int>(i);
+    // The sub-blocks may use the variables anywhere in their runs.
+    bool control_flow = ops[i]->HasAttr("sub_block");
+    for (auto &input : ops[i]->Inputs()) {
+      for (auto &name : input.second) {
+        auto it = lifetimes.find(name);
+        if (control_flow || it == lifetimes.end()) {
+          // read before written, it is fed to the block
+          skipped.insert(name);
+          continue;
+        }
+        it->second.last_use = id;
+        it->second.consumed = true;
+      }
+    }
+    for (auto &output : ops[i]->Outputs()) {
+      for (auto &name : output.second) {
+        if (control_flow) {
+          skipped.insert(name);
+          continue;
+        }
+        auto it = lifetimes.find(name);
+        if (it == lifetimes.end()) {
+          lifetimes.emplace(name, Lifetime{id, id, false});
+        } else {
+          it->second.last_use = id;
+        }
+      }
+    }
+  }
+
+  // The tensors sharing the memory are grouped to one buffer.
+  struct Group {
+    ArenaBuffer buffer;
+    std::vector<std::string> names;
+    std::vector<LoDTensor *> tensors;
+    bool packed{true};
+  };
+  std::vector<Group> groups;
+  std::unordered_map<const memory::Allocation *, size_t> group_of_holder;
+  // The buffers keep the sizes of the former plan, so a smaller run after a
+  // larger one does not shrink them and the arena is planned again only when
+  // a tensor grows.
+  std::unordered_map<const LoDTensor *, size_t> former_sizes;
+  for (auto &binding : bindings_) {
+    former_sizes[binding.first] = binding.second->size();
+  }
+  std::unordered_set<const Variable *> packed_vars;
+  for (auto &item : lifetimes) {
+    auto &name = item.first;
+    auto &lifetime = item.second;
+    if (!lifetime.consumed || skipped.count(name)) continue;
+    auto *var = scope->FindVar(name);
+    if (var == nullptr || !var->IsType<LoDTensor>()) continue;
+    auto *tensor = var->GetMutable<LoDTensor>();
+    if (!tensor->IsInitialized() ||
+        !platform::is_same_place(tensor->place(), place_)) {
+      continue;
+    }
+    size_t size =
+        tensor->offset() + tensor->numel() * SizeOfType(tensor->type());
+    auto former = former_sizes.find(tensor);
+    if (former != former_sizes.end()) {
+      size = std::max(size, former->second);
+    }
+    auto inserted =
+        group_of_holder.emplace(tensor->Holder().get(), groups.size());
+    if (inserted.second) {
+      groups.emplace_back();
+      groups.back().buffer.first_use = lifetime.first_use;
+      groups.back().buffer.last_use = lifetime.last_use;
+    }
+    auto &group = groups[inserted.first->second];
+    group.buffer.size = std::max(group.buffer.size, size);
+    group.buffer.first_use =
+        std::min(group.buffer.first_use, lifetime.first_use);
+    group.buffer.last_use = std::max(group.buffer.last_use, lifetime.last_use);
+    group.names.push_back(name);
+    group.tensors.push_back(tensor);
+    packed_vars.insert(var);
+  }
+
+  // The memory shared with a variable not packed, e.g. a parameter or a fetch
+  // target, is not packed either.
+  for (const Scope *s = scope; s != nullptr; s = s->parent()) {
+    for (auto &name : s->LocalVarNames()) {
+      auto *var = s->FindLocalVar(name);
+      if (var == nullptr || packed_vars.count(var) ||
+          !var->IsType<LoDTensor>()) {
+        continue;
+      }
+      auto it = group_of_holder.find(var->Get<LoDTensor>().Holder().get());
+      if (it != group_of_holder.end()) {
+        groups[it->second].packed = false;
+      }
+    }
+  }
+
+  std::vector<ArenaBuffer> buffers;
+  std::vector<Group *> packed_groups;
+  for (auto &group : groups) {
+    if (group.packed && group.buffer.size > 0) {
+      buffers.push_back(group.buffer);
+      packed_groups.push_back(&group);
+    }
+  }
+  arena_size_ = PlanArenaOffsets(&buffers, kArenaAlignment);
+  tensors_size_ = 0;
+  for (auto &buffer : buffers) {
+    tensors_size_ += buffer.size;
+  }
+
+  auto former_bindings = std::move(bindings_);
+  bindings_.clear();
+  binding_names_.clear();
+  arena_ = memory::AllocShared(place_, std::max(arena_size_, kArenaAlignment));
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    std::shared_ptr<memory::Allocation> slice = std::make_shared<ArenaSlice>(
+        arena_, buffers[i].offset, buffers[i].size);
+    for (size_t j = 0; j < packed_groups[i]->tensors.size(); ++j) {
+      bindings_.emplace_back(packed_groups[i]->tensors[j], slice);
+      binding_names_.push_back(packed_groups[i]->names[j]);
+    }
+  }
+  // Releases the former arena.
+  for (auto &binding : former_bindings) {
+    if (binding.first->Holder() == binding.second) {
+      binding.first->clear();
+    }
+  }
+  Bind();
+  planned_ = true;
+
+  LOG(INFO) << "The activation arena packs " << bindings_.size()
+            << " tensors of " << tensors_size_ << " bytes into "
+            << arena_size_ << " bytes";
+}
+
+void ActivationArena::Bind() const {
+  for (auto &binding : bindings_) {
+    if (binding.first->Holder() != binding.second) {
+      binding.first->clear();
+      binding.first->ResetHolder(binding.second);
+    }
+  }
+}
+
+bool ActivationArena::NeedPlan() {
+  if (!planned_) return true;
+  bool need_plan = false;
+  for (size_t i = 0; i < bindings_.size(); ++i) {
+    auto *tensor = bindings_[i].first;
+    auto &slice = bindings_[i].second;
+    if (tensor->Holder() == slice) continue;
+    need_plan = true;
+    if (tensor->IsInitialized() &&
+        tensor->offset() + tensor->numel() * SizeOfType(tensor->type()) <=
+            slice->size()) {
+      // It fits in the slice but uses another buffer.
+      VLOG(3) << "Tensor " << binding_names_[i]
+              << " leaves the activation arena";
+      excluded_.insert(binding_names_[i]);
+    }
+  }
+  return need_plan;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,100 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/framework/block_desc.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/memory/malloc.h"
+
+namespace paddle {
+namespace framework {
+
+// A buffer of an arena, used from the first to the last op of its lifetime.
+struct ArenaBuffer {
+  size_t size{0};
+  int first_use{0};
+  int last_use{0};
+  // Planned by PlanArenaOffsets.
+  size_t offset{0};
+};
+
+// Plans the offsets of the buffers in one arena, the buffers whose lifetimes
+// overlap never overlap in the arena. The buffers are placed from the largest
+// one, each in the smallest gap that fits it between the placed buffers of an
+// overlapping lifetime, or above them if there is no such gap. The offsets are
+// multiples of the alignment. Returns the size of the arena.
+size_t PlanArenaOffsets(std::vector<ArenaBuffer> *buffers, size_t alignment);
+
+// Packs the non-persistable LoDTensor activations of the ops of a block into
+// one arena for the NaiveExecutor.
+//
+// The lifetimes come from the order of the ops, the sizes from the tensors
+// after a reference run, which should have the largest input expected. The
+// tensors sharing their memory, like the outputs of the in-place reshape, are
+// placed as one buffer. After the planning every tensor is bound to its slice
+// of the arena before a run, so its ops reuse the slice instead of allocating.
+//
+// The inputs fed to the block, the fetched and the unused outputs, and the
+// variables of the control flow ops are not packed. A tensor needing more
+// memory than planned leaves its slice and the arena is planned again after
+// the run; a tensor leaving its slice for another buffer is not packed any
+// more. The slices never shrink when planned again.
+class ActivationArena {
+ public:
+  ActivationArena(const BlockDesc &block, const platform::Place &place);
+
+  bool planned() const { return planned_; }
+
+  // Plans the arena after a run of the ops on the scope and binds the tensors
+  // to their slices.
+  void Plan(const std::vector<std::unique_ptr<OperatorBase>> &ops,
+            Scope *scope);
+
+  // Binds the tensors to their slices before a run, without allocating.
+  void Bind() const;
+
+  // Whether the arena should be planned, after a run.
+  bool NeedPlan();
+
+  // The size of the arena in bytes.
+  size_t arena_size() const { return arena_size_; }
+  // The sum of the sizes of the buffers packed, the memory the tensors take
+  // without the arena.
+  size_t tensors_size() const { return tensors_size_; }
+  size_t num_tensors() const { return bindings_.size(); }
+
+ private:
+  platform::Place place_;
+  // The variables never packed: persistable, fed and fetched ones.
+  std::unordered_set<std::string> excluded_;
+
+  bool planned_{false};
+  size_t arena_size_{0};
+  std::shared_ptr<memory::Allocation> arena_;
+  std::vector<std::pair<LoDTensor *, std::shared_ptr<memory::Allocation>>>
+      bindings_;
+  std::vector<std::string> binding_names_;
+  size_t tensors_size_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,142 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the NaiveExecutor with and without the activation arena on a
+// MLP of mul, elementwise_add and relu ops. It reports the memory of the
+// activations and the latency per run.
+//
+//   ./activation_arena_benchmark --layers=32 --width=512 --batch_size=16
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/platform/init.h"
+
+DEFINE_int32(layers, 32, "The number of the fc layers.");
+DEFINE_int32(width, 512, "The width of the fc layers.");
+DEFINE_int32(batch_size, 16, "The batch size of the input.");
+DEFINE_int32(runs, 200, "The number of the runs.");
+
+USE_OP(mul);
+USE_OP(elementwise_add);
+USE_OP(relu);
+
+namespace paddle {
+namespace framework {
+
+static void AddVar(BlockDesc* block, const std::string& name,
+                   bool persistable) {
+  auto* var = block->Var(name);
+  var->SetType(proto::VarType::LOD_TENSOR);
+  var->SetPersistable(persistable);
+}
+
+static void AddOp(BlockDesc* block, const std::string& type,
+                  const VariableNameMap& inputs,
+                  const VariableNameMap& outputs) {
+  auto* op = block->AppendOp();
+  op->SetType(type);
+  for (auto& input : inputs) op->SetInput(input.first, input.second);
+  for (auto& output : outputs) op->SetOutput(output.first, output.second);
+}
+
+// h[i+1] = relu(h[i] * w[i] + b[i])
+static void BuildProgram(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  AddVar(block, "h0", false);
+  for (int i = 0; i < FLAGS_layers; ++i) {
+    std::string id = std::to_string(i);
+    std::string next = "h" + std::to_string(i + 1);
+    for (auto* name : {"w", "b"}) AddVar(block, name + id, true);
+    for (auto* name : {"mul", "add"}) AddVar(block, name + id, false);
+    AddVar(block, next, false);
+    AddOp(block, "mul", {{"X", {"h" + id}}, {"Y", {"w" + id}}},
+          {{"Out", {"mul" + id}}});
+    AddOp(block, "elementwise_add", {{"X", {"mul" + id}}, {"Y", {"b" + id}}},
+          {{"Out", {"add" + id}}});
+    AddOp(block, "relu", {{"X", {"add" + id}}}, {{"Out", {next}}});
+  }
+}
+
+static void RandomFill(LoDTensor* tensor, const DDim& dims) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-0.1f, 0.1f);
+  float* data = tensor->mutable_data<float>(dims, platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+static double MsPerRun(bool arena) {
+  ProgramDesc program;
+  BuildProgram(&program);
+  platform::CPUPlace place;
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, true, &scope);
+  for (int i = 0; i < FLAGS_layers; ++i) {
+    std::string id = std::to_string(i);
+    RandomFill(scope.Var("w" + id)->GetMutable<LoDTensor>(),
+               make_ddim({FLAGS_width, FLAGS_width}));
+    RandomFill(scope.Var("b" + id)->GetMutable<LoDTensor>(),
+               make_ddim({FLAGS_width}));
+  }
+  auto& sub_scope = scope.NewScope();
+  exe.CreateVariables(program, 0, false, &sub_scope);
+  exe.Prepare(&sub_scope, program, 0, false);
+  if (arena) {
+    exe.EnableActivationArena(program, 0);
+  }
+  RandomFill(exe.FindTensor("h0"), make_ddim({FLAGS_batch_size, FLAGS_width}));
+
+  exe.Run();
+  if (arena) {
+    auto* activation_arena = exe.activation_arena();
+    LOG(INFO) << activation_arena->num_tensors() << " activations of "
+              << activation_arena->tensors_size() << " bytes packed into "
+              << activation_arena->arena_size() << " bytes";
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < FLAGS_runs; ++r) {
+    exe.Run();
+  }
+  std::chrono::duration<double, std::milli> ms =
+      std::chrono::steady_clock::now() - start;
+  return ms.count() / FLAGS_runs;
+}
+
+void Run() {
+  InitDevices(false);
+  double former_ms = MsPerRun(false);
+  double arena_ms = MsPerRun(true);
+  LOG(INFO) << FLAGS_layers << " layers of " << FLAGS_width << " x "
+            << FLAGS_batch_size << ", per run: separate tensors " << former_ms
+            << " ms, activation arena " << arena_ms << " ms (gain "
+            << former_ms - arena_ms << " ms)";
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Run();
+  return 0;
+}
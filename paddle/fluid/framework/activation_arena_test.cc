@@ -0,0 +1,180 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/activation_arena.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(PlanArenaOffsets, chain) {
+  // Every buffer is live with its neighbours only, two slots are enough.
+  std::vector<ArenaBuffer> buffers(5);
+  for (int i = 0; i < 5; ++i) {
+    buffers[i].size = 100;
+    buffers[i].first_use = i;
+    buffers[i].last_use = i + 1;
+  }
+  EXPECT_EQ(PlanArenaOffsets(&buffers, 64), 228UL);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(buffers[i].offset, i % 2 == 0 ? 0UL : 128UL);
+  }
+}
+
+TEST(PlanArenaOffsets, best_fit) {
+  // size, first use, last use
+  std::vector<std::vector<int>> specs = {{1024, 0, 3}, {512, 0, 0},
+                                         {256, 0, 3},  {128, 0, 0},
+                                         {64, 0, 3},   {60, 2, 3}};
+  std::vector<ArenaBuffer> buffers(specs.size());
+  for (size_t i = 0; i < specs.size(); ++i) {
+    buffers[i].size = specs[i][0];
+    buffers[i].first_use = specs[i][1];
+    buffers[i].last_use = specs[i][2];
+  }
+  EXPECT_EQ(PlanArenaOffsets(&buffers, 64), 1984UL);
+  std::vector<size_t> offsets = {0, 1024, 1536, 1792, 1920};
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    EXPECT_EQ(buffers[i].offset, offsets[i]);
+  }
+  // The memory of 1 and 3 is free after the first op, the last buffer takes
+  // the smaller gap of 3.
+  EXPECT_EQ(buffers[5].offset, 1792UL);
+}
+
+TEST(PlanArenaOffsets, random) {
+  std::mt19937 rng(100);
+  std::uniform_int_distribution<int> size_dist(1, 1 << 16);
+  std::uniform_int_distribution<int> use_dist(0, 100);
+  std::uniform_int_distribution<int> length_dist(0, 10);
+  std::vector<ArenaBuffer> buffers(300);
+  size_t total = 0;
+  for (auto& buffer : buffers) {
+    buffer.size = size_dist(rng);
+    buffer.first_use = use_dist(rng);
+    buffer.last_use = buffer.first_use + length_dist(rng);
+    total += (buffer.size + 63) / 64 * 64;
+  }
+  size_t arena_size = PlanArenaOffsets(&buffers, 64);
+  EXPECT_LE(arena_size, total);
+
+  size_t max_live = 0;
+  for (int use = 0; use <= 110; ++use) {
+    size_t live = 0;
+    for (auto& buffer : buffers) {
+      if (buffer.first_use <= use && use <= buffer.last_use) {
+        live += buffer.size;
+      }
+    }
+    max_live = std::max(max_live, live);
+  }
+  EXPECT_GE(arena_size, max_live);
+
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    auto& a = buffers[i];
+    EXPECT_EQ(a.offset % 64, 0UL);
+    EXPECT_LE(a.offset + a.size, arena_size);
+    for (size_t j = i + 1; j < buffers.size(); ++j) {
+      auto& b = buffers[j];
+      if (a.first_use > b.last_use || b.first_use > a.last_use) continue;
+      EXPECT_TRUE(a.offset + a.size <= b.offset ||
+                  b.offset + b.size <= a.offset)
+          << i << " and " << j << " overlap";
+    }
+  }
+}
+
+// out = t7 + a, t[i] = t[i-1] + a, t0 = a + a
+static void BuildChain(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  std::vector<std::string> names = {"a"};
+  for (int i = 0; i < 8; ++i) {
+    names.push_back("t" + std::to_string(i));
+  }
+  names.push_back("out");
+  for (auto& name : names) {
+    block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  for (size_t i = 1; i < names.size(); ++i) {
+    auto* add = block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {i == 1 ? "a" : names[i - 1]});
+    add->SetInput("Y", {"a"});
+    add->SetOutput("Out", {names[i]});
+  }
+}
+
+static void RunChain(NaiveExecutor* exe, int64_t numel) {
+  platform::CPUPlace place;
+  float* a = exe->FindTensor("a")->mutable_data<float>(
+      make_ddim({1, numel}), place);
+  for (int64_t i = 0; i < numel; ++i) {
+    a[i] = static_cast<float>(i);
+  }
+  exe->Run();
+  auto* out = exe->FindTensor("out");
+  ASSERT_EQ(out->numel(), numel);
+  for (int64_t i = 0; i < numel; ++i) {
+    ASSERT_NEAR(out->data<float>()[i], 10.f * i, 1e-3);
+  }
+}
+
+TEST(ActivationArena, naive_executor) {
+  ProgramDesc program;
+  BuildChain(&program);
+  platform::CPUPlace place;
+  NaiveExecutor exe(place);
+  exe.Prepare(nullptr, program, 0, false);
+  exe.CreateVariables(program, 0, false, exe.scope());
+  exe.EnableActivationArena(program, 0);
+
+  RunChain(&exe, 1000);
+  auto* arena = exe.activation_arena();
+  ASSERT_TRUE(arena->planned());
+  // the fed a and the output out are not packed
+  EXPECT_EQ(arena->num_tensors(), 8UL);
+  EXPECT_EQ(arena->tensors_size(), 8 * 4000UL);
+  EXPECT_EQ(arena->arena_size(), 4032UL + 4000UL);
+
+  // The later runs reuse the slices.
+  RunChain(&exe, 1000);
+  std::vector<const void*> holders;
+  for (int i = 0; i < 8; ++i) {
+    holders.push_back(exe.FindTensor("t" + std::to_string(i))->data<float>());
+  }
+  RunChain(&exe, 600);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(exe.FindTensor("t" + std::to_string(i))->data<float>(),
+              holders[i]);
+  }
+  EXPECT_EQ(arena->arena_size(), 8032UL);
+
+  // A larger input plans the arena again.
+  RunChain(&exe, 2000);
+  EXPECT_EQ(arena->arena_size(), 8000UL + 8000UL);
+  RunChain(&exe, 2000);
+  EXPECT_EQ(arena->num_tensors(), 8UL);
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+USE_OP(elementwise_add);
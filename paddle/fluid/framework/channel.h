@@ -21,29 +21,56 @@
 
 #include <glog/logging.h>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
 #include <deque>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/expect.h"
+#include "paddle/fluid/framework/mpmc_ring_buffer.h"
 
 namespace paddle {
 namespace framework {
 
+// The storage of a ChannelObject.
+// kDeque: an unbounded (or bounded) std::deque guarded by one mutex.
+// kRingBuffer: a bounded lock-free MpmcRingBuffer. Readers and writers only
+//   take the mutex to sleep when the ring is empty/full, so it scales better
+//   with many producers and consumers. The capacity must be in [1, 2^40] and
+//   is rounded up to a power of two, and it can not be changed later.
+enum class ChannelBackend { kDeque, kRingBuffer };
+
 template <class T>
 class ChannelObject {
  public:
   ChannelObject() {}
 
   // capacity can be zero
-  explicit ChannelObject(size_t capacity) {
+  explicit ChannelObject(size_t capacity,
+                         ChannelBackend backend = ChannelBackend::kDeque) {
     capacity_ = (std::min)(MaxCapacity(), capacity);
+    if (backend == ChannelBackend::kRingBuffer) {
+      ring_.reset(new MpmcRingBuffer<T>(capacity_));
+      capacity_ = ring_->Capacity();
+    }
+  }
+
+  ChannelBackend Backend() {
+    return ring_ ? ChannelBackend::kRingBuffer : ChannelBackend::kDeque;
   }
 
   void Clear() {
+    if (ring_) {
+      T val;
+      while (ring_->TryPop(1, &val) != 0) {
+      }
+      RingNotify();
+      return;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     data_.clear();
     data_.shrink_to_fit();
@@ -54,6 +81,7 @@ class ChannelObject {
   }
 
   void SetCapacity(size_t x) {  // capacity can be zero
+    CHECK(!ring_) << "can not change the capacity of a ring buffer channel";
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
     Notify();
@@ -69,6 +97,8 @@ class ChannelObject {
     block_size_ = x;
   }
 
+  // only the capacity and block size are inherited, the channel is always
+  // backed by a deque
   template <class U>
   void InheritFrom(const std::shared_ptr<ChannelObject<U>>& other) {
     std::lock_guard<std::mutex> lock(mutex_);
@@ -85,6 +115,10 @@ class ChannelObject {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = false;
     Notify();
+    if (ring_) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    }
   }
 
   // close channel, then no more data can be write() to channel
@@ -92,14 +126,24 @@ class ChannelObject {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
     Notify();
+    if (ring_) {
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    }
   }
 
   size_t Size() {
+    if (ring_) {
+      return ring_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (ring_) {
+      return ring_->Size() == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -113,6 +157,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingRead(n, p);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -132,6 +179,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWrite(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -143,6 +193,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_) {
+      return RingWriteMove(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -181,7 +234,7 @@ class ChannelObject {
  private:
   size_t capacity_ = MaxCapacity();
   size_t block_size_ = 1024;
-  bool closed_ = false;
+  std::atomic<bool> closed_{false};
   std::mutex mutex_;
   // use deque to store data
   std::deque<T> data_;
@@ -191,6 +244,14 @@ class ChannelObject {
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
 
+  // only used by the ring buffer backend
+  std::unique_ptr<MpmcRingBuffer<T>> ring_;
+  std::atomic<int> ring_writing_{0};
+  std::atomic<int> ring_empty_waiters_{0};
+  std::atomic<int> ring_full_waiters_{0};
+
+  static constexpr int kRingSpinCount = 64;
+
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
   }
@@ -206,6 +267,98 @@ class ChannelObject {
 
   bool EmptyUnlocked() { return data_.empty(); }
 
+  // Wake up the sleeping readers and writers of the ring buffer. The fence
+  // pairs with the one in RingWait: either the waiter sees the new state of
+  // the ring, or we see the waiter and notify it under the mutex.
+  void RingNotify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (ring_empty_waiters_.load(std::memory_order_relaxed) != 0 ||
+        ring_full_waiters_.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      empty_cond_.notify_all();
+      full_cond_.notify_all();
+    }
+  }
+
+  // Spin for a while and then sleep until ready() returns true.
+  template <class Ready>
+  void RingWait(std::atomic<int>* waiters, std::condition_variable* cond,
+                Ready ready) {
+    for (int i = 0; i < kRingSpinCount; ++i) {
+      if (ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    waiters->fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!ready()) {
+      cond->wait(lock);
+    }
+    waiters->fetch_sub(1);
+  }
+
+  // The channel is drained when it is closed, no writer is pushing and the
+  // ring is empty. A writer increases ring_writing_ before it checks closed_,
+  // so it either sees closed_ and gives up, or is seen by the reader here.
+  bool RingDrained() {
+    return closed_ && ring_writing_ == 0 && !ring_->Readable();
+  }
+
+  size_t RingRead(size_t n, T* p) {
+    size_t finished = 0;
+    while (finished < n) {
+      size_t m = ring_->TryPop(n - finished, p + finished);
+      if (m != 0) {
+        finished += m;
+        RingNotify();
+        continue;
+      }
+      if (RingDrained()) {
+        break;
+      }
+      RingWait(&ring_empty_waiters_, &empty_cond_,
+               [this] { return ring_->Readable() || RingDrained(); });
+    }
+    return finished;
+  }
+
+  template <class Push>
+  size_t RingWriteImpl(size_t n, Push push) {
+    size_t finished = 0;
+    while (finished < n) {
+      ring_writing_.fetch_add(1);
+      if (closed_) {
+        ring_writing_.fetch_sub(1);
+        RingNotify();
+        break;
+      }
+      size_t m = push(finished);
+      ring_writing_.fetch_sub(1);
+      if (m != 0) {
+        finished += m;
+        RingNotify();
+        continue;
+      }
+      RingWait(&ring_full_waiters_, &full_cond_,
+               [this] { return ring_->Writable() || closed_; });
+    }
+    return finished;
+  }
+
+  size_t RingWrite(size_t n, const T* p) {
+    return RingWriteImpl(n, [this, n, p](size_t finished) {
+      return ring_->TryPush(n - finished, p + finished);
+    });
+  }
+
+  size_t RingWriteMove(size_t n, T* p) {
+    return RingWriteImpl(n, [this, n, p](size_t finished) {
+      return ring_->TryPushMove(n - finished, p + finished);
+    });
+  }
+
   bool FullUnlocked() { return data_.size() >= capacity_ + reading_count_; }
 
   bool WaitForRead(std::unique_lock<std::mutex>& lock) {  // NOLINT
@@ -289,8 +442,9 @@ template <class T>
 using Channel = std::shared_ptr<ChannelObject<T>>;
 
 template <class T>
-Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
-  return std::make_shared<ChannelObject<T>>(capacity);
+Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)(),
+                       ChannelBackend backend = ChannelBackend::kDeque) {
+  return std::make_shared<ChannelObject<T>>(capacity, backend);
 }
 
 template <class T, class U>
@@ -0,0 +1,109 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Contention benchmark of ChannelObject, compares the deque backend with the
+// lock-free ring buffer backend with N producers and N consumers moving
+// values in batches through one channel.
+//
+//   ./channel_benchmark --threads=1,2,4,8,16,32,64 --batch_sizes=1,16,256
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(threads, "1,2,4,8,16,32,64",
+              "The numbers of producer (and consumer) threads.");
+DEFINE_string(batch_sizes, "1,16,256",
+              "The numbers of values per Write/Read call.");
+DEFINE_int64(values_per_thread, 1 << 20,
+             "The number of values written by each producer.");
+DEFINE_int64(capacity, 4096, "The capacity of the channel.");
+
+namespace paddle {
+namespace framework {
+
+std::vector<int> ParseIntList(const std::string& str) {
+  std::vector<int> res;
+  for (auto& s : string::Split(str, ',')) {
+    res.push_back(std::stoi(s));
+  }
+  return res;
+}
+
+// returns million values per second
+double RunOnce(ChannelBackend backend, int threads, int batch) {
+  auto chan = MakeChannel<int64_t>(FLAGS_capacity, backend);
+  int64_t per_thread = FLAGS_values_per_thread / batch * batch;
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&] {
+      std::vector<int64_t> buf(batch);
+      for (int64_t i = 0; i < per_thread; i += batch) {
+        for (int j = 0; j < batch; ++j) {
+          buf[j] = i + j;
+        }
+        chan->WriteMove(batch, buf.data());
+      }
+    });
+  }
+  std::vector<std::thread> readers;
+  for (int t = 0; t < threads; ++t) {
+    readers.emplace_back([&] {
+      std::vector<int64_t> buf(batch);
+      while (chan->Read(batch, buf.data()) != 0) {
+      }
+    });
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : readers) {
+    t.join();
+  }
+  std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+  return per_thread * threads / sec.count() / 1e6;
+}
+
+void Run() {
+  unsigned int cores = std::thread::hardware_concurrency();
+  LOG(INFO) << "hardware concurrency " << cores << ", capacity "
+            << FLAGS_capacity;
+  for (int batch : ParseIntList(FLAGS_batch_sizes)) {
+    for (int threads : ParseIntList(FLAGS_threads)) {
+      double deque = RunOnce(ChannelBackend::kDeque, threads, batch);
+      double ring = RunOnce(ChannelBackend::kRingBuffer, threads, batch);
+      LOG(INFO) << "batch " << batch << ", " << threads << " producers x "
+                << threads << " consumers: deque " << deque
+                << " M/s, ring buffer " << ring << " M/s, speedup "
+                << ring / deque;
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Run();
+  return 0;
+}
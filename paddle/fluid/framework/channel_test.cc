@@ -0,0 +1,149 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(MpmcRingBuffer, PushPop) {
+  MpmcRingBuffer<int> ring(5);
+  EXPECT_EQ(ring.Capacity(), 8UL);
+  std::vector<int> in = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  EXPECT_EQ(ring.TryPush(in.size(), in.data()), 8UL);
+  EXPECT_EQ(ring.Size(), 8UL);
+  EXPECT_FALSE(ring.Writable());
+  std::vector<int> out(10, -1);
+  EXPECT_EQ(ring.TryPop(3, out.data()), 3UL);
+  EXPECT_EQ(ring.TryPush(2, in.data() + 8), 2UL);
+  EXPECT_EQ(ring.TryPop(10, out.data() + 3), 7UL);
+  EXPECT_EQ(out, in);
+  EXPECT_FALSE(ring.Readable());
+  EXPECT_EQ(ring.TryPop(1, out.data()), 0UL);
+}
+
+TEST(MpmcRingBuffer, PushMove) {
+  MpmcRingBuffer<std::string> ring(2);
+  std::vector<std::string> in = {"a", "b"};
+  EXPECT_EQ(ring.TryPushMove(2, in.data()), 2UL);
+  EXPECT_TRUE(in[0].empty());
+  std::string out;
+  EXPECT_EQ(ring.TryPop(1, &out), 1UL);
+  EXPECT_EQ(out, "a");
+}
+
+void CheckMultiProducerConsumer(Channel<int64_t> chan, int producer_num,
+                                int consumer_num, int batch) {
+  const int64_t per_producer = 20000;
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> count{0};
+  std::vector<std::thread> producers;
+  for (int t = 0; t < producer_num; ++t) {
+    producers.emplace_back([&, t] {
+      std::vector<int64_t> buf;
+      for (int64_t i = 0; i < per_producer; ++i) {
+        buf.push_back(t * per_producer + i);
+        if (static_cast<int>(buf.size()) == batch) {
+          ASSERT_EQ(chan->WriteMove(buf.size(), buf.data()), buf.size());
+          buf.clear();
+        }
+      }
+      ASSERT_EQ(chan->Write(buf.size(), buf.data()), buf.size());
+    });
+  }
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < consumer_num; ++t) {
+    consumers.emplace_back([&] {
+      std::vector<int64_t> buf(batch);
+      size_t n = 0;
+      while ((n = chan->Read(buf.size(), buf.data())) != 0) {
+        for (size_t i = 0; i < n; ++i) {
+          sum += buf[i];
+        }
+        count += n;
+      }
+    });
+  }
+  for (auto& t : producers) {
+    t.join();
+  }
+  chan->Close();
+  for (auto& t : consumers) {
+    t.join();
+  }
+  int64_t total = producer_num * per_producer;
+  EXPECT_EQ(count.load(), total);
+  EXPECT_EQ(sum.load(), total * (total - 1) / 2);
+  EXPECT_TRUE(chan->Empty());
+}
+
+TEST(ChannelObject, RingBufferMultiProducerConsumer) {
+  for (int threads : {1, 4}) {
+    for (int batch : {1, 7, 64}) {
+      CheckMultiProducerConsumer(
+          MakeChannel<int64_t>(16, ChannelBackend::kRingBuffer), threads,
+          threads, batch);
+      CheckMultiProducerConsumer(
+          MakeChannel<int64_t>(16, ChannelBackend::kRingBuffer), threads,
+          threads + 2, batch);
+    }
+  }
+}
+
+TEST(ChannelObject, DequeMultiProducerConsumer) {
+  CheckMultiProducerConsumer(MakeChannel<int64_t>(16), 4, 4, 7);
+}
+
+TEST(ChannelObject, RingBufferClose) {
+  auto chan = MakeChannel<int>(4, ChannelBackend::kRingBuffer);
+  EXPECT_EQ(chan->Backend(), ChannelBackend::kRingBuffer);
+  EXPECT_EQ(chan->Capacity(), 4UL);
+  std::vector<int> in = {1, 2, 3, 4, 5, 6};
+  // the writer blocks on the full ring until the channel is closed
+  std::thread writer(
+      [&] { EXPECT_EQ(chan->Write(in.size(), in.data()), 4UL); });
+  while (chan->Size() < 4) {
+    std::this_thread::yield();
+  }
+  chan->Close();
+  writer.join();
+  EXPECT_FALSE(chan->Put(7));
+
+  // the closed channel can still be drained
+  std::vector<int> out;
+  EXPECT_EQ(chan->ReadAll(out), 4UL);
+  EXPECT_EQ(out, std::vector<int>({1, 2, 3, 4}));
+  int val = 0;
+  EXPECT_FALSE(chan->Get(val));
+
+  // the reader blocks on the empty ring until the channel is closed
+  chan->Open();
+  std::thread reader([&] {
+    int v = 0;
+    EXPECT_TRUE(chan->Get(v));
+    EXPECT_EQ(v, 9);
+    EXPECT_FALSE(chan->Get(v));
+  });
+  EXPECT_TRUE(chan->Put(9));
+  chan->Close();
+  reader.join();
+}
+
+}  // namespace framework
+}  // namespace paddle
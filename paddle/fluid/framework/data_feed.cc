@@ -24,6 +24,8 @@ limitations under the License. */
 #include <sys/stat.h>
 #include <sys/types.h>
 #endif
+#include <algorithm>
+#include <exception>
 #include <utility>
 #include "gflags/gflags.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
@@ -39,6 +41,58 @@ limitations under the License. */
 namespace paddle {
 namespace framework {
 
+namespace {
+// Call fn(line_begin, line_end) for every non-empty line in [begin, end), the
+// '\n' is not included in the line.
+template <typename Fn>
+void ForEachLine(const char* begin, const char* end, Fn fn) {
+  while (begin < end) {
+    const char* line_end = reinterpret_cast<const char*>(
+        memchr(begin, '\n', static_cast<size_t>(end - begin)));
+    if (line_end == nullptr) {
+      line_end = end;
+    }
+    const char* pos = begin;
+    SkipTokenSpaces(&pos, line_end);
+    if (pos != line_end) {
+      fn(begin, line_end);
+    }
+    begin = line_end + 1;
+  }
+}
+
+// Run fn(chunk_id, chunk_begin, chunk_end) for every chunk in its own thread.
+template <typename Fn>
+void ParseChunksInParallel(const char* data,
+                           const std::vector<std::pair<size_t, size_t>>& chunks,
+                           Fn fn) {
+  if (chunks.size() == 1) {
+    fn(0, data + chunks[0].first, data + chunks[0].second);
+    return;
+  }
+  std::vector<std::thread> threads;
+  std::vector<std::exception_ptr> errors(chunks.size());
+  threads.reserve(chunks.size());
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    threads.emplace_back([&, i] {
+      try {
+        fn(i, data + chunks[i].first, data + chunks[i].second);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+}  // namespace
+
 void RecordCandidateList::ReSize(size_t length) {
   _mutex.lock();
   _capacity = length;
@@ -136,6 +190,45 @@ void DataFeed::CheckStart() {
   PADDLE_ENFORCE(finish_start_, "Datafeed has not started running yet.");
 }
 
+void DataFeed::SetParseMode(const DataFeedDesc& data_feed_desc) {
+  const std::string& mode = data_feed_desc.parse_mode();
+  PADDLE_ENFORCE(mode == "line" || mode == "mmap",
+                 "Illegal parse mode: %s, only line and mmap are supported.",
+                 mode);
+  use_mmap_parser_ = (mode == "mmap");
+  parse_thread_num_ = data_feed_desc.parse_thread_num();
+  auto_parse_thread_num_ = parse_thread_num_ <= 0;
+  if (auto_parse_thread_num_) {
+    SetThreadNum(reader_thread_num_);
+  }
+}
+
+void DataFeed::SetThreadNum(int thread_num) {
+  reader_thread_num_ = std::max(thread_num, 1);
+  if (auto_parse_thread_num_) {
+    // The readers parse their files at the same time, share the hardware
+    // threads instead of oversubscribing them.
+    int hardware_threads =
+        static_cast<int>(std::thread::hardware_concurrency());
+    parse_thread_num_ = std::max(hardware_threads / reader_thread_num_, 1);
+  }
+}
+
+bool DataFeed::CanParseByMmap(const std::string& filename) const {
+#ifdef _LINUX
+  if (!use_mmap_parser_ || fs_select_internal(filename) != 0) {
+    return false;
+  }
+  if (filename.size() >= 3 &&
+      filename.compare(filename.size() - 3, 3, ".gz") == 0) {
+    return false;
+  }
+  return pipe_command_.empty() || pipe_command_ == "cat";
+#else
+  return false;
+#endif
+}
+
 void DataFeed::AssignFeedVar(const Scope& scope) {
   CheckInit();
   for (size_t i = 0; i < use_slots_.size(); ++i) {
@@ -159,8 +252,10 @@ template <typename T>
 void PrivateQueueDataFeed<T>::SetQueueSize(int queue_size) {
   PADDLE_ENFORCE(queue_size > 0, "Illegal queue size: %d.", queue_size);
   queue_size_ = queue_size;
-  queue_ = paddle::framework::MakeChannel<T>();
-  queue_->SetCapacity(queue_size);
+  // the queue is bounded and every instance is put/got one by one, use the
+  // lock-free ring buffer
+  queue_ = paddle::framework::MakeChannel<T>(
+      queue_size, paddle::framework::ChannelBackend::kRingBuffer);
 }
 
 template <typename T>
@@ -306,6 +401,7 @@ void InMemoryDataFeed<T>::SetThreadId(int thread_id) {
 template <typename T>
 void InMemoryDataFeed<T>::SetThreadNum(int thread_num) {
   thread_num_ = thread_num;
+  DataFeed::SetThreadNum(thread_num);
 }
 
 template <typename T>
@@ -326,6 +422,10 @@ void InMemoryDataFeed<T>::LoadIntoMemory() {
   while (this->PickOneFile(&filename)) {
     VLOG(3) << "PickOneFile, filename=" << filename
             << ", thread_id=" << thread_id_;
+    if (this->CanParseByMmap(filename)) {
+      LoadIntoMemoryByMmap(filename);
+      continue;
+    }
     int err_no = 0;
     this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_);
     CHECK(this->fp_ != nullptr);
@@ -348,6 +448,33 @@ void InMemoryDataFeed<T>::LoadIntoMemory() {
 #endif
 }
 
+template <typename T>
+void InMemoryDataFeed<T>::LoadIntoMemoryByMmap(const std::string& filename) {
+#ifdef _LINUX
+  MmapFile file;
+  PADDLE_ENFORCE(file.Open(filename), "Fail to mmap file: %s", filename);
+  platform::Timer timeline;
+  timeline.Start();
+  auto chunks = SplitLineAlignedChunks(file.data(), file.size(),
+                                       this->parse_thread_num_);
+  ParseChunksInParallel(
+      file.data(), chunks, [this](size_t, const char* begin, const char* end) {
+        paddle::framework::ChannelWriter<T> writer(input_channel_);
+        ForEachLine(begin, end, [&](const char* line, const char* line_end) {
+          T instance;
+          ParseOneInstanceFromBuffer(line, line_end, &instance);
+          writer << std::move(instance);
+        });
+        writer.Flush();
+      });
+  timeline.Pause();
+  VLOG(3) << "LoadIntoMemoryByMmap() read all lines, file=" << filename
+          << ", chunks=" << chunks.size()
+          << ", cost time=" << timeline.ElapsedSec()
+          << " seconds, thread_id=" << thread_id_;
+#endif
+}
+
 // explicit instantiation
 template class InMemoryDataFeed<Record>;
 
@@ -401,6 +528,7 @@ void MultiSlotDataFeed::Init(
   }
   feed_vec_.resize(use_slots_.size());
   pipe_command_ = data_feed_desc.pipe_command();
+  SetParseMode(data_feed_desc);
   finish_init_ = true;
 }
 
@@ -408,6 +536,10 @@ void MultiSlotDataFeed::ReadThread() {
 #ifdef _LINUX
   std::string filename;
   while (PickOneFile(&filename)) {
+    if (CanParseByMmap(filename)) {
+      ReadFileByMmap(filename);
+      continue;
+    }
     int err_no = 0;
     fp_ = fs_open_read(filename, &err_no, pipe_command_);
     CHECK(fp_ != nullptr);
@@ -424,6 +556,46 @@ void MultiSlotDataFeed::ReadThread() {
 #endif
 }
 
+void MultiSlotDataFeed::ReadFileByMmap(const std::string& filename) {
+#ifdef _LINUX
+  // every thread parses about 4MB text of a window at a time, which bounds
+  // the memory of parsed but not yet queued instances.
+  const size_t kChunkBytes = 4 << 20;
+  MmapFile file;
+  PADDLE_ENFORCE(file.Open(filename), "Fail to mmap file: %s", filename);
+  const char* data = file.data();
+  const size_t size = file.size();
+  const size_t window_bytes = kChunkBytes * parse_thread_num_;
+  int ins_num = 0;
+  std::vector<std::vector<std::vector<MultiSlotType>>> parsed;
+  for (size_t offset = 0; offset < size;) {
+    size_t window_end =
+        AlignToNextLine(data, size, std::min(offset + window_bytes, size));
+    auto chunks = SplitLineAlignedChunks(data + offset, window_end - offset,
+                                         parse_thread_num_);
+    parsed.clear();
+    parsed.resize(chunks.size());
+    ParseChunksInParallel(
+        data + offset, chunks,
+        [&](size_t chunk_id, const char* begin, const char* end) {
+          auto& out = parsed[chunk_id];
+          ForEachLine(begin, end, [&](const char* line, const char* line_end) {
+            out.emplace_back();
+            ParseOneInstanceFromBuffer(line, line_end, &out.back());
+          });
+        });
+    for (auto& chunk_ins : parsed) {
+      for (auto& instance : chunk_ins) {
+        queue_->Put(std::move(instance));
+        ++ins_num;
+      }
+    }
+    offset = window_end;
+  }
+  VLOG(3) << "filename: " << filename << " inst num: " << ins_num;
+#endif
+}
+
 bool MultiSlotDataFeed::CheckFile(const char* filename) {
 #ifdef _LINUX
   CheckInit();  // get info of slots
@@ -641,6 +813,50 @@ bool MultiSlotDataFeed::ParseOneInstance(std::vector<MultiSlotType>* instance) {
   return false;
 }
 
+bool MultiSlotDataFeed::ParseOneInstanceFromBuffer(
+    const char* begin, const char* end, std::vector<MultiSlotType>* instance) {
+  int use_slots_num = use_slots_.size();
+  instance->resize(use_slots_num);
+  const char* pos = begin;
+  for (size_t i = 0; i < use_slots_index_.size(); ++i) {
+    int idx = use_slots_index_[i];
+    int32_t num = 0;
+    PADDLE_ENFORCE(
+        ParseInt32Token(&pos, end, &num) && num > 0,
+        "The number of ids can not be zero, you need padding "
+        "it in data generator; or if there is something wrong with "
+        "the data, please check if the data contains unresolvable "
+        "characters.\nplease check this error line: %s",
+        std::string(begin, end));
+    if (idx != -1) {
+      auto& slot = (*instance)[idx];
+      slot.Init(all_slots_type_[i], num);
+      if (slot.GetType()[0] == 'f') {  // float
+        auto& data = slot.MutableFloatData();
+        data.resize(num);
+        for (int j = 0; j < num; ++j) {
+          PADDLE_ENFORCE(ParseFloatToken(&pos, end, &data[j]),
+                         "Fail to parse float feasign in line: %s",
+                         std::string(begin, end));
+        }
+      } else if (slot.GetType()[0] == 'u') {  // uint64
+        auto& data = slot.MutableUint64Data();
+        data.resize(num);
+        for (int j = 0; j < num; ++j) {
+          PADDLE_ENFORCE(ParseUint64Token(&pos, end, &data[j]),
+                         "Fail to parse uint64 feasign in line: %s",
+                         std::string(begin, end));
+        }
+      }
+    } else {
+      for (int j = 0; j < num; ++j) {
+        SkipToken(&pos, end);
+      }
+    }
+  }
+  return true;
+}
+
 void MultiSlotDataFeed::AddInstanceToInsVec(
     std::vector<MultiSlotType>* ins_vec,
     const std::vector<MultiSlotType>& instance, int index) {
@@ -745,6 +961,7 @@ void MultiSlotInMemoryDataFeed::Init(
   }
   feed_vec_.resize(use_slots_.size());
   pipe_command_ = data_feed_desc.pipe_command();
+  SetParseMode(data_feed_desc);
   finish_init_ = true;
 }
 
@@ -800,7 +1017,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             float feasign = strtof(endptr, &endptr);
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
-            if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
+            if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[idx]) {
               continue;
             }
             FeatureKey f;
@@ -812,7 +1029,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
-            if (feasign == 0 && !use_slots_is_dense_[i]) {
+            if (feasign == 0 && !use_slots_is_dense_[idx]) {
               continue;
             }
             FeatureKey f;
@@ -898,6 +1115,77 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
   return false;
 }
 
+bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromBuffer(const char* begin,
+                                                           const char* end,
+                                                           Record* instance) {
+  const char* pos = begin;
+  if (parse_ins_id_) {
+    int32_t num = 0;
+    CHECK(ParseInt32Token(&pos, end, &num) && num == 1);  // NOLINT
+    SkipTokenSpaces(&pos, end);
+    const char* id_begin = pos;
+    SkipToken(&pos, end);
+    instance->ins_id_.assign(id_begin, pos);
+    VLOG(3) << "ins_id " << instance->ins_id_;
+  }
+  if (parse_content_) {
+    int32_t num = 0;
+    CHECK(ParseInt32Token(&pos, end, &num) && num == 1);  // NOLINT
+    SkipTokenSpaces(&pos, end);
+    const char* content_begin = pos;
+    SkipToken(&pos, end);
+    instance->content_.assign(content_begin, pos);
+    VLOG(3) << "content " << instance->content_;
+  }
+  for (size_t i = 0; i < use_slots_index_.size(); ++i) {
+    int idx = use_slots_index_[i];
+    int32_t num = 0;
+    PADDLE_ENFORCE(
+        ParseInt32Token(&pos, end, &num) && num > 0,
+        "The number of ids can not be zero, you need padding "
+        "it in data generator; or if there is something wrong with "
+        "the data, please check if the data contains unresolvable "
+        "characters.\nplease check this error line: %s",
+        std::string(begin, end));
+    if (idx != -1) {
+      if (all_slots_type_[i][0] == 'f') {  // float
+        for (int j = 0; j < num; ++j) {
+          FeatureKey f;
+          PADDLE_ENFORCE(ParseFloatToken(&pos, end, &f.float_feasign_),
+                         "Fail to parse float feasign in line: %s",
+                         std::string(begin, end));
+          // if float feasign is equal to zero, ignore it
+          // except when slot is dense
+          if (fabs(f.float_feasign_) < 1e-6 && !use_slots_is_dense_[idx]) {
+            continue;
+          }
+          instance->float_feasigns_.push_back(FeatureItem(f, idx));
+        }
+      } else if (all_slots_type_[i][0] == 'u') {  // uint64
+        for (int j = 0; j < num; ++j) {
+          FeatureKey f;
+          PADDLE_ENFORCE(ParseUint64Token(&pos, end, &f.uint64_feasign_),
+                         "Fail to parse uint64 feasign in line: %s",
+                         std::string(begin, end));
+          // if uint64 feasign is equal to zero, ignore it
+          // except when slot is dense
+          if (f.uint64_feasign_ == 0 && !use_slots_is_dense_[idx]) {
+            continue;
+          }
+          instance->uint64_feasigns_.push_back(FeatureItem(f, idx));
+        }
+      }
+    } else {
+      for (int j = 0; j < num; ++j) {
+        SkipToken(&pos, end);
+      }
+    }
+  }
+  instance->float_feasigns_.shrink_to_fit();
+  instance->uint64_feasigns_.shrink_to_fit();
+  return true;
+}
+
 void MultiSlotInMemoryDataFeed::PutToFeedVec(
     const std::vector<Record>& ins_vec) {
 #ifdef _LINUX
@@ -977,6 +1265,132 @@ void MultiSlotInMemoryDataFeed::PutToFeedVec(
 #endif
 }
 
+#ifdef _LINUX
+// Open a MultiSlot binary file and check that its slots match the slots of
+// the DataFeedDesc.
+static std::unique_ptr<MultiSlotBinaryReader> OpenMultiSlotBinaryFile(
+    const std::string& filename, const std::vector<std::string>& slot_types) {
+  int err_no = 0;
+  auto fp = fs_open_read(filename, &err_no, "");
+  PADDLE_ENFORCE(fp != nullptr, "Fail to open file: %s", filename);
+  std::unique_ptr<MultiSlotBinaryReader> reader(new MultiSlotBinaryReader(fp));
+  const auto& types = reader->Meta().slot_types;
+  PADDLE_ENFORCE_EQ(types.size(), slot_types.size(),
+                    "The slot number of %s does not match the DataFeedDesc.",
+                    filename);
+  for (size_t i = 0; i < types.size(); ++i) {
+    PADDLE_ENFORCE_EQ(types[i], slot_types[i][0],
+                      "The type of slot %d of %s does not match the "
+                      "DataFeedDesc.",
+                      i, filename);
+  }
+  return reader;
+}
+#endif
+
+void MultiSlotBinaryDataFeed::ReadThread() {
+#ifdef _LINUX
+  std::string filename;
+  MultiSlotBinaryBlock block;
+  while (PickOneFile(&filename)) {
+    auto reader = OpenMultiSlotBinaryFile(filename, all_slots_type_);
+    int ins_num = 0;
+    while (reader->NextBlock(&block)) {
+      for (size_t ins = 0; ins < block.InstanceNum(); ++ins) {
+        std::vector<MultiSlotType> instance(use_slots_.size());
+        for (size_t i = 0; i < use_slots_index_.size(); ++i) {
+          int idx = use_slots_index_[i];
+          if (idx == -1) {
+            continue;
+          }
+          const uint32_t* offsets = block.Offsets(i);
+          size_t num = offsets[ins + 1] - offsets[ins];
+          instance[idx].Init(all_slots_type_[i]);
+          if (block.SlotType(i) == 'f') {
+            instance[idx].CopyValues(block.FloatData(i) + offsets[ins], num);
+          } else {
+            instance[idx].CopyValues(block.Uint64Data(i) + offsets[ins], num);
+          }
+        }
+        queue_->Put(std::move(instance));
+        ++ins_num;
+      }
+    }
+    VLOG(3) << "filename: " << filename << " inst num: " << ins_num;
+  }
+  queue_->Close();
+#endif
+}
+
+void MultiSlotBinaryInMemoryDataFeed::LoadIntoMemory() {
+#ifdef _LINUX
+  VLOG(3) << "LoadIntoMemory() begin, thread_id=" << thread_id_;
+  std::string filename;
+  MultiSlotBinaryBlock block;
+  while (PickOneFile(&filename)) {
+    auto reader = OpenMultiSlotBinaryFile(filename, all_slots_type_);
+    const auto& meta = reader->Meta();
+    PADDLE_ENFORCE(!parse_ins_id_ || meta.HasInsId(),
+                   "File %s has no ins_id.", filename);
+    PADDLE_ENFORCE(!parse_content_ || meta.HasContent(),
+                   "File %s has no content.", filename);
+    paddle::framework::ChannelWriter<Record> writer(input_channel_);
+    platform::Timer timeline;
+    timeline.Start();
+    while (reader->NextBlock(&block)) {
+      for (size_t ins = 0; ins < block.InstanceNum(); ++ins) {
+        Record instance;
+        if (parse_ins_id_) {
+          instance.ins_id_ = block.InsId(ins);
+        }
+        if (parse_content_) {
+          instance.content_ = block.Content(ins);
+        }
+        for (size_t i = 0; i < use_slots_index_.size(); ++i) {
+          int idx = use_slots_index_[i];
+          if (idx == -1) {
+            continue;
+          }
+          const uint32_t* offsets = block.Offsets(i);
+          // feasigns equal to zero are ignored except when slot is dense,
+          // the same as parsing the text data
+          if (block.SlotType(i) == 'f') {
+            const float* data = block.FloatData(i);
+            for (uint32_t j = offsets[ins]; j < offsets[ins + 1]; ++j) {
+              if (fabs(data[j]) < 1e-6 && !use_slots_is_dense_[idx]) {
+                continue;
+              }
+              FeatureKey f;
+              f.float_feasign_ = data[j];
+              instance.float_feasigns_.push_back(FeatureItem(f, idx));
+            }
+          } else {
+            const uint64_t* data = block.Uint64Data(i);
+            for (uint32_t j = offsets[ins]; j < offsets[ins + 1]; ++j) {
+              if (data[j] == 0 && !use_slots_is_dense_[idx]) {
+                continue;
+              }
+              FeatureKey f;
+              f.uint64_feasign_ = data[j];
+              instance.uint64_feasigns_.push_back(FeatureItem(f, idx));
+            }
+          }
+        }
+        instance.float_feasigns_.shrink_to_fit();
+        instance.uint64_feasigns_.shrink_to_fit();
+        writer << std::move(instance);
+      }
+    }
+    writer.Flush();
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemory() read all blocks, file=" << filename
+            << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemory() end, thread_id=" << thread_id_;
+#endif
+}
+
 #if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
 template <typename T>
 void PrivateInstantDataFeed<T>::PutToFeedVec() {
@@ -34,7 +34,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/data_feed.pb.h"
+#include "paddle/fluid/framework/data_feed_parser.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/multi_slot_binary.h"
 #include "paddle/fluid/framework/reader.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -63,6 +65,10 @@ class DataFeed {
   DataFeed() {
     mutex_for_pick_file_ = nullptr;
     file_idx_ = nullptr;
+    use_mmap_parser_ = false;
+    parse_thread_num_ = 1;
+    auto_parse_thread_num_ = false;
+    reader_thread_num_ = 1;
   }
   virtual ~DataFeed() {}
   virtual void Init(const DataFeedDesc& data_feed_desc) = 0;
@@ -101,8 +107,9 @@ class DataFeed {
   virtual void SetConsumeChannel(void* channel) {}
   // This function will do nothing at default
   virtual void SetThreadId(int thread_id) {}
-  // This function will do nothing at default
-  virtual void SetThreadNum(int thread_num) {}
+  // Set the number of the readers of the dataset, the default number of the
+  // parse threads of "mmap" mode is shared by them.
+  virtual void SetThreadNum(int thread_num);
   // This function will do nothing at default
   virtual void SetParseInsId(bool parse_ins_id) {}
   virtual void SetParseContent(bool parse_content) {}
@@ -138,6 +145,11 @@ class DataFeed {
   // safe).
   virtual bool PickOneFile(std::string* filename);
   virtual void CopyToFeedTensor(void* dst, const void* src, size_t size);
+  // Set parse_mode and parse_thread_num from data_feed_desc.
+  virtual void SetParseMode(const DataFeedDesc& data_feed_desc);
+  // Whether the file can be read by the "mmap" parse mode, i.e. the mode is
+  // enabled and the file is a local plain text file without pipe_command.
+  virtual bool CanParseByMmap(const std::string& filename) const;
 
   std::vector<std::string> filelist_;
   size_t* file_idx_;
@@ -172,6 +184,14 @@ class DataFeed {
   bool finish_set_filelist_;
   bool finish_start_;
   std::string pipe_command_;
+  // parse files by MmapFile and the tokenizers in data_feed_parser.h
+  bool use_mmap_parser_;
+  // the number of threads used to parse one file in "mmap" mode
+  int parse_thread_num_;
+  // whether parse_thread_num_ is derived from the hardware threads
+  bool auto_parse_thread_num_;
+  // the number of the readers parsing files at the same time
+  int reader_thread_num_;
   std::vector<std::string> ins_id_vec_;
   std::vector<std::string> ins_content_vec_;
   platform::Place place_;
@@ -238,6 +258,15 @@ class InMemoryDataFeed : public DataFeed {
  protected:
   virtual bool ParseOneInstance(T* instance) = 0;
   virtual bool ParseOneInstanceFromPipe(T* instance) = 0;
+  // Parse one line [begin, end) of a mmapped file, used by "mmap" mode.
+  virtual bool ParseOneInstanceFromBuffer(const char* begin, const char* end,
+                                          T* instance) {
+    PADDLE_THROW(
+        "This function(ParseOneInstanceFromBuffer) is not implemented.");
+  }
+  // Parse a local file with parse_thread_num_ threads, each of them parses a
+  // line-aligned chunk of the mmapped file and writes to input_channel_.
+  virtual void LoadIntoMemoryByMmap(const std::string& filename);
   virtual void PutToFeedVec(const std::vector<T>& ins_vec) = 0;
 
   int thread_id_;
@@ -544,6 +573,11 @@ class MultiSlotDataFeed
                                    int index);
   virtual bool ParseOneInstance(std::vector<MultiSlotType>* instance);
   virtual bool ParseOneInstanceFromPipe(std::vector<MultiSlotType>* instance);
+  virtual bool ParseOneInstanceFromBuffer(const char* begin, const char* end,
+                                          std::vector<MultiSlotType>* instance);
+  // Parse a local file in windows of line-aligned chunks, the chunks of one
+  // window are parsed in parallel and put into queue_ in the file order.
+  virtual void ReadFileByMmap(const std::string& filename);
   virtual void PutToFeedVec(const std::vector<MultiSlotType>& ins_vec);
 };
 
@@ -556,9 +590,32 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
  protected:
   virtual bool ParseOneInstance(Record* instance);
   virtual bool ParseOneInstanceFromPipe(Record* instance);
+  virtual bool ParseOneInstanceFromBuffer(const char* begin, const char* end,
+                                          Record* instance);
   virtual void PutToFeedVec(const std::vector<Record>& ins_vec);
 };
 
+// This DataFeed is used to feed data of the MultiSlot binary format (see
+// multi_slot_binary.h), which is converted from multi-slot text data by
+// multi_slot_binary_converter, so that the data is parsed only once.
+class MultiSlotBinaryDataFeed : public MultiSlotDataFeed {
+ public:
+  MultiSlotBinaryDataFeed() {}
+  virtual ~MultiSlotBinaryDataFeed() {}
+
+ protected:
+  virtual void ReadThread();
+};
+
+// The in-memory version of MultiSlotBinaryDataFeed, the columns of every
+// block are read into Records directly.
+class MultiSlotBinaryInMemoryDataFeed : public MultiSlotInMemoryDataFeed {
+ public:
+  MultiSlotBinaryInMemoryDataFeed() {}
+  virtual ~MultiSlotBinaryInMemoryDataFeed() {}
+  virtual void LoadIntoMemory();
+};
+
 #if defined(PADDLE_WITH_CUDA) && !defined(_WIN32)
 template <typename T>
 class PrivateInstantDataFeed : public DataFeed {
@@ -0,0 +1,172 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Benchmark of MultiSlotInMemoryDataFeed::LoadIntoMemory, compares the
+// "line" parse mode (LineFileReader + strtoull/strtof) with the "mmap" parse
+// mode (mmap + line-aligned chunks parsed in parallel), and with
+// MultiSlotBinaryInMemoryDataFeed reading the same data converted to the
+// MultiSlot binary format.
+//
+//   ./data_feed_benchmark --ins_num=1000000 --parse_thread_num=8
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed_factory.h"
+#include "paddle/fluid/framework/multi_slot_binary.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_int32(ins_num, 500000, "The number of instances in the test file.");
+DEFINE_int32(sparse_slot_num, 20, "The number of uint64 sparse slots.");
+DEFINE_int32(dense_slot_num, 4, "The number of float dense slots.");
+DEFINE_int32(feasign_per_slot, 4, "The number of feasigns per sparse slot.");
+DEFINE_int32(parse_thread_num, 0, "Threads used by the mmap parse mode.");
+DEFINE_int32(repeat, 3, "Repeat times of each parse mode.");
+DEFINE_string(filename, "data_feed_benchmark.txt", "The test file.");
+
+namespace paddle {
+namespace framework {
+
+DataFeedDesc MakeDesc(const std::string& name, const std::string& parse_mode) {
+  DataFeedDesc desc;
+  desc.set_name(name);
+  desc.set_batch_size(32);
+  desc.set_pipe_command("cat");
+  desc.set_parse_mode(parse_mode);
+  desc.set_parse_thread_num(FLAGS_parse_thread_num);
+  auto* multi_slot_desc = desc.mutable_multi_slot_desc();
+  for (int i = 0; i < FLAGS_sparse_slot_num; ++i) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name("sparse_" + std::to_string(i));
+    slot->set_type("uint64");
+    slot->set_is_used(true);
+  }
+  for (int i = 0; i < FLAGS_dense_slot_num; ++i) {
+    auto* slot = multi_slot_desc->add_slots();
+    slot->set_name("dense_" + std::to_string(i));
+    slot->set_type("float");
+    slot->set_is_used(true);
+    slot->set_is_dense(true);
+    slot->add_shape(1);
+  }
+  return desc;
+}
+
+size_t GenerateFile() {
+  std::mt19937_64 rng(0);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::ofstream fout(FLAGS_filename);
+  std::string line;
+  for (int i = 0; i < FLAGS_ins_num; ++i) {
+    line.clear();
+    for (int s = 0; s < FLAGS_sparse_slot_num; ++s) {
+      line += std::to_string(FLAGS_feasign_per_slot);
+      for (int j = 0; j < FLAGS_feasign_per_slot; ++j) {
+        line += " " + std::to_string(rng() >> 1);
+      }
+      line += " ";
+    }
+    for (int s = 0; s < FLAGS_dense_slot_num; ++s) {
+      line += "1 " + std::to_string(dist(rng)) + " ";
+    }
+    line.back() = '\n';
+    fout << line;
+  }
+  return static_cast<size_t>(fout.tellp());
+}
+
+size_t ConvertToBinary(const std::string& binary_filename) {
+  MultiSlotBinaryMeta meta;
+  for (int i = 0; i < FLAGS_sparse_slot_num; ++i) {
+    meta.slot_types.push_back('u');
+  }
+  for (int i = 0; i < FLAGS_dense_slot_num; ++i) {
+    meta.slot_types.push_back('f');
+  }
+  std::shared_ptr<FILE> in(fopen(FLAGS_filename.c_str(), "r"), &fclose);
+  std::shared_ptr<FILE> out(fopen(binary_filename.c_str(), "wb"), &fclose);
+  MultiSlotBinaryWriter writer(out, meta);
+  ConvertMultiSlotText(in.get(), &writer);
+  writer.Close();
+  return writer.BytesWritten();
+}
+
+double LoadOnce(const std::string& name, const std::string& parse_mode,
+                const std::string& filename, size_t* ins_num) {
+  auto feed = DataFeedFactory::CreateDataFeed(name);
+  std::mutex mutex;
+  size_t file_idx = 0;
+  auto channel = MakeChannel<Record>();
+  feed->Init(MakeDesc(name, parse_mode));
+  feed->SetFileListMutex(&mutex);
+  feed->SetFileListIndex(&file_idx);
+  feed->SetFileList({filename});
+  feed->SetInputChannel(channel.get());
+  platform::Timer timer;
+  timer.Start();
+  feed->LoadIntoMemory();
+  timer.Pause();
+  *ins_num = channel->Size();
+  return timer.ElapsedSec();
+}
+
+void Run() {
+  size_t bytes = GenerateFile();
+  std::string binary_filename = FLAGS_filename + ".bin";
+  size_t binary_bytes = ConvertToBinary(binary_filename);
+  LOG(INFO) << FLAGS_ins_num << " instances, text " << bytes
+            << " bytes (" << bytes / FLAGS_ins_num << " bytes/ins), binary "
+            << binary_bytes << " bytes (" << binary_bytes / FLAGS_ins_num
+            << " bytes/ins)";
+  struct Case {
+    std::string name;
+    std::string parse_mode;
+    std::string filename;
+  };
+  std::vector<Case> cases = {
+      {"MultiSlotInMemoryDataFeed", "line", FLAGS_filename},
+      {"MultiSlotInMemoryDataFeed", "mmap", FLAGS_filename},
+      {"MultiSlotBinaryInMemoryDataFeed", "line", binary_filename}};
+  for (auto& c : cases) {
+    double best = 0;
+    size_t ins_num = 0;
+    for (int i = 0; i < FLAGS_repeat; ++i) {
+      double sec = LoadOnce(c.name, c.parse_mode, c.filename, &ins_num);
+      best = (i == 0 || sec < best) ? sec : best;
+    }
+    PADDLE_ENFORCE_EQ(ins_num, static_cast<size_t>(FLAGS_ins_num));
+    LOG(INFO) << c.name << " parse_mode=" << c.parse_mode << ": "
+              << best * 1000 << " ms, " << ins_num / best << " ins/s";
+  }
+  remove(FLAGS_filename.c_str());
+  remove(binary_filename.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Run();
+  return 0;
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/data_feed_parser.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include "glog/logging.h"
+
+namespace paddle {
+namespace framework {
+
+bool MmapFile::Open(const std::string& filename) {
+  Close();
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if (fd_ == -1) {
+    VLOG(1) << "MmapFile: fail to open " << filename;
+    return false;
+  }
+  struct stat sb;
+  if (fstat(fd_, &sb) != 0) {
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(sb.st_size);
+  if (size_ == 0) {
+    // mmap does not accept zero length, an empty file is just empty data.
+    return true;
+  }
+  void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (addr == MAP_FAILED) {
+    VLOG(1) << "MmapFile: fail to mmap " << filename << ", "
+            << strerror(errno);
+    Close();
+    return false;
+  }
+  madvise(addr, size_, MADV_SEQUENTIAL);
+  data_ = reinterpret_cast<const char*>(addr);
+  return true;
+}
+
+void MmapFile::Close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+  }
+  if (fd_ != -1) {
+    close(fd_);
+    fd_ = -1;
+  }
+  size_ = 0;
+}
+
+size_t AlignToNextLine(const char* data, size_t size, size_t offset) {
+  if (offset == 0 || offset >= size) {
+    return std::min(offset, size);
+  }
+  const void* nl = memchr(data + offset - 1, '\n', size - offset + 1);
+  if (nl == nullptr) {
+    return size;
+  }
+  return static_cast<size_t>(reinterpret_cast<const char*>(nl) - data) + 1;
+}
+
+std::vector<std::pair<size_t, size_t>> SplitLineAlignedChunks(const char* data,
+                                                              size_t size,
+                                                              int chunk_num) {
+  std::vector<std::pair<size_t, size_t>> chunks;
+  if (size == 0) {
+    return chunks;
+  }
+  chunk_num = std::max(chunk_num, 1);
+  size_t step = (size + chunk_num - 1) / chunk_num;
+  size_t begin = 0;
+  while (begin < size) {
+    size_t end = AlignToNextLine(data, size, std::min(begin + step, size));
+    chunks.emplace_back(begin, end);
+    begin = end;
+  }
+  return chunks;
+}
+
+}  // namespace framework
+}  // namespace paddle
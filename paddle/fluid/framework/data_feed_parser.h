@@ -0,0 +1,262 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The tokenizers in this file are used by the "mmap" parse mode of the
+// MultiSlot DataFeeds. Unlike strtoull/strtof they never rely on a trailing
+// '\0', so that they can work on a read-only mmapped file directly, and they
+// convert eight digits at a time with SWAR (SIMD within a register) tricks.
+//
+// All of them take [*pos, end) as input, advance *pos past the parsed token
+// and return false when no valid token starts at *pos.
+
+// Read-only mapping of a whole local file.
+class MmapFile {
+ public:
+  MmapFile() {}
+  ~MmapFile() { Close(); }
+  MmapFile(const MmapFile&) = delete;
+  MmapFile& operator=(const MmapFile&) = delete;
+
+  // Maps the file and advises the kernel that it will be read sequentially.
+  // Returns false when the file can not be opened or mapped.
+  bool Open(const std::string& filename);
+  void Close();
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  int fd_{-1};
+  const char* data_{nullptr};
+  size_t size_{0};
+};
+
+// Returns the offset of the first line beginning at or after `offset`, i.e.
+// `offset` itself when it is 0 or follows a '\n', otherwise the byte after
+// the next '\n' (or `size` when there is none).
+size_t AlignToNextLine(const char* data, size_t size, size_t offset);
+
+// Split [data, data + size) into at most `chunk_num` chunks of roughly the
+// same size. Every chunk begins at the start of a line and ends right after a
+// '\n' (or at the end of data), so that chunks can be parsed independently.
+// Returns (begin_offset, end_offset) pairs, empty chunks are dropped.
+std::vector<std::pair<size_t, size_t>> SplitLineAlignedChunks(const char* data,
+                                                              size_t size,
+                                                              int chunk_num);
+
+inline bool IsTokenSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Skip spaces inside one line, never skips '\n'.
+inline void SkipTokenSpaces(const char** pos, const char* end) {
+  const char* p = *pos;
+  while (p < end && IsTokenSpace(*p)) {
+    ++p;
+  }
+  *pos = p;
+}
+
+// Skip one token without converting it.
+inline void SkipToken(const char** pos, const char* end) {
+  SkipTokenSpaces(pos, end);
+  const char* p = *pos;
+  while (p < end && !IsTokenSpace(*p) && *p != '\n') {
+    ++p;
+  }
+  *pos = p;
+}
+
+namespace internal {
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PADDLE_DATA_FEED_SWAR
+#endif
+
+#ifdef PADDLE_DATA_FEED_SWAR
+inline uint64_t LoadEightBytes(const char* p) {
+  uint64_t val;
+  memcpy(&val, p, sizeof(val));
+  return val;
+}
+
+// Whether all eight bytes are in ['0', '9'].
+inline bool IsEightDigits(uint64_t val) {
+  return (((val & 0xF0F0F0F0F0F0F0F0ULL) |
+           (((val + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+          0x3333333333333333ULL);
+}
+
+// Convert eight ascii digits to an integer with three multiplications, the
+// first byte in memory is the most significant digit.
+inline uint32_t ParseEightDigits(uint64_t val) {
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 0x000F424000000064ULL;  // 100 + (1000000ULL << 32)
+  const uint64_t mul2 = 0x0000271000000001ULL;  // 1 + (10000ULL << 32)
+  val -= 0x3030303030303030ULL;
+  val = (val * 10) + (val >> 8);  // val = (val * 2561) >> 8;
+  val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+  return static_cast<uint32_t>(val);
+}
+#endif
+
+// Parse the leading decimal digits, returns the number of consumed digits.
+// At most 19 digits are consumed, so that the result never overflows.
+inline int ParseDigits(const char** pos, const char* end, uint64_t* value) {
+  const char* p = *pos;
+  uint64_t v = 0;
+  int n = 0;
+#ifdef PADDLE_DATA_FEED_SWAR
+  while (n + 8 <= 16 && end - p >= 8) {
+    uint64_t chunk = LoadEightBytes(p);
+    if (!IsEightDigits(chunk)) {
+      break;
+    }
+    v = v * 100000000ULL + ParseEightDigits(chunk);
+    p += 8;
+    n += 8;
+  }
+#endif
+  while (n < 19 && p < end && static_cast<unsigned char>(*p - '0') < 10) {
+    v = v * 10 + static_cast<uint64_t>(*p - '0');
+    ++p;
+    ++n;
+  }
+  *pos = p;
+  *value = v;
+  return n;
+}
+
+// Copy one token into a '\0' terminated buffer and parse it with strto*, used
+// only by the slow paths (exponents, overlong numbers, inf/nan).
+template <typename T, typename Fn>
+inline bool ParseTokenSlow(const char** pos, const char* end, T* value,
+                           Fn fn) {
+  const char* p = *pos;
+  const char* q = p;
+  while (q < end && !IsTokenSpace(*q) && *q != '\n') {
+    ++q;
+  }
+  char buf[128];
+  size_t len = static_cast<size_t>(q - p);
+  if (len == 0 || len >= sizeof(buf)) {
+    return false;
+  }
+  memcpy(buf, p, len);
+  buf[len] = '\0';
+  char* endptr = buf;
+  *value = fn(buf, &endptr);
+  if (endptr == buf) {
+    return false;
+  }
+  *pos = p + (endptr - buf);
+  return true;
+}
+
+}  // namespace internal
+
+inline bool ParseUint64Token(const char** pos, const char* end,
+                             uint64_t* value) {
+  SkipTokenSpaces(pos, end);
+  const char* start = *pos;
+  uint64_t v = 0;
+  int n = internal::ParseDigits(pos, end, &v);
+  if (n == 0) {
+    *pos = start;
+    return false;
+  }
+  if (*pos < end && static_cast<unsigned char>(**pos - '0') < 10) {
+    // 20 digits, may be larger than 19 digits can hold
+    *pos = start;
+    return internal::ParseTokenSlow(
+        pos, end, value, [](const char* s, char** e) -> uint64_t {
+          return static_cast<uint64_t>(strtoull(s, e, 10));
+        });
+  }
+  *value = v;
+  return true;
+}
+
+inline bool ParseInt32Token(const char** pos, const char* end,
+                            int32_t* value) {
+  SkipTokenSpaces(pos, end);
+  const char* start = *pos;
+  bool negative = false;
+  if (*pos < end && (**pos == '-' || **pos == '+')) {
+    negative = **pos == '-';
+    ++*pos;
+  }
+  // the sign should be followed by the digits, like strtol
+  uint64_t v = 0;
+  if (*pos == end || static_cast<unsigned char>(**pos - '0') >= 10 ||
+      !ParseUint64Token(pos, end, &v)) {
+    *pos = start;
+    return false;
+  }
+  *value = negative ? -static_cast<int32_t>(v) : static_cast<int32_t>(v);
+  return true;
+}
+
+inline bool ParseFloatToken(const char** pos, const char* end, float* value) {
+  static const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,
+                                  1e7,  1e8,  1e9,  1e10, 1e11, 1e12, 1e13,
+                                  1e14, 1e15, 1e16, 1e17, 1e18, 1e19};
+  SkipTokenSpaces(pos, end);
+  const char* start = *pos;
+  const char* p = start;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t int_part = 0;
+  int int_digits = internal::ParseDigits(&p, end, &int_part);
+  uint64_t frac_part = 0;
+  int frac_digits = 0;
+  if (p < end && *p == '.') {
+    ++p;
+    frac_digits = internal::ParseDigits(&p, end, &frac_part);
+  }
+  bool fast = (int_digits + frac_digits > 0) && int_digits < 16 &&
+              (p >= end || IsTokenSpace(*p) || *p == '\n');
+  if (!fast) {
+    // exponent, too many digits, inf, nan and so on
+    *pos = start;
+    return internal::ParseTokenSlow(
+        pos, end, value,
+        [](const char* s, char** e) -> float { return strtof(s, e); });
+  }
+  double v = static_cast<double>(int_part);
+  if (frac_digits > 0) {
+    v += static_cast<double>(frac_part) / kPow10[frac_digits];
+  }
+  *value = static_cast<float>(negative ? -v : v);
+  *pos = p;
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,161 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/data_feed_parser.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(DataFeedParser, ParseUint64) {
+  std::vector<uint64_t> expected = {0,
+                                    7,
+                                    12345678,
+                                    123456789,
+                                    1234567890123456,
+                                    9999999999999999999ULL,
+                                    18446744073709551615ULL};
+  std::string line;
+  for (auto v : expected) {
+    line += std::to_string(v) + " ";
+  }
+  line += "\t";
+  const char* pos = line.data();
+  const char* end = line.data() + line.size();
+  for (auto v : expected) {
+    uint64_t out = 1;
+    ASSERT_TRUE(ParseUint64Token(&pos, end, &out));
+    EXPECT_EQ(out, v);
+  }
+  uint64_t out = 0;
+  EXPECT_FALSE(ParseUint64Token(&pos, end, &out));
+}
+
+TEST(DataFeedParser, ParseUint64WithoutTrailingSpace) {
+  // the token ends at the end of the buffer, which is not '\0' terminated
+  std::string line = "3 1234567890";
+  const char* pos = line.data();
+  const char* end = line.data() + line.size() - 2;
+  int32_t num = 0;
+  uint64_t out = 0;
+  ASSERT_TRUE(ParseInt32Token(&pos, end, &num));
+  EXPECT_EQ(num, 3);
+  ASSERT_TRUE(ParseUint64Token(&pos, end, &out));
+  EXPECT_EQ(out, 12345678UL);
+  EXPECT_EQ(pos, end);
+}
+
+TEST(DataFeedParser, ParseInt32) {
+  std::string line = "-5 +3 12 - 5";
+  const char* pos = line.data();
+  const char* end = line.data() + line.size();
+  int32_t num = 0;
+  ASSERT_TRUE(ParseInt32Token(&pos, end, &num));
+  EXPECT_EQ(num, -5);
+  ASSERT_TRUE(ParseInt32Token(&pos, end, &num));
+  EXPECT_EQ(num, 3);
+  ASSERT_TRUE(ParseInt32Token(&pos, end, &num));
+  EXPECT_EQ(num, 12);
+  // a sign not followed by the digits, like strtol
+  EXPECT_FALSE(ParseInt32Token(&pos, end, &num));
+  EXPECT_EQ(*pos, '-');
+
+  std::string only_sign = "-";
+  pos = only_sign.data();
+  EXPECT_FALSE(ParseInt32Token(&pos, pos + only_sign.size(), &num));
+}
+
+TEST(DataFeedParser, ParseFloat) {
+  std::vector<std::string> tokens = {"0",       "1.5",     "-2.25",  "+3",
+                                     "0.001",   ".5",      "7.",     "1e-3",
+                                     "-2.5E+4", "3.14159", "123456.789",
+                                     "0.000000000000000000001"};
+  std::string line;
+  for (auto& t : tokens) {
+    line += t + " ";
+  }
+  const char* pos = line.data();
+  const char* end = line.data() + line.size();
+  for (auto& t : tokens) {
+    float out = -1;
+    ASSERT_TRUE(ParseFloatToken(&pos, end, &out)) << t;
+    float expected = strtof(t.c_str(), nullptr);
+    EXPECT_NEAR(out, expected, std::fabs(expected) * 1e-6 + 1e-30) << t;
+  }
+}
+
+TEST(DataFeedParser, SkipToken) {
+  std::string line = "2 a b 1 9\n";
+  const char* pos = line.data();
+  const char* end = line.data() + line.size();
+  int32_t num = 0;
+  ASSERT_TRUE(ParseInt32Token(&pos, end, &num));
+  for (int i = 0; i < num; ++i) {
+    SkipToken(&pos, end);
+  }
+  ASSERT_TRUE(ParseInt32Token(&pos, end, &num));
+  EXPECT_EQ(num, 1);
+  uint64_t out = 0;
+  ASSERT_TRUE(ParseUint64Token(&pos, end, &out));
+  EXPECT_EQ(out, 9UL);
+  EXPECT_EQ(*pos, '\n');
+}
+
+TEST(DataFeedParser, SplitLineAlignedChunks) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data += std::to_string(i) + " " + std::to_string(i * 7) + "\n";
+  }
+  data += "1000 7000";  // the last line has no '\n'
+  for (int n : {1, 2, 3, 7, 64, 5000}) {
+    auto chunks = SplitLineAlignedChunks(data.data(), data.size(), n);
+    ASSERT_FALSE(chunks.empty());
+    EXPECT_LE(chunks.size(), static_cast<size_t>(n));
+    EXPECT_EQ(chunks.front().first, 0UL);
+    EXPECT_EQ(chunks.back().second, data.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      EXPECT_LT(chunks[i].first, chunks[i].second);
+      if (i > 0) {
+        EXPECT_EQ(chunks[i].first, chunks[i - 1].second);
+        EXPECT_EQ(data[chunks[i].first - 1], '\n');
+      }
+    }
+  }
+  EXPECT_TRUE(SplitLineAlignedChunks(data.data(), 0, 4).empty());
+}
+
+TEST(DataFeedParser, MmapFile) {
+  std::string filename = "data_feed_parser_test_file.txt";
+  std::string content = "1 2\n3 4\n";
+  {
+    std::ofstream fout(filename);
+    fout << content;
+  }
+  MmapFile file;
+  ASSERT_TRUE(file.Open(filename));
+  ASSERT_EQ(file.size(), content.size());
+  EXPECT_EQ(std::string(file.data(), file.size()), content);
+  file.Close();
+  EXPECT_EQ(file.data(), nullptr);
+  remove(filename.c_str());
+  EXPECT_FALSE(file.Open(filename));
+}
+
+}  // namespace framework
+}  // namespace paddle
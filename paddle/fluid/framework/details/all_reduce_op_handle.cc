@@ -14,7 +14,7 @@
 #include "paddle/fluid/framework/details/all_reduce_op_handle.h"
 #include <algorithm>
 #include "paddle/fluid/framework/details/container_cast.h"
-#include "paddle/fluid/framework/details/reduce_and_gather.h"
+#include "paddle/fluid/framework/details/cpu_all_reduce.h"
 #include "paddle/fluid/framework/details/variable_visitor.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/platform/gpu_info.h"
@@ -132,26 +132,19 @@ void AllReduceOpHandle::AllReduceFunc(
     PADDLE_THROW("Not compiled with CUDA.");
 #endif
   } else {  // Special handle CPU only Operator's gradient. Like CRF
-    auto &trg = *local_exec_scopes_[0]
-                     ->FindVar(out_var_names[0])
-                     ->GetMutable<LoDTensor>();
-
-    // Reduce All Tensor to trg in CPU
-    ReduceBufferData func(lod_tensor_data, trg.data<void>(), numel);
-    VisitDataType(trg.type(), func);
-
-    for (size_t i = 1; i < local_exec_scopes_.size(); ++i) {
-      auto &scope = local_exec_scopes_[i];
-      auto &p = places[i];
-      auto *var = scope->FindVar(out_var_names[i]);
-
-      size_t size = numel * SizeOfType(trg.type());
-      RunAndRecordEvent(p, [&trg, var, p, size] {
-        auto dst_ptr = var->GetMutable<framework::LoDTensor>()->data<void>();
-        platform::CPUPlace cpu_place;
-        memory::Copy(cpu_place, dst_ptr, cpu_place, trg.data<void>(), size);
-      });
+    std::vector<void *> out_data;
+    out_data.reserve(local_exec_scopes_.size());
+    for (size_t i = 0; i < local_exec_scopes_.size(); ++i) {
+      auto *var = local_exec_scopes_[i]->FindVar(out_var_names[i]);
+      PADDLE_ENFORCE_NOT_NULL(var, "%s is not found int scope.",
+                              out_var_names[i]);
+      out_data.emplace_back(
+          var->GetMutable<framework::LoDTensor>()->data<void>());
     }
+
+    // Reduce-scatter and all-gather the chunks of the buffers in parallel
+    this->RunAndRecordEvent(
+        [&] { CPUAllReduce(lod_tensor_data, out_data, dtype, numel); });
   }
   VLOG(10) << Name() << " size:" << numel * SizeOfType(dtype);
 }
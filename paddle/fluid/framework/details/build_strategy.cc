@@ -74,6 +74,8 @@ class ParallelExecutorPassBuilder : public ir::PassBuilder {
     // attr if putting it after MultiDevPass.
     AppendPassWithCheck(strategy_.cache_runtime_context_,
                         "runtime_context_cache_pass");
+    AppendPassWithCheck(strategy_.cache_shape_signature_,
+                        "shape_signature_cache_pass");
     AppendPassWithCheck(strategy_.remove_unnecessary_lock_,
                         "modify_op_lock_and_record_event_pass");
     // Note: This pass is used to check whether the multi_device_graph is right.
@@ -412,6 +414,7 @@ USE_PASS(fuse_sgd_op_pass);
 USE_PASS(fuse_momentum_op_pass);
 USE_PASS(fuse_all_reduce_op_pass);
 USE_PASS(runtime_context_cache_pass);
+USE_PASS(shape_signature_cache_pass);
 #ifdef PADDLE_WITH_MKLDNN
 USE_PASS(mkldnn_placement_pass);
 #endif
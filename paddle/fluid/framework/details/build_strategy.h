@@ -82,6 +82,9 @@ struct BuildStrategy {
   // TODO(dev-paddle): cache_runtime_context may cause some models to hang up
   // while running.
   bool cache_runtime_context_{false};
+  // Skip InferShape and PrepareData of the ops while the shapes of their
+  // inputs do not change.
+  bool cache_shape_signature_{false};
 
   // Operator fusion
   // TODO(dev-paddle): fuse_elewise_add_act_ops may cause some models have
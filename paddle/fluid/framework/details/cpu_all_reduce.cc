@@ -0,0 +1,183 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/details/cpu_all_reduce.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+// The bytes of a chunk, the sum of a chunk stays in the L2 cache before it is
+// copied to the other places.
+static constexpr int64_t kChunkBytes = 64 * 1024;
+
+// acc = a + b + ... (N sources), or acc += a + b + ... if kAccumulate. The
+// sources never alias acc, so that the loop is vectorized.
+template <typename T, int N, bool kAccumulate>
+static void SumChunk(T *acc, const T *const *srcs, int64_t n) {
+  const T *a = srcs[0];
+  const T *b = N > 1 ? srcs[1] : nullptr;
+  const T *c = N > 2 ? srcs[2] : nullptr;
+  const T *d = N > 3 ? srcs[3] : nullptr;
+  for (int64_t k = 0; k < n; ++k) {
+    T sum = a[k];
+    if (N > 1) sum = static_cast<T>(sum + b[k]);
+    if (N > 2) sum = static_cast<T>(sum + c[k]);
+    if (N > 3) sum = static_cast<T>(sum + d[k]);
+    acc[k] = kAccumulate ? static_cast<T>(acc[k] + sum) : sum;
+  }
+}
+
+template <typename T>
+static void SumChunk(T *acc, const T *const *srcs, int num, bool accumulate,
+                     int64_t n) {
+  switch (num + (accumulate ? 4 : 0)) {
+    case 1:
+      return SumChunk<T, 1, false>(acc, srcs, n);
+    case 2:
+      return SumChunk<T, 2, false>(acc, srcs, n);
+    case 3:
+      return SumChunk<T, 3, false>(acc, srcs, n);
+    case 4:
+      return SumChunk<T, 4, false>(acc, srcs, n);
+    case 5:
+      return SumChunk<T, 1, true>(acc, srcs, n);
+    case 6:
+      return SumChunk<T, 2, true>(acc, srcs, n);
+    case 7:
+      return SumChunk<T, 3, true>(acc, srcs, n);
+    default:
+      PADDLE_THROW("Cannot sum %d sources at once.", num);
+  }
+}
+
+struct CPUAllReduceFunctor {
+  const std::vector<const void *> &src_;
+  const std::vector<void *> &dst_;
+  int64_t numel_;
+
+  CPUAllReduceFunctor(const std::vector<const void *> &src,
+                      const std::vector<void *> &dst, int64_t numel)
+      : src_(src), dst_(dst), numel_(numel) {}
+
+  template <typename T>
+  void apply() const;
+
+  template <typename T>
+  void ReduceChunk(int64_t begin, int64_t end,
+                   std::vector<const T *> *srcs) const {
+    int num = static_cast<int>(src_.size());
+    T *acc = static_cast<T *>(dst_[0]) + begin;
+    int64_t n = end - begin;
+    for (int i = 0; i < num; ++i) {
+      (*srcs)[i] = static_cast<const T *>(src_[i]) + begin;
+    }
+
+    // Sums four sources in the first pass and three (plus acc) in the others,
+    // so that acc is read and written once per pass.
+    int i = 0;
+    bool accumulate = false;
+    if ((*srcs)[0] == acc) {
+      i = 1;
+      accumulate = true;
+    }
+    while (i < num) {
+      int m = std::min(num - i, accumulate ? 3 : 4);
+      SumChunk<T>(acc, srcs->data() + i, m, accumulate, n);
+      accumulate = true;
+      i += m;
+    }
+
+    for (size_t j = 1; j < dst_.size(); ++j) {
+      T *out = static_cast<T *>(dst_[j]) + begin;
+      if (out != acc) {
+        std::memcpy(out, acc, n * sizeof(T));
+      }
+    }
+  }
+};
+
+// The calling thread runs a task too, so the pool has one thread less than
+// the cores.
+static ThreadPool *CPUAllReduceThreadPool() {
+  static std::unique_ptr<ThreadPool> pool(new ThreadPool(
+      std::max<int>(static_cast<int>(std::thread::hardware_concurrency()) - 1,
+                    1)));
+  return pool.get();
+}
+
+template <typename T>
+void CPUAllReduceFunctor::apply() const {
+  int64_t chunk = std::max<int64_t>(kChunkBytes / sizeof(T), 1);
+  int64_t chunk_num = (numel_ + chunk - 1) / chunk;
+  int64_t task_num =
+      std::min<int64_t>(static_cast<int64_t>(src_.size()), chunk_num);
+
+  std::atomic<int64_t> next_chunk{0};
+  auto task = [&] {
+    std::vector<const T *> srcs(src_.size());
+    for (int64_t c = next_chunk.fetch_add(1); c < chunk_num;
+         c = next_chunk.fetch_add(1)) {
+      ReduceChunk<T>(c * chunk, std::min(numel_, (c + 1) * chunk), &srcs);
+    }
+  };
+  if (task_num <= 1) {
+    task();
+    return;
+  }
+
+  TaskGroup group;
+  auto *pool = CPUAllReduceThreadPool();
+  for (int64_t t = 1; t < task_num; ++t) {
+    pool->Run(task, &group);
+  }
+  std::unique_ptr<platform::EnforceNotMet> ex;
+  try {
+    task();
+  } catch (platform::EnforceNotMet &e) {
+    ex.reset(new platform::EnforceNotMet(e));
+  }
+  // the tasks reference the locals, wait for them even if task() threw
+  auto pool_ex = group.Wait();
+  if (ex != nullptr) {
+    throw *ex;
+  }
+  if (pool_ex != nullptr) {
+    throw *pool_ex;
+  }
+}
+
+void CPUAllReduce(const std::vector<const void *> &src,
+                  const std::vector<void *> &dst, proto::VarType::Type dtype,
+                  int64_t numel) {
+  PADDLE_ENFORCE(!src.empty(), "The all-reduce has no input.");
+  PADDLE_ENFORCE_EQ(src.size(), dst.size(),
+                    "The all-reduce should have one output per input.");
+  if (numel <= 0) {
+    return;
+  }
+  VisitDataType(dtype, CPUAllReduceFunctor(src, dst, numel));
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,39 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "paddle/fluid/framework/framework.pb.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+// The all-reduce of the buffers of the CPU places: every dst[i] is set to the
+// sum of all the src buffers. dst[i] may be src[i] (in place).
+//
+// The buffers are split into chunks. A chunk is reduced across the places
+// into dst[0] (reduce-scatter) and then copied into the other dst buffers
+// while it is still in the cache (all-gather). The chunks are shared by one
+// task per place: the calling thread and the tasks run by a pool that is only
+// used by the all-reduce, so that the tasks never wait on each other.
+void CPUAllReduce(const std::vector<const void *> &src,
+                  const std::vector<void *> &dst, proto::VarType::Type dtype,
+                  int64_t numel);
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,98 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the all-reduce of the gradients of the CPU places of
+// ParallelExecutor: the serial ReduceBufferData into place 0 followed by the
+// copies to the other places used before, and CPUAllReduce.
+//
+//   ./cpu_all_reduce_benchmark --numel=4194304 --places=2,4,8,16,32
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/details/cpu_all_reduce.h"
+#include "paddle/fluid/framework/details/reduce_and_gather.h"
+
+DEFINE_int64(numel, 1 << 22, "The number of floats of the gradient buffer.");
+DEFINE_string(places, "2,4,8,16,32", "The numbers of the CPU places.");
+DEFINE_int32(repeat, 10, "The number of the all-reduces of every case.");
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+template <typename Callback>
+static double MeasureMs(Callback &&fn) {
+  fn();  // warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    fn();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() /
+         FLAGS_repeat;
+}
+
+void Benchmark() {
+  std::vector<int> place_nums;
+  std::stringstream ss(FLAGS_places);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    place_nums.push_back(std::stoi(item));
+  }
+
+  int64_t numel = FLAGS_numel;
+  for (int place_num : place_nums) {
+    std::vector<std::vector<float>> buffers(place_num,
+                                            std::vector<float>(numel, 1.0f));
+    std::vector<const void *> src;
+    std::vector<void *> dst;
+    for (auto &buffer : buffers) {
+      src.emplace_back(buffer.data());
+      dst.emplace_back(buffer.data());
+    }
+
+    double serial_ms = MeasureMs([&] {
+      ReduceBufferData func(src, dst[0], numel);
+      VisitDataType(proto::VarType::FP32, func);
+      for (int i = 1; i < place_num; ++i) {
+        std::memcpy(dst[i], dst[0], numel * sizeof(float));
+      }
+    });
+    double chunked_ms = MeasureMs(
+        [&] { CPUAllReduce(src, dst, proto::VarType::FP32, numel); });
+    double gb = static_cast<double>(numel) * sizeof(float) * place_num / 1e9;
+    LOG(INFO) << place_num << " places, " << numel
+              << " floats: serial reduce and copy " << serial_ms
+              << " ms, CPUAllReduce " << chunked_ms << " ms ("
+              << gb / (chunked_ms / 1e3) << " GB/s of the buffers), speedup "
+              << serial_ms / chunked_ms;
+  }
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::details::Benchmark();
+  return 0;
+}
@@ -0,0 +1,94 @@
+//   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/details/cpu_all_reduce.h"
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+template <typename T>
+static void TestCPUAllReduce(int place_num, int64_t numel, bool in_place) {
+  std::vector<std::vector<T>> inputs(place_num, std::vector<T>(numel));
+  std::vector<std::vector<T>> outputs(in_place ? 0 : place_num,
+                                      std::vector<T>(numel));
+  std::vector<T> expect(numel, static_cast<T>(0));
+  for (int i = 0; i < place_num; ++i) {
+    for (int64_t k = 0; k < numel; ++k) {
+      inputs[i][k] = static_cast<T>((k * 7 + i * 3) % 11);
+      expect[k] = static_cast<T>(expect[k] + inputs[i][k]);
+    }
+  }
+
+  std::vector<const void *> src;
+  std::vector<void *> dst;
+  for (int i = 0; i < place_num; ++i) {
+    src.emplace_back(inputs[i].data());
+    dst.emplace_back(in_place ? inputs[i].data() : outputs[i].data());
+  }
+  CPUAllReduce(src, dst, DataTypeTrait<T>::DataType(), numel);
+
+  for (int i = 0; i < place_num; ++i) {
+    const T *out = static_cast<const T *>(dst[i]);
+    for (int64_t k = 0; k < numel; ++k) {
+      ASSERT_EQ(out[k], expect[k]) << "place " << i << ", index " << k;
+    }
+  }
+}
+
+TEST(CPUAllReduce, places) {
+  for (int place_num : {1, 2, 3, 4, 5, 7, 8, 16}) {
+    TestCPUAllReduce<float>(place_num, 100003, true);
+    TestCPUAllReduce<float>(place_num, 100003, false);
+  }
+}
+
+TEST(CPUAllReduce, sizes) {
+  // smaller than, equal to and not a multiple of a chunk
+  for (int64_t numel : {1, 17, 16384, 16385, 300000}) {
+    TestCPUAllReduce<float>(4, numel, true);
+  }
+  TestCPUAllReduce<float>(4, 0, true);
+}
+
+TEST(CPUAllReduce, dtypes) {
+  TestCPUAllReduce<double>(6, 50000, true);
+  TestCPUAllReduce<int>(6, 50000, false);
+  TestCPUAllReduce<int64_t>(3, 50000, true);
+  TestCPUAllReduce<platform::float16>(4, 70000, true);
+}
+
+TEST(CPUAllReduce, concurrent) {
+  // the all-reduce op handles of different gradients run concurrently
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 10; ++i) {
+        TestCPUAllReduce<float>(8, 200000, true);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
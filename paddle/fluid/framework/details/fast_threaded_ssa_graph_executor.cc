@@ -190,7 +190,7 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
     OpHandleBase *op,
     const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
   ++remaining_;
-  this->pool_.enqueue([=] {
+  auto run_ops = [=] {
     std::deque<OpHandleBase *> op_queue;
     op_queue.push_front(op);
 
@@ -230,7 +230,9 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
     }
     --remaining_;
     complete_q->Push(complete);
-  });
+  };
+  // the exceptions of ops are kept in exception_, so no TaskGroup is needed
+  this->pool_.Run(run_ops, nullptr);
 }
 
 void FastThreadedSSAGraphExecutor::PrepareAtomicOpDeps() {
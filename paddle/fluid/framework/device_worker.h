@@ -25,6 +25,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/data_feed.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/local_sgd.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/program_desc.h"
@@ -116,6 +117,7 @@ class DeviceWorker {
   virtual void SetDataFeed(DataFeed* data_feed);
   virtual void SetNeedDump(bool need_dump_field) {}
   virtual void SetChannelWriter(ChannelObject<std::string>* queue) {}
+  virtual void SetLocalSGD(const std::shared_ptr<LocalSGD>& local_sgd) {}
   virtual void SetPlace(const paddle::platform::Place& place) {
     place_ = place;
   }
@@ -158,6 +160,9 @@ class HogwildWorker : public CPUWorkerBase {
   virtual void PrintFetchVars();
   virtual void CreateDeviceResource(const ProgramDesc& main_prog);
   virtual void BindingDataFeedMemory();
+  virtual void SetLocalSGD(const std::shared_ptr<LocalSGD>& local_sgd) {
+    local_sgd_ = local_sgd;
+  }
   template <typename T>
   void SetZero(LoDTensor* tensor, LoDTensor* root_tensor, int tensor_dim);
 
@@ -170,6 +175,9 @@ class HogwildWorker : public CPUWorkerBase {
   HogwildWorkerParameter param_;
   std::vector<std::string> skip_ops_;
   std::map<std::string, int> stat_var_name_map_;
+  // shared by all the workers of the trainer in local SGD
+  std::shared_ptr<LocalSGD> local_sgd_;
+  std::vector<std::string> local_sgd_vars_;
 };
 
 class DownpourWorker : public HogwildWorker {
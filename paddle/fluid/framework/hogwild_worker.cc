@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <string>
+#include <unordered_set>
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/device_worker.h"
 #include "paddle/fluid/framework/device_worker_factory.h"
@@ -51,6 +53,20 @@ void HogwildWorker::CreateThreadScope(const ProgramDesc &program) {
 
   thread_scope_ = &root_scope_->NewScope();
 
+  std::unordered_set<std::string> local_sgd_vars;
+  if (local_sgd_) {
+    std::unordered_set<std::string> shared(
+        param_.local_sgd_shared_vars().begin(),
+        param_.local_sgd_shared_vars().end());
+    for (auto &item : stat_var_name_map_) {
+      shared.insert(item.first);
+    }
+    local_sgd_vars_ = LocalSGD::PrivateVars(block, shared);
+    local_sgd_vars.insert(local_sgd_vars_.begin(), local_sgd_vars_.end());
+    VLOG(3) << "thread " << thread_id_ << " trains " << local_sgd_vars_.size()
+            << " private parameters";
+  }
+
   for (auto &var : block.AllVars()) {
     if (var->Persistable()) {
       auto *ptr = root_scope_->Var(var->Name());
@@ -72,6 +88,10 @@ void HogwildWorker::CreateThreadScope(const ProgramDesc &program) {
   } while (0)
         _ForEachDataType_(MemsetCallback);
       }
+      if (local_sgd_vars.count(var->Name())) {
+        // copied from the root one when the thread starts
+        InitializeVariable(thread_scope_->Var(var->Name()), var->GetType());
+      }
     } else {
       auto *ptr = thread_scope_->Var(var->Name());
       InitializeVariable(ptr, var->GetType());
@@ -101,6 +121,10 @@ void HogwildWorker::CreateDeviceResource(const ProgramDesc &main_prog) {
 
 void HogwildWorker::TrainFilesWithProfiler() {
   platform::SetNumThreads(1);
+  if (local_sgd_) {
+    local_sgd_->InitThread(thread_id_, local_sgd_vars_, root_scope_,
+                           thread_scope_);
+  }
   device_reader_->Start();
   std::vector<double> op_total_time;
   std::vector<std::string> op_name;
@@ -156,12 +180,22 @@ void HogwildWorker::TrainFilesWithProfiler() {
       }
     }
     thread_scope_->DropKids();
+    if (local_sgd_) {
+      local_sgd_->Step(thread_id_);
+    }
     timeline.Start();
   }
+  if (local_sgd_) {
+    local_sgd_->Finish(thread_id_);
+  }
 }
 
 void HogwildWorker::TrainFiles() {
   platform::SetNumThreads(1);
+  if (local_sgd_) {
+    local_sgd_->InitThread(thread_id_, local_sgd_vars_, root_scope_,
+                           thread_scope_);
+  }
 
   // how to accumulate fetched values here
   device_reader_->Start();
@@ -182,6 +216,12 @@ void HogwildWorker::TrainFiles() {
 
     PrintFetchVars();
     thread_scope_->DropKids();
+    if (local_sgd_) {
+      local_sgd_->Step(thread_id_);
+    }
+  }
+  if (local_sgd_) {
+    local_sgd_->Finish(thread_id_);
   }
 }
 
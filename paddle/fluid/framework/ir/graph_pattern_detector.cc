@@ -1969,6 +1969,124 @@ void patterns::DeleteQuantDequantOpPattern::operator()() {
   any_op2->LinksFrom({quant_dequant_out});
 }
 
+PDNode *patterns::MultiHeadMatmul::operator()(bool with_scale) {
+  // The q, k and v branches: x + bias -> reshape2 -> transpose2.
+  auto branch = [&](PDNode *x, PDNode *bias, PDNode *eltadd,
+                    PDNode *eltadd_out, PDNode *reshape2,
+                    PDNode *reshape2_out, PDNode *transpose2,
+                    PDNode *transpose2_out) {
+    x->AsInput()->assert_is_op_input("elementwise_add", "X");
+    bias->AsInput()
+        ->assert_is_persistable_var()
+        ->assert_is_op_input("elementwise_add", "Y");
+    eltadd->assert_is_op("elementwise_add");
+    eltadd_out->AsIntermediate()
+        ->assert_is_op_output("elementwise_add")
+        ->assert_is_op_input("reshape2", "X");
+    reshape2->assert_is_op("reshape2");
+    reshape2_out->AsIntermediate()
+        ->assert_is_op_output("reshape2", "Out")
+        ->assert_is_op_input("transpose2", "X");
+    transpose2->assert_is_op("transpose2");
+    transpose2_out->AsIntermediate()->assert_is_op_output("transpose2", "Out");
+
+    eltadd->LinksFrom({x, bias}).LinksTo({eltadd_out});
+    reshape2->LinksFrom({eltadd_out}).LinksTo({reshape2_out});
+    transpose2->LinksFrom({reshape2_out}).LinksTo({transpose2_out});
+  };
+
+  auto *transpose2_q_out_var = pattern->NewNode(transpose2_q_out_repr());
+  auto *transpose2_k_out_var = pattern->NewNode(transpose2_k_out_repr());
+  auto *transpose2_v_out_var = pattern->NewNode(transpose2_v_out_repr());
+  branch(pattern->NewNode(q_repr()), pattern->NewNode(bias_q_repr()),
+         pattern->NewNode(eltadd_q_repr()),
+         pattern->NewNode(eltadd_q_out_repr()),
+         pattern->NewNode(reshape2_q_repr()),
+         pattern->NewNode(reshape2_q_out_repr()),
+         pattern->NewNode(transpose2_q_repr()), transpose2_q_out_var);
+  branch(pattern->NewNode(k_repr()), pattern->NewNode(bias_k_repr()),
+         pattern->NewNode(eltadd_k_repr()),
+         pattern->NewNode(eltadd_k_out_repr()),
+         pattern->NewNode(reshape2_k_repr()),
+         pattern->NewNode(reshape2_k_out_repr()),
+         pattern->NewNode(transpose2_k_repr()), transpose2_k_out_var);
+  branch(pattern->NewNode(v_repr()), pattern->NewNode(bias_v_repr()),
+         pattern->NewNode(eltadd_v_repr()),
+         pattern->NewNode(eltadd_v_out_repr()),
+         pattern->NewNode(reshape2_v_repr()),
+         pattern->NewNode(reshape2_v_out_repr()),
+         pattern->NewNode(transpose2_v_repr()), transpose2_v_out_var);
+
+  PDNode *q_var = transpose2_q_out_var;
+  if (with_scale) {
+    transpose2_q_out_var->assert_is_op_input("scale", "X");
+    auto *scale_op = pattern->NewNode(scale_repr())->assert_is_op("scale");
+    auto *scale_out_var = pattern->NewNode(scale_out_repr())
+                              ->AsIntermediate()
+                              ->assert_is_op_output("scale");
+    scale_op->LinksFrom({transpose2_q_out_var}).LinksTo({scale_out_var});
+    q_var = scale_out_var;
+  }
+  q_var->assert_is_op_input("matmul", "X");
+  transpose2_k_out_var->assert_is_op_input("matmul", "Y");
+  transpose2_v_out_var->assert_is_op_input("matmul", "Y");
+
+  // softmax(q * k^T + bias_qk)
+  auto *matmul_qk_op =
+      pattern->NewNode(matmul_qk_repr())->assert_is_op("matmul");
+  auto *matmul_qk_out_var = pattern->NewNode(matmul_qk_out_repr())
+                                ->AsIntermediate()
+                                ->assert_is_op_output("matmul")
+                                ->assert_is_op_input("elementwise_add", "X");
+  auto *bias_qk_var = pattern->NewNode(bias_qk_repr())
+                          ->AsInput()
+                          ->assert_is_op_input("elementwise_add", "Y");
+  auto *eltadd_qk_op =
+      pattern->NewNode(eltadd_qk_repr())->assert_is_op("elementwise_add");
+  auto *eltadd_qk_out_var = pattern->NewNode(eltadd_qk_out_repr())
+                                ->AsIntermediate()
+                                ->assert_is_op_output("elementwise_add")
+                                ->assert_is_op_input("softmax", "X");
+  auto *softmax_qk_op =
+      pattern->NewNode(softmax_qk_repr())->assert_is_op("softmax");
+  auto *softmax_qk_out_var = pattern->NewNode(softmax_qk_out_repr())
+                                 ->AsIntermediate()
+                                 ->assert_is_op_output("softmax")
+                                 ->assert_is_op_input("matmul", "X");
+
+  // the heads of softmax * v are merged back
+  auto *matmul_qkv_op =
+      pattern->NewNode(matmul_qkv_repr())->assert_is_op("matmul");
+  auto *matmul_qkv_out_var = pattern->NewNode(matmul_qkv_out_repr())
+                                 ->AsIntermediate()
+                                 ->assert_is_op_output("matmul")
+                                 ->assert_is_op_input("transpose2", "X");
+  auto *transpose2_qkv_op =
+      pattern->NewNode(transpose2_qkv_repr())->assert_is_op("transpose2");
+  auto *transpose2_qkv_out_var = pattern->NewNode(transpose2_qkv_out_repr())
+                                     ->AsIntermediate()
+                                     ->assert_is_op_output("transpose2", "Out")
+                                     ->assert_is_op_input("reshape2", "X");
+  auto *reshape2_qkv_op =
+      pattern->NewNode(reshape2_qkv_repr())->assert_is_op("reshape2");
+  auto *reshape2_qkv_out_var = pattern->NewNode(reshape2_qkv_out_repr())
+                                   ->AsOutput()
+                                   ->assert_is_op_output("reshape2", "Out");
+
+  matmul_qk_op->LinksFrom({q_var, transpose2_k_out_var})
+      .LinksTo({matmul_qk_out_var});
+  eltadd_qk_op->LinksFrom({matmul_qk_out_var, bias_qk_var})
+      .LinksTo({eltadd_qk_out_var});
+  softmax_qk_op->LinksFrom({eltadd_qk_out_var}).LinksTo({softmax_qk_out_var});
+  matmul_qkv_op->LinksFrom({softmax_qk_out_var, transpose2_v_out_var})
+      .LinksTo({matmul_qkv_out_var});
+  transpose2_qkv_op->LinksFrom({matmul_qkv_out_var})
+      .LinksTo({transpose2_qkv_out_var});
+  reshape2_qkv_op->LinksFrom({transpose2_qkv_out_var})
+      .LinksTo({reshape2_qkv_out_var});
+  return reshape2_qkv_out_var;
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
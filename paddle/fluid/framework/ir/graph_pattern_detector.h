@@ -1044,6 +1044,60 @@ struct DeleteQuantDequantOpPattern : public PatternBase {
   PATTERN_DECL_NODE(any_op2);
 };
 
+// The scaled dot-product attention of the Transformer and BERT models:
+//
+//   q = transpose2(reshape2(Q + BiasQ)), with k and v likewise
+//   qk = softmax(matmul(scale(q), k, transpose_Y=true) + BiasQK)
+//   Out = reshape2(transpose2(matmul(qk, v)))
+//
+// The scale is optional, the alpha of the first matmul is used otherwise.
+struct MultiHeadMatmul : public PatternBase {
+  MultiHeadMatmul(PDPattern* pattern, const std::string& name_scope)
+      : PatternBase(pattern, name_scope, "multihead_matmul") {}
+
+  PDNode* operator()(bool with_scale);
+
+  PATTERN_DECL_NODE(q);
+  PATTERN_DECL_NODE(k);
+  PATTERN_DECL_NODE(v);
+  PATTERN_DECL_NODE(bias_q);
+  PATTERN_DECL_NODE(bias_k);
+  PATTERN_DECL_NODE(bias_v);
+  PATTERN_DECL_NODE(eltadd_q);
+  PATTERN_DECL_NODE(eltadd_k);
+  PATTERN_DECL_NODE(eltadd_v);
+  PATTERN_DECL_NODE(eltadd_q_out);
+  PATTERN_DECL_NODE(eltadd_k_out);
+  PATTERN_DECL_NODE(eltadd_v_out);
+  PATTERN_DECL_NODE(reshape2_q);
+  PATTERN_DECL_NODE(reshape2_k);
+  PATTERN_DECL_NODE(reshape2_v);
+  PATTERN_DECL_NODE(reshape2_q_out);
+  PATTERN_DECL_NODE(reshape2_k_out);
+  PATTERN_DECL_NODE(reshape2_v_out);
+  PATTERN_DECL_NODE(transpose2_q);
+  PATTERN_DECL_NODE(transpose2_k);
+  PATTERN_DECL_NODE(transpose2_v);
+  PATTERN_DECL_NODE(transpose2_q_out);
+  PATTERN_DECL_NODE(transpose2_k_out);
+  PATTERN_DECL_NODE(transpose2_v_out);
+  PATTERN_DECL_NODE(scale);
+  PATTERN_DECL_NODE(scale_out);
+  PATTERN_DECL_NODE(matmul_qk);
+  PATTERN_DECL_NODE(matmul_qk_out);
+  PATTERN_DECL_NODE(bias_qk);
+  PATTERN_DECL_NODE(eltadd_qk);
+  PATTERN_DECL_NODE(eltadd_qk_out);
+  PATTERN_DECL_NODE(softmax_qk);
+  PATTERN_DECL_NODE(softmax_qk_out);
+  PATTERN_DECL_NODE(matmul_qkv);
+  PATTERN_DECL_NODE(matmul_qkv_out);
+  PATTERN_DECL_NODE(transpose2_qkv);
+  PATTERN_DECL_NODE(transpose2_qkv_out);
+  PATTERN_DECL_NODE(reshape2_qkv);
+  PATTERN_DECL_NODE(reshape2_qkv_out);
+};
+
 }  // namespace patterns
 
 // Link two ir::Nodes from each other.
@@ -0,0 +1,183 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/framework/ir/multihead_matmul_fuse_pass.h"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+template <typename T>
+static T GetAttrOr(const OpDesc* op, const std::string& name, T value) {
+  return op->HasAttr(name) ? boost::get<T>(op->GetAttr(name)) : value;
+}
+
+// The heads are split by reshape2 to [0, 0, head_number, size_per_head] and
+// transpose2 with axis [0, 2, 1, 3], returns the head_number or -1.
+static int SplitHeadNumber(const Node* reshape2, const Node* transpose2) {
+  auto shape = GetAttrOr(reshape2->Op(), "shape", std::vector<int>());
+  auto axis = GetAttrOr(transpose2->Op(), "axis", std::vector<int>());
+  if (shape.size() != 4 || shape[2] <= 0 ||
+      axis != std::vector<int>({0, 2, 1, 3})) {
+    return -1;
+  }
+  return shape[2];
+}
+
+// The bias of Q, K and V is added to the last dimension.
+static bool IsRowBias(const Node* eltadd, const Node* bias) {
+  int axis = GetAttrOr(eltadd->Op(), "axis", -1);
+  return bias->Var() && bias->Var()->GetShape().size() == 1 &&
+         (axis == -1 || axis == 2);
+}
+
+static int BuildFusion(Graph* graph, const std::string& name_scope,
+                       bool with_scale) {
+  GraphPatternDetector gpd;
+  patterns::MultiHeadMatmul pattern(gpd.mutable_pattern(), name_scope);
+  pattern(with_scale);
+
+  int fusion_count{0};
+  auto handler = [&](const GraphPatternDetector::subgraph_t& subgraph,
+                     Graph* g) {
+    GET_IR_NODE_FROM_SUBGRAPH(q, q, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(k, k, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(v, v, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(bias_q, bias_q, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(bias_k, bias_k, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(bias_v, bias_v, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(eltadd_q, eltadd_q, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(eltadd_k, eltadd_k, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(eltadd_v, eltadd_v, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(reshape2_q, reshape2_q, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(reshape2_k, reshape2_k, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(reshape2_v, reshape2_v, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(transpose2_q, transpose2_q, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(transpose2_k, transpose2_k, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(transpose2_v, transpose2_v, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(matmul_qk, matmul_qk, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(bias_qk, bias_qk, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(eltadd_qk, eltadd_qk, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(softmax_qk, softmax_qk, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(matmul_qkv, matmul_qkv, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(transpose2_qkv, transpose2_qkv, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(reshape2_qkv, reshape2_qkv, pattern);
+    GET_IR_NODE_FROM_SUBGRAPH(reshape2_qkv_out, reshape2_qkv_out, pattern);
+
+    // Only the standard attention is fused, the other variants are left
+    // to the unfused ops.
+    int head_number = SplitHeadNumber(reshape2_q, transpose2_q);
+    if (head_number <= 0 ||
+        SplitHeadNumber(reshape2_k, transpose2_k) != head_number ||
+        SplitHeadNumber(reshape2_v, transpose2_v) != head_number) {
+      return;
+    }
+    auto merge_shape =
+        GetAttrOr(reshape2_qkv->Op(), "shape", std::vector<int>());
+    auto merge_axis =
+        GetAttrOr(transpose2_qkv->Op(), "axis", std::vector<int>());
+    if (merge_shape.size() != 3 ||
+        merge_axis != std::vector<int>({0, 2, 1, 3})) {
+      return;
+    }
+    if (!IsRowBias(eltadd_q, bias_q) || !IsRowBias(eltadd_k, bias_k) ||
+        !IsRowBias(eltadd_v, bias_v)) {
+      return;
+    }
+    auto* qk_desc = matmul_qk->Op();
+    auto* qkv_desc = matmul_qkv->Op();
+    if (GetAttrOr(qk_desc, "transpose_X", false) ||
+        !GetAttrOr(qk_desc, "transpose_Y", false) ||
+        GetAttrOr(qkv_desc, "transpose_X", false) ||
+        GetAttrOr(qkv_desc, "transpose_Y", false) ||
+        GetAttrOr(qkv_desc, "alpha", 1.f) != 1.f) {
+      return;
+    }
+    int softmax_axis = GetAttrOr(softmax_qk->Op(), "axis", -1);
+    if (GetAttrOr(eltadd_qk->Op(), "axis", -1) != -1 ||
+        (softmax_axis != -1 && softmax_axis != 3)) {
+      return;
+    }
+    float alpha = GetAttrOr(qk_desc, "alpha", 1.f);
+    if (with_scale) {
+      GET_IR_NODE_FROM_SUBGRAPH(scale, scale, pattern);
+      if (GetAttrOr(scale->Op(), "bias", 0.f) != 0.f) {
+        return;
+      }
+      alpha *= GetAttrOr(scale->Op(), "scale", 1.f);
+    }
+
+    OpDesc desc;
+    desc.SetType("multihead_matmul");
+    desc.SetInput("Q", {q->Name()});
+    desc.SetInput("K", {k->Name()});
+    desc.SetInput("V", {v->Name()});
+    desc.SetInput("BiasQ", {bias_q->Name()});
+    desc.SetInput("BiasK", {bias_k->Name()});
+    desc.SetInput("BiasV", {bias_v->Name()});
+    desc.SetInput("BiasQK", {bias_qk->Name()});
+    desc.SetOutput("Out", {reshape2_qkv_out->Name()});
+    desc.SetAttr("alpha", alpha);
+    desc.SetAttr("head_number", head_number);
+
+    auto* fused_node = g->CreateOpNode(&desc);
+    std::vector<Node*> inputs({q, k, v, bias_q, bias_k, bias_v, bias_qk});
+    for (auto* in : inputs) {
+      IR_NODE_LINK_TO(in, fused_node);
+    }
+    IR_NODE_LINK_TO(fused_node, reshape2_qkv_out);
+
+    std::unordered_set<const Node*> kept_nodes(inputs.begin(), inputs.end());
+    kept_nodes.insert(reshape2_qkv_out);
+    std::unordered_set<const Node*> marked_nodes;
+    for (auto& item : subgraph) {
+      if (!kept_nodes.count(item.second)) {
+        marked_nodes.insert(item.second);
+      }
+    }
+    // the XShape outputs of reshape2 and transpose2 are not in the pattern
+    for (auto* op : {reshape2_q, reshape2_k, reshape2_v, transpose2_q,
+                     transpose2_k, transpose2_v, transpose2_qkv,
+                     reshape2_qkv}) {
+      for (auto* out : op->outputs) {
+        if (!out->outputs.empty()) continue;
+        for (auto& name : op->Op()->Output("XShape")) {
+          if (out->Name() == name) marked_nodes.insert(out);
+        }
+      }
+    }
+    GraphSafeRemoveNodes(g, marked_nodes);
+    ++fusion_count;
+  };
+
+  gpd(graph, handler);
+  return fusion_count;
+}
+
+void MultiHeadMatmulFusePass::ApplyImpl(ir::Graph* graph) const {
+  FusePassBase::Init(name_scope_, graph);
+  int fusion_count = BuildFusion(graph, name_scope_, true /*with_scale*/);
+  fusion_count += BuildFusion(graph, name_scope_, false /*with_scale*/);
+  AddStatis(fusion_count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(multihead_matmul_fuse_pass,
+              paddle::framework::ir::MultiHeadMatmulFusePass);
@@ -0,0 +1,70 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <string>
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+/**
+ * Fuse the multi-head attention of the Transformer and BERT models.
+ *
+ * Before fuse:
+ *       Q                K                V
+ *       |                |                |
+ *  elementwise_add  elementwise_add  elementwise_add
+ *       |                |                |
+ *    reshape2         reshape2         reshape2
+ *       |                |                |
+ *   transpose2       transpose2       transpose2
+ *       |                |                |
+ *    (scale)             |                |
+ *        \              /                 |
+ *         matmul(trans_y)                 |
+ *              |                          |
+ *       elementwise_add(BiasQK)           |
+ *              |                          |
+ *           softmax                       |
+ *                \                       /
+ *                        matmul
+ *                          |
+ *                      transpose2
+ *                          |
+ *                       reshape2
+ *
+ * After fuse:
+ *   Q   K   V
+ *    \  |  /
+ *  multihead_matmul
+ *        |
+ */
+class MultiHeadMatmulFusePass : public FusePassBase {
+ public:
+  virtual ~MultiHeadMatmulFusePass() {}
+
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+
+  const std::string name_scope_{"multihead_matmul_fuse"};
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,113 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/ir/multihead_matmul_fuse_pass.h"
+
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+void TestMain(bool with_scale, std::vector<int> qkv_axis,
+              int num_fused_nodes) {
+  // inputs                           operator            output
+  // --------------------------------------------------------------------
+  // (x, weights_q)                   mul              -> q
+  // (q, bias_q)                      elementwise_add  -> q_bias
+  // (q_bias)                         reshape2         -> q_split
+  // (q_split)                        transpose2       -> q_heads
+  // ... the same for k and v
+  // (q_heads)                        scale            -> q_scaled
+  // (q_scaled, k_heads)              matmul           -> qk
+  // (qk, bias_qk)                    elementwise_add  -> qk_bias
+  // (qk_bias)                        softmax          -> qk_softmax
+  // (qk_softmax, v_heads)            matmul           -> qkv
+  // (qkv)                            transpose2       -> qkv_merge
+  // (qkv_merge)                      reshape2         -> out
+  const int head_number = 12, size_per_head = 64;
+  Layers layers;
+  VarDesc* x = layers.data("x", {1, 128, 768});
+  VarDesc* bias_qk = layers.data("bias_qk", {1, head_number, 128, 128});
+  std::vector<VarDesc*> heads;
+  for (auto& name : {"q", "k", "v"}) {
+    VarDesc* weights =
+        layers.data(std::string("weights_") + name, {768, 768}, true);
+    VarDesc* bias = layers.data(std::string("bias_") + name, {768}, true);
+    VarDesc* out = layers.mul(x, weights);
+    out = layers.elementwise_add(out, bias);
+    out = layers.reshape2(out, {0, 0, head_number, size_per_head});
+    heads.push_back(layers.transpose2(out, {0, 2, 1, 3}));
+  }
+  float alpha = 0.125f;
+  VarDesc* q = heads[0];
+  if (with_scale) {
+    q = layers.scale(q, alpha, 0.f);
+  }
+  VarDesc* qk = layers.matmul(q, heads[1], true, with_scale ? 1.f : alpha);
+  qk = layers.elementwise_add(qk, bias_qk);
+  qk = layers.softmax(qk, -1);
+  VarDesc* qkv = layers.matmul(qk, heads[2]);
+  qkv = layers.transpose2(qkv, qkv_axis);
+  layers.reshape2(qkv, {0, 0, head_number * size_per_head});
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(layers.main_program()));
+  auto pass = PassRegistry::Instance().Get("multihead_matmul_fuse_pass");
+  int num_nodes_before = graph->Nodes().size();
+  VLOG(3) << DebugString(graph);
+
+  graph.reset(pass->Apply(graph.release()));
+  int num_nodes_after = graph->Nodes().size();
+  int num_fused_nodes_after = GetNumOpNodes(graph, "multihead_matmul");
+  VLOG(3) << DebugString(graph);
+
+  EXPECT_EQ(num_fused_nodes_after, num_fused_nodes);
+  if (num_fused_nodes == 0) {
+    EXPECT_EQ(num_nodes_after, num_nodes_before);
+    return;
+  }
+  // The 3 mul ops and their inputs and outputs are kept. The 3 branches
+  // remove 8 nodes each with the XShape of reshape2 and transpose2, the
+  // scale removes 2, the attention removes 8 and the merge removes 5.
+  int num_removed_nodes = 3 * 8 + (with_scale ? 2 : 0) + 8 + 5;
+  EXPECT_EQ(num_nodes_before - num_removed_nodes + 1, num_nodes_after);
+  for (auto* node : graph->Nodes()) {
+    if (node->IsOp() && node->Op()->Type() == "multihead_matmul") {
+      auto* op = node->Op();
+      EXPECT_EQ(boost::get<int>(op->GetAttr("head_number")), head_number);
+      EXPECT_EQ(boost::get<float>(op->GetAttr("alpha")), alpha);
+      EXPECT_EQ(node->inputs.size(), 7UL);
+      EXPECT_EQ(node->outputs.size(), 1UL);
+    }
+  }
+}
+
+TEST(MultiHeadMatmulFusePass, with_scale) {
+  TestMain(true, {0, 2, 1, 3}, 1);
+}
+
+TEST(MultiHeadMatmulFusePass, with_alpha) {
+  TestMain(false, {0, 2, 1, 3}, 1);
+}
+
+TEST(MultiHeadMatmulFusePass, other_merge_axis) {
+  TestMain(true, {0, 1, 2, 3}, 0);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(multihead_matmul_fuse_pass);
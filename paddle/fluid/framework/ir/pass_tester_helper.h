@@ -121,6 +121,50 @@ struct Layers {
     return out;
   }
 
+  VarDesc* scale(VarDesc* x, float scale, float bias) {
+    AttributeMap attrs;
+    attrs["scale"] = scale;
+    attrs["bias"] = bias;
+    return unary_op("scale", x, nullptr, &attrs);
+  }
+
+  VarDesc* softmax(VarDesc* x, int axis = -1) {
+    AttributeMap attrs;
+    attrs["axis"] = axis;
+    return unary_op("softmax", x, nullptr, &attrs);
+  }
+
+  VarDesc* reshape2(VarDesc* x, std::vector<int> shape,
+                    VarDesc* actual_shape = nullptr) {
+    AttributeMap attrs;
+    attrs["shape"] = shape;
+    VarDesc* out = unary_op_with_xshape("reshape2", x, &attrs);
+    if (actual_shape) {
+      OpDesc* op = program_.MutableBlock(0)->AllOps().back();
+      op->SetInput("Shape", {actual_shape->Name()});
+    }
+    return out;
+  }
+
+  VarDesc* transpose2(VarDesc* x, std::vector<int> axis) {
+    AttributeMap attrs;
+    attrs["axis"] = axis;
+    return unary_op_with_xshape("transpose2", x, &attrs);
+  }
+
+  VarDesc* matmul(VarDesc* x, VarDesc* y, bool transpose_y = false,
+                  float alpha = 1.f) {
+    AttributeMap attrs;
+    attrs["transpose_X"] = false;
+    attrs["transpose_Y"] = transpose_y;
+    attrs["alpha"] = alpha;
+    return binary_op("matmul", x, y, nullptr, &attrs);
+  }
+
+  VarDesc* sequence_softmax(VarDesc* x) {
+    return unary_op("sequence_softmax", x);
+  }
+
   VarDesc* concat(std::vector<VarDesc*> inputs, int axis = -1) {
     VarDesc* out = lod_tensor(unique_name());
     OpDesc* op = program_.MutableBlock(0)->AppendOp();
@@ -147,7 +191,8 @@ struct Layers {
     return var;
   }
 
-  VarDesc* unary_op(std::string type, VarDesc* x, VarDesc* out = nullptr) {
+  VarDesc* unary_op(std::string type, VarDesc* x, VarDesc* out = nullptr,
+                    const AttributeMap* attrs = nullptr) {
     if (!out) {
       out = lod_tensor(unique_name());
     }
@@ -155,11 +200,25 @@ struct Layers {
     op->SetType(type);
     op->SetInput("X", {x->Name()});
     op->SetOutput("Out", {out->Name()});
+    if (attrs) {
+      for (auto& iter : *attrs) {
+        op->SetAttr(iter.first, iter.second);
+      }
+    }
     op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
                 static_cast<int>(OpRole::kForward));
     return out;
   }
 
+  VarDesc* unary_op_with_xshape(std::string type, VarDesc* x,
+                                const AttributeMap* attrs) {
+    VarDesc* out = unary_op(type, x, nullptr, attrs);
+    VarDesc* xshape = lod_tensor(unique_name());
+    OpDesc* op = program_.MutableBlock(0)->AllOps().back();
+    op->SetOutput("XShape", {xshape->Name()});
+    return out;
+  }
+
   VarDesc* binary_op(std::string type, VarDesc* x, VarDesc* y,
                      VarDesc* out = nullptr,
                      const AttributeMap* attrs = nullptr) {
@@ -0,0 +1,127 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/ir/shape_signature_cache_pass.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "paddle/fluid/framework/operator.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+// The ops whose InferShape() depends only on the shapes of the inputs and
+// the attributes, mapped to their optional inputs whose data is read as a
+// shape. Such an op is cached only if those inputs are not set. The control
+// flow ops, the sequence ops whose outputs depend on the LoD of the data and
+// the ops reading the data of the inputs in InferShape() are not listed.
+static const std::unordered_map<std::string, std::vector<std::string>>&
+CacheableOps() {
+  static const std::unordered_map<std::string, std::vector<std::string>> ops{
+      {"conv2d", {}},
+      {"depthwise_conv2d", {}},
+      {"conv2d_transpose", {}},
+      {"conv2d_fusion", {}},
+      {"conv3d", {}},
+      {"pool2d", {}},
+      {"pool3d", {}},
+      {"batch_norm", {}},
+      {"layer_norm", {}},
+      {"lrn", {}},
+      {"affine_channel", {}},
+      {"prelu", {}},
+      {"relu", {}},
+      {"relu6", {}},
+      {"leaky_relu", {}},
+      {"brelu", {}},
+      {"elu", {}},
+      {"gelu", {}},
+      {"swish", {}},
+      {"sigmoid", {}},
+      {"hard_sigmoid", {}},
+      {"tanh", {}},
+      {"exp", {}},
+      {"sqrt", {}},
+      {"abs", {}},
+      {"square", {}},
+      {"softplus", {}},
+      {"softsign", {}},
+      {"softmax", {}},
+      {"mul", {}},
+      {"matmul", {}},
+      {"fc", {}},
+      {"elementwise_add", {}},
+      {"elementwise_sub", {}},
+      {"elementwise_mul", {}},
+      {"elementwise_div", {}},
+      {"elementwise_max", {}},
+      {"elementwise_min", {}},
+      {"elementwise_pow", {}},
+      {"scale", {}},
+      {"dropout", {}},
+      {"sum", {}},
+      {"cast", {}},
+      {"mean", {}},
+      {"concat", {}},
+      {"split", {}},
+      {"transpose", {}},
+      {"transpose2", {}},
+      {"flatten", {}},
+      {"flatten2", {}},
+      {"squeeze", {}},
+      {"squeeze2", {}},
+      {"unsqueeze", {}},
+      {"unsqueeze2", {}},
+      {"reshape", {"Shape", "ShapeTensor"}},
+      {"reshape2", {"Shape", "ShapeTensor"}},
+      {"slice",
+       {"StartsTensor", "EndsTensor", "StartsTensorList", "EndsTensorList"}},
+      {"expand", {"ExpandTimes", "expand_times_tensor"}},
+      {"bilinear_interp", {"OutSize"}},
+      {"nearest_interp", {"OutSize"}},
+  };
+  return ops;
+}
+
+static bool IsCacheable(const OpDesc& op) {
+  auto it = CacheableOps().find(op.Type());
+  if (it == CacheableOps().end()) {
+    return false;
+  }
+  for (auto& shape_input : it->second) {
+    auto args = op.Inputs().find(shape_input);
+    if (args != op.Inputs().end() && !args->second.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ShapeSignatureCachePass::ApplyImpl(ir::Graph* graph) const {
+  VLOG(3) << "Applies Shape Signature Cache strategy.";
+  for (const Node* n : graph->Nodes()) {
+    if (n->IsOp() && n->Op() && IsCacheable(*n->Op())) {
+      n->Op()->SetAttr(kEnableCacheShapeSignature, true);
+    }
+  }
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(shape_signature_cache_pass,
+              paddle::framework::ir::ShapeSignatureCachePass);
@@ -0,0 +1,66 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/ir/shape_signature_cache_pass.h"
+
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/framework/operator.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+TEST(ShapeSignatureCachePass, basic) {
+  Layers layers;
+  // (x) -> relu -> (tmp_0)
+  // (tmp_0) -> reshape2 -> (tmp_1)
+  // (tmp_1, shape) -> reshape2 -> (tmp_3)
+  // (tmp_3) -> sequence_softmax -> (tmp_5)
+  auto* x = layers.data("x");
+  auto* shape = layers.data("shape");
+  auto* relu_out = layers.relu(x);
+  auto* reshape_out = layers.reshape2(relu_out, {-1, 8});
+  auto* reshape_with_shape_out = layers.reshape2(reshape_out, {-1, 4}, shape);
+  auto* sequence_softmax_out = layers.sequence_softmax(reshape_with_shape_out);
+
+  std::unique_ptr<Graph> graph(new Graph(layers.main_program()));
+  auto pass = PassRegistry::Instance().Get("shape_signature_cache_pass");
+  graph.reset(pass->Apply(graph.release()));
+
+  int cached_num = 0;
+  for (auto* node : graph->Nodes()) {
+    if (!node->IsOp() || !node->Op()) continue;
+    auto* op = node->Op();
+    bool cached = op->HasAttr(kEnableCacheShapeSignature);
+    auto out = op->Output("Out")[0];
+    VLOG(3) << DebugString(node);
+    if (out == relu_out->Name() || out == reshape_out->Name()) {
+      EXPECT_TRUE(cached) << op->Type();
+      ++cached_num;
+    } else {
+      // the reshape2 reading the data of Shape and the sequence op
+      EXPECT_TRUE(out == reshape_with_shape_out->Name() ||
+                  out == sequence_softmax_out->Name());
+      EXPECT_FALSE(cached) << op->Type();
+    }
+  }
+  EXPECT_EQ(cached_num, 2);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(shape_signature_cache_pass);
@@ -0,0 +1,204 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/local_sgd.h"
+#include <algorithm>
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+namespace paddle {
+namespace framework {
+
+LocalSGD::LocalSGD(int thread_num, int steps, bool bind_numa)
+    : thread_num_(thread_num),
+      steps_(steps),
+      bind_numa_(bind_numa),
+      local_(thread_num),
+      trained_(thread_num, 0),
+      finished_(thread_num, 0) {
+  PADDLE_ENFORCE_GT(thread_num, 0, "The thread_num of local SGD should be > 0");
+  PADDLE_ENFORCE_GT(steps, 0, "The steps of local SGD should be > 0");
+}
+
+std::vector<std::string> LocalSGD::PrivateVars(
+    const BlockDesc &block, const std::unordered_set<std::string> &shared) {
+  std::unordered_set<std::string> written;
+  std::unordered_set<std::string> sparse;
+  for (auto *op : block.AllOps()) {
+    bool reads_selected_rows = false;
+    for (auto &name : op->InputArgumentNames()) {
+      auto *var = block.FindVarRecursive(name);
+      if (var != nullptr && var->GetType() == proto::VarType::SELECTED_ROWS) {
+        reads_selected_rows = true;
+        break;
+      }
+    }
+    for (auto &name : op->OutputArgumentNames()) {
+      written.insert(name);
+      if (reads_selected_rows) sparse.insert(name);
+    }
+  }
+
+  std::vector<std::string> names;
+  for (auto *var : block.AllVars()) {
+    auto name = var->Name();
+    if (!var->Persistable() || var->GetType() != proto::VarType::LOD_TENSOR ||
+        !written.count(name) || sparse.count(name) || shared.count(name)) {
+      continue;
+    }
+    auto type = var->GetDataType();
+    if (type == proto::VarType::FP32 || type == proto::VarType::FP64) {
+      names.push_back(name);
+    }
+  }
+  return names;
+}
+
+void LocalSGD::InitThread(int thread_id, const std::vector<std::string> &names,
+                          Scope *root_scope, Scope *thread_scope) {
+  PADDLE_ENFORCE(thread_id >= 0 && thread_id < thread_num_,
+                 "The thread %d of local SGD is out of [0, %d)", thread_id,
+                 thread_num_);
+  if (bind_numa_) {
+    // the threads are spread over the nodes with CPUs
+    std::vector<int> node_ids;
+    auto nodes = platform::NumaNodeCpus();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (!nodes[i].empty()) node_ids.push_back(i);
+    }
+    int node = node_ids[static_cast<int64_t>(thread_id) * node_ids.size() /
+                        thread_num_];
+    if (!platform::BindCurrentThreadToCpus(nodes[node])) {
+      LOG(WARNING) << "Failed to bind the thread " << thread_id
+                   << " of local SGD to the NUMA node " << node;
+    }
+  }
+
+  auto &local = local_[thread_id];
+  local.clear();
+  std::vector<LoDTensor *> root;
+  for (auto &name : names) {
+    auto *root_var = root_scope->FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(root_var, "Variable %s is not in the root scope",
+                            name);
+    auto *root_tensor = root_var->GetMutable<LoDTensor>();
+    PADDLE_ENFORCE(root_tensor->IsInitialized(),
+                   "Variable %s should be initialized before the training",
+                   name);
+    PADDLE_ENFORCE(platform::is_cpu_place(root_tensor->place()),
+                   "Local SGD only supports the variables on CPU");
+    auto *local_tensor = thread_scope->Var(name)->GetMutable<LoDTensor>();
+    // Allocated and written by this thread, so it is placed on its node.
+    TensorCopySync(*root_tensor, platform::CPUPlace(), local_tensor);
+    root.push_back(root_tensor);
+    local.push_back(local_tensor);
+  }
+  // The others use them after the first barrier.
+  if (thread_id == 0) root_ = std::move(root);
+}
+
+void LocalSGD::Barrier(const std::function<void()> &completion) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (++arrived_ == thread_num_) {
+    completion();
+    arrived_ = 0;
+    ++generation_;
+    cv_.notify_all();
+    return;
+  }
+  int64_t generation = generation_;
+  cv_.wait(lock, [&] { return generation != generation_; });
+}
+
+bool LocalSGD::Round(int thread_id, bool finished) {
+  finished_[thread_id] = finished;
+  Barrier([this] {
+    contributors_.clear();
+    for (int i = 0; i < thread_num_; ++i) {
+      if (trained_[i] > 0) contributors_.push_back(i);
+      trained_[i] = 0;
+    }
+    last_round_ = std::all_of(finished_.begin(), finished_.end(),
+                              [](int f) { return f != 0; });
+    if (!root_reallocated_ && !contributors_.empty()) {
+      ReallocateRoot();
+      root_reallocated_ = true;
+    }
+  });
+  // The completion runs before the others leave the barrier, and nothing
+  // changes the state it sets until all of them arrive at the next one.
+  bool last_round = last_round_;
+  if (contributors_.empty()) return !last_round;
+
+  Average(thread_id);
+  Barrier([] {});
+  if (!finished) {
+    auto &local = local_[thread_id];
+    for (size_t i = 0; i < local.size(); ++i) {
+      TensorCopySync(*root_[i], platform::CPUPlace(), local[i]);
+    }
+  }
+  return !last_round;
+}
+
+void LocalSGD::ReallocateRoot() {
+  for (auto *root : root_) {
+    // Allocated before the former one is released, so it is a new memory
+    // whose pages are not touched yet when it is large.
+    Tensor fresh;
+    fresh.Resize(root->dims());
+    fresh.mutable_data(root->place(), root->type());
+    root->ShareDataWith(fresh);
+  }
+}
+
+template <typename T>
+static void AverageSlice(const std::vector<const T *> &srcs, int64_t begin,
+                         int64_t end, T *dst) {
+  T scale = static_cast<T>(1) / srcs.size();
+  const T *first = srcs[0];
+  for (int64_t j = begin; j < end; ++j) {
+    dst[j] = first[j];
+  }
+  for (size_t s = 1; s < srcs.size(); ++s) {
+    const T *src = srcs[s];
+    for (int64_t j = begin; j < end; ++j) {
+      dst[j] += src[j];
+    }
+  }
+  for (int64_t j = begin; j < end; ++j) {
+    dst[j] *= scale;
+  }
+}
+
+void LocalSGD::Average(int thread_id) {
+  for (size_t i = 0; i < root_.size(); ++i) {
+    int64_t numel = root_[i]->numel();
+    int64_t begin = numel * thread_id / thread_num_;
+    int64_t end = numel * (thread_id + 1) / thread_num_;
+    if (begin == end) continue;
+    if (root_[i]->type() == proto::VarType::FP32) {
+      std::vector<const float *> srcs;
+      for (int c : contributors_) srcs.push_back(local_[c][i]->data<float>());
+      AverageSlice<float>(srcs, begin, end, root_[i]->data<float>());
+    } else {
+      std::vector<const double *> srcs;
+      for (int c : contributors_) srcs.push_back(local_[c][i]->data<double>());
+      AverageSlice<double>(srcs, begin, end, root_[i]->data<double>());
+    }
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,109 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/block_desc.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace framework {
+
+// Local SGD of the threads of a MultiTrainer.
+//
+// Every thread trains private copies of the dense parameters in its thread
+// scope instead of the ones of the root scope, so the threads never write the
+// same cache lines. Every `steps` batches the threads meet and the copies are
+// averaged into the root scope, each thread averaging its own slice of every
+// parameter, then each thread copies the average back to its copies. A thread
+// out of data keeps joining the averaging rounds without training until all
+// the threads are out of data; the last round merges the remaining updates.
+//
+// The copies are allocated and written by their threads, and with bind_numa
+// every thread is bound to the CPUs of a NUMA node it is allowed to run on,
+// so the copies stay on the node of their thread by the first-touch policy.
+// The root copies are reallocated in the first round for their slices to be
+// placed by the averaging threads.
+class LocalSGD {
+ public:
+  LocalSGD(int thread_num, int steps, bool bind_numa);
+
+  int steps() const { return steps_; }
+
+  // The persistable variables of the block trained privately: the FP32 and
+  // FP64 LoDTensors written by an op. The ones written by an op reading a
+  // SelectedRows, like the sparse updates of an embedding, and the shared
+  // ones stay in the root scope.
+  static std::vector<std::string> PrivateVars(
+      const BlockDesc &block, const std::unordered_set<std::string> &shared);
+
+  // Called by every thread before its training. Binds the thread to its NUMA
+  // node and copies the root variables to the ones of the thread scope.
+  void InitThread(int thread_id, const std::vector<std::string> &names,
+                  Scope *root_scope, Scope *thread_scope);
+
+  // Called by every thread after every batch, blocks every `steps` batches
+  // until the variables are averaged.
+  void Step(int thread_id) {
+    if (++trained_[thread_id] % steps_ == 0) Round(thread_id, false);
+  }
+
+  // Called by every thread out of data, blocks until all the threads are.
+  void Finish(int thread_id) {
+    while (Round(thread_id, true)) {
+    }
+  }
+
+ private:
+  // Runs one averaging round, returns false if it is the last one.
+  bool Round(int thread_id, bool finished);
+  // Blocks until all the threads arrive, the last one runs the completion
+  // before the others are released.
+  void Barrier(const std::function<void()> &completion);
+  // Averages the slice of the thread of every variable into the root scope.
+  void Average(int thread_id);
+  // Reallocates the root variables for the first touch of their slices.
+  void ReallocateRoot();
+
+  int thread_num_;
+  int steps_;
+  bool bind_numa_;
+
+  // The root variables, and the copies of them for every thread.
+  std::vector<LoDTensor *> root_;
+  std::vector<std::vector<LoDTensor *>> local_;
+  // The batches trained by every thread since the last round.
+  std::vector<int> trained_;
+  std::vector<int> finished_;
+
+  // Set by the completions of the barriers.
+  std::vector<int> contributors_;
+  bool root_reallocated_{false};
+  bool last_round_{false};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int arrived_{0};
+  int64_t generation_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
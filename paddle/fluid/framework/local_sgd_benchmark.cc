@@ -0,0 +1,191 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Scaling benchmark of the HogwildWorker, compares the threads training the
+// parameters of the root scope with local SGD. Every batch of every layer
+// runs h = x * w, g = x^T * h and the sgd op on w, the throughput is the
+// number of batches per second of all the threads.
+//
+//   ./local_sgd_benchmark --threads=1,2,4,8,16,32,64 --local_sgd_steps=16
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/device_worker.h"
+#include "paddle/fluid/framework/device_worker_factory.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/platform/init.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(threads, "1,2,4,8,16,32,64", "The numbers of threads.");
+DEFINE_int32(layers, 4, "The number of the layers.");
+DEFINE_int32(width, 256, "The width of the layers.");
+DEFINE_int32(batch_size, 8, "The batch size.");
+DEFINE_int32(batches_per_thread, 400, "The number of batches of a thread.");
+DEFINE_int32(local_sgd_steps, 16, "The batches between two averagings.");
+DEFINE_bool(bind_numa, false, "Bind the local SGD threads to NUMA nodes.");
+
+USE_OP(matmul);
+USE_OP(sgd);
+
+namespace paddle {
+namespace framework {
+
+std::vector<int> ParseIntList(const std::string& str) {
+  std::vector<int> res;
+  for (auto& s : string::Split(str, ',')) {
+    res.push_back(std::stoi(s));
+  }
+  return res;
+}
+
+// Repeats the batch of the thread scope.
+class RepeatedBatchFeed : public DataFeed {
+ public:
+  explicit RepeatedBatchFeed(int batches) : batches_(batches) {}
+  void Init(const DataFeedDesc& data_feed_desc) override {}
+  bool Start() override { return true; }
+  int Next() override { return batches_-- > 0 ? FLAGS_batch_size : 0; }
+
+ private:
+  int batches_;
+};
+
+static void AddVar(BlockDesc* block, const std::string& name,
+                   bool persistable) {
+  auto* var = block->Var(name);
+  var->SetType(proto::VarType::LOD_TENSOR);
+  var->SetDataType(proto::VarType::FP32);
+  var->SetPersistable(persistable);
+}
+
+static void BuildProgram(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  AddVar(block, "x", false);
+  AddVar(block, "lr", true);
+  for (int i = 0; i < FLAGS_layers; ++i) {
+    std::string id = std::to_string(i);
+    AddVar(block, "w" + id, true);
+    AddVar(block, "h" + id, false);
+    AddVar(block, "g" + id, false);
+    auto* forward = block->AppendOp();
+    forward->SetType("matmul");
+    forward->SetInput("X", {"x"});
+    forward->SetInput("Y", {"w" + id});
+    forward->SetOutput("Out", {"h" + id});
+    auto* grad = block->AppendOp();
+    grad->SetType("matmul");
+    grad->SetInput("X", {"x"});
+    grad->SetInput("Y", {"h" + id});
+    grad->SetOutput("Out", {"g" + id});
+    grad->SetAttr("transpose_X", true);
+    auto* sgd = block->AppendOp();
+    sgd->SetType("sgd");
+    sgd->SetInput("Param", {"w" + id});
+    sgd->SetInput("Grad", {"g" + id});
+    sgd->SetInput("LearningRate", {"lr"});
+    sgd->SetOutput("ParamOut", {"w" + id});
+  }
+}
+
+static void RandomFill(LoDTensor* tensor, const DDim& dims, float range) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-range, range);
+  float* data = tensor->mutable_data<float>(dims, platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+// returns batches per second
+static double RunOnce(int thread_num, bool local_sgd) {
+  ProgramDesc program;
+  BuildProgram(&program);
+  Scope root_scope;
+  RandomFill(root_scope.Var("lr")->GetMutable<LoDTensor>(), make_ddim({1}),
+             1e-6f);
+  for (int i = 0; i < FLAGS_layers; ++i) {
+    auto* w = root_scope.Var("w" + std::to_string(i))->GetMutable<LoDTensor>();
+    RandomFill(w, make_ddim({FLAGS_width, FLAGS_width}), 0.1f);
+  }
+
+  TrainerDesc desc;
+  desc.set_device_worker_name("HogwildWorker");
+  std::shared_ptr<LocalSGD> shared_local_sgd;
+  if (local_sgd) {
+    desc.mutable_hogwild_param()->set_local_sgd_steps(FLAGS_local_sgd_steps);
+    desc.mutable_hogwild_param()->set_local_sgd_bind_numa(FLAGS_bind_numa);
+    shared_local_sgd = std::make_shared<LocalSGD>(
+        thread_num, FLAGS_local_sgd_steps, FLAGS_bind_numa);
+  }
+  std::vector<std::unique_ptr<RepeatedBatchFeed>> feeds;
+  std::vector<std::shared_ptr<DeviceWorker>> workers;
+  for (int t = 0; t < thread_num; ++t) {
+    feeds.emplace_back(new RepeatedBatchFeed(FLAGS_batches_per_thread));
+    auto worker = DeviceWorkerFactory::CreateDeviceWorker("HogwildWorker");
+    worker->Initialize(desc);
+    worker->SetDeviceIndex(t);
+    worker->SetDataFeed(feeds.back().get());
+    if (local_sgd) worker->SetLocalSGD(shared_local_sgd);
+    worker->SetPlace(platform::CPUPlace());
+    worker->SetRootScope(&root_scope);
+    worker->CreateDeviceResource(program);
+    worker->BindingDataFeedMemory();
+    RandomFill(worker->GetThreadScope()->Var("x")->GetMutable<LoDTensor>(),
+               make_ddim({FLAGS_batch_size, FLAGS_width}), 0.01f);
+    workers.push_back(worker);
+  }
+
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (auto& worker : workers) {
+    threads.emplace_back(&DeviceWorker::TrainFiles, worker.get());
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(thread_num) * FLAGS_batches_per_thread /
+         sec.count();
+}
+
+void Run() {
+  InitDevices(false);
+  LOG(INFO) << FLAGS_layers << " layers of " << FLAGS_width << " x "
+            << FLAGS_batch_size << ", local SGD every "
+            << FLAGS_local_sgd_steps << " batches";
+  for (int threads : ParseIntList(FLAGS_threads)) {
+    double hogwild = RunOnce(threads, false);
+    double local_sgd = RunOnce(threads, true);
+    LOG(INFO) << "threads " << threads << ": hogwild " << hogwild
+              << " batches/s, local SGD " << local_sgd
+              << " batches/s, speedup " << local_sgd / hogwild;
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Run();
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/local_sgd.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace framework {
+
+static void AddVar(BlockDesc* block, const std::string& name,
+                   proto::VarType::Type type, proto::VarType::Type dtype,
+                   bool persistable) {
+  auto* var = block->Var(name);
+  var->SetType(type);
+  var->SetDataType(dtype);
+  var->SetPersistable(persistable);
+}
+
+TEST(LocalSGD, private_vars) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  auto lod_tensor = proto::VarType::LOD_TENSOR;
+  AddVar(block, "w", lod_tensor, proto::VarType::FP32, true);
+  AddVar(block, "w@GRAD", lod_tensor, proto::VarType::FP32, false);
+  AddVar(block, "emb", lod_tensor, proto::VarType::FP32, true);
+  AddVar(block, "emb@GRAD", proto::VarType::SELECTED_ROWS,
+         proto::VarType::FP32, false);
+  AddVar(block, "lr", lod_tensor, proto::VarType::FP32, true);
+  AddVar(block, "step", lod_tensor, proto::VarType::INT64, true);
+  AddVar(block, "counter", lod_tensor, proto::VarType::FP64, true);
+
+  for (auto* param : {"w", "emb"}) {
+    auto* sgd = block->AppendOp();
+    sgd->SetType("sgd");
+    sgd->SetInput("Param", {param});
+    sgd->SetInput("Grad", {std::string(param) + "@GRAD"});
+    sgd->SetInput("LearningRate", {"lr"});
+    sgd->SetOutput("ParamOut", {param});
+  }
+  for (auto* name : {"step", "counter"}) {
+    auto* increment = block->AppendOp();
+    increment->SetType("increment");
+    increment->SetInput("X", {name});
+    increment->SetOutput("Out", {name});
+  }
+
+  // emb is updated sparsely, lr is never written and step is not a float.
+  EXPECT_EQ(LocalSGD::PrivateVars(*block, {}),
+            std::vector<std::string>({"counter", "w"}));
+  EXPECT_EQ(LocalSGD::PrivateVars(*block, {"counter"}),
+            std::vector<std::string>({"w"}));
+}
+
+// Every thread adds thread_id + 1 to its copy of w in every batch.
+static void Train(LocalSGD* local_sgd, int thread_id, int batches,
+                  Scope* root_scope, Scope* thread_scope) {
+  local_sgd->InitThread(thread_id, {"w"}, root_scope, thread_scope);
+  auto* w = thread_scope->FindVar("w")->GetMutable<LoDTensor>();
+  for (int b = 0; b < batches; ++b) {
+    for (int64_t i = 0; i < w->numel(); ++i) {
+      w->data<float>()[i] += thread_id + 1;
+    }
+    local_sgd->Step(thread_id);
+  }
+  local_sgd->Finish(thread_id);
+}
+
+static void TestAverage(const std::vector<int>& batches, int steps,
+                        float expected) {
+  Scope root_scope;
+  auto* w = root_scope.Var("w")->GetMutable<LoDTensor>();
+  platform::CPUPlace place;
+  float* data = w->mutable_data<float>(make_ddim({7, 5}), place);
+  std::fill(data, data + w->numel(), 0.f);
+
+  int thread_num = batches.size();
+  LocalSGD local_sgd(thread_num, steps, false);
+  std::vector<Scope*> thread_scopes;
+  for (int t = 0; t < thread_num; ++t) {
+    thread_scopes.push_back(&root_scope.NewScope());
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back(Train, &local_sgd, t, batches[t], &root_scope,
+                         thread_scopes[t]);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(w->numel(), 35);
+  for (int64_t i = 0; i < w->numel(); ++i) {
+    ASSERT_NEAR(w->data<float>()[i], expected, 1e-5) << i;
+  }
+}
+
+TEST(LocalSGD, average) {
+  // One round of the 4 threads: (2 + 4 + 6 + 8) / 4.
+  TestAverage({2, 2, 2, 2}, 2, 5.f);
+  // The last round merges the batches after the former one: 5 + 1.
+  TestAverage({3, 2, 2, 2}, 2, 6.f);
+  // The thread 3 is out of data from the start and never averaged, the
+  // rounds average 2, 4, 6 to 4, then 4 + 2, 4 + 4, 4 + 6 to 8.
+  TestAverage({4, 4, 4, 0}, 2, 8.f);
+  // The threads run out of data at different rounds.
+  // round 1: (1 + 2 + 3) / 3 = 2, round 2: (3 + 4) / 2 = 3.5,
+  // round 3: 3.5 + 1 = 4.5.
+  TestAverage({3, 2, 1}, 1, 4.5f);
+  TestAverage({5}, 2, 5.f);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,323 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mmap_param_file.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <utility>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace framework {
+
+static_assert(sizeof(MmapParamHeader) == 40,
+              "MmapParamHeader should be packed without padding");
+
+template <typename T>
+static void AppendPod(const T &value, std::string *out) {
+  out->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+MmapParamFileWriter::MmapParamFileWriter(std::ostream *os)
+    : os_(os), offset_(sizeof(MmapParamHeader)) {
+  // the header is written by Finish
+  MmapParamHeader header;
+  std::memset(&header, 0, sizeof(header));
+  os_->write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void MmapParamFileWriter::Append(const std::string &name,
+                                 const LoDTensor &tensor,
+                                 const platform::DeviceContext &dev_ctx) {
+  PADDLE_ENFORCE(!finished_, "Cannot append %s after Finish().", name);
+  const Tensor *cpu_tensor = &tensor;
+  Tensor cpu_copy;
+  if (!platform::is_cpu_place(tensor.place())) {
+    TensorCopySync(tensor, platform::CPUPlace(), &cpu_copy);
+    cpu_tensor = &cpu_copy;
+  }
+
+  uint64_t padding =
+      (kMmapParamAlignment - offset_ % kMmapParamAlignment) %
+      kMmapParamAlignment;
+  static const char kZeros[kMmapParamAlignment] = {0};
+  os_->write(kZeros, padding);
+  offset_ += padding;
+  uint64_t data_offset = offset_;
+  uint64_t data_size = tensor.numel() * SizeOfType(tensor.type());
+  os_->write(static_cast<const char *>(cpu_tensor->data<void>()),
+             static_cast<std::streamsize>(data_size));
+  offset_ += data_size;
+  PADDLE_ENFORCE(static_cast<bool>(*os_), "Failed to write the tensor %s.",
+                 name);
+
+  AppendPod(static_cast<uint32_t>(name.size()), &index_);
+  index_.append(name);
+  AppendPod(static_cast<uint64_t>(tensor.lod().size()), &index_);
+  for (auto &level : tensor.lod()) {
+    AppendPod(static_cast<uint64_t>(level.size() * sizeof(size_t)), &index_);
+    index_.append(reinterpret_cast<const char *>(level.data()),
+                  level.size() * sizeof(size_t));
+  }
+  proto::VarType::TensorDesc desc;
+  desc.set_data_type(tensor.type());
+  auto dims = vectorize(tensor.dims());
+  for (auto dim : dims) {
+    desc.add_dims(dim);
+  }
+  auto desc_str = desc.SerializeAsString();
+  AppendPod(static_cast<int32_t>(desc_str.size()), &index_);
+  index_.append(desc_str);
+  AppendPod(data_offset, &index_);
+  AppendPod(data_size, &index_);
+  ++tensor_num_;
+}
+
+void MmapParamFileWriter::Finish() {
+  PADDLE_ENFORCE(!finished_, "Finish() can only be called once.");
+  finished_ = true;
+  os_->write(index_.data(), static_cast<std::streamsize>(index_.size()));
+
+  MmapParamHeader header;
+  std::memcpy(header.magic, kMmapParamMagic, sizeof(header.magic));
+  header.version = kMmapParamVersion;
+  header.alignment = kMmapParamAlignment;
+  header.tensor_num = tensor_num_;
+  header.index_offset = offset_;
+  header.index_size = index_.size();
+  os_->seekp(0);
+  os_->write(reinterpret_cast<const char *>(&header), sizeof(header));
+  os_->seekp(0, std::ios::end);
+  os_->flush();
+  PADDLE_ENFORCE(static_cast<bool>(*os_),
+                 "Failed to write the combined parameter file.");
+}
+
+// The allocation of a tensor referencing the data of a MmapParamFile, which
+// keeps the file mapped.
+class MmapParamAllocation : public memory::Allocation {
+ public:
+  MmapParamAllocation(void *ptr, size_t size,
+                      std::shared_ptr<const MmapParamFile> file)
+      : Allocation(ptr, size, platform::CPUPlace()), file_(std::move(file)) {}
+
+ private:
+  std::shared_ptr<const MmapParamFile> file_;
+};
+
+std::shared_ptr<MmapParamFile> MmapParamFile::Open(const std::string &path) {
+  std::shared_ptr<MmapParamFile> file(new MmapParamFile());
+#if !defined(_WIN32)
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd, 0, "Cannot open the file %s.", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    PADDLE_THROW("Cannot stat the file %s.", path);
+  }
+  file->size_ = static_cast<size_t>(st.st_size);
+  if (file->size_ > 0) {
+    // Private and writable: the pages are shared through the page cache until
+    // they are written.
+    void *data = mmap(nullptr, file->size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, 0);
+    close(fd);
+    PADDLE_ENFORCE(data != MAP_FAILED, "Cannot mmap the file %s.", path);
+    file->data_ = static_cast<char *>(data);
+    file->mapped_ = true;
+  } else {
+    close(fd);
+  }
+#else
+  std::ifstream fin(path, std::ios::binary);
+  PADDLE_ENFORCE(static_cast<bool>(fin), "Cannot open the file %s.", path);
+  file->buffer_.assign(std::istreambuf_iterator<char>(fin),
+                       std::istreambuf_iterator<char>());
+  file->data_ = &file->buffer_[0];
+  file->size_ = file->buffer_.size();
+#endif
+  file->ParseIndex();
+  return file;
+}
+
+std::shared_ptr<MmapParamFile> MmapParamFile::FromBuffer(std::string buffer) {
+  std::shared_ptr<MmapParamFile> file(new MmapParamFile());
+  file->buffer_ = std::move(buffer);
+  file->data_ = &file->buffer_[0];
+  file->size_ = file->buffer_.size();
+  file->ParseIndex();
+  return file;
+}
+
+bool MmapParamFile::IsMmapParamFile(const std::string &path) {
+  std::ifstream fin(path, std::ios::binary);
+  char magic[sizeof(kMmapParamMagic)];
+  return fin.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, kMmapParamMagic, sizeof(magic)) == 0;
+}
+
+bool MmapParamFile::IsMmapParamBuffer(const std::string &buffer) {
+  return buffer.size() >= sizeof(kMmapParamMagic) &&
+         std::memcmp(buffer.data(), kMmapParamMagic,
+                     sizeof(kMmapParamMagic)) == 0;
+}
+
+MmapParamFile::~MmapParamFile() {
+#if !defined(_WIN32)
+  if (mapped_) {
+    munmap(data_, size_);
+  }
+#endif
+}
+
+// Reads the index with bounds checking.
+class MmapParamIndexReader {
+ public:
+  MmapParamIndexReader(const char *begin, const char *end)
+      : pos_(begin), end_(end) {}
+
+  void Read(void *dst, size_t n) {
+    CheckRemaining(n);
+    std::memcpy(dst, pos_, n);
+    pos_ += n;
+  }
+
+  template <typename T>
+  T Read() {
+    T value;
+    Read(&value, sizeof(T));
+    return value;
+  }
+
+  std::string ReadString(size_t n) {
+    CheckRemaining(n);
+    std::string s(n, '\0');
+    Read(&s[0], n);
+    return s;
+  }
+
+  // Checks the n bytes are in the index, before allocating for them.
+  void CheckRemaining(uint64_t n) const {
+    PADDLE_ENFORCE_LE(n, static_cast<uint64_t>(end_ - pos_),
+                      "The index of the combined parameter file is damaged.");
+  }
+
+ private:
+  const char *pos_;
+  const char *end_;
+};
+
+void MmapParamFile::ParseIndex() {
+  PADDLE_ENFORCE_GE(size_, sizeof(MmapParamHeader),
+                    "The combined parameter file is damaged.");
+  MmapParamHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  PADDLE_ENFORCE(
+      std::memcmp(header.magic, kMmapParamMagic, sizeof(header.magic)) == 0,
+      "It is not a combined parameter file.");
+  PADDLE_ENFORCE_EQ(header.version, kMmapParamVersion,
+                    "The version %d of the combined parameter file is not "
+                    "supported.",
+                    header.version);
+  PADDLE_ENFORCE(header.index_offset <= size_ &&
+                     header.index_size <= size_ - header.index_offset,
+                 "The combined parameter file is damaged.");
+  MmapParamIndexReader reader(data_ + header.index_offset,
+                              data_ + header.index_offset + header.index_size);
+  for (uint64_t i = 0; i < header.tensor_num; ++i) {
+    Entry entry;
+    entry.name = reader.ReadString(reader.Read<uint32_t>());
+    auto &name = entry.name;
+    uint64_t lod_level = reader.Read<uint64_t>();
+    // every level takes at least its size
+    PADDLE_ENFORCE_LE(lod_level, std::numeric_limits<uint64_t>::max() /
+                                     sizeof(uint64_t),
+                      "The LoD of %s is damaged.", name);
+    reader.CheckRemaining(lod_level * sizeof(uint64_t));
+    entry.lod.resize(lod_level);
+    for (auto &level : entry.lod) {
+      uint64_t bytes = reader.Read<uint64_t>();
+      PADDLE_ENFORCE_EQ(bytes % sizeof(size_t), 0UL,
+                        "The LoD of %s is damaged.", name);
+      reader.CheckRemaining(bytes);
+      level.resize(bytes / sizeof(size_t));
+      reader.Read(level.data(), bytes);
+    }
+    proto::VarType::TensorDesc desc;
+    auto desc_str = reader.ReadString(reader.Read<int32_t>());
+    PADDLE_ENFORCE(desc.ParseFromString(desc_str),
+                   "Cannot parse the tensor desc of %s.", name);
+    entry.type = desc.data_type();
+    entry.dims.assign(desc.dims().begin(), desc.dims().end());
+    entry.offset = reader.Read<uint64_t>();
+    entry.size = reader.Read<uint64_t>();
+    PADDLE_ENFORCE(entry.offset <= header.index_offset &&
+                       entry.size <= header.index_offset - entry.offset,
+                   "The data of %s is out of the combined parameter file.",
+                   name);
+    PADDLE_ENFORCE_EQ(entry.size, static_cast<uint64_t>(product(make_ddim(
+                                                           entry.dims))) *
+                                      SizeOfType(entry.type),
+                      "The data size of %s does not match its dims.", name);
+    PADDLE_ENFORCE(indices_.emplace(name, entries_.size()).second,
+                   "The tensor %s is duplicated in the combined parameter "
+                   "file.",
+                   name);
+    entries_.emplace_back(std::move(entry));
+  }
+}
+
+void MmapParamFile::LoadTensor(const std::string &name,
+                               const platform::Place &place,
+                               LoDTensor *tensor) const {
+  auto iter = indices_.find(name);
+  PADDLE_ENFORCE(iter != indices_.end(),
+                 "The tensor %s is not in the combined parameter file.", name);
+  LoadTensor(iter->second, place, tensor);
+}
+
+void MmapParamFile::LoadTensor(size_t i, const platform::Place &place,
+                               LoDTensor *tensor) const {
+  PADDLE_ENFORCE_LT(i, entries_.size(),
+                    "The combined parameter file only has %d tensors.",
+                    entries_.size());
+  auto &entry = entries_[i];
+  auto allocation = std::make_shared<MmapParamAllocation>(
+      data_ + entry.offset, entry.size, shared_from_this());
+  if (platform::is_cpu_place(place)) {
+    tensor->clear();
+    tensor->Resize(make_ddim(entry.dims));
+    tensor->ResetHolderWithType(allocation, entry.type);
+  } else {
+    Tensor cpu_tensor;
+    cpu_tensor.Resize(make_ddim(entry.dims));
+    cpu_tensor.ResetHolderWithType(allocation, entry.type);
+    TensorCopySync(cpu_tensor, place, tensor);
+  }
+  tensor->set_lod(entry.lod);
+}
+
+}  // namespace framework
+}  // namespace paddle
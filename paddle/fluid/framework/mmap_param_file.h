@@ -0,0 +1,137 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace framework {
+
+// The combined parameter file that can be memory mapped. Unlike the stream of
+// SerializeToStream written by save_combine, the data of every tensor is
+// aligned in the file and the descriptions of the tensors are stored in an
+// index, so that the tensors loaded on CPU reference the mapped file directly
+// instead of copying it. The pages of the file are shared by all the
+// processes that load it through the page cache.
+//
+// Layout, all the integers are little endian:
+//
+//   MmapParamHeader
+//   the data of the tensors, every one aligned to header.alignment
+//   the index, for every tensor:
+//     uint32_t name size, the name
+//     uint64_t lod level, for every level: uint64_t size in bytes, the offsets
+//     int32_t  TensorDesc size, the TensorDesc protobuf message
+//     uint64_t data offset in the file, uint64_t data size in bytes
+struct MmapParamHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t alignment;
+  uint64_t tensor_num;
+  uint64_t index_offset;
+  uint64_t index_size;
+};
+
+constexpr char kMmapParamMagic[8] = {'P', 'D', 'P', 'A', 'R', 'A', 'M', '\0'};
+constexpr uint32_t kMmapParamVersion = 1;
+constexpr uint32_t kMmapParamAlignment = 64;
+
+// Writes the tensors to a seekable stream in the format above.
+class MmapParamFileWriter {
+ public:
+  explicit MmapParamFileWriter(std::ostream *os);
+
+  void Append(const std::string &name, const LoDTensor &tensor,
+              const platform::DeviceContext &dev_ctx);
+
+  // Writes the index and the header, must be called once after all the
+  // tensors are appended.
+  void Finish();
+
+ private:
+  std::ostream *os_;
+  uint64_t offset_;
+  uint64_t tensor_num_{0};
+  std::string index_;
+  bool finished_{false};
+
+  DISABLE_COPY_AND_ASSIGN(MmapParamFileWriter);
+};
+
+class MmapParamFile : public std::enable_shared_from_this<MmapParamFile> {
+ public:
+  // Maps the file. Every call maps the file privately, so that the weights
+  // rewritten by a predictor are not seen by the others, while the pages not
+  // written are still shared through the page cache.
+  static std::shared_ptr<MmapParamFile> Open(const std::string &path);
+
+  // The file content that is already in memory, e.g. the params buffer of
+  // AnalysisConfig::SetModelBuffer.
+  static std::shared_ptr<MmapParamFile> FromBuffer(std::string buffer);
+
+  static bool IsMmapParamFile(const std::string &path);
+  static bool IsMmapParamBuffer(const std::string &buffer);
+
+  ~MmapParamFile();
+
+  // The tensors are in the order they were appended.
+  size_t size() const { return entries_.size(); }
+  const std::string &name(size_t i) const { return entries_.at(i).name; }
+  bool Has(const std::string &name) const {
+    return indices_.count(name) != 0;
+  }
+
+  // Loads the i-th tensor. On CPU the tensor references the mapped data, the
+  // mapping is private copy-on-write so that the passes rewriting the weights
+  // in place only copy the pages they modify. On the other places the data is
+  // copied.
+  void LoadTensor(size_t i, const platform::Place &place,
+                  LoDTensor *tensor) const;
+  void LoadTensor(const std::string &name, const platform::Place &place,
+                  LoDTensor *tensor) const;
+
+ private:
+  struct Entry {
+    std::string name;
+    LoD lod;
+    proto::VarType::Type type;
+    std::vector<int64_t> dims;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  MmapParamFile() = default;
+  void ParseIndex();
+
+  char *data_{nullptr};
+  size_t size_{0};
+  // the data is the mapped file or buffer_
+  bool mapped_{false};
+  std::string buffer_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, size_t> indices_;
+
+  DISABLE_COPY_AND_ASSIGN(MmapParamFile);
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,160 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Benchmark of loading the combined parameters saved by save_combine, for the
+// stream of SerializeToStream and for the mmap format (mmap_param_file.h). It
+// loads the parameters `loads` times, like the predictors of a process, and
+// reports the load time and the anonymous and the file backed RSS (from
+// /proc/self/status) after loading and after reading all the weights. The
+// file is in the page cache in both cases.
+//
+//   ./mmap_param_file_benchmark --tensor_num=200 --tensor_size=262144 --loads=4
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/mmap_param_file.h"
+
+DEFINE_int32(tensor_num, 200, "The number of the tensors.");
+DEFINE_int32(tensor_size, 1 << 18, "The number of floats of every tensor.");
+DEFINE_int32(loads, 4, "The number of times the parameters are loaded.");
+DEFINE_string(path, "/tmp/mmap_param_file_benchmark",
+              "The prefix of the parameter files.");
+
+namespace paddle {
+namespace framework {
+
+// RssAnon and RssFile in MB
+static std::pair<double, double> ReadRss() {
+  std::ifstream fin("/proc/self/status");
+  std::string key;
+  double anon = 0, file = 0;
+  while (fin >> key) {
+    if (key == "RssAnon:") {
+      fin >> anon;
+    } else if (key == "RssFile:") {
+      fin >> file;
+    }
+  }
+  return {anon / 1024, file / 1024};
+}
+
+static double Now() {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void Report(const std::string &name, double ms,
+                   std::pair<double, double> base,
+                   std::pair<double, double> loaded,
+                   std::pair<double, double> touched) {
+  LOG(INFO) << name << ": load " << ms << " ms, after loading RssAnon +"
+            << loaded.first - base.first << " MB RssFile +"
+            << loaded.second - base.second
+            << " MB, after reading RssAnon +" << touched.first - base.first
+            << " MB RssFile +" << touched.second - base.second << " MB";
+}
+
+static float ReadAll(const std::vector<LoDTensor> &tensors) {
+  float sum = 0;
+  for (auto &tensor : tensors) {
+    const float *data = tensor.data<float>();
+    for (int64_t i = 0; i < tensor.numel(); i += 1024) {
+      sum += data[i];
+    }
+  }
+  return sum;
+}
+
+void Benchmark() {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  std::string stream_path = FLAGS_path + ".stream";
+  std::string mmap_path = FLAGS_path + ".mmap";
+  {
+    std::ofstream stream_out(stream_path, std::ios::binary);
+    std::ofstream mmap_out(mmap_path, std::ios::binary);
+    MmapParamFileWriter writer(&mmap_out);
+    LoDTensor tensor;
+    float *data =
+        tensor.mutable_data<float>(make_ddim({FLAGS_tensor_size}), place);
+    for (int i = 0; i < FLAGS_tensor_size; ++i) {
+      data[i] = static_cast<float>(i % 97);
+    }
+    for (int i = 0; i < FLAGS_tensor_num; ++i) {
+      SerializeToStream(stream_out, tensor, ctx);
+      writer.Append("param_" + std::to_string(i), tensor, ctx);
+    }
+    writer.Finish();
+  }
+  LOG(INFO) << FLAGS_tensor_num << " tensors of " << FLAGS_tensor_size
+            << " floats, " << FLAGS_loads << " loads";
+
+  float sum = 0;
+  {
+    auto base = ReadRss();
+    double start = Now();
+    std::vector<std::vector<LoDTensor>> loads(FLAGS_loads);
+    for (auto &tensors : loads) {
+      std::ifstream fin(stream_path, std::ios::binary);
+      tensors.resize(FLAGS_tensor_num);
+      for (auto &tensor : tensors) {
+        DeserializeFromStream(fin, &tensor, ctx);
+      }
+    }
+    double ms = Now() - start;
+    auto loaded = ReadRss();
+    for (auto &tensors : loads) {
+      sum += ReadAll(tensors);
+    }
+    Report("stream", ms, base, loaded, ReadRss());
+  }
+  {
+    auto base = ReadRss();
+    double start = Now();
+    std::vector<std::vector<LoDTensor>> loads(FLAGS_loads);
+    for (auto &tensors : loads) {
+      auto file = MmapParamFile::Open(mmap_path);
+      tensors.resize(FLAGS_tensor_num);
+      for (size_t i = 0; i < tensors.size(); ++i) {
+        file->LoadTensor(i, place, &tensors[i]);
+      }
+    }
+    double ms = Now() - start;
+    auto loaded = ReadRss();
+    for (auto &tensors : loads) {
+      sum += ReadAll(tensors);
+    }
+    Report("mmap", ms, base, loaded, ReadRss());
+  }
+  LOG(INFO) << "checksum " << sum;
+  std::remove(stream_path.c_str());
+  std::remove(mmap_path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Benchmark();
+  return 0;
+}
@@ -0,0 +1,175 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mmap_param_file.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+static void WriteTestFile(const std::string &path) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+  std::ofstream fout(path, std::ios::binary);
+  MmapParamFileWriter writer(&fout);
+
+  LoDTensor fc_w;
+  float *w = fc_w.mutable_data<float>(make_ddim({3, 5}), place);
+  for (int i = 0; i < 15; ++i) {
+    w[i] = static_cast<float>(i) * 0.5f;
+  }
+  writer.Append("fc_w", fc_w, ctx);
+
+  LoDTensor ids;
+  ids.set_lod({{0, 1, 3}, {0, 2, 3, 7}});
+  int64_t *id = ids.mutable_data<int64_t>(make_ddim({7, 1}), place);
+  for (int i = 0; i < 7; ++i) {
+    id[i] = i * 100;
+  }
+  writer.Append("ids", ids, ctx);
+
+  LoDTensor flag;
+  flag.mutable_data<int8_t>(make_ddim({1}), place)[0] = 3;
+  writer.Append("flag", flag, ctx);
+  writer.Finish();
+}
+
+TEST(MmapParamFile, save_and_load) {
+  std::string path = "mmap_param_file_test.params";
+  WriteTestFile(path);
+  ASSERT_TRUE(MmapParamFile::IsMmapParamFile(path));
+
+  auto file = MmapParamFile::Open(path);
+  ASSERT_EQ(file->size(), 3UL);
+  ASSERT_EQ(file->name(0), "fc_w");
+  ASSERT_EQ(file->name(2), "flag");
+  ASSERT_TRUE(file->Has("ids"));
+  ASSERT_FALSE(file->Has("bias"));
+
+  platform::CPUPlace place;
+  LoDTensor fc_w, ids, flag;
+  file->LoadTensor("fc_w", place, &fc_w);
+  file->LoadTensor(1, place, &ids);
+  file->LoadTensor("flag", place, &flag);
+
+  ASSERT_EQ(fc_w.type(), proto::VarType::FP32);
+  ASSERT_EQ(fc_w.dims(), make_ddim({3, 5}));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(fc_w.data<float>()) %
+                kMmapParamAlignment,
+            0UL);
+  for (int i = 0; i < 15; ++i) {
+    ASSERT_EQ(fc_w.data<float>()[i], static_cast<float>(i) * 0.5f);
+  }
+
+  ASSERT_EQ(ids.type(), proto::VarType::INT64);
+  ASSERT_EQ(ids.dims(), make_ddim({7, 1}));
+  ASSERT_EQ(ids.lod(), LoD({{0, 1, 3}, {0, 2, 3, 7}}));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(ids.data<int64_t>()) %
+                kMmapParamAlignment,
+            0UL);
+  for (int i = 0; i < 7; ++i) {
+    ASSERT_EQ(ids.data<int64_t>()[i], i * 100);
+  }
+
+  ASSERT_EQ(flag.type(), proto::VarType::INT8);
+  ASSERT_EQ(flag.data<int8_t>()[0], 3);
+
+  // the tensors keep the file mapped
+  file.reset();
+  ASSERT_EQ(fc_w.data<float>()[14], 7.0f);
+
+  // writing a loaded tensor does not change the file or the other mappings
+  auto other = MmapParamFile::Open(path);
+  fc_w.mutable_data<float>(place)[0] = -1.0f;
+  LoDTensor other_fc_w;
+  other->LoadTensor("fc_w", place, &other_fc_w);
+  ASSERT_EQ(other_fc_w.data<float>()[0], 0.0f);
+  other.reset();
+  other = MmapParamFile::Open(path);
+  other->LoadTensor("fc_w", place, &other_fc_w);
+  ASSERT_EQ(other_fc_w.data<float>()[0], 0.0f);
+
+  std::remove(path.c_str());
+}
+
+TEST(MmapParamFile, from_buffer) {
+  std::string path = "mmap_param_file_test_buffer.params";
+  WriteTestFile(path);
+  std::ifstream fin(path, std::ios::binary);
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  std::remove(path.c_str());
+
+  ASSERT_TRUE(MmapParamFile::IsMmapParamBuffer(ss.str()));
+  ASSERT_FALSE(MmapParamFile::IsMmapParamBuffer("PDPARA"));
+  auto file = MmapParamFile::FromBuffer(ss.str());
+  ASSERT_EQ(file->size(), 3UL);
+  LoDTensor ids;
+  file->LoadTensor("ids", platform::CPUPlace(), &ids);
+  file.reset();
+  ASSERT_EQ(ids.lod(), LoD({{0, 1, 3}, {0, 2, 3, 7}}));
+  ASSERT_EQ(ids.data<int64_t>()[6], 600);
+
+  LoDTensor missing;
+  ASSERT_THROW(MmapParamFile::FromBuffer(ss.str())->LoadTensor(
+                   "missing", platform::CPUPlace(), &missing),
+               platform::EnforceNotMet);
+}
+
+TEST(MmapParamFile, damaged) {
+  std::string path = "mmap_param_file_test_damaged.params";
+  WriteTestFile(path);
+  std::ifstream fin(path, std::ios::binary);
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  std::remove(path.c_str());
+  std::string buffer = ss.str();
+
+  // truncated index
+  ASSERT_THROW(MmapParamFile::FromBuffer(buffer.substr(0, buffer.size() - 1)),
+               platform::EnforceNotMet);
+  // truncated header
+  ASSERT_THROW(MmapParamFile::FromBuffer(buffer.substr(0, 16)),
+               platform::EnforceNotMet);
+  // unknown version
+  std::string bad_version = buffer;
+  bad_version[8] = 100;
+  ASSERT_THROW(MmapParamFile::FromBuffer(bad_version), platform::EnforceNotMet);
+  // damaged LoD of ids, its level number and the bytes of its first level
+  // follow its name in the index
+  size_t lod_pos = buffer.rfind("ids") + 3;
+  auto damage_lod = [&](size_t pos, uint64_t value) {
+    std::string damaged = buffer;
+    std::memcpy(&damaged[pos], &value, sizeof(value));
+    return damaged;
+  };
+  ASSERT_THROW(MmapParamFile::FromBuffer(damage_lod(lod_pos, 1ULL << 60)),
+               platform::EnforceNotMet);
+  ASSERT_THROW(MmapParamFile::FromBuffer(damage_lod(lod_pos + 8, 25)),
+               platform::EnforceNotMet);
+  ASSERT_THROW(MmapParamFile::FromBuffer(damage_lod(lod_pos + 8, 1ULL << 40)),
+               platform::EnforceNotMet);
+  // not the format
+  ASSERT_FALSE(MmapParamFile::IsMmapParamFile(path));
+  ASSERT_THROW(MmapParamFile::FromBuffer(std::string(64, 'x')),
+               platform::EnforceNotMet);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,188 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <glog/logging.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace paddle {
+namespace framework {
+
+// A bounded lock-free multi-producer/multi-consumer ring buffer, based on the
+// per-cell sequence number design of Dmitry Vyukov. The capacity is rounded
+// up to a power of two.
+//
+// Every cell carries a sequence number telling which position of the ring it
+// is ready for: a producer may fill the cell of position `pos` when the
+// sequence equals `pos`, and a consumer may take it when the sequence equals
+// `pos + 1`. Producers and consumers only contend on one CAS of the enqueue
+// or dequeue position, and a batch of n values costs one CAS instead of n.
+//
+// TryPush/TryPop never block, they return the number of values moved, which
+// is less than n if the ring is full/empty. Blocking and closing are left to
+// the caller, see ChannelObject.
+template <class T>
+class MpmcRingBuffer {
+ public:
+  explicit MpmcRingBuffer(size_t capacity) {
+    CHECK(capacity >= 1) << "capacity of ring buffer must be >= 1";
+    CHECK(capacity <= (static_cast<size_t>(1) << 40))
+        << "capacity of ring buffer is too large: " << capacity;
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+  }
+
+  MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+  MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  // The number of values in the ring, it is exact only when there are no
+  // concurrent producers or consumers.
+  size_t Size() const {
+    size_t head = dequeue_pos_.load(std::memory_order_acquire);
+    size_t tail = enqueue_pos_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  // Whether the next position to pop has been published by a producer.
+  bool Readable() const {
+    size_t pos = dequeue_pos_.load(std::memory_order_acquire);
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire) ==
+           pos + 1;
+  }
+
+  // Whether the next position to push has been released by a consumer.
+  bool Writable() const {
+    size_t pos = enqueue_pos_.load(std::memory_order_acquire);
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire) ==
+           pos;
+  }
+
+  size_t TryPush(size_t n, const T* p) {
+    return TryPushImpl(n, [p](size_t i, T* dst) { *dst = p[i]; });
+  }
+
+  // the pushed values of p are moved from
+  size_t TryPushMove(size_t n, T* p) {
+    return TryPushImpl(n, [p](size_t i, T* dst) { *dst = std::move(p[i]); });
+  }
+
+  size_t TryPop(size_t n, T* p) {
+    if (n == 0) {
+      return 0;
+    }
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    size_t m = 0;
+    for (;;) {
+      m = 0;
+      while (m < n && Sequence(pos + m) == pos + m + 1) {
+        ++m;
+      }
+      if (m == 0) {
+        intptr_t diff = static_cast<intptr_t>(Sequence(pos) - (pos + 1));
+        if (diff < 0) {
+          return 0;  // empty
+        }
+        // another consumer has taken this position
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + m,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < m; ++i) {
+      Cell& cell = cells_[(pos + i) & mask_];
+      p[i] = std::move(cell.data);
+      cell.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    return m;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  size_t Sequence(size_t pos) const {
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+  }
+
+  template <class Assign>
+  size_t TryPushImpl(size_t n, Assign assign) {
+    if (n == 0) {
+      return 0;
+    }
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    size_t m = 0;
+    for (;;) {
+      m = 0;
+      while (m < n && Sequence(pos + m) == pos + m) {
+        ++m;
+      }
+      if (m == 0) {
+        intptr_t diff = static_cast<intptr_t>(Sequence(pos) - pos);
+        if (diff < 0) {
+          return 0;  // full
+        }
+        // another producer has taken this position
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + m,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < m; ++i) {
+      Cell& cell = cells_[(pos + i) & mask_];
+      assign(i, &cell.data);
+      cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return m;
+  }
+
+  static constexpr size_t kCacheLineSize = 64;
+
+  // keep the positions on their own cache lines to avoid false sharing
+  // between producers and consumers
+  char pad0_[kCacheLineSize];
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  char pad1_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_;
+  char pad2_[kCacheLineSize];
+  std::atomic<size_t> dequeue_pos_;
+  char pad3_[kCacheLineSize];
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,431 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/multi_slot_binary.h"
+#include <zlib.h>
+#include <cstring>
+#include <utility>
+#include "paddle/fluid/framework/data_feed_parser.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+const char kFileMagic[8] = {'P', 'D', 'M', 'S', 'L', 'O', 'T', '\0'};
+const uint32_t kBlockMagic = 0x4B4C4253;  // "SBLK"
+const uint32_t kIndexMagic = 0x58444953;  // "SIDX"
+const uint32_t kVersion = 1;
+
+inline size_t AlignUp8(size_t x) { return (x + 7) & ~static_cast<size_t>(7); }
+
+void AppendColumn(std::string* payload, const void* data, size_t bytes) {
+  payload->append(reinterpret_cast<const char*>(data), bytes);
+  payload->resize(AlignUp8(payload->size()), '\0');
+}
+
+template <typename T>
+const T* ColumnView(const std::string& payload, size_t num, size_t* pos) {
+  PADDLE_ENFORCE(*pos <= payload.size() &&
+                     num <= (payload.size() - *pos) / sizeof(T),
+                 "Corrupted MultiSlot binary block.");
+  size_t bytes = num * sizeof(T);
+  const T* view = reinterpret_cast<const T*>(payload.data() + *pos);
+  *pos += AlignUp8(bytes);
+  return view;
+}
+
+// The offsets of the ins_num instances start from 0 and never decrease, so
+// the last one bounds them all.
+const uint32_t* OffsetsView(const std::string& payload, size_t ins_num,
+                            size_t* pos) {
+  const uint32_t* offsets = ColumnView<uint32_t>(payload, ins_num + 1, pos);
+  PADDLE_ENFORCE_EQ(offsets[0], 0U, "Corrupted MultiSlot binary block.");
+  for (size_t i = 0; i < ins_num; ++i) {
+    PADDLE_ENFORCE_LE(offsets[i], offsets[i + 1],
+                      "Corrupted MultiSlot binary block.");
+  }
+  return offsets;
+}
+
+void CheckSlotType(char type) {
+  PADDLE_ENFORCE(type == 'u' || type == 'f',
+                 "Unknown MultiSlot binary slot type %d.", type);
+}
+}  // namespace
+
+void MultiSlotBinaryBlock::Init(const MultiSlotBinaryMeta& meta) {
+  slot_types_ = meta.slot_types;
+  has_ins_id_ = meta.HasInsId();
+  has_content_ = meta.HasContent();
+  columns_.resize(slot_types_.size());
+  views_.resize(slot_types_.size());
+  Clear();
+}
+
+void MultiSlotBinaryBlock::Clear() {
+  ins_num_ = 0;
+  for (auto& column : columns_) {
+    column.offsets.assign(1, 0);
+    column.uint64_values.clear();
+    column.float_values.clear();
+  }
+  ins_id_column_offsets_.assign(1, 0);
+  ins_id_column_.clear();
+  content_column_offsets_.assign(1, 0);
+  content_column_.clear();
+  payload_.clear();
+}
+
+void MultiSlotBinaryBlock::BeginInstance() {
+  ins_id_.clear();
+  content_.clear();
+}
+
+void MultiSlotBinaryBlock::EndInstance() {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    auto& column = columns_[i];
+    column.offsets.push_back(slot_types_[i] == 'u'
+                                 ? column.uint64_values.size()
+                                 : column.float_values.size());
+  }
+  if (has_ins_id_) {
+    ins_id_column_ += ins_id_;
+    ins_id_column_offsets_.push_back(ins_id_column_.size());
+  }
+  if (has_content_) {
+    content_column_ += content_;
+    content_column_offsets_.push_back(content_column_.size());
+  }
+  ++ins_num_;
+}
+
+void MultiSlotBinaryBlock::Serialize(std::string* payload) const {
+  payload->clear();
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    auto& column = columns_[i];
+    AppendColumn(payload, column.offsets.data(),
+                 column.offsets.size() * sizeof(uint32_t));
+    if (slot_types_[i] == 'u') {
+      AppendColumn(payload, column.uint64_values.data(),
+                   column.uint64_values.size() * sizeof(uint64_t));
+    } else {
+      AppendColumn(payload, column.float_values.data(),
+                   column.float_values.size() * sizeof(float));
+    }
+  }
+  if (has_ins_id_) {
+    AppendColumn(payload, ins_id_column_offsets_.data(),
+                 ins_id_column_offsets_.size() * sizeof(uint32_t));
+    AppendColumn(payload, ins_id_column_.data(), ins_id_column_.size());
+  }
+  if (has_content_) {
+    AppendColumn(payload, content_column_offsets_.data(),
+                 content_column_offsets_.size() * sizeof(uint32_t));
+    AppendColumn(payload, content_column_.data(), content_column_.size());
+  }
+}
+
+void MultiSlotBinaryBlock::Deserialize(std::string&& payload, size_t ins_num) {
+  payload_ = std::move(payload);
+  ins_num_ = ins_num;
+  size_t pos = 0;
+  for (size_t i = 0; i < slot_types_.size(); ++i) {
+    CheckSlotType(slot_types_[i]);
+    auto& view = views_[i];
+    view.offsets = OffsetsView(payload_, ins_num, &pos);
+    size_t value_num = view.offsets[ins_num];
+    if (slot_types_[i] == 'u') {
+      view.uint64_values = ColumnView<uint64_t>(payload_, value_num, &pos);
+      view.float_values = nullptr;
+    } else {
+      view.float_values = ColumnView<float>(payload_, value_num, &pos);
+      view.uint64_values = nullptr;
+    }
+  }
+  if (has_ins_id_) {
+    ins_id_offsets_ = OffsetsView(payload_, ins_num, &pos);
+    ins_id_data_ = ColumnView<char>(payload_, ins_id_offsets_[ins_num], &pos);
+  }
+  if (has_content_) {
+    content_offsets_ = OffsetsView(payload_, ins_num, &pos);
+    content_data_ =
+        ColumnView<char>(payload_, content_offsets_[ins_num], &pos);
+  }
+}
+
+void MultiSlotBinaryCompress(uint32_t codec, int level, const std::string& raw,
+                             std::string* stored) {
+  if (codec == kMultiSlotBinaryNoCompress) {
+    *stored = raw;
+    return;
+  }
+  PADDLE_ENFORCE_EQ(codec, kMultiSlotBinaryZlib, "Unknown codec %d", codec);
+  uLongf stored_size = compressBound(raw.size());
+  stored->resize(stored_size);
+  int ret = compress2(reinterpret_cast<Bytef*>(&(*stored)[0]), &stored_size,
+                      reinterpret_cast<const Bytef*>(raw.data()), raw.size(),
+                      level);
+  PADDLE_ENFORCE_EQ(ret, Z_OK, "zlib compress failed: %d", ret);
+  stored->resize(stored_size);
+}
+
+void MultiSlotBinaryDecompress(uint32_t codec, const std::string& stored,
+                               size_t raw_size, std::string* raw) {
+  if (codec == kMultiSlotBinaryNoCompress) {
+    PADDLE_ENFORCE_EQ(stored.size(), raw_size,
+                      "Corrupted MultiSlot binary block.");
+    *raw = stored;
+    return;
+  }
+  PADDLE_ENFORCE_EQ(codec, kMultiSlotBinaryZlib, "Unknown codec %d", codec);
+  raw->resize(raw_size);
+  uLongf size = raw_size;
+  int ret = uncompress(reinterpret_cast<Bytef*>(&(*raw)[0]), &size,
+                       reinterpret_cast<const Bytef*>(stored.data()),
+                       stored.size());
+  PADDLE_ENFORCE(ret == Z_OK && size == raw_size,
+                 "zlib uncompress failed: %d", ret);
+}
+
+MultiSlotBinaryWriter::MultiSlotBinaryWriter(std::shared_ptr<FILE> fp,
+                                             const MultiSlotBinaryMeta& meta,
+                                             size_t block_ins_num,
+                                             int compress_level)
+    : fp_(fp),
+      meta_(meta),
+      block_ins_num_(block_ins_num),
+      compress_level_(compress_level) {
+  PADDLE_ENFORCE(fp_ != nullptr, "MultiSlotBinaryWriter: file is null.");
+  PADDLE_ENFORCE_GT(block_ins_num_, 0);
+  meta_.version = kVersion;
+  uint32_t slot_num = meta_.slot_types.size();
+  WriteBytes(kFileMagic, sizeof(kFileMagic));
+  WriteBytes(&meta_.version, sizeof(uint32_t));
+  WriteBytes(&slot_num, sizeof(uint32_t));
+  WriteBytes(&meta_.flags, sizeof(uint32_t));
+  WriteBytes(&meta_.codec, sizeof(uint32_t));
+  WriteBytes(meta_.slot_types.data(), slot_num);
+  block_.Init(meta_);
+}
+
+MultiSlotBinaryWriter::~MultiSlotBinaryWriter() {
+  if (!closed_) {
+    Close();
+  }
+}
+
+void MultiSlotBinaryWriter::InstanceAdded() {
+  if (block_.InstanceNum() >= block_ins_num_) {
+    FlushBlock();
+  }
+}
+
+void MultiSlotBinaryWriter::FlushBlock() {
+  if (block_.InstanceNum() == 0) {
+    return;
+  }
+  block_.Serialize(&payload_);
+  MultiSlotBinaryCompress(meta_.codec, compress_level_, payload_, &stored_);
+  MultiSlotBinaryBlockIndex index;
+  index.offset = offset_;
+  index.ins_num = block_.InstanceNum();
+  index.raw_size = payload_.size();
+  index.stored_size = stored_.size();
+  WriteBytes(&kBlockMagic, sizeof(uint32_t));
+  WriteBytes(&index.ins_num, sizeof(uint32_t));
+  WriteBytes(&index.raw_size, sizeof(uint64_t));
+  WriteBytes(&index.stored_size, sizeof(uint64_t));
+  WriteBytes(stored_.data(), stored_.size());
+  index_.push_back(index);
+  block_.Clear();
+}
+
+void MultiSlotBinaryWriter::Close() {
+  FlushBlock();
+  uint64_t index_offset = offset_;
+  uint32_t block_num = index_.size();
+  WriteBytes(&kIndexMagic, sizeof(uint32_t));
+  WriteBytes(&block_num, sizeof(uint32_t));
+  for (auto& index : index_) {
+    WriteBytes(&index.offset, sizeof(uint64_t));
+    WriteBytes(&index.ins_num, sizeof(uint32_t));
+    WriteBytes(&index.raw_size, sizeof(uint64_t));
+    WriteBytes(&index.stored_size, sizeof(uint64_t));
+  }
+  WriteBytes(&index_offset, sizeof(uint64_t));
+  WriteBytes(kFileMagic, sizeof(kFileMagic));
+  fflush(fp_.get());
+  closed_ = true;
+}
+
+void MultiSlotBinaryWriter::WriteBytes(const void* data, size_t size) {
+  PADDLE_ENFORCE_EQ(fwrite(data, 1, size, fp_.get()), size,
+                    "MultiSlotBinaryWriter: fail to write.");
+  offset_ += size;
+}
+
+MultiSlotBinaryReader::MultiSlotBinaryReader(std::shared_ptr<FILE> fp)
+    : fp_(fp) {
+  PADDLE_ENFORCE(fp_ != nullptr, "MultiSlotBinaryReader: file is null.");
+  char magic[sizeof(kFileMagic)];
+  ReadBytes(magic, sizeof(magic));
+  PADDLE_ENFORCE(memcmp(magic, kFileMagic, sizeof(magic)) == 0,
+                 "It is not a MultiSlot binary file.");
+  uint32_t slot_num = 0;
+  ReadBytes(&meta_.version, sizeof(uint32_t));
+  PADDLE_ENFORCE_EQ(meta_.version, kVersion,
+                    "Unsupported MultiSlot binary version %d.", meta_.version);
+  ReadBytes(&slot_num, sizeof(uint32_t));
+  ReadBytes(&meta_.flags, sizeof(uint32_t));
+  ReadBytes(&meta_.codec, sizeof(uint32_t));
+  meta_.slot_types.resize(slot_num);
+  ReadBytes(meta_.slot_types.data(), slot_num);
+  for (char type : meta_.slot_types) {
+    CheckSlotType(type);
+  }
+}
+
+bool MultiSlotBinaryReader::NextBlock(MultiSlotBinaryBlock* block) {
+  if (finished_) {
+    return false;
+  }
+  uint32_t magic = 0;
+  if (fread(&magic, 1, sizeof(uint32_t), fp_.get()) != sizeof(uint32_t)) {
+    // a file without index, e.g. the writer did not close it
+    finished_ = true;
+    return false;
+  }
+  if (magic == kIndexMagic) {
+    finished_ = true;
+    return false;
+  }
+  PADDLE_ENFORCE_EQ(magic, kBlockMagic, "Corrupted MultiSlot binary file.");
+  uint32_t ins_num = 0;
+  uint64_t raw_size = 0;
+  uint64_t stored_size = 0;
+  ReadBytes(&ins_num, sizeof(uint32_t));
+  ReadBytes(&raw_size, sizeof(uint64_t));
+  ReadBytes(&stored_size, sizeof(uint64_t));
+  stored_.resize(stored_size);
+  ReadBytes(&stored_[0], stored_size);
+  std::string raw;
+  MultiSlotBinaryDecompress(meta_.codec, stored_, raw_size, &raw);
+  block->Init(meta_);
+  block->Deserialize(std::move(raw), ins_num);
+  return true;
+}
+
+void MultiSlotBinaryReader::ReadBytes(void* data, size_t size) {
+  PADDLE_ENFORCE_EQ(fread(data, 1, size, fp_.get()), size,
+                    "MultiSlotBinaryReader: unexpected end of file.");
+}
+
+std::vector<MultiSlotBinaryBlockIndex> MultiSlotBinaryReader::ReadBlockIndex(
+    const std::string& filename) {
+  std::unique_ptr<FILE, int (*)(FILE*)> fp(fopen(filename.c_str(), "rb"),
+                                           &fclose);
+  PADDLE_ENFORCE(fp != nullptr, "Fail to open file: %s", filename);
+  auto read = [&](void* data, size_t size) {
+    PADDLE_ENFORCE_EQ(fread(data, 1, size, fp.get()), size,
+                      "Corrupted MultiSlot binary file: %s", filename);
+  };
+  const long footer_size = sizeof(uint64_t) + sizeof(kFileMagic);  // NOLINT
+  uint64_t index_offset = 0;
+  char magic[sizeof(kFileMagic)];
+  PADDLE_ENFORCE_EQ(fseek(fp.get(), -footer_size, SEEK_END), 0,
+                    "MultiSlot binary file %s is too short.", filename);
+  read(&index_offset, sizeof(uint64_t));
+  read(magic, sizeof(magic));
+  PADDLE_ENFORCE(memcmp(magic, kFileMagic, sizeof(magic)) == 0,
+                 "MultiSlot binary file %s has no block index.", filename);
+  PADDLE_ENFORCE_EQ(fseek(fp.get(), index_offset, SEEK_SET), 0);
+  uint32_t index_magic = 0;
+  uint32_t block_num = 0;
+  read(&index_magic, sizeof(uint32_t));
+  PADDLE_ENFORCE_EQ(index_magic, kIndexMagic,
+                    "Corrupted MultiSlot binary file: %s", filename);
+  read(&block_num, sizeof(uint32_t));
+  std::vector<MultiSlotBinaryBlockIndex> indices(block_num);
+  for (auto& index : indices) {
+    read(&index.offset, sizeof(uint64_t));
+    read(&index.ins_num, sizeof(uint32_t));
+    read(&index.raw_size, sizeof(uint64_t));
+    read(&index.stored_size, sizeof(uint64_t));
+  }
+  return indices;
+}
+
+size_t ConvertMultiSlotText(FILE* in, MultiSlotBinaryWriter* writer) {
+  const MultiSlotBinaryMeta& meta = writer->Meta();
+  MultiSlotBinaryBlock* block = writer->CurrentBlock();
+  string::LineFileReader reader;
+  size_t ins_num = 0;
+  while (reader.getline(in)) {
+    const char* line = reader.get();
+    const char* end = line + reader.length();
+    const char* pos = line;
+    SkipTokenSpaces(&pos, end);
+    if (pos == end) {
+      continue;
+    }
+    block->BeginInstance();
+    int32_t num = 0;
+    if (meta.HasInsId()) {
+      PADDLE_ENFORCE(ParseInt32Token(&pos, end, &num) && num == 1,
+                     "Fail to parse ins_id in line: %s", line);
+      SkipTokenSpaces(&pos, end);
+      const char* begin = pos;
+      SkipToken(&pos, end);
+      block->SetInsId(begin, pos - begin);
+    }
+    if (meta.HasContent()) {
+      PADDLE_ENFORCE(ParseInt32Token(&pos, end, &num) && num == 1,
+                     "Fail to parse content in line: %s", line);
+      SkipTokenSpaces(&pos, end);
+      const char* begin = pos;
+      SkipToken(&pos, end);
+      block->SetContent(begin, pos - begin);
+    }
+    for (size_t i = 0; i < meta.slot_types.size(); ++i) {
+      PADDLE_ENFORCE(ParseInt32Token(&pos, end, &num) && num > 0,
+                     "The number of ids can not be zero, please check this "
+                     "error line: %s",
+                     line);
+      if (meta.slot_types[i] == 'u') {
+        for (int j = 0; j < num; ++j) {
+          uint64_t value = 0;
+          PADDLE_ENFORCE(ParseUint64Token(&pos, end, &value),
+                         "Fail to parse uint64 feasign in line: %s", line);
+          block->AppendUint64(i, value);
+        }
+      } else {
+        for (int j = 0; j < num; ++j) {
+          float value = 0;
+          PADDLE_ENFORCE(ParseFloatToken(&pos, end, &value),
+                         "Fail to parse float feasign in line: %s", line);
+          block->AppendFloat(i, value);
+        }
+      }
+    }
+    block->EndInstance();
+    writer->InstanceAdded();
+    ++ins_num;
+  }
+  return ins_num;
+}
+
+}  // namespace framework
+}  // namespace paddle
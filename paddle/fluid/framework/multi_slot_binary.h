@@ -0,0 +1,235 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// MultiSlot binary format, a columnar on-disk format of the MultiSlot text
+// data, so that the data only needs to be parsed once.
+//
+//   file   := header block* index footer
+//   header := "PDMSLOT\0" version:u32 slot_num:u32 flags:u32 codec:u32
+//             slot_type:u8 * slot_num        ('u' for uint64, 'f' for float)
+//   block  := block_magic:u32 ins_num:u32 raw_size:u64 stored_size:u64
+//             payload:u8 * stored_size      (payload is compressed by codec)
+//   index  := index_magic:u32 block_num:u32
+//             (offset:u64 ins_num:u32 raw_size:u64 stored_size:u64) * block_num
+//   footer := index_offset:u64 "PDMSLOT\0"
+//
+// The uncompressed payload of a block holds, for every slot in order, an
+// offset column of (ins_num + 1) uint32 values followed by the feasign
+// column (uint64 or float), and then the ins_id/content columns if the
+// corresponding flags are set. Every column starts at an 8-byte boundary, so
+// the columns can be read in place from the decompressed buffer.
+//
+// A block can be read sequentially from a stream (e.g. a hdfs pipe), the
+// index is only needed for random access of local files.
+
+enum MultiSlotBinaryFlag : uint32_t {
+  kMultiSlotBinaryHasInsId = 1,
+  kMultiSlotBinaryHasContent = 2,
+};
+
+enum MultiSlotBinaryCodec : uint32_t {
+  kMultiSlotBinaryNoCompress = 0,
+  kMultiSlotBinaryZlib = 1,
+};
+
+struct MultiSlotBinaryMeta {
+  uint32_t version{1};
+  uint32_t flags{0};
+  uint32_t codec{kMultiSlotBinaryZlib};
+  // 'u' for uint64 slots and 'f' for float slots, in the order of all slots
+  // in the DataFeedDesc.
+  std::vector<char> slot_types;
+
+  bool HasInsId() const { return flags & kMultiSlotBinaryHasInsId; }
+  bool HasContent() const { return flags & kMultiSlotBinaryHasContent; }
+};
+
+struct MultiSlotBinaryBlockIndex {
+  uint64_t offset;
+  uint32_t ins_num;
+  uint64_t raw_size;
+  uint64_t stored_size;
+};
+
+// One block of instances in columnar layout. On the writer side it is built
+// instance by instance and serialized, on the reader side it is deserialized
+// from a payload and the columns are read in place.
+class MultiSlotBinaryBlock {
+ public:
+  MultiSlotBinaryBlock() {}
+
+  void Init(const MultiSlotBinaryMeta& meta);
+  void Clear();
+
+  size_t InstanceNum() const { return ins_num_; }
+  size_t SlotNum() const { return slot_types_.size(); }
+  char SlotType(size_t slot) const { return slot_types_[slot]; }
+
+  // Builder API, the values of every slot of one instance are appended
+  // between BeginInstance and EndInstance.
+  void BeginInstance();
+  void AppendUint64(size_t slot, uint64_t value) {
+    columns_[slot].uint64_values.push_back(value);
+  }
+  void AppendFloat(size_t slot, float value) {
+    columns_[slot].float_values.push_back(value);
+  }
+  void SetInsId(const char* str, size_t len) { ins_id_.assign(str, len); }
+  void SetContent(const char* str, size_t len) { content_.assign(str, len); }
+  void EndInstance();
+  // Serialize the built columns into an uncompressed payload.
+  void Serialize(std::string* payload) const;
+
+  // Reader API, valid after Deserialize. Offsets(slot)[i] to
+  // Offsets(slot)[i + 1] is the range of the i-th instance in
+  // Uint64Data(slot) or FloatData(slot). Deserialize throws if the slot
+  // types are unknown or the offsets decrease or are out of the payload.
+  void Deserialize(std::string&& payload, size_t ins_num);
+  const uint32_t* Offsets(size_t slot) const { return views_[slot].offsets; }
+  const uint64_t* Uint64Data(size_t slot) const {
+    return views_[slot].uint64_values;
+  }
+  const float* FloatData(size_t slot) const {
+    return views_[slot].float_values;
+  }
+  std::string InsId(size_t ins) const {
+    return std::string(ins_id_data_ + ins_id_offsets_[ins],
+                       ins_id_offsets_[ins + 1] - ins_id_offsets_[ins]);
+  }
+  std::string Content(size_t ins) const {
+    return std::string(content_data_ + content_offsets_[ins],
+                       content_offsets_[ins + 1] - content_offsets_[ins]);
+  }
+
+ private:
+  struct SlotColumn {
+    std::vector<uint32_t> offsets;
+    std::vector<uint64_t> uint64_values;
+    std::vector<float> float_values;
+  };
+  struct SlotView {
+    const uint32_t* offsets{nullptr};
+    const uint64_t* uint64_values{nullptr};
+    const float* float_values{nullptr};
+  };
+
+  std::vector<char> slot_types_;
+  bool has_ins_id_{false};
+  bool has_content_{false};
+  size_t ins_num_{0};
+
+  // builder side
+  std::vector<SlotColumn> columns_;
+  std::vector<uint32_t> ins_id_column_offsets_;
+  std::string ins_id_column_;
+  std::vector<uint32_t> content_column_offsets_;
+  std::string content_column_;
+  std::string ins_id_;
+  std::string content_;
+
+  // reader side, all of the views point into payload_
+  std::string payload_;
+  std::vector<SlotView> views_;
+  const uint32_t* ins_id_offsets_{nullptr};
+  const char* ins_id_data_{nullptr};
+  const uint32_t* content_offsets_{nullptr};
+  const char* content_data_{nullptr};
+};
+
+// Write MultiSlot binary data to a FILE, e.g. one returned by fs_open_write.
+// Instances are built in the current block, and a full block is compressed
+// and written automatically.
+class MultiSlotBinaryWriter {
+ public:
+  MultiSlotBinaryWriter(std::shared_ptr<FILE> fp,
+                        const MultiSlotBinaryMeta& meta,
+                        size_t block_ins_num = 4096,
+                        int compress_level = 1);
+  ~MultiSlotBinaryWriter();
+
+  const MultiSlotBinaryMeta& Meta() const { return meta_; }
+  MultiSlotBinaryBlock* CurrentBlock() { return &block_; }
+  // Called after every EndInstance of CurrentBlock().
+  void InstanceAdded();
+  // Write the last block, the index and the footer.
+  void Close();
+
+  uint64_t BytesWritten() const { return offset_; }
+  const std::vector<MultiSlotBinaryBlockIndex>& BlockIndex() const {
+    return index_;
+  }
+
+ private:
+  void FlushBlock();
+  void WriteBytes(const void* data, size_t size);
+
+  std::shared_ptr<FILE> fp_;
+  MultiSlotBinaryMeta meta_;
+  size_t block_ins_num_;
+  int compress_level_;
+  MultiSlotBinaryBlock block_;
+  std::string payload_;
+  std::string stored_;
+  std::vector<MultiSlotBinaryBlockIndex> index_;
+  uint64_t offset_{0};
+  bool closed_{false};
+};
+
+// Read MultiSlot binary data sequentially from a FILE, e.g. one returned by
+// fs_open_read.
+class MultiSlotBinaryReader {
+ public:
+  explicit MultiSlotBinaryReader(std::shared_ptr<FILE> fp);
+
+  const MultiSlotBinaryMeta& Meta() const { return meta_; }
+  // Read and decompress the next block, returns false at the end of blocks.
+  bool NextBlock(MultiSlotBinaryBlock* block);
+
+  // Read the block index of a local file.
+  static std::vector<MultiSlotBinaryBlockIndex> ReadBlockIndex(
+      const std::string& filename);
+
+ private:
+  void ReadBytes(void* data, size_t size);
+
+  std::shared_ptr<FILE> fp_;
+  MultiSlotBinaryMeta meta_;
+  std::string stored_;
+  bool finished_{false};
+};
+
+// Parse MultiSlot text lines (the format of MultiSlotDataFeed, with the
+// ins_id/content fields if the flags of the writer meta are set) from `in`
+// and add them to `writer`. Returns the number of converted instances.
+size_t ConvertMultiSlotText(FILE* in, MultiSlotBinaryWriter* writer);
+
+// Compress/decompress a block payload with the given codec.
+void MultiSlotBinaryCompress(uint32_t codec, int level, const std::string& raw,
+                             std::string* stored);
+void MultiSlotBinaryDecompress(uint32_t codec, const std::string& stored,
+                               size_t raw_size, std::string* raw);
+
+}  // namespace framework
+}  // namespace paddle
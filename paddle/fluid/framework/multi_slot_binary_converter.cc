@@ -0,0 +1,110 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Convert multi-slot text data into the MultiSlot binary format, which can be
+// fed by MultiSlotBinaryDataFeed and MultiSlotBinaryInMemoryDataFeed.
+//
+//   ./multi_slot_binary_converter --data_feed_desc=data_feed.prototxt \
+//       --input=part-00000 --output=part-00000.bin --pipe_command="cat"
+//
+// The input is read through fs_open_read, so hdfs/afs paths and the
+// pipe_command of the DataFeedDesc (or --pipe_command) work as in training.
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/text_format.h"
+#include "io/fs.h"
+#include "paddle/fluid/framework/data_feed.pb.h"
+#include "paddle/fluid/framework/multi_slot_binary.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/timer.h"
+
+DEFINE_string(data_feed_desc, "", "The DataFeedDesc in protobuf text format.");
+DEFINE_string(input, "", "The multi-slot text file.");
+DEFINE_string(output, "", "The MultiSlot binary file.");
+DEFINE_string(pipe_command, "",
+              "The pipe command of the input, default is the pipe_command "
+              "of the DataFeedDesc.");
+DEFINE_int32(block_ins_num, 4096, "The number of instances in one block.");
+DEFINE_int32(compress_level, 1, "zlib compress level, 0 means no compress.");
+DEFINE_bool(parse_ins_id, false, "Whether the text data contains ins_id.");
+DEFINE_bool(parse_content, false, "Whether the text data contains content.");
+
+namespace paddle {
+namespace framework {
+
+void Convert() {
+  PADDLE_ENFORCE(!FLAGS_data_feed_desc.empty() && !FLAGS_input.empty() &&
+                     !FLAGS_output.empty(),
+                 "--data_feed_desc, --input and --output are required.");
+  DataFeedDesc desc;
+  int fd = open(FLAGS_data_feed_desc.c_str(), O_RDONLY);
+  PADDLE_ENFORCE(fd != -1, "Can not open %s.", FLAGS_data_feed_desc);
+  google::protobuf::io::FileInputStream input(fd);
+  PADDLE_ENFORCE(google::protobuf::TextFormat::Parse(&input, &desc),
+                 "Fail to parse %s.", FLAGS_data_feed_desc);
+  close(fd);
+
+  MultiSlotBinaryMeta meta;
+  for (const auto& slot : desc.multi_slot_desc().slots()) {
+    PADDLE_ENFORCE(slot.type() == "uint64" || slot.type() == "float",
+                   "There is no this type<%s>.", slot.type());
+    meta.slot_types.push_back(slot.type()[0]);
+  }
+  if (FLAGS_parse_ins_id) {
+    meta.flags |= kMultiSlotBinaryHasInsId;
+  }
+  if (FLAGS_parse_content) {
+    meta.flags |= kMultiSlotBinaryHasContent;
+  }
+  meta.codec = FLAGS_compress_level > 0 ? kMultiSlotBinaryZlib
+                                        : kMultiSlotBinaryNoCompress;
+
+  const std::string& pipe_command =
+      FLAGS_pipe_command.empty() ? desc.pipe_command() : FLAGS_pipe_command;
+  int err_no = 0;
+  auto in = fs_open_read(FLAGS_input, &err_no, pipe_command);
+  PADDLE_ENFORCE(in != nullptr, "Fail to open %s.", FLAGS_input);
+  auto out = fs_open_write(FLAGS_output, &err_no, "");
+  PADDLE_ENFORCE(out != nullptr, "Fail to open %s.", FLAGS_output);
+
+  platform::Timer timer;
+  timer.Start();
+  MultiSlotBinaryWriter writer(out, meta, FLAGS_block_ins_num,
+                               FLAGS_compress_level);
+  size_t ins_num = ConvertMultiSlotText(in.get(), &writer);
+  writer.Close();
+  timer.Pause();
+  size_t bytes = writer.BytesWritten();
+  LOG(INFO) << "Converted " << ins_num << " instances in "
+            << writer.BlockIndex().size() << " blocks from " << FLAGS_input
+            << " to " << FLAGS_output << ", " << bytes << " bytes ("
+            << bytes / std::max<size_t>(ins_num, 1)
+            << " bytes/instance), cost " << timer.ElapsedSec() << " seconds";
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Convert();
+  return 0;
+}
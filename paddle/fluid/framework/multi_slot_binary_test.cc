@@ -0,0 +1,165 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/multi_slot_binary.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+static std::shared_ptr<FILE> OpenFile(const std::string& filename,
+                                      const char* mode) {
+  return std::shared_ptr<FILE>(fopen(filename.c_str(), mode), &fclose);
+}
+
+static void TestConvertAndRead(uint32_t codec, size_t block_ins_num) {
+  // slots: uint64, float, uint64
+  std::string text;
+  const int ins_num = 10;
+  for (int i = 0; i < ins_num; ++i) {
+    text += "1 id" + std::to_string(i) + " ";
+    text += std::to_string(i % 3 + 1);
+    for (int j = 0; j <= i % 3; ++j) {
+      text += " " + std::to_string(i * 100 + j + 12345678901ULL);
+    }
+    text += " 2 " + std::to_string(i) + ".5 -" + std::to_string(i) + ".25";
+    text += " 1 " + std::to_string(i) + "\n";
+  }
+  std::string text_file = "multi_slot_binary_test_" +
+                          std::to_string(codec) + ".txt";
+  std::string bin_file = text_file + ".bin";
+  {
+    auto fp = OpenFile(text_file, "w");
+    fwrite(text.data(), 1, text.size(), fp.get());
+  }
+
+  MultiSlotBinaryMeta meta;
+  meta.slot_types = {'u', 'f', 'u'};
+  meta.flags = kMultiSlotBinaryHasInsId;
+  meta.codec = codec;
+  {
+    auto in = OpenFile(text_file, "r");
+    MultiSlotBinaryWriter writer(OpenFile(bin_file, "wb"), meta,
+                                 block_ins_num);
+    EXPECT_EQ(ConvertMultiSlotText(in.get(), &writer),
+              static_cast<size_t>(ins_num));
+    writer.Close();
+    EXPECT_EQ(writer.BlockIndex().size(),
+              (ins_num + block_ins_num - 1) / block_ins_num);
+  }
+
+  auto index = MultiSlotBinaryReader::ReadBlockIndex(bin_file);
+  ASSERT_EQ(index.size(), (ins_num + block_ins_num - 1) / block_ins_num);
+
+  MultiSlotBinaryReader reader(OpenFile(bin_file, "rb"));
+  EXPECT_EQ(reader.Meta().slot_types, meta.slot_types);
+  EXPECT_TRUE(reader.Meta().HasInsId());
+  EXPECT_FALSE(reader.Meta().HasContent());
+  MultiSlotBinaryBlock block;
+  int i = 0;
+  size_t block_id = 0;
+  while (reader.NextBlock(&block)) {
+    ASSERT_LT(block_id, index.size());
+    EXPECT_EQ(block.InstanceNum(), index[block_id++].ins_num);
+    for (size_t ins = 0; ins < block.InstanceNum(); ++ins, ++i) {
+      EXPECT_EQ(block.InsId(ins), "id" + std::to_string(i));
+      const uint32_t* off = block.Offsets(0);
+      ASSERT_EQ(off[ins + 1] - off[ins], static_cast<uint32_t>(i % 3 + 1));
+      for (uint32_t j = 0; j < off[ins + 1] - off[ins]; ++j) {
+        EXPECT_EQ(block.Uint64Data(0)[off[ins] + j],
+                  i * 100 + j + 12345678901ULL);
+      }
+      off = block.Offsets(1);
+      ASSERT_EQ(off[ins + 1] - off[ins], 2U);
+      EXPECT_FLOAT_EQ(block.FloatData(1)[off[ins]], i + 0.5f);
+      EXPECT_FLOAT_EQ(block.FloatData(1)[off[ins] + 1], -i - 0.25f);
+      off = block.Offsets(2);
+      ASSERT_EQ(off[ins + 1] - off[ins], 1U);
+      EXPECT_EQ(block.Uint64Data(2)[off[ins]], static_cast<uint64_t>(i));
+    }
+  }
+  EXPECT_EQ(i, ins_num);
+  EXPECT_FALSE(reader.NextBlock(&block));
+  remove(text_file.c_str());
+  remove(bin_file.c_str());
+}
+
+TEST(MultiSlotBinary, ZlibSingleBlock) {
+  TestConvertAndRead(kMultiSlotBinaryZlib, 4096);
+}
+
+TEST(MultiSlotBinary, ZlibMultiBlocks) {
+  TestConvertAndRead(kMultiSlotBinaryZlib, 3);
+}
+
+TEST(MultiSlotBinary, NoCompress) {
+  TestConvertAndRead(kMultiSlotBinaryNoCompress, 4);
+}
+
+TEST(MultiSlotBinary, CorruptedBlock) {
+  // two instances of a uint64 slot, values {7} and {8, 9}
+  MultiSlotBinaryMeta meta;
+  meta.slot_types = {'u'};
+  MultiSlotBinaryBlock block;
+  block.Init(meta);
+  block.BeginInstance();
+  block.AppendUint64(0, 7);
+  block.EndInstance();
+  block.BeginInstance();
+  block.AppendUint64(0, 8);
+  block.AppendUint64(0, 9);
+  block.EndInstance();
+  std::string payload;
+  block.Serialize(&payload);
+
+  MultiSlotBinaryBlock reader;
+  reader.Init(meta);
+  reader.Deserialize(std::string(payload), 2);
+  EXPECT_EQ(reader.Uint64Data(0)[2], 9U);
+
+  auto set_offset = [&](size_t i, uint32_t value) {
+    std::string corrupted = payload;
+    memcpy(&corrupted[i * sizeof(uint32_t)], &value, sizeof(value));
+    return corrupted;
+  };
+  // decreasing offsets
+  EXPECT_THROW(reader.Deserialize(set_offset(1, 4), 2),
+               platform::EnforceNotMet);
+  // the last offset out of the values
+  EXPECT_THROW(reader.Deserialize(set_offset(2, 1000), 2),
+               platform::EnforceNotMet);
+  // not starting from 0
+  EXPECT_THROW(reader.Deserialize(set_offset(0, 1), 2),
+               platform::EnforceNotMet);
+  // truncated
+  EXPECT_THROW(reader.Deserialize(payload.substr(0, 20), 2),
+               platform::EnforceNotMet);
+  // more instances than the payload
+  EXPECT_THROW(reader.Deserialize(std::string(payload), 1000),
+               platform::EnforceNotMet);
+
+  meta.slot_types = {'x'};
+  reader.Init(meta);
+  EXPECT_THROW(reader.Deserialize(std::string(payload), 2),
+               platform::EnforceNotMet);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <memory>
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/data_feed_factory.h"
@@ -45,6 +46,18 @@ void MultiTrainer::Initialize(const TrainerDesc& trainer_desc,
     workers_[i]->SetDeviceIndex(i);
     workers_[i]->SetDataFeed(readers[i]);
   }
+  const auto& hogwild_param = trainer_desc.hogwild_param();
+  if (trainer_desc.device_worker_name() == "HogwildWorker" &&
+      hogwild_param.local_sgd_steps() > 0) {
+    VLOG(3) << "local SGD of " << thread_num_ << " threads every "
+            << hogwild_param.local_sgd_steps() << " batches";
+    auto local_sgd = std::make_shared<LocalSGD>(
+        thread_num_, hogwild_param.local_sgd_steps(),
+        hogwild_param.local_sgd_bind_numa());
+    for (auto& worker : workers_) {
+      worker->SetLocalSGD(local_sgd);
+    }
+  }
 
   // set debug here
   SetDebug(trainer_desc.debug());
@@ -49,12 +49,23 @@ void NaiveExecutor::Run() {
                              "setting the cmake flag ON_INFER=ON if you are "
                              "running Paddle Inference";
 #endif  // PADDLE_ON_INFERENCE
+  if (activation_arena_) {
+    activation_arena_->Bind();
+  }
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
     op->Run(*scope_, place_);
   }
+  if (activation_arena_ && activation_arena_->NeedPlan()) {
+    activation_arena_->Plan(ops_, scope_);
+  }
+}
+
+void NaiveExecutor::EnableActivationArena(const ProgramDesc &desc,
+                                          int block_id) {
+  activation_arena_.reset(new ActivationArena(desc.Block(block_id), place_));
 }
 
 void NaiveExecutor::CreateVariables(const ProgramDesc &desc, int block_id,
@@ -127,5 +138,15 @@ void NaiveExecutor::CleanFeedFetchOps() {
   ops_.swap(ops);
 }
 
+std::unordered_map<std::string, OpRunStats> NaiveExecutor::GetOpRunStats()
+    const {
+  std::vector<const OperatorBase *> ops;
+  ops.reserve(ops_.size());
+  for (auto &op : ops_) {
+    ops.push_back(op.get());
+  }
+  return CollectOpRunStats(ops);
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "paddle/fluid/framework/activation_arena.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
@@ -44,6 +47,14 @@ class NaiveExecutor {
   void CreateVariables(const ProgramDesc& desc, int block_id, bool persistable,
                        Scope* scope);
 
+  // Packs the temporary variables of the block into one arena, planned after
+  // the next run, see ActivationArena. It should be called after Prepare.
+  void EnableActivationArena(const ProgramDesc& desc, int block_id);
+
+  const ActivationArena* activation_arena() const {
+    return activation_arena_.get();
+  }
+
   // Run all the operators.
   void Run();
 
@@ -54,6 +65,9 @@ class NaiveExecutor {
 
   void CleanFeedFetchOps();
 
+  // The OpRunStats of the ops by op type.
+  std::unordered_map<std::string, OpRunStats> GetOpRunStats() const;
+
  protected:
   void CreateOps(const ProgramDesc& desc, int block_id,
                  bool with_feed_fetch_ops);
@@ -63,6 +77,7 @@ class NaiveExecutor {
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
   Scope* scope_;
+  std::unique_ptr<ActivationArena> activation_arena_;
 };
 
 }  // namespace framework
@@ -0,0 +1,192 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Benchmark of the per-op dispatch cost of OperatorWithKernel. It measures
+// building the RuntimeContext of an op plus the name lookups a small kernel
+// does, for the std::map based VariableValueMap used before and for the flat
+// slot arrays, and the whole Run() of an op with an empty kernel, also with the
+// trace profiler (trace_profiler.h) and the profiler of profiler.h enabled.
+//
+//   ./op_dispatch_benchmark --slots=4 --vars_per_slot=1 --iterations=1000000
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/platform/init.h"
+#include "paddle/fluid/platform/profiler.h"
+#include "paddle/fluid/platform/trace_profiler.h"
+
+DEFINE_int32(slots, 4, "The number of input slots of the op.");
+DEFINE_int32(vars_per_slot, 1, "The number of variables of every slot.");
+DEFINE_int32(iterations, 1000000, "The number of op runs.");
+DEFINE_string(profile_path, "/tmp/op_dispatch_benchmark.profile",
+              "The path of the report of the profiler of profiler.h.");
+
+namespace paddle {
+namespace framework {
+
+class DispatchBenchmarkOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {}
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class DispatchBenchmarkOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "The inputs.").AsDuplicable();
+    AddOutput("Out", "The output.");
+    AddComment("Op with an empty kernel for benchmark.");
+  }
+};
+
+class DispatchBenchmarkKernel : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto xs = ctx.MultiInputVar("X");
+    auto* out = ctx.OutputVar("Out");
+    PADDLE_ENFORCE(!xs.empty() && out != nullptr);
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OPERATOR(dispatch_benchmark, paddle::framework::DispatchBenchmarkOp,
+                  paddle::framework::DispatchBenchmarkOpMaker);
+REGISTER_OP_CPU_KERNEL(dispatch_benchmark,
+                       paddle::framework::DispatchBenchmarkKernel);
+
+namespace paddle {
+namespace framework {
+
+template <typename Fn>
+double NsPerIteration(Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iterations; ++i) {
+    fn();
+  }
+  std::chrono::duration<double, std::nano> ns =
+      std::chrono::steady_clock::now() - start;
+  return ns.count() / FLAGS_iterations;
+}
+
+void Run() {
+  InitDevices(false);
+  Scope scope;
+  VariableNameMap inputs;
+  for (int i = 0; i < FLAGS_slots; ++i) {
+    std::string slot = "Input" + std::to_string(i);
+    for (int j = 0; j < FLAGS_vars_per_slot; ++j) {
+      std::string name = slot + "_" + std::to_string(j);
+      scope.Var(name)->GetMutable<LoDTensor>();
+      inputs[slot].push_back(name);
+    }
+  }
+  scope.Var("out")->GetMutable<LoDTensor>();
+  VariableNameMap outputs = {{"Out", {"out"}}};
+
+  // the context and the lookups of a kernel reading every input slot
+  double map_ns = NsPerIteration([&] {
+    VariableValueMap ins;
+    for (auto& item : inputs) {
+      auto& vars = ins[item.first];
+      vars.reserve(item.second.size());
+      for (auto& name : item.second) {
+        vars.push_back(scope.FindVar(name));
+      }
+    }
+    VariableValueMap outs;
+    outs["Out"].push_back(scope.FindVar("out"));
+    for (auto& item : inputs) {
+      PADDLE_ENFORCE(!ins.find(item.first)->second.empty());
+    }
+    PADDLE_ENFORCE(!outs.find("Out")->second.empty());
+  });
+  auto in_layout = std::make_shared<SlotLayout>(inputs);
+  auto out_layout = std::make_shared<SlotLayout>(outputs);
+  double flat_ns = NsPerIteration([&] {
+    RuntimeContext ctx(in_layout, out_layout, inputs, outputs, scope);
+    for (auto& item : inputs) {
+      PADDLE_ENFORCE(!ctx.inputs.Slot(ctx.inputs.Find(item.first)).empty());
+    }
+    PADDLE_ENFORCE(!ctx.outputs.Slot(ctx.outputs.Find("Out")).empty());
+  });
+  LOG(INFO) << FLAGS_slots << " slots x " << FLAGS_vars_per_slot
+            << " variables, context and lookups: std::map " << map_ns
+            << " ns, flat slots " << flat_ns << " ns";
+
+  platform::CPUPlace place;
+  AttributeMap attrs;
+  auto op = OpRegistry::CreateOp("dispatch_benchmark", {{"X", {"Input0_0"}}},
+                                 outputs, attrs);
+  double run_ns = NsPerIteration([&] { op->Run(scope, place); });
+  attrs[kEnableCacheRuntimeContext] = true;
+  auto cached_op = OpRegistry::CreateOp("dispatch_benchmark",
+                                        {{"X", {"Input0_0"}}}, outputs, attrs);
+  double cached_run_ns = NsPerIteration([&] { cached_op->Run(scope, place); });
+  LOG(INFO) << "Run() of an op with an empty kernel: " << run_ns
+            << " ns, with cached runtime context " << cached_run_ns << " ns";
+
+  // the cost of the recording alone, the whole Run() is too noisy for it
+  uint32_t trace_name_id = platform::InternTraceName("dispatch_benchmark");
+  double event_ns = NsPerIteration(
+      [&] { platform::RecordTraceEvent trace_event(trace_name_id); });
+  LOG(INFO) << "RecordTraceEvent with the trace profiler disabled: "
+            << event_ns << " ns";
+  for (int sample_period : {1, 16}) {
+    platform::TraceProfilerConfig config;
+    config.sample_period = sample_period;
+    platform::EnableTraceProfiler(config);
+    event_ns = NsPerIteration(
+        [&] { platform::RecordTraceEvent trace_event(trace_name_id); });
+    platform::TakeTraceSnapshot();
+    double trace_ns = NsPerIteration([&] { op->Run(scope, place); });
+    platform::DisableTraceProfiler();
+    auto stats =
+        platform::AggregateTraceSnapshot(platform::TakeTraceSnapshot());
+    LOG(INFO) << "RecordTraceEvent with the trace profiler, sample period "
+              << sample_period << ": " << event_ns << " ns";
+    LOG(INFO) << "Run() with the trace profiler, sample period "
+              << sample_period << ": " << trace_ns << " ns, overhead "
+              << trace_ns - run_ns << " ns\n"
+              << platform::TraceEventStatsToString(stats);
+  }
+  platform::EnableProfiler(platform::ProfilerState::kCPU);
+  double profile_ns = NsPerIteration([&] { op->Run(scope, place); });
+  platform::DisableProfiler(platform::EventSortingKey::kDefault,
+                            FLAGS_profile_path);
+  LOG(INFO) << "Run() with the profiler: " << profile_ns << " ns, overhead "
+            << profile_ns - run_ns << " ns";
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Run();
+  return 0;
+}
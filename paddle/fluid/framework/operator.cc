@@ -30,6 +30,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/platform/profiler.h"
+#include "paddle/fluid/platform/trace_profiler.h"
 
 DECLARE_bool(benchmark);
 DECLARE_bool(check_nan_inf);
@@ -141,25 +142,52 @@ static LoD GetLoDDebug(const Scope& scope, const std::string& name) {
   }
 }
 
-RuntimeContext::RuntimeContext(const VariableNameMap& innames,
-                               const VariableNameMap& outnames,
-                               const Scope& scope) {
-  for (auto& var_name_item : innames) {
-    std::vector<Variable*>& input_vars = inputs[var_name_item.first];
-    input_vars.reserve(var_name_item.second.size());
-    for (auto& var_name : var_name_item.second) {
-      input_vars.push_back(scope.FindVar(var_name));
+constexpr size_t SlotLayout::kNotFound;
+
+size_t SlotLayout::Find(const std::string& name) const {
+  // An operator has only a few slots, a linear scan comparing the lengths
+  // first is faster than the tree walk of std::map.
+  for (size_t i = 0; i < names_.size(); ++i) {
+    if (names_[i].size() == name.size() && names_[i] == name) {
+      return i;
     }
   }
-  for (auto& var_name_item : outnames) {
-    std::vector<Variable*>& output_vars = outputs[var_name_item.first];
-    output_vars.reserve(var_name_item.second.size());
+  return kNotFound;
+}
+
+SlotVariableMap::SlotVariableMap(std::shared_ptr<const SlotLayout> layout,
+                                 const VariableNameMap& names,
+                                 const Scope& scope)
+    : SlotVariableMap(std::move(layout)) {
+  PADDLE_ENFORCE_EQ(names.size(), layout_->SlotNum(),
+                    "The slots do not match the layout");
+  Variable** var = vars_.data();
+  size_t slot = 0;
+  for (auto& var_name_item : names) {
+    PADDLE_ENFORCE_EQ(var_name_item.second.size(), layout_->Size(slot++),
+                      "The variables of slot %s do not match the layout",
+                      var_name_item.first);
     for (auto& var_name : var_name_item.second) {
-      output_vars.push_back(scope.FindVar(var_name));
+      *var++ = scope.FindVar(var_name);
     }
   }
 }
 
+SlotVariableMap::SlotVariableMap(const VariableValueMap& vars)
+    : SlotVariableMap(std::make_shared<SlotLayout>(vars)) {
+  Variable** var = vars_.data();
+  for (auto& var_item : vars) {
+    var = std::copy(var_item.second.begin(), var_item.second.end(), var);
+  }
+}
+
+RuntimeContext::RuntimeContext(const VariableNameMap& innames,
+                               const VariableNameMap& outnames,
+                               const Scope& scope)
+    : RuntimeContext(std::make_shared<SlotLayout>(innames),
+                     std::make_shared<SlotLayout>(outnames), innames,
+                     outnames, scope) {}
+
 void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
   try {
     VLOG(4) << place << " " << DebugStringEx(&scope);
@@ -176,6 +204,7 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
     // issue
     // in concurrency scenerio. Here use an `if` to fix this issue.
     // Please not remove the `if`, ask @Superjomn if there are any concern.
+    platform::RecordTraceEvent trace_event(trace_name_id_);
     if (platform::IsProfileEnabled()) {
       platform::RecordEvent record_event(Type());
       RunImpl(scope, place);
@@ -312,7 +341,8 @@ OperatorBase::OperatorBase(const std::string& type,
       outputs_(outputs),
       attrs_(attrs),
       // NOTE(zjl): why op_info may be nullptr?
-      info_(OpInfoMap::Instance().GetNullable(type)) {
+      info_(OpInfoMap::Instance().GetNullable(type)),
+      trace_name_id_(platform::InternTraceName(type)) {
   GenerateTemporaryNames();
   CheckAllInputOutputSet();
 }
@@ -442,23 +472,25 @@ bool ExecutionContext::HasOutput(const std::string& name) const {
 }
 
 const Variable* ExecutionContext::InputVar(const std::string& name) const {
-  auto it = ctx_.inputs.find(name);
-  if (it == ctx_.inputs.end()) return nullptr;
+  size_t slot = ctx_.inputs.Find(name);
+  if (slot == SlotLayout::kNotFound) return nullptr;
 
-  PADDLE_ENFORCE_LE(it->second.size(), 1UL,
+  auto vars = ctx_.inputs.Slot(slot);
+  PADDLE_ENFORCE_LE(vars.size(), 1UL,
                     "Operator %s's input %s should contain only one variable.",
                     op_.Type(), name);
-  return it->second.empty() ? nullptr : it->second[0];
+  return vars.empty() ? nullptr : vars[0];
 }
 
 Variable* ExecutionContext::OutputVar(const std::string& name) const {
-  auto it = ctx_.outputs.find(name);
-  if (it == ctx_.outputs.end()) return nullptr;
+  size_t slot = ctx_.outputs.Find(name);
+  if (slot == SlotLayout::kNotFound) return nullptr;
 
-  PADDLE_ENFORCE_LE(it->second.size(), 1UL,
+  auto vars = ctx_.outputs.Slot(slot);
+  PADDLE_ENFORCE_LE(vars.size(), 1UL,
                     "Operator %s's output %s should contain only one variable.",
                     op_.Type(), name);
-  return it->second.empty() ? nullptr : it->second[0];
+  return vars.empty() ? nullptr : vars[0];
 }
 
 template <>
@@ -469,11 +501,11 @@ const Tensor* ExecutionContext::Input<Tensor>(const std::string& name) const {
 template <>
 const std::vector<const Tensor*> ExecutionContext::MultiInput<Tensor>(
     const std::string& name) const {
-  auto it = ctx_.inputs.find(name);
-  if (it == ctx_.inputs.end()) {
+  size_t slot = ctx_.inputs.Find(name);
+  if (slot == SlotLayout::kNotFound) {
     return {};
   }
-  const std::vector<Variable*>& vars = it->second;
+  auto vars = ctx_.inputs.Slot(slot);
   std::vector<const Tensor*> res;
   res.reserve(vars.size());
   std::transform(vars.begin(), vars.end(), std::back_inserter(res),
@@ -496,11 +528,11 @@ Tensor* ExecutionContext::Output<Tensor>(const std::string& name) const {
 template <>
 std::vector<Tensor*> ExecutionContext::MultiOutput<Tensor>(
     const std::string& name) const {
-  auto it = ctx_.outputs.find(name);
-  if (it == ctx_.outputs.end()) {
+  size_t slot = ctx_.outputs.Find(name);
+  if (slot == SlotLayout::kNotFound) {
     return {};
   }
-  const std::vector<Variable*>& vars = it->second;
+  auto vars = ctx_.outputs.Slot(slot);
   std::vector<Tensor*> res;
   res.reserve(vars.size());
   std::transform(vars.begin(), vars.end(), std::back_inserter(res),
@@ -535,11 +567,11 @@ class RuntimeInferShapeContext : public InferShapeContext {
   bool HasInput(const std::string& name) const override {
     // has only one input
     const auto& ins = ctx_.inputs;
-    auto it = ins.find(name);
-    if (it == ins.end()) {
+    size_t slot = ins.Find(name);
+    if (slot == SlotLayout::kNotFound) {
       return false;
     }
-    const auto& in = it->second;
+    auto in = ins.Slot(slot);
     if (in.size() == 0) return false;
     PADDLE_ENFORCE_EQ(in.size(), 1UL,
                       "Input %s should not have more than one inputs", name);
@@ -549,11 +581,11 @@ class RuntimeInferShapeContext : public InferShapeContext {
   bool HasOutput(const std::string& name) const override {
     // has only one output
     const auto& outs = ctx_.outputs;
-    auto it = outs.find(name);
-    if (it == outs.end()) {
+    size_t slot = outs.Find(name);
+    if (slot == SlotLayout::kNotFound) {
       return false;
     }
-    const auto& out = it->second;
+    auto out = outs.Slot(slot);
     if (out.size() == 0) {
       return false;
     }
@@ -564,11 +596,11 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
   bool HasInputs(const std::string& name) const override {
     const auto& ins = ctx_.inputs;
-    auto it = ins.find(name);
-    if (it == ins.end() || it->second.empty()) {
+    size_t slot = ins.Find(name);
+    if (slot == SlotLayout::kNotFound || ins.Slot(slot).empty()) {
       return false;
     }
-    for (auto& input : it->second) {
+    for (auto* input : ins.Slot(slot)) {
       if (input == nullptr) {
         return false;
       }
@@ -578,11 +610,11 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
   bool HasOutputs(const std::string& name) const override {
     const auto& outs = ctx_.outputs;
-    auto it = outs.find(name);
-    if (it == outs.end() || it->second.empty()) {
+    size_t slot = outs.Find(name);
+    if (slot == SlotLayout::kNotFound || outs.Slot(slot).empty()) {
       return false;
     }
-    for (auto& output : it->second) {
+    for (auto* output : outs.Slot(slot)) {
       if (output == nullptr) {
         return false;
       }
@@ -604,15 +636,15 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
   void ShareDim(const std::string& in, const std::string& out, size_t i = 0,
                 size_t j = 0) override {
-    auto in_it = ctx_.inputs.find(in);
-    auto out_it = ctx_.outputs.find(out);
-    PADDLE_ENFORCE(in_it != ctx_.inputs.end() && in_it->second.size() > i,
-                   "Inputs %s should have %llu argument", in, i);
-    PADDLE_ENFORCE(out_it != ctx_.outputs.end() && out_it->second.size() > j,
-                   "Outputs %s should have %llu argument", out, j);
+    auto in_vars = FindVars(ctx_.inputs, in);
+    auto out_vars = FindVars(ctx_.outputs, out);
+    PADDLE_ENFORCE(in_vars.size() > i, "Inputs %s should have %llu argument",
+                   in, i);
+    PADDLE_ENFORCE(out_vars.size() > j, "Outputs %s should have %llu argument",
+                   out, j);
 
-    Variable* in_var = in_it->second[i];
-    Variable* out_var = out_it->second[j];
+    Variable* in_var = in_vars[i];
+    Variable* out_var = out_vars[j];
 
     PADDLE_ENFORCE(in_var->Type() == out_var->Type(),
                    "The type of %s and %s is not the same.", in, out);
@@ -636,16 +668,16 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
   void ShareLoD(const std::string& in, const std::string& out, size_t i = 0,
                 size_t j = 0) const override {
-    auto in_it = ctx_.inputs.find(in);
-    auto out_it = ctx_.outputs.find(out);
-    PADDLE_ENFORCE(in_it != ctx_.inputs.end() && in_it->second.size() > i,
-                   "Inputs %s should have %llu argument", in, i);
-    PADDLE_ENFORCE(out_it != ctx_.outputs.end() && out_it->second.size() > j,
-                   "Outputs %s should have %llu argument", out, j);
-
-    Variable* in_var = in_it->second.at(i);
+    auto in_vars = FindVars(ctx_.inputs, in);
+    auto out_vars = FindVars(ctx_.outputs, out);
+    PADDLE_ENFORCE(in_vars.size() > i, "Inputs %s should have %llu argument",
+                   in, i);
+    PADDLE_ENFORCE(out_vars.size() > j, "Outputs %s should have %llu argument",
+                   out, j);
+
+    Variable* in_var = in_vars.at(i);
     if (!in_var->IsType<LoDTensor>()) return;
-    Variable* out_var = out_it->second.at(j);
+    Variable* out_var = out_vars.at(j);
     PADDLE_ENFORCE(out_var->IsType<LoDTensor>(),
                    "The %d-th output of Output(%s) must be LoDTensor.", j, out);
     auto& in_tensor = in_var->Get<LoDTensor>();
@@ -683,7 +715,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
   // TODO(paddle-dev): Can this be template?
   std::vector<InferShapeVarPtr> GetInputVarPtrs(
       const std::string& name) override {
-    const std::vector<Variable*>& vars = InputVars(name);
+    auto vars = InputVars(name);
     std::vector<InferShapeVarPtr> res;
     res.reserve(vars.size());
     res.insert(res.begin(), vars.begin(), vars.end());
@@ -692,7 +724,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
   std::vector<InferShapeVarPtr> GetOutputVarPtrs(
       const std::string& name) override {
-    const std::vector<Variable*>& vars = OutputVars(name);
+    auto vars = OutputVars(name);
     std::vector<InferShapeVarPtr> res;
     res.reserve(vars.size());
     res.insert(res.begin(), vars.begin(), vars.end());
@@ -700,7 +732,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
   }
 
   DDim GetInputDim(const std::string& name) const override {
-    const std::vector<Variable*>& vars = InputVars(name);
+    auto vars = InputVars(name);
     PADDLE_ENFORCE_EQ(vars.size(), 1UL,
                       "Input(%s) should hold one element, but now it holds %d",
                       name, vars.size());
@@ -708,8 +740,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
   }
 
   std::vector<DDim> GetInputsDim(const std::string& name) const override {
-    const std::vector<Variable*>& vars = InputVars(name);
-    return GetDims(vars);
+    return GetDims(InputVars(name));
   }
 
   std::vector<proto::VarType::Type> GetInputsVarType(
@@ -723,7 +754,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
   }
 
   void SetOutputDim(const std::string& name, const DDim& dim) override {
-    auto& vars = OutputVars(name);
+    auto vars = OutputVars(name);
     PADDLE_ENFORCE_EQ(vars.size(), 1UL,
                       "Output(%s) should hold one element, but now it holds %d",
                       name, vars.size());
@@ -732,8 +763,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
   void SetOutputsDim(const std::string& name,
                      const std::vector<DDim>& dims) override {
-    auto& vars = OutputVars(name);
-    SetDims(vars, dims);
+    SetDims(OutputVars(name), dims);
   }
 
  protected:
@@ -751,7 +781,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
     }
   }
 
-  std::vector<DDim> GetDims(const std::vector<Variable*>& vars) const {
+  std::vector<DDim> GetDims(VariableSpan vars) const {
     std::vector<DDim> ret;
     ret.reserve(vars.size());
     std::transform(vars.begin(), vars.end(), std::back_inserter(ret),
@@ -774,8 +804,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
     }
   }
 
-  void SetDims(const std::vector<Variable*>& vars,
-               const std::vector<DDim>& dims) {
+  void SetDims(VariableSpan vars, const std::vector<DDim>& dims) {
     size_t length = vars.size();
     PADDLE_ENFORCE_EQ(length, dims.size());
     for (size_t i = 0; i < length; ++i) {
@@ -791,8 +820,7 @@ class RuntimeInferShapeContext : public InferShapeContext {
     PADDLE_THROW("Only compile time support this method");
   }
 
-  std::vector<proto::VarType::Type> GetVarTypes(
-      const std::vector<Variable*>& vars) const {
+  std::vector<proto::VarType::Type> GetVarTypes(VariableSpan vars) const {
     std::vector<proto::VarType::Type> retv;
     retv.resize(vars.size());
     std::transform(vars.begin(), vars.end(), retv.begin(),
@@ -806,19 +834,26 @@ class RuntimeInferShapeContext : public InferShapeContext {
   }
 
  private:
-  const std::vector<Variable*>& InputVars(const std::string& name) const {
-    auto it = ctx_.inputs.find(name);
-    PADDLE_ENFORCE(it != ctx_.inputs.end(),
+  // the variables of the slot, or empty if there is no such slot
+  static VariableSpan FindVars(const SlotVariableMap& vars,
+                               const std::string& name) {
+    size_t slot = vars.Find(name);
+    return slot == SlotLayout::kNotFound ? VariableSpan() : vars.Slot(slot);
+  }
+
+  VariableSpan InputVars(const std::string& name) const {
+    size_t slot = ctx_.inputs.Find(name);
+    PADDLE_ENFORCE(slot != SlotLayout::kNotFound,
                    "Operator %s does not have the input %s.", op_.Type(), name);
-    return it->second;
+    return ctx_.inputs.Slot(slot);
   }
 
-  const std::vector<Variable*>& OutputVars(const std::string& name) const {
-    auto it = ctx_.outputs.find(name);
-    PADDLE_ENFORCE(it != ctx_.outputs.end(),
+  VariableSpan OutputVars(const std::string& name) const {
+    size_t slot = ctx_.outputs.Find(name);
+    PADDLE_ENFORCE(slot != SlotLayout::kNotFound,
                    "Operator %s does not have the outputs %s.", op_.Type(),
                    name);
-    return it->second;
+    return ctx_.outputs.Slot(slot);
   }
 
   const OperatorBase& op_;
@@ -867,15 +902,19 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   if (!all_kernels_must_compute_runtime_shape_ &&
       HasAttr(kAllKernelsMustComputeRuntimeShape))
     all_kernels_must_compute_runtime_shape_ = true;
+  if (!enable_cache_shape_signature_ && HasAttr(kEnableCacheShapeSignature))
+    enable_cache_shape_signature_ = true;
   if (!enable_cache_runtime_context_) {
-    RuntimeContext ctx(Inputs(), Outputs(), scope);
+    RuntimeContext ctx(input_layout_, output_layout_, Inputs(), Outputs(),
+                       scope);
     RunImpl(scope, place, &ctx);
   } else {
     const Scope* cur_scope = &scope;
     if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
       std::lock_guard<std::mutex> lock(cache_update_mutex_);
       if (runtime_ctx_.get() == nullptr || pre_scope_ != cur_scope) {
-        runtime_ctx_.reset(new RuntimeContext(Inputs(), Outputs(), scope));
+        runtime_ctx_.reset(new RuntimeContext(
+            input_layout_, output_layout_, Inputs(), Outputs(), scope));
         pre_scope_ = cur_scope;
       }
     }
@@ -895,10 +934,40 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
 
   std::vector<KernelConfig>* kernel_configs = GetKernelConfig(*kernel_type_);
 
+  // If the variables match the signature of the last run, neither the data
+  // transform nor InferShape could change anything.
+  bool signature_matched = false;
+  if (enable_cache_shape_signature_) {
+    signature_matched =
+        shape_signature_valid_ &&
+        MatchSignature(runtime_ctx->inputs, true, input_signature_) &&
+        (all_kernels_must_compute_runtime_shape_ ||
+         MatchSignature(runtime_ctx->outputs, false, output_signature_));
+    if (!signature_matched) {
+      shape_signature_valid_ =
+          RecordSignature(runtime_ctx->inputs, true, &input_signature_);
+    }
+    ++run_stats_.run_count;
+    if (signature_matched) {
+      ++run_stats_.prepare_data_skip_count;
+      if (!all_kernels_must_compute_runtime_shape_) {
+        ++run_stats_.infer_shape_skip_count;
+      }
+    } else {
+      ++run_stats_.prepare_data_count;
+      if (!all_kernels_must_compute_runtime_shape_) {
+        ++run_stats_.infer_shape_count;
+      }
+    }
+  }
+
   // do data transformScope &transfer_scope;
   std::vector<std::string> transfered_inplace_vars;
-  auto* transfer_scope =
-      PrepareData(scope, *kernel_type_, &transfered_inplace_vars, runtime_ctx);
+  Scope* transfer_scope = nullptr;
+  if (!signature_matched) {
+    transfer_scope = PrepareData(scope, *kernel_type_,
+                                 &transfered_inplace_vars, runtime_ctx);
+  }
 
   // exec scope is the scope that kernel actually executed on.
   const Scope& exec_scope =
@@ -908,10 +977,16 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
     dev_ctx = pool.Get(kernel_type_->place_);
   }
 
-  if (!all_kernels_must_compute_runtime_shape_) {
+  if (!all_kernels_must_compute_runtime_shape_ && !signature_matched) {
     RuntimeInferShapeContext infer_shape_ctx(*this, exec_scope, *runtime_ctx);
     this->InferShape(&infer_shape_ctx);
   }
+  if (enable_cache_shape_signature_ && !signature_matched) {
+    // the transformed inputs are in a new scope every run
+    shape_signature_valid_ =
+        shape_signature_valid_ && transfer_scope == nullptr &&
+        RecordSignature(runtime_ctx->outputs, false, &output_signature_);
+  }
   // TODO(panyx0718): ExecutionContext should only depend on RuntimeContext
   // not Scope. Imperative mode only pass inputs and get outputs.
   (*kernel_func_)(ExecutionContext(*this, exec_scope, *dev_ctx, *runtime_ctx,
@@ -967,6 +1042,96 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 }
 
+bool OperatorWithKernel::RecordSignature(
+    const SlotVariableMap& vars, bool with_data,
+    std::vector<VarSignature>* signature) const {
+  signature->resize(vars.Layout().VarNum());
+  size_t i = 0;
+  for (size_t slot = 0; slot < vars.Layout().SlotNum(); ++slot) {
+    for (auto* var : vars.Slot(slot)) {
+      auto& var_signature = (*signature)[i++];
+      var_signature.var = var;
+      if (var == nullptr) {
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        return false;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      var_signature.dims = tensor.dims();
+      if (var_signature.lod != tensor.lod()) {
+        var_signature.lod = tensor.lod();
+      }
+      if (!with_data) {
+        continue;
+      }
+      var_signature.initialized = tensor.IsInitialized();
+      if (var_signature.initialized) {
+        var_signature.type = tensor.type();
+        var_signature.layout = tensor.layout();
+        var_signature.place = tensor.place();
+#ifdef PADDLE_WITH_MKLDNN
+        var_signature.format = tensor.format();
+#endif
+      }
+    }
+  }
+  return true;
+}
+
+bool OperatorWithKernel::MatchSignature(
+    const SlotVariableMap& vars, bool with_data,
+    const std::vector<VarSignature>& signature) const {
+  size_t i = 0;
+  for (size_t slot = 0; slot < vars.Layout().SlotNum(); ++slot) {
+    for (auto* var : vars.Slot(slot)) {
+      auto& var_signature = signature[i++];
+      if (var != var_signature.var) {
+        return false;
+      }
+      if (var == nullptr) {
+        continue;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      if (tensor.dims() != var_signature.dims ||
+          tensor.lod() != var_signature.lod) {
+        return false;
+      }
+      if (!with_data) {
+        continue;
+      }
+      if (tensor.IsInitialized() != var_signature.initialized) {
+        return false;
+      }
+      if (var_signature.initialized &&
+          (tensor.type() != var_signature.type ||
+           tensor.layout() != var_signature.layout ||
+           !platform::is_same_place(tensor.place(), var_signature.place))) {
+        return false;
+      }
+#ifdef PADDLE_WITH_MKLDNN
+      if (var_signature.initialized &&
+          tensor.format() != var_signature.format) {
+        return false;
+      }
+#endif
+    }
+  }
+  return true;
+}
+
+std::unordered_map<std::string, OpRunStats> CollectOpRunStats(
+    const std::vector<const OperatorBase*>& ops) {
+  std::unordered_map<std::string, OpRunStats> stats;
+  for (auto* op : ops) {
+    auto* op_with_kernel = dynamic_cast<const OperatorWithKernel*>(op);
+    if (op_with_kernel != nullptr) {
+      stats[op->Type()] += op_with_kernel->RunStats();
+    }
+  }
+  return stats;
+}
+
 void OperatorWithKernel::ChooseKernel(const RuntimeContext& ctx,
                                       const Scope& scope,
                                       const platform::Place& place) const {
@@ -1054,7 +1219,11 @@ Scope* OperatorWithKernel::PrepareData(
       continue;
     }
 
-    std::vector<Variable*>& input_vars = ctx->inputs[var_name_item.first];
+    size_t slot = ctx->inputs.Find(var_name_item.first);
+    PADDLE_ENFORCE(slot != SlotLayout::kNotFound,
+                   "Operator %s does not have the input %s.", type_,
+                   var_name_item.first);
+    Variable** input_vars = ctx->inputs.MutableSlot(slot);
 
     for (size_t i = 0; i < var_name_item.second.size(); ++i) {
       auto& var_name = var_name_item.second[i];
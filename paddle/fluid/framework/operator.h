@@ -81,6 +81,19 @@ constexpr char kEnableCacheRuntimeContext[] = "@ENABLE_CACHE_RUNTIME_CONTEXT@";
 constexpr char kAllKernelsMustComputeRuntimeShape[] =
     "@ALL_KERNELS_MUST_COMPUTE_RUNTIME_SHAPE@";
 
+/// If an Op has attribute kEnableCacheShapeSignature, OperatorWithKernel
+/// records the signature of its variables in a run: the dims, LoD, data type,
+/// layout and place of the inputs before the run, and the dims and LoD of the
+/// outputs after InferShape(). In the later runs, if the variables match the
+/// signature, OperatorWithKernel::RunImpl() skips InferShape() and the data
+/// transform checks of PrepareData(), e.g. for inference with fixed shapes.
+/// The ops whose runtime InferShape() reads the data of the inputs should not
+/// have this attribute, shape_signature_cache_pass sets it only on the listed
+/// ops known not to. The signature is kept in the op without synchronization,
+/// so an op with this attribute must not be run by several threads at the
+/// same time, as the executors and the cloned predictors do not.
+constexpr char kEnableCacheShapeSignature[] = "@ENABLE_CACHE_SHAPE_SIGNATURE@";
+
 // define some kernel priority
 /* Define multiple kernel type fallback order*/
 extern std::vector<std::tuple<platform::Place, LibraryType>> kKernelPriority;
@@ -109,17 +122,117 @@ Tensor* GetMutableLoDTensorOrSelectedRowsValueFromVar(Variable* var);
 class OperatorBase;
 class ExecutionContext;
 
+/// SlotLayout resolves the input (or output) slot names of an operator to
+/// dense indices. The variables of the i-th slot are stored in the range
+/// [Offset(i), Offset(i + 1)) of a flat Variable* array, so that an operator
+/// resolves its slots once and a RuntimeContext is only two flat arrays.
+class SlotLayout {
+ public:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  // MapType is VariableNameMap or VariableValueMap.
+  template <typename MapType>
+  explicit SlotLayout(const MapType& slots) {
+    names_.reserve(slots.size());
+    offsets_.reserve(slots.size() + 1);
+    offsets_.push_back(0);
+    for (auto& slot : slots) {
+      names_.push_back(slot.first);
+      offsets_.push_back(offsets_.back() + slot.second.size());
+    }
+  }
+
+  size_t SlotNum() const { return names_.size(); }
+  size_t VarNum() const { return offsets_.back(); }
+
+  const std::string& Name(size_t slot) const { return names_[slot]; }
+  size_t Offset(size_t slot) const { return offsets_[slot]; }
+  size_t Size(size_t slot) const {
+    return offsets_[slot + 1] - offsets_[slot];
+  }
+
+  // Returns the index of the slot, or kNotFound.
+  size_t Find(const std::string& name) const;
+
+ private:
+  std::vector<std::string> names_;
+  std::vector<size_t> offsets_;
+};
+
+/// The variables of a slot, a view of the flat array of a SlotVariableMap.
+class VariableSpan {
+ public:
+  VariableSpan() = default;
+  VariableSpan(Variable* const* data, size_t size)
+      : data_(data), size_(size) {}
+
+  Variable* const* begin() const { return data_; }
+  Variable* const* end() const { return data_ + size_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  Variable* operator[](size_t i) const { return data_[i]; }
+  Variable* at(size_t i) const {
+    PADDLE_ENFORCE_LT(i, size_, "Index out of range");
+    return data_[i];
+  }
+
+ private:
+  Variable* const* data_{nullptr};
+  size_t size_{0};
+};
+
+/// The variables of all of the input (or output) slots of an operator.
+class SlotVariableMap {
+ public:
+  explicit SlotVariableMap(std::shared_ptr<const SlotLayout> layout)
+      : layout_(std::move(layout)), vars_(layout_->VarNum(), nullptr) {}
+
+  // names must be the map the layout is built from.
+  SlotVariableMap(std::shared_ptr<const SlotLayout> layout,
+                  const VariableNameMap& names, const Scope& scope);
+
+  explicit SlotVariableMap(const VariableValueMap& vars);
+
+  const SlotLayout& Layout() const { return *layout_; }
+
+  size_t Find(const std::string& name) const { return layout_->Find(name); }
+  bool Has(const std::string& name) const {
+    return Find(name) != SlotLayout::kNotFound;
+  }
+
+  VariableSpan Slot(size_t slot) const {
+    return VariableSpan(vars_.data() + layout_->Offset(slot),
+                        layout_->Size(slot));
+  }
+  Variable** MutableSlot(size_t slot) {
+    return vars_.data() + layout_->Offset(slot);
+  }
+
+ private:
+  std::shared_ptr<const SlotLayout> layout_;
+  std::vector<Variable*> vars_;
+};
+
 class RuntimeContext {
  public:
   RuntimeContext(const VariableNameMap& innames,
                  const VariableNameMap& outnames, const Scope& scope);
 
+  // Use the slot layouts resolved by an operator, innames and outnames must
+  // be the maps the layouts are built from.
+  RuntimeContext(const std::shared_ptr<const SlotLayout>& in_layout,
+                 const std::shared_ptr<const SlotLayout>& out_layout,
+                 const VariableNameMap& innames,
+                 const VariableNameMap& outnames, const Scope& scope)
+      : inputs(in_layout, innames, scope),
+        outputs(out_layout, outnames, scope) {}
+
   RuntimeContext(const VariableValueMap& invars,
                  const VariableValueMap& outvars)
       : inputs(invars), outputs(outvars) {}
 
-  VariableValueMap inputs;
-  VariableValueMap outputs;
+  SlotVariableMap inputs;
+  SlotVariableMap outputs;
 };
 
 /**
@@ -205,6 +318,9 @@ class OperatorBase {
   // OpInfo
   const OpInfo* info_;
 
+  // The interned type of the events of the trace profiler.
+  uint32_t trace_name_id_;
+
   // Whether this operator executes in an Executor.
   bool run_by_executor_{true};
 
@@ -269,20 +385,21 @@ class ExecutionContext {
 
   const std::vector<const Variable*> MultiInputVar(
       const std::string& name) const {
-    auto it = ctx_.inputs.find(name);
-    if (it == ctx_.inputs.end()) {
+    size_t slot = ctx_.inputs.Find(name);
+    if (slot == SlotLayout::kNotFound) {
       return {};
     }
-    return {it->second.begin(), it->second.end()};
+    auto vars = ctx_.inputs.Slot(slot);
+    return {vars.begin(), vars.end()};
   }
 
   std::vector<Variable*> MultiOutputVar(const std::string& name) const {
-    auto names = op_.Outputs(name);
-    auto it = ctx_.outputs.find(name);
-    if (it == ctx_.outputs.end()) {
+    size_t slot = ctx_.outputs.Find(name);
+    if (slot == SlotLayout::kNotFound) {
       return {};
     }
-    return it->second;
+    auto vars = ctx_.outputs.Slot(slot);
+    return {vars.begin(), vars.end()};
   }
 
   template <typename T>
@@ -299,11 +416,11 @@ class ExecutionContext {
 
   template <typename T>
   const std::vector<const T*> MultiInput(const std::string& name) const {
-    auto it = ctx_.inputs.find(name);
-    if (it == ctx_.inputs.end()) {
+    size_t slot = ctx_.inputs.Find(name);
+    if (slot == SlotLayout::kNotFound) {
       return {};
     }
-    const std::vector<Variable*>& vars = it->second;
+    auto vars = ctx_.inputs.Slot(slot);
     std::vector<const T*> res;
     res.reserve(vars.size());
     std::transform(vars.begin(), vars.end(), std::back_inserter(res),
@@ -315,11 +432,11 @@ class ExecutionContext {
 
   template <typename T>
   std::vector<T*> MultiOutput(const std::string& name) const {
-    auto it = ctx_.outputs.find(name);
-    if (it == ctx_.outputs.end()) {
+    size_t slot = ctx_.outputs.Find(name);
+    if (slot == SlotLayout::kNotFound) {
       return {};
     }
-    const std::vector<Variable*>& vars = it->second;
+    auto vars = ctx_.outputs.Slot(slot);
     std::vector<T*> res;
     res.reserve(vars.size());
     std::transform(vars.begin(), vars.end(), std::back_inserter(res),
@@ -428,6 +545,25 @@ class OpKernel : public OpKernelBase {
   using ELEMENT_TYPE = T;
 };
 
+/// The statistics of the runs of an OperatorWithKernel, to see the overhead
+/// saved by kEnableCacheShapeSignature. Only the ops with it are counted.
+struct OpRunStats {
+  uint64_t run_count{0};
+  uint64_t infer_shape_count{0};
+  uint64_t infer_shape_skip_count{0};
+  uint64_t prepare_data_count{0};
+  uint64_t prepare_data_skip_count{0};
+
+  OpRunStats& operator+=(const OpRunStats& other) {
+    run_count += other.run_count;
+    infer_shape_count += other.infer_shape_count;
+    infer_shape_skip_count += other.infer_shape_skip_count;
+    prepare_data_count += other.prepare_data_count;
+    prepare_data_skip_count += other.prepare_data_skip_count;
+    return *this;
+  }
+};
+
 class OperatorWithKernel : public OperatorBase {
  public:
   using OpKernelFunc = std::function<void(const ExecutionContext&)>;
@@ -436,7 +572,9 @@ class OperatorWithKernel : public OperatorBase {
 
   OperatorWithKernel(const std::string& type, const VariableNameMap& inputs,
                      const VariableNameMap& outputs, const AttributeMap& attrs)
-      : OperatorBase(type, inputs, outputs, attrs) {}
+      : OperatorBase(type, inputs, outputs, attrs),
+        input_layout_(std::make_shared<SlotLayout>(inputs_)),
+        output_layout_(std::make_shared<SlotLayout>(outputs_)) {}
 
   static std::unordered_map<std::string /* op_type */, OpKernelMap>&
   AllOpKernels() {
@@ -469,6 +607,10 @@ class OperatorWithKernel : public OperatorBase {
       const std::string& var_name, const Tensor& tensor,
       const OpKernelType& expected_kernel_type) const;
 
+  // The counters are updated by the thread running the op without
+  // synchronization, only when kEnableCacheShapeSignature is set.
+  const OpRunStats& RunStats() const { return run_stats_; }
+
  private:
   // indicate kernel DataType by input data. By default all input data must be
   // same.
@@ -495,7 +637,32 @@ class OperatorWithKernel : public OperatorBase {
   void ChooseKernel(const RuntimeContext& ctx, const Scope& scope,
                     const platform::Place& place) const;
 
+  // The signature of a variable for kEnableCacheShapeSignature.
+  struct VarSignature {
+    const Variable* var{nullptr};
+    bool initialized{false};
+    DDim dims;
+    LoD lod;
+    proto::VarType::Type type{proto::VarType::FP32};
+    DataLayout layout{DataLayout::kAnyLayout};
+    platform::Place place;
+#ifdef PADDLE_WITH_MKLDNN
+    mkldnn::memory::format format{mkldnn::memory::format::format_undef};
+#endif
+  };
+
+  // Record the signature of vars, with_data is false for the outputs, only
+  // their dims and LoD are recorded. Returns false if any of the variables
+  // is not a LoDTensor.
+  bool RecordSignature(const SlotVariableMap& vars, bool with_data,
+                       std::vector<VarSignature>* signature) const;
+  bool MatchSignature(const SlotVariableMap& vars, bool with_data,
+                      const std::vector<VarSignature>& signature) const;
+
  protected:
+  // the slots of inputs_ and outputs_ resolved at construction
+  std::shared_ptr<const SlotLayout> input_layout_;
+  std::shared_ptr<const SlotLayout> output_layout_;
   mutable OpKernelConfigsMap kernel_configs_map_;
   mutable std::unique_ptr<OpKernelType> kernel_type_;
   mutable std::unique_ptr<OpKernelFunc> kernel_func_;
@@ -505,8 +672,18 @@ class OperatorWithKernel : public OperatorBase {
   mutable bool all_kernels_must_compute_runtime_shape_ = false;
   mutable std::mutex cache_update_mutex_;
   mutable bool enable_cache_transfer_scope_ = false;
+  // not guarded by cache_update_mutex_, see kEnableCacheShapeSignature
+  mutable bool enable_cache_shape_signature_ = false;
+  mutable bool shape_signature_valid_ = false;
+  mutable std::vector<VarSignature> input_signature_;
+  mutable std::vector<VarSignature> output_signature_;
+  mutable OpRunStats run_stats_;
 };
 
+/// Sum the OpRunStats of the OperatorWithKernels in ops by op type.
+std::unordered_map<std::string, OpRunStats> CollectOpRunStats(
+    const std::vector<const OperatorBase*>& ops);
+
 extern bool OpSupportGPU(const std::string& op_type);
 
 }  // namespace framework
@@ -315,3 +315,148 @@ TEST(VarNameTest, all) {
   original_var_name = paddle::framework::GradOriginalVarName(original_var_name);
   ASSERT_EQ(original_var_name, "");
 }
+
+TEST(RuntimeContext, slots) {
+  paddle::framework::VariableNameMap inputs = {{"X", {"x0", "x1", "x2"}},
+                                               {"Y", {}},
+                                               {"Z", {"z0", "missing"}}};
+  paddle::framework::VariableNameMap outputs = {{"Out", {"out"}}};
+  paddle::framework::Scope scope;
+  auto* x0 = scope.Var("x0");
+  auto* x1 = scope.Var("x1");
+  auto* x2 = scope.Var("x2");
+  auto* z0 = scope.Var("z0");
+  auto* out = scope.Var("out");
+
+  paddle::framework::RuntimeContext ctx(inputs, outputs, scope);
+  const auto& layout = ctx.inputs.Layout();
+  ASSERT_EQ(layout.SlotNum(), 3UL);
+  ASSERT_EQ(layout.VarNum(), 5UL);
+  ASSERT_EQ(layout.Find("Y"), 1UL);
+  ASSERT_EQ(layout.Find("W"), paddle::framework::SlotLayout::kNotFound);
+  ASSERT_FALSE(ctx.inputs.Has("Out"));
+
+  auto xs = ctx.inputs.Slot(ctx.inputs.Find("X"));
+  ASSERT_EQ(xs.size(), 3UL);
+  ASSERT_EQ(xs[0], x0);
+  ASSERT_EQ(xs[1], x1);
+  ASSERT_EQ(xs[2], x2);
+  ASSERT_TRUE(ctx.inputs.Slot(ctx.inputs.Find("Y")).empty());
+  auto zs = ctx.inputs.Slot(ctx.inputs.Find("Z"));
+  ASSERT_EQ(zs.size(), 2UL);
+  ASSERT_EQ(zs[0], z0);
+  ASSERT_EQ(zs[1], nullptr);
+  ASSERT_EQ(ctx.outputs.Slot(ctx.outputs.Find("Out"))[0], out);
+
+  // the same layout is shared by the contexts of an operator
+  auto in_layout = std::make_shared<paddle::framework::SlotLayout>(inputs);
+  auto out_layout = std::make_shared<paddle::framework::SlotLayout>(outputs);
+  paddle::framework::RuntimeContext ctx2(in_layout, out_layout, inputs,
+                                         outputs, scope);
+  ASSERT_EQ(&ctx2.inputs.Layout(), in_layout.get());
+  ASSERT_EQ(ctx2.inputs.Slot(2)[0], z0);
+
+  // built from variables, as in imperative mode
+  paddle::framework::RuntimeContext ctx3({{"X", {x0, x1}}}, {{"Out", {out}}});
+  ASSERT_EQ(ctx3.inputs.Slot(0).size(), 2UL);
+  ASSERT_EQ(ctx3.inputs.Slot(0)[1], x1);
+  ASSERT_EQ(ctx3.outputs.Slot(ctx3.outputs.Find("Out"))[0], out);
+}
+
+namespace paddle {
+namespace framework {
+
+static int shape_cache_infer_shape_num = 0;
+
+class OpWithShapeCacheTest : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    ++shape_cache_infer_shape_num;
+    ctx->SetOutputDim("y", ctx->GetInputDim("x"));
+    ctx->ShareLoD("x", "y");
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class CPUShapeCacheKernelTest : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const {
+    auto* x = ctx.Input<Tensor>("x");
+    auto* y = ctx.Output<Tensor>("y");
+    float* y_data = y->mutable_data<float>(ctx.GetPlace());
+    for (int64_t i = 0; i < x->numel(); ++i) {
+      y_data[i] = x->data<float>()[i];
+    }
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(
+    op_with_shape_cache, paddle::framework::OpWithShapeCacheTest,
+    paddle::framework::OpKernelTestProtoAndCheckerMaker);
+REGISTER_OP_CPU_KERNEL(op_with_shape_cache,
+                       paddle::framework::CPUShapeCacheKernelTest);
+
+TEST(OpKernel, cache_shape_signature) {
+  paddle::framework::InitDevices(true);
+  paddle::framework::proto::OpDesc op_desc;
+  op_desc.set_type("op_with_shape_cache");
+  BuildVar("x", {"IN1"}, op_desc.add_inputs());
+  BuildVar("y", {"OUT1"}, op_desc.add_outputs());
+  auto attr = op_desc.mutable_attrs()->Add();
+  attr->set_name(paddle::framework::kEnableCacheShapeSignature);
+  attr->set_type(paddle::framework::proto::AttrType::BOOLEAN);
+  attr->set_b(true);
+
+  paddle::platform::CPUPlace cpu_place;
+  paddle::framework::Scope scope;
+  auto* x = scope.Var("IN1")->GetMutable<paddle::framework::LoDTensor>();
+  auto* y = scope.Var("OUT1")->GetMutable<paddle::framework::LoDTensor>();
+  x->mutable_data<float>(paddle::framework::make_ddim({2, 3}), cpu_place);
+
+  auto op = paddle::framework::OpRegistry::CreateOp(op_desc);
+  auto* op_with_kernel =
+      dynamic_cast<paddle::framework::OperatorWithKernel*>(op.get());
+  ASSERT_NE(op_with_kernel, nullptr);
+  const auto& stats = op_with_kernel->RunStats();
+
+  op->Run(scope, cpu_place);
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::shape_cache_infer_shape_num, 1);
+  ASSERT_EQ(stats.run_count, 2UL);
+  ASSERT_EQ(stats.infer_shape_skip_count, 1UL);
+  ASSERT_EQ(stats.prepare_data_skip_count, 1UL);
+  ASSERT_EQ(y->dims(), paddle::framework::make_ddim({2, 3}));
+
+  // a new shape of the input
+  x->mutable_data<float>(paddle::framework::make_ddim({4, 3}), cpu_place);
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::shape_cache_infer_shape_num, 2);
+  ASSERT_EQ(y->dims(), paddle::framework::make_ddim({4, 3}));
+
+  // a new LoD of the input
+  x->set_lod({{0, 1, 4}});
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::shape_cache_infer_shape_num, 3);
+  ASSERT_EQ(y->lod(), x->lod());
+
+  // the output is resized by another op
+  y->Resize(paddle::framework::make_ddim({1}));
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::shape_cache_infer_shape_num, 4);
+  op->Run(scope, cpu_place);
+  ASSERT_EQ(paddle::framework::shape_cache_infer_shape_num, 4);
+  ASSERT_EQ(stats.run_count, 6UL);
+  ASSERT_EQ(stats.infer_shape_count, 4UL);
+
+  auto op_stats = paddle::framework::CollectOpRunStats({op.get()});
+  ASSERT_EQ(op_stats["op_with_shape_cache"].infer_shape_skip_count, 2UL);
+}
@@ -83,12 +83,42 @@ struct TensorFillVisitor {
   int64_t size_;
 };
 
+// Writes the rows of the sharded table in the format of a SelectedRows, so
+// that it is loaded as the legacy one.
+static void SerializeShardedTable(std::ostream& os,
+                                  const ShardedSparseTable& table,
+                                  int64_t height,
+                                  const platform::DeviceContext& dev_ctx) {
+  std::vector<int64_t> ids;
+  std::vector<float> values;
+  table.Export(&ids, &values);
+  {
+    uint64_t size = ids.size();
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char*>(ids.data()),
+             sizeof(int64_t) * ids.size());
+  }
+  os.write(reinterpret_cast<const char*>(&height), sizeof(height));
+  Tensor value;
+  int64_t width = table.GetConfig().value_width;
+  float* data = value.mutable_data<float>(
+      make_ddim({static_cast<int64_t>(ids.size()), width}),
+      platform::CPUPlace());
+  std::copy(values.begin(), values.end(), data);
+  TensorToStream(os, value, dev_ctx);
+}
+
 void SerializeToStream(std::ostream& os, const SelectedRows& selected_rows,
                        const platform::DeviceContext& dev_ctx) {
   {  // the 1st field, uint32_t version
     constexpr uint32_t version = 0;
     os.write(reinterpret_cast<const char*>(&version), sizeof(version));
   }
+  auto table = selected_rows.sharded_table();
+  if (table != nullptr) {
+    SerializeShardedTable(os, *table, selected_rows.height(), dev_ctx);
+    return;
+  }
   {
     // the 2st field, rows information
     auto& rows = selected_rows.rows();
@@ -140,71 +170,70 @@ bool SelectedRows::HasKey(int64_t key) const {
                                                                    : true;
 }
 
+int64_t SelectedRows::GetIndexFromId(int64_t key) const {
+  auto& shard = IndexShardOf(key);
+  shard.lock.RDLock();
+  int64_t index = shard.id_to_index.Find(key);
+  shard.lock.UNLock();
+  return index;
+}
+
 int64_t SelectedRows::AutoGrownIndex(int64_t key, bool auto_grown,
                                      bool is_test) {
-  if (is_test) {
-    auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
-      return iter->second;
-    }
+  int64_t index = GetIndexFromId(key);
+  if (index != Int64HashMap::kNotFound || is_test) {
+    return index;
   }
-
-  rwlock_->RDLock();
-  auto iter = id_to_index_.find(key);
-  if (iter == id_to_index_.end()) {
-    rwlock_->UNLock();
-    if (!auto_grown) {
-      PADDLE_THROW("key %d not found", key);
-    }
-    rwlock_->WRLock();
-    auto map_size = id_to_index_.size();
-    auto vector_size = rows_.size();
-    if (map_size != vector_size) {
-      rwlock_->UNLock();
-      PADDLE_THROW(
-          "id_to_index_ size %d should have the same size with rows_ %d",
-          map_size, vector_size);
-    }
-    auto write_iter = id_to_index_.find(key);
-    if (write_iter == id_to_index_.end()) {
-      int row_num = rows_.size();
-      if (row_num == value_->dims()[0]) {
-        rwlock_->UNLock();
-        PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
-      }
-      // key logic to put a key into id_to_index_
-      rows_.push_back(key);
-      auto index = static_cast<int64_t>(rows_.size() - 1);
-      id_to_index_[key] = index;
-      rwlock_->UNLock();
-      return index;
-    } else {
-      auto index = write_iter->second;
-      rwlock_->UNLock();
-      return index;
-    }
-  } else {
-    auto index = iter->second;
-    rwlock_->UNLock();
+  if (!auto_grown) {
+    PADDLE_THROW("key %d not found", key);
+  }
+  auto& shard = IndexShardOf(key);
+  AutoWRLock shard_guard(&shard.lock);
+  index = shard.id_to_index.Find(key);
+  if (index != Int64HashMap::kNotFound) {
     return index;
   }
+  {
+    // key logic to put a key into id_to_index_
+    AutoWRLock guard(rwlock_.get());
+    int64_t row_num = rows_.size();
+    if (row_num == value_->dims()[0]) {
+      PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
+    }
+    rows_.push_back(key);
+    index = row_num;
+  }
+  shard.id_to_index.Set(key, index);
+  return index;
 }
 
 void SelectedRows::SyncIndex() {
-  rwlock_->WRLock();
-  id_to_index_.clear();
+  for (int i = 0; i < kIndexShardNum; ++i) {
+    index_shards_[i].lock.WRLock();
+    index_shards_[i].id_to_index.Clear();
+  }
   for (size_t i = 0; i < rows_.size(); ++i) {
-    id_to_index_[rows_[i]] = i;
+    IndexShardOf(rows_[i]).id_to_index.Set(rows_[i], i);
+  }
+  for (int i = 0; i < kIndexShardNum; ++i) {
+    index_shards_[i].lock.UNLock();
   }
-  rwlock_->UNLock();
 }
 
 void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
                        bool auto_grown, bool is_test) {
   PADDLE_ENFORCE(value->IsInitialized(),
                  "The value tensor should be initialized.");
+  auto table = sharded_table();
+  if (table != nullptr) {
+    PADDLE_ENFORCE_EQ(value->numel(),
+                      ids.numel() * table->GetConfig().value_width,
+                      "output tensor should have the same shape with table "
+                      "except the dims[0].");
+    table->Get(ids.data<int64_t>(), ids.numel(), value->data<float>(),
+               auto_grown, is_test);
+    return;
+  }
   if (ids.numel() == 0) {
     VLOG(3) << "keys is empty, please check data!";
   } else {
@@ -230,5 +259,26 @@ void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
   }
 }
 
+void SelectedRows::EnableShardedTable(
+    const ShardedSparseTable::Config& config) {
+  std::call_once(*sharded_table_once_, [&] {
+    PADDLE_ENFORCE(platform::is_cpu_place(value_->place()),
+                   "The sharded table only supports the value on CPU.");
+    PADDLE_ENFORCE_EQ(value_->type(), proto::VarType::FP32,
+                      "The sharded table only supports the FP32 value.");
+    PADDLE_ENFORCE_GT(value_->dims()[0], 0,
+                      "The value should have at least one row.");
+    auto table_config = config;
+    table_config.value_width = value_->numel() / value_->dims()[0];
+    auto table = std::make_shared<ShardedSparseTable>(table_config);
+    // the rows added before, e.g. loaded from a checkpoint
+    AutoWRLock lock(rwlock_.get());
+    if (!rows_.empty()) {
+      table->Import(rows_.data(), rows_.size(), value_->data<float>());
+    }
+    std::atomic_store(&sharded_table_, table);
+  });
+}
+
 }  // namespace framework
 }  // namespace paddle
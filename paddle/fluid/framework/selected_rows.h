@@ -23,6 +23,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/rw_lock.h"
+#include "paddle/fluid/framework/sharded_sparse_table.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/memory/memcpy.h"
 
@@ -50,12 +51,16 @@ class SelectedRows {
       : rows_(rows), height_(height) {
     value_.reset(new Tensor());
     rwlock_.reset(new RWLock);
+    index_shards_.reset(new IndexShard[kIndexShardNum]);
+    sharded_table_once_.reset(new std::once_flag);
   }
 
   SelectedRows() {
     height_ = 0;
     value_.reset(new Tensor());
     rwlock_.reset(new RWLock);
+    index_shards_.reset(new IndexShard[kIndexShardNum]);
+    sharded_table_once_.reset(new std::once_flag);
   }
 
   platform::Place place() const { return value_->place(); }
@@ -121,15 +126,10 @@ class SelectedRows {
 
   /*
    * @brief Get the index of the key from id_to_index_ map.
+   *
+   * @return -1 if the key does not exists.
    */
-  inline int64_t GetIndexFromId(int64_t key) {
-    auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
-      return iter->second;
-    }
-  }
+  int64_t GetIndexFromId(int64_t key) const;
 
   void SyncIndex();
   /*
@@ -141,16 +141,52 @@ class SelectedRows {
     return make_ddim(dims);
   }
 
+  /*
+   * @brief Move the rows into a ShardedSparseTable of the config, whose
+   * value_width is taken from the value. Then Get, the sparse sgd update
+   * and the serialization use the table instead of rows_ and value_. Only
+   * the first call takes effect.
+   *
+   * Note!!! this interface is only used when selected_rows is used as
+   * parameters for distribute lookup table, and the value should be FP32 on
+   * CPU.
+   */
+  void EnableShardedTable(const ShardedSparseTable::Config& config);
+
+  /*
+   * @brief Get the sharded table of the rows.
+   *
+   * @return nullptr if EnableShardedTable is not called.
+   */
+  std::shared_ptr<ShardedSparseTable> sharded_table() const {
+    return std::atomic_load(&sharded_table_);
+  }
+
  private:
   // Notice: rows can be duplicate. We can have {0, 4, 7, 0, 5, 7, 9} here.
   // SelectedRows are simply concated when adding together. Until a
   // SelectedRows add a Tensor, will the duplicate rows be handled.
   Vector<int64_t> rows_;
-  std::unordered_map<int64_t, int64_t>
-      id_to_index_;  // should not be used when rows_ has duplicate member
   std::unique_ptr<Tensor> value_{nullptr};
   int64_t height_;  // height indicates the underline tensor's height
+  // guards the appending of rows_ by AutoGrownIndex
   std::unique_ptr<RWLock> rwlock_{nullptr};
+
+  // The id_to_index_ map is sharded by the ids, so that the lookups of the
+  // distributed lookup tables do not contend on one lock. It should not be
+  // used when rows_ has duplicate member.
+  struct IndexShard {
+    RWLock lock;
+    Int64HashMap id_to_index;
+  };
+  static constexpr int kIndexShardNum = 16;
+  IndexShard& IndexShardOf(int64_t key) const {
+    return index_shards_[Int64HashMap::ShardOf(key, kIndexShardNum)];
+  }
+  std::unique_ptr<IndexShard[]> index_shards_{nullptr};
+
+  std::unique_ptr<std::once_flag> sharded_table_once_{nullptr};
+  std::shared_ptr<ShardedSparseTable> sharded_table_{nullptr};
 };
 
 /*
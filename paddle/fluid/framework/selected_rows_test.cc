@@ -10,6 +10,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <time.h>
+#include <map>
 #include <thread>  // NOLINT
 
 #include "gtest/gtest.h"
@@ -69,6 +70,52 @@ TEST_F(SelectedRowsTester, SerializeAndDeseralize) {
   }
 }
 
+TEST_F(SelectedRowsTester, ShardedTable) {
+  ShardedSparseTable::Config config;
+  config.shard_num = 4;
+  config.init_min = -1.f;
+  config.init_max = -1.f;
+  selected_rows_->EnableShardedTable(config);
+  auto table = selected_rows_->sharded_table();
+  ASSERT_NE(table, nullptr);
+  ASSERT_EQ(table->GetConfig().value_width, 100);
+  ASSERT_EQ(table->Size(), 3);
+
+  // 4 and 7 are imported, 5 is a new one
+  Tensor ids;
+  auto* ids_data = ids.mutable_data<int64_t>(make_ddim({3, 1}), place_);
+  ids_data[0] = 4;
+  ids_data[1] = 7;
+  ids_data[2] = 5;
+  Tensor out;
+  auto* out_data = out.mutable_data<float>(make_ddim({3, 100}), place_);
+  selected_rows_->Get(ids, &out, true);
+  for (int64_t j = 0; j < 100; ++j) {
+    ASSERT_EQ(out_data[j], static_cast<float>(100 + j));
+    ASSERT_EQ(out_data[100 + j], static_cast<float>(200 + j));
+    ASSERT_EQ(out_data[200 + j], -1.f);
+  }
+
+  // the rows of the table are saved as a SelectedRows
+  SelectedRows dst_tensor;
+  platform::CPUDeviceContext cpu_ctx(place_);
+  std::ostringstream oss;
+  SerializeToStream(oss, *selected_rows_, cpu_ctx);
+  std::istringstream iss(oss.str());
+  DeserializeFromStream(iss, &dst_tensor, cpu_ctx);
+  ASSERT_EQ(dst_tensor.height(), 10);
+  ASSERT_EQ(dst_tensor.rows().size(), 4UL);
+  ASSERT_EQ(dst_tensor.value().dims(), make_ddim({4, 100}));
+  std::map<int64_t, float> first_values{
+      {0, 0.f}, {4, 100.f}, {7, 200.f}, {5, -1.f}};
+  auto* dst_data = dst_tensor.value().data<float>();
+  for (size_t i = 0; i < dst_tensor.rows().size(); ++i) {
+    int64_t id = dst_tensor.rows()[i];
+    ASSERT_EQ(first_values.count(id), 1UL) << id;
+    ASSERT_EQ(dst_data[i * 100], first_values[id]) << id;
+  }
+}
+
 TEST(SelectedRows, SparseTable) {
   platform::CPUPlace cpu;
   SelectedRows table;
@@ -198,5 +245,19 @@ TEST(SelectedRows, MultiThreadAutoIndex) {
   t4.join();
 }
 
+TEST(SelectedRows, SyncIndex) {
+  std::vector<int64_t> rows{9, 2, 100, 5};
+  SelectedRows table(rows, 1000);
+  table.mutable_value()->Resize(framework::make_ddim({8, 1}));
+  table.SyncIndex();
+  for (size_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(table.Index(rows[i]), static_cast<int64_t>(i));
+    ASSERT_EQ(table.AutoGrownIndex(rows[i], false), static_cast<int64_t>(i));
+  }
+  ASSERT_EQ(table.AutoGrownIndex(7, false, true), -1);
+  ASSERT_EQ(table.AutoGrownIndex(7, true), 4);
+  ASSERT_EQ(table.rows().size(), 5UL);
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,424 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/sharded_sparse_table.h"
+#include <algorithm>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+constexpr int64_t Int64HashMap::kNotFound;
+
+void Int64HashMap::Set(int64_t key, int64_t value) {
+  // keep the load factor under 0.75
+  if ((size_ + 1) * 4 > slots_.size() * 3) {
+    Rehash(std::max<size_t>(16, slots_.size() * 2));
+  }
+  size_t i = Hash(key) & mask_;
+  while (slots_[i].value != kNotFound && slots_[i].key != key) {
+    i = (i + 1) & mask_;
+  }
+  if (slots_[i].value == kNotFound) {
+    ++size_;
+  }
+  slots_[i].key = key;
+  slots_[i].value = value;
+}
+
+int64_t Int64HashMap::Erase(int64_t key) {
+  if (size_ == 0) {
+    return kNotFound;
+  }
+  size_t i = Hash(key) & mask_;
+  while (slots_[i].value != kNotFound && slots_[i].key != key) {
+    i = (i + 1) & mask_;
+  }
+  int64_t value = slots_[i].value;
+  if (value == kNotFound) {
+    return kNotFound;
+  }
+  // Shift the following keys of the cluster back, so that no tombstone is
+  // needed. The key in slot j stays if its home slot is cyclically in
+  // (i, j].
+  size_t j = i;
+  while (true) {
+    j = (j + 1) & mask_;
+    if (slots_[j].value == kNotFound) {
+      break;
+    }
+    size_t home = Hash(slots_[j].key) & mask_;
+    bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+    if (!stays) {
+      slots_[i] = slots_[j];
+      i = j;
+    }
+  }
+  slots_[i].value = kNotFound;
+  --size_;
+  return value;
+}
+
+void Int64HashMap::Rehash(size_t capacity) {
+  std::vector<Slot> old_slots(capacity, Slot{0, kNotFound});
+  old_slots.swap(slots_);
+  mask_ = capacity - 1;
+  for (auto& slot : old_slots) {
+    if (slot.value != kNotFound) {
+      size_t i = Hash(slot.key) & mask_;
+      while (slots_[i].value != kNotFound) {
+        i = (i + 1) & mask_;
+      }
+      slots_[i] = slot;
+    }
+  }
+}
+
+struct ShardedSparseTable::Shard {
+  struct Row {
+    int64_t id;
+    // the step of the last use
+    int64_t step;
+    // the LRU list, from the most recently used to the least
+    int64_t prev;
+    int64_t next;
+  };
+
+  Shard(const Config& config, unsigned int seed)
+      : config_(config),
+        track_lru_(config.max_rows > 0 || config.ttl > 0),
+        max_rows_(config.max_rows > 0
+                      ? std::max<int64_t>(
+                            1, (config.max_rows + config.shard_num - 1) /
+                                   config.shard_num)
+                      : 0),
+        rng_(seed) {}
+
+  int64_t RowNum() const {
+    return static_cast<int64_t>(rows_.size() - free_rows_.size());
+  }
+
+  float* Value(int64_t row) {
+    return chunks_[row / config_.chunk_rows].get() +
+           (row % config_.chunk_rows) * config_.value_width;
+  }
+
+  // Returns the row of id, and inserts it if insert is true and the id is
+  // admitted, or returns kNotFound.
+  int64_t Lookup(int64_t id, bool insert, int64_t step) {
+    int64_t row = index_.Find(id);
+    if (row != Int64HashMap::kNotFound) {
+      ++stats_.hit_count;
+      Touch(row, step);
+      return row;
+    }
+    if (!insert) {
+      return Int64HashMap::kNotFound;
+    }
+    if (config_.admit_count > 1) {
+      int64_t count = pending_.Find(id);
+      count = count == Int64HashMap::kNotFound ? 1 : count + 1;
+      if (count < config_.admit_count) {
+        if (count == 1 &&
+            static_cast<int64_t>(pending_.Size()) >= config_.max_pending_ids) {
+          pending_.Clear();
+        }
+        pending_.Set(id, count);
+        ++stats_.reject_count;
+        return Int64HashMap::kNotFound;
+      }
+      pending_.Erase(id);
+    }
+    return Insert(id, step);
+  }
+
+  int64_t Insert(int64_t id, int64_t step) {
+    if (max_rows_ > 0 && RowNum() >= max_rows_) {
+      Evict(tail_);
+    }
+    int64_t row;
+    if (!free_rows_.empty()) {
+      row = free_rows_.back();
+      free_rows_.pop_back();
+    } else {
+      row = static_cast<int64_t>(rows_.size());
+      if (row % config_.chunk_rows == 0) {
+        chunks_.emplace_back(
+            new float[config_.chunk_rows * config_.value_width]);
+      }
+      rows_.emplace_back();
+    }
+    float* value = Value(row);
+    if (config_.init_min == config_.init_max) {
+      std::fill(value, value + config_.value_width, config_.init_min);
+    } else {
+      std::uniform_real_distribution<float> dist(config_.init_min,
+                                                 config_.init_max);
+      for (int64_t i = 0; i < config_.value_width; ++i) {
+        value[i] = dist(rng_);
+      }
+    }
+    rows_[row].id = id;
+    rows_[row].step = step;
+    if (track_lru_) {
+      PushFront(row);
+    }
+    index_.Set(id, row);
+    ++stats_.insert_count;
+    return row;
+  }
+
+  void Evict(int64_t row) {
+    index_.Erase(rows_[row].id);
+    Unlink(row);
+    free_rows_.push_back(row);
+    ++stats_.evict_count;
+  }
+
+  int64_t Shrink(int64_t step) {
+    int64_t evicted = 0;
+    while (tail_ != -1 && step - rows_[tail_].step > config_.ttl) {
+      Evict(tail_);
+      ++evicted;
+    }
+    return evicted;
+  }
+
+  std::mutex mutex_;
+  const Config& config_;
+  const bool track_lru_;
+  // the max rows of the shard, 0 means unlimited
+  const int64_t max_rows_;
+  Int64HashMap index_;
+  // the counts of the ids not admitted yet
+  Int64HashMap pending_;
+  std::vector<std::unique_ptr<float[]>> chunks_;
+  std::vector<Row> rows_;
+  std::vector<int64_t> free_rows_;
+  int64_t head_{-1};
+  int64_t tail_{-1};
+  std::mt19937 rng_;
+  Stats stats_;
+
+ private:
+  void Touch(int64_t row, int64_t step) {
+    rows_[row].step = step;
+    if (track_lru_ && head_ != row) {
+      Unlink(row);
+      PushFront(row);
+    }
+  }
+
+  void PushFront(int64_t row) {
+    rows_[row].prev = -1;
+    rows_[row].next = head_;
+    if (head_ != -1) {
+      rows_[head_].prev = row;
+    }
+    head_ = row;
+    if (tail_ == -1) {
+      tail_ = row;
+    }
+  }
+
+  void Unlink(int64_t row) {
+    if (!track_lru_) {
+      return;
+    }
+    Row& r = rows_[row];
+    if (r.prev != -1) {
+      rows_[r.prev].next = r.next;
+    } else {
+      head_ = r.next;
+    }
+    if (r.next != -1) {
+      rows_[r.next].prev = r.prev;
+    } else {
+      tail_ = r.prev;
+    }
+  }
+};
+
+ShardedSparseTable::ShardedSparseTable(const Config& config)
+    : config_(config) {
+  PADDLE_ENFORCE_GT(config_.value_width, 0);
+  PADDLE_ENFORCE_GT(config_.shard_num, 0);
+  PADDLE_ENFORCE_GT(config_.chunk_rows, 0);
+  PADDLE_ENFORCE_LE(config_.init_min, config_.init_max);
+  PADDLE_ENFORCE_GE(config_.max_rows, 0);
+  PADDLE_ENFORCE_GE(config_.ttl, 0);
+  shards_.reserve(config_.shard_num);
+  for (int i = 0; i < config_.shard_num; ++i) {
+    shards_.emplace_back(new Shard(config_, config_.seed + i));
+  }
+}
+
+ShardedSparseTable::~ShardedSparseTable() {}
+
+void ShardedSparseTable::ForEachShard(
+    const int64_t* ids, size_t n,
+    const std::function<void(Shard*, const size_t*, size_t)>& fn) {
+  if (n == 1) {
+    size_t pos = 0;
+    fn(&ShardOf(ids[0]), &pos, 1);
+    return;
+  }
+  // counting sort of the positions by shard
+  size_t shard_num = shards_.size();
+  std::vector<size_t> shard_of(n);
+  std::vector<size_t> offsets(shard_num + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    shard_of[i] = Int64HashMap::ShardOf(ids[i], shard_num);
+    ++offsets[shard_of[i] + 1];
+  }
+  for (size_t i = 0; i < shard_num; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<size_t> positions(n);
+  std::vector<size_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < n; ++i) {
+    positions[cursor[shard_of[i]]++] = i;
+  }
+  for (size_t i = 0; i < shard_num; ++i) {
+    if (offsets[i + 1] > offsets[i]) {
+      fn(shards_[i].get(), positions.data() + offsets[i],
+         offsets[i + 1] - offsets[i]);
+    }
+  }
+}
+
+void ShardedSparseTable::Get(const int64_t* ids, size_t n, float* out,
+                             bool auto_grown, bool is_test) {
+  int64_t width = config_.value_width;
+  int64_t step = step_.load(std::memory_order_relaxed);
+  ForEachShard(ids, n, [&](Shard* shard, const size_t* positions,
+                           size_t num) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    for (size_t i = 0; i < num; ++i) {
+      size_t pos = positions[i];
+      int64_t row = Int64HashMap::kNotFound;
+      if (is_test) {
+        row = shard->index_.Find(ids[pos]);
+      } else {
+        row = shard->Lookup(ids[pos], auto_grown, step);
+        if (row == Int64HashMap::kNotFound && !auto_grown) {
+          PADDLE_THROW("id %d not found", ids[pos]);
+        }
+      }
+      float* dst = out + pos * width;
+      if (row == Int64HashMap::kNotFound) {
+        std::fill(dst, dst + width, 0.f);
+      } else {
+        const float* value = shard->Value(row);
+        std::copy(value, value + width, dst);
+      }
+    }
+  });
+}
+
+void ShardedSparseTable::Update(
+    const int64_t* ids, size_t n,
+    const std::function<void(size_t, float*)>& update) {
+  int64_t step = step_.load(std::memory_order_relaxed);
+  ForEachShard(ids, n, [&](Shard* shard, const size_t* positions,
+                           size_t num) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    for (size_t i = 0; i < num; ++i) {
+      int64_t row = shard->Lookup(ids[positions[i]], false, step);
+      if (row != Int64HashMap::kNotFound) {
+        update(positions[i], shard->Value(row));
+      }
+    }
+  });
+}
+
+bool ShardedSparseTable::HasKey(int64_t id) const {
+  Shard& shard = ShardOf(id);
+  std::lock_guard<std::mutex> guard(shard.mutex_);
+  return shard.index_.Find(id) != Int64HashMap::kNotFound;
+}
+
+int64_t ShardedSparseTable::Size() const {
+  int64_t size = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    size += shard->RowNum();
+  }
+  return size;
+}
+
+int64_t ShardedSparseTable::Shrink() {
+  if (config_.ttl == 0) {
+    return 0;
+  }
+  int64_t step = step_.load();
+  int64_t evicted = 0;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    evicted += shard->Shrink(step);
+  }
+  return evicted;
+}
+
+void ShardedSparseTable::Export(std::vector<int64_t>* ids,
+                                std::vector<float>* values) const {
+  ids->clear();
+  values->clear();
+  int64_t width = config_.value_width;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    ids->reserve(ids->size() + shard->RowNum());
+    values->reserve(values->size() + shard->RowNum() * width);
+    shard->index_.ForEach([&](int64_t id, int64_t row) {
+      ids->push_back(id);
+      const float* value = shard->Value(row);
+      values->insert(values->end(), value, value + width);
+    });
+  }
+}
+
+void ShardedSparseTable::Import(const int64_t* ids, size_t n,
+                                const float* values) {
+  int64_t width = config_.value_width;
+  int64_t step = step_.load(std::memory_order_relaxed);
+  ForEachShard(ids, n, [&](Shard* shard, const size_t* positions,
+                           size_t num) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    for (size_t i = 0; i < num; ++i) {
+      size_t pos = positions[i];
+      int64_t row = shard->Lookup(ids[pos], false, step);
+      if (row == Int64HashMap::kNotFound) {
+        row = shard->Insert(ids[pos], step);
+      }
+      std::copy(values + pos * width, values + (pos + 1) * width,
+                shard->Value(row));
+    }
+  });
+}
+
+ShardedSparseTable::Stats ShardedSparseTable::GetStats() const {
+  Stats stats;
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> guard(shard->mutex_);
+    stats.rows += shard->RowNum();
+    stats.hit_count += shard->stats_.hit_count;
+    stats.insert_count += shard->stats_.insert_count;
+    stats.reject_count += shard->stats_.reject_count;
+    stats.evict_count += shard->stats_.evict_count;
+  }
+  return stats;
+}
+
+}  // namespace framework
+}  // namespace paddle
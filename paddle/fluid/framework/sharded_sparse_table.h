@@ -0,0 +1,208 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+/*
+ * @brief Int64HashMap is an open-addressing hash map from int64_t keys to
+ * non-negative int64_t values with linear probing. It is not thread safe,
+ * the callers shard the keys and lock the shards.
+ */
+class Int64HashMap {
+ public:
+  static constexpr int64_t kNotFound = -1;
+
+  size_t Size() const { return size_; }
+
+  int64_t Find(int64_t key) const {
+    if (size_ == 0) {
+      return kNotFound;
+    }
+    for (size_t i = Hash(key) & mask_;; i = (i + 1) & mask_) {
+      const Slot& slot = slots_[i];
+      if (slot.value == kNotFound || slot.key == key) {
+        return slot.value;
+      }
+    }
+  }
+
+  // Insert the key, or overwrite its value if the key exists.
+  void Set(int64_t key, int64_t value);
+
+  // Returns the value of the erased key, or kNotFound.
+  int64_t Erase(int64_t key);
+
+  void Clear() {
+    slots_.clear();
+    mask_ = 0;
+    size_ = 0;
+  }
+
+  template <typename Callback>
+  void ForEach(Callback callback) const {
+    for (auto& slot : slots_) {
+      if (slot.value != kNotFound) {
+        callback(slot.key, slot.value);
+      }
+    }
+  }
+
+  // The shard of a key when the keys are sharded by the callers, it uses the
+  // high bits of the hash, which are not used by the probing in a shard.
+  static size_t ShardOf(int64_t key, size_t shard_num) {
+    return (Hash(key) >> 40) % shard_num;
+  }
+
+ private:
+  struct Slot {
+    int64_t key;
+    int64_t value;
+  };
+
+  static size_t Hash(int64_t key) {
+    // the finalizer of MurmurHash3, the ids are often sequential
+    uint64_t x = static_cast<uint64_t>(key);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+
+  void Rehash(size_t capacity);
+
+  std::vector<Slot> slots_;
+  size_t mask_{0};
+  size_t size_{0};
+};
+
+/*
+ * @brief ShardedSparseTable is a sparse parameter table from int64_t ids to
+ * float rows of value_width, for the distributed lookup tables whose ids are
+ * not known in advance.
+ *
+ * The ids are sharded, every shard has its own lock, an Int64HashMap from
+ * the ids to the rows, and the rows in chunks of chunk_rows rows, so that
+ * the table grows without reallocating the rows.
+ *
+ * Optional features:
+ *  - admission: a new id gets a row only after it is looked up admit_count
+ *    times, the ids seen fewer times read zeros.
+ *  - LRU eviction: a shard keeps at most max_rows / shard_num rows, the
+ *    least recently used row is evicted for a new one.
+ *  - TTL eviction: Shrink() evicts the rows not used in the last ttl steps,
+ *    the step is advanced by AdvanceStep(), e.g. once per pass.
+ */
+class ShardedSparseTable {
+ public:
+  struct Config {
+    int64_t value_width{1};
+    int shard_num{64};
+    int64_t chunk_rows{1024};
+    // the new rows are initialized uniformly in [init_min, init_max]
+    float init_min{0.f};
+    float init_max{0.f};
+    unsigned int seed{0};
+    // 0 or 1 admits the new ids at once
+    int admit_count{0};
+    // the max number of the ids being counted by a shard for admission,
+    // the counts are reset when it is exceeded
+    int64_t max_pending_ids{1 << 16};
+    // 0 means unlimited
+    int64_t max_rows{0};
+    // 0 means the rows do not expire
+    int64_t ttl{0};
+  };
+
+  struct Stats {
+    int64_t rows{0};
+    int64_t hit_count{0};
+    int64_t insert_count{0};
+    int64_t reject_count{0};
+    int64_t evict_count{0};
+  };
+
+  explicit ShardedSparseTable(const Config& config);
+
+  ~ShardedSparseTable();
+
+  const Config& GetConfig() const { return config_; }
+
+  /*
+   * @brief Copy the rows of ids[0, n) to out, which has n * value_width
+   * floats. The missing ids are inserted if auto_grown is true (and they are
+   * admitted), otherwise it throws. In test mode, the missing ids read zeros
+   * and the table is not changed.
+   */
+  void Get(const int64_t* ids, size_t n, float* out, bool auto_grown = true,
+           bool is_test = false);
+
+  /*
+   * @brief Call update(i, row) under the lock of the shard for every id of
+   * ids[0, n) which is in the table, e.g. to apply the gradients.
+   */
+  void Update(const int64_t* ids, size_t n,
+              const std::function<void(size_t, float*)>& update);
+
+  bool HasKey(int64_t id) const;
+
+  int64_t Size() const;
+
+  // Evict the rows not used in the last ttl steps, returns the number of
+  // the evicted rows.
+  int64_t Shrink();
+
+  void AdvanceStep() { ++step_; }
+
+  // Dump the ids and their rows, e.g. for checkpoints.
+  void Export(std::vector<int64_t>* ids, std::vector<float>* values) const;
+
+  // Insert or overwrite the rows of ids[0, n).
+  void Import(const int64_t* ids, size_t n, const float* values);
+
+  Stats GetStats() const;
+
+ private:
+  struct Shard;
+
+  Shard& ShardOf(int64_t id) const {
+    return *shards_[Int64HashMap::ShardOf(id, shards_.size())];
+  }
+
+  // Group the positions of ids by shard, and call fn(shard, positions, num)
+  // with the positions of the ids in every shard, so that every shard is
+  // locked once for a batch.
+  void ForEachShard(
+      const int64_t* ids, size_t n,
+      const std::function<void(Shard*, const size_t*, size_t)>& fn);
+
+  Config config_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<int64_t> step_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,237 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/sharded_sparse_table.h"
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(Int64HashMap, set_find_erase) {
+  Int64HashMap map;
+  std::unordered_map<int64_t, int64_t> expected;
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int64_t> key_dist(-5000, 5000);
+  for (int i = 0; i < 100000; ++i) {
+    int64_t key = key_dist(rng);
+    if (rng() % 3 == 0) {
+      auto iter = expected.find(key);
+      int64_t value = iter == expected.end() ? -1 : iter->second;
+      ASSERT_EQ(map.Erase(key), value);
+      expected.erase(key);
+    } else {
+      map.Set(key, i);
+      expected[key] = i;
+    }
+    ASSERT_EQ(map.Size(), expected.size());
+  }
+  for (int64_t key = -5000; key <= 5000; ++key) {
+    auto iter = expected.find(key);
+    int64_t value = iter == expected.end() ? -1 : iter->second;
+    ASSERT_EQ(map.Find(key), value);
+  }
+  size_t count = 0;
+  map.ForEach([&](int64_t key, int64_t value) {
+    ASSERT_EQ(expected[key], value);
+    ++count;
+  });
+  ASSERT_EQ(count, expected.size());
+
+  map.Clear();
+  ASSERT_EQ(map.Size(), 0UL);
+  ASSERT_EQ(map.Find(0), Int64HashMap::kNotFound);
+}
+
+static ShardedSparseTable::Config SmallConfig() {
+  ShardedSparseTable::Config config;
+  config.value_width = 4;
+  config.shard_num = 4;
+  config.chunk_rows = 8;
+  config.init_min = 1.f;
+  config.init_max = 1.f;
+  return config;
+}
+
+TEST(ShardedSparseTable, get) {
+  ShardedSparseTable table(SmallConfig());
+  std::vector<int64_t> ids{3, 100, 3, 7};
+  std::vector<float> out(ids.size() * 4, -1.f);
+
+  // is_test does not insert the missing ids
+  table.Get(ids.data(), ids.size(), out.data(), true, true);
+  for (float v : out) {
+    ASSERT_EQ(v, 0.f);
+  }
+  ASSERT_EQ(table.Size(), 0);
+  ASSERT_THROW(table.Get(ids.data(), ids.size(), out.data(), false),
+               platform::EnforceNotMet);
+
+  table.Get(ids.data(), ids.size(), out.data());
+  ASSERT_EQ(table.Size(), 3);
+  for (float v : out) {
+    ASSERT_EQ(v, 1.f);
+  }
+  ASSERT_TRUE(table.HasKey(100));
+  ASSERT_FALSE(table.HasKey(4));
+
+  table.Update(ids.data(), 2, [&](size_t i, float* row) {
+    for (int j = 0; j < 4; ++j) {
+      row[j] += static_cast<float>(ids[i]);
+    }
+  });
+  table.Get(ids.data(), ids.size(), out.data(), false);
+  ASSERT_EQ(out[0], 4.f);
+  ASSERT_EQ(out[4], 101.f);
+  ASSERT_EQ(out[8], 4.f);
+  ASSERT_EQ(out[12], 1.f);
+
+  // grow over many chunks
+  std::vector<int64_t> many(1000);
+  for (size_t i = 0; i < many.size(); ++i) {
+    many[i] = static_cast<int64_t>(i) * 7919;
+  }
+  std::vector<float> many_out(many.size() * 4);
+  table.Get(many.data(), many.size(), many_out.data());
+  table.Get(ids.data(), ids.size(), out.data(), false);
+  ASSERT_EQ(out[4], 101.f);
+  ASSERT_EQ(table.Size(), 1003);
+}
+
+TEST(ShardedSparseTable, admission) {
+  auto config = SmallConfig();
+  config.admit_count = 3;
+  ShardedSparseTable table(config);
+  int64_t id = 42;
+  float out[4];
+  for (int i = 0; i < 2; ++i) {
+    table.Get(&id, 1, out);
+    ASSERT_EQ(out[0], 0.f);
+    ASSERT_FALSE(table.HasKey(id));
+  }
+  table.Get(&id, 1, out);
+  ASSERT_EQ(out[0], 1.f);
+  ASSERT_TRUE(table.HasKey(id));
+  auto stats = table.GetStats();
+  ASSERT_EQ(stats.reject_count, 2);
+  ASSERT_EQ(stats.insert_count, 1);
+}
+
+TEST(ShardedSparseTable, lru_evict) {
+  auto config = SmallConfig();
+  config.shard_num = 1;
+  config.max_rows = 3;
+  ShardedSparseTable table(config);
+  float out[4];
+  for (int64_t id = 0; id < 3; ++id) {
+    table.Get(&id, 1, out);
+  }
+  // touch 0, so that 1 is the least recently used
+  int64_t id = 0;
+  table.Get(&id, 1, out);
+  id = 3;
+  table.Get(&id, 1, out);
+  ASSERT_EQ(table.Size(), 3);
+  ASSERT_TRUE(table.HasKey(0));
+  ASSERT_FALSE(table.HasKey(1));
+  ASSERT_TRUE(table.HasKey(2));
+  ASSERT_TRUE(table.HasKey(3));
+  ASSERT_EQ(table.GetStats().evict_count, 1);
+}
+
+TEST(ShardedSparseTable, ttl_shrink) {
+  auto config = SmallConfig();
+  config.ttl = 1;
+  ShardedSparseTable table(config);
+  float out[4];
+  std::vector<int64_t> old_ids{1, 2, 3};
+  std::vector<float> buf(old_ids.size() * 4);
+  table.Get(old_ids.data(), old_ids.size(), buf.data());
+  table.AdvanceStep();
+  int64_t id = 2;
+  table.Get(&id, 1, out);
+  table.AdvanceStep();
+  ASSERT_EQ(table.Shrink(), 2);
+  ASSERT_EQ(table.Size(), 1);
+  ASSERT_TRUE(table.HasKey(2));
+  // the freed rows are reused
+  table.Get(old_ids.data(), old_ids.size(), buf.data());
+  ASSERT_EQ(table.Size(), 3);
+}
+
+TEST(ShardedSparseTable, export_import) {
+  ShardedSparseTable table(SmallConfig());
+  std::vector<int64_t> ids{5, 9, 1000};
+  std::vector<float> values(ids.size() * 4);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<float>(i);
+  }
+  table.Import(ids.data(), ids.size(), values.data());
+
+  std::vector<int64_t> exported_ids;
+  std::vector<float> exported_values;
+  table.Export(&exported_ids, &exported_values);
+  ASSERT_EQ(exported_ids.size(), ids.size());
+
+  ShardedSparseTable other(SmallConfig());
+  other.Import(exported_ids.data(), exported_ids.size(),
+               exported_values.data());
+  std::vector<float> out(ids.size() * 4);
+  other.Get(ids.data(), ids.size(), out.data(), false);
+  ASSERT_EQ(out, values);
+}
+
+TEST(ShardedSparseTable, multi_thread) {
+  auto config = SmallConfig();
+  config.shard_num = 16;
+  ShardedSparseTable table(config);
+  const int64_t id_num = 10000;
+  const int64_t batch_size = 64;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&table, t, id_num, batch_size] {
+      std::vector<int64_t> ids(batch_size);
+      std::vector<float> out(ids.size() * 4);
+      for (int64_t i = 0; i < id_num; i += batch_size) {
+        for (size_t j = 0; j < ids.size(); ++j) {
+          ids[j] = (i + j * (t + 1)) % id_num;
+        }
+        table.Get(ids.data(), ids.size(), out.data());
+        table.Update(ids.data(), ids.size(), [](size_t i, float* row) {
+          row[0] += 1.f;
+        });
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::vector<int64_t> ids;
+  std::vector<float> values;
+  table.Export(&ids, &values);
+  ASSERT_EQ(static_cast<int64_t>(ids.size()), table.Size());
+  float sum = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    sum += values[i * 4] - 1.f;
+  }
+  int64_t batch_num = (id_num + batch_size - 1) / batch_size;
+  ASSERT_EQ(sum, 4.f * batch_num * batch_size);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,113 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Benchmark of the id lookups of the distributed sparse tables. Every thread
+// looks up batches of ids, drawn from a skewed distribution like the ids of
+// the CTR models, in the index of SelectedRows (AutoGrownIndex) and in
+// ShardedSparseTable (Get), for thread counts 1, 2, 4, ... up to --threads.
+//
+//   ./sparse_table_benchmark --threads=16 --id_num=1000000 --batch_size=512
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/framework/sharded_sparse_table.h"
+
+DEFINE_int32(threads, 8, "The max number of the threads.");
+DEFINE_int64(id_num, 1000000, "The number of the distinct ids.");
+DEFINE_int32(batch_size, 512, "The number of the ids of a lookup.");
+DEFINE_int32(batches, 2000, "The number of the lookups of every thread.");
+DEFINE_int32(value_width, 8, "The width of the rows.");
+
+namespace paddle {
+namespace framework {
+
+static std::vector<int64_t> MakeIds(int seed) {
+  std::mt19937_64 rng(seed);
+  // a few hot ids and a long tail
+  std::exponential_distribution<double> dist(8.0 / FLAGS_id_num);
+  std::vector<int64_t> ids(static_cast<size_t>(FLAGS_batch_size) *
+                           FLAGS_batches);
+  for (auto& id : ids) {
+    id = static_cast<int64_t>(dist(rng)) % FLAGS_id_num;
+  }
+  return ids;
+}
+
+// Returns the ids looked up per second.
+template <typename Lookup>
+static double Run(int thread_num, Lookup lookup) {
+  std::vector<std::vector<int64_t>> ids(thread_num);
+  for (int i = 0; i < thread_num; ++i) {
+    ids[i] = MakeIds(i);
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back([&, i] { lookup(ids[i]); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> seconds =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(thread_num) * FLAGS_batch_size * FLAGS_batches /
+         seconds.count();
+}
+
+static void Benchmark(int thread_num) {
+  SelectedRows selected_rows;
+  // AutoGrownIndex only needs the height of the value
+  selected_rows.mutable_value()->Resize(
+      make_ddim({FLAGS_id_num, FLAGS_value_width}));
+  auto selected_rows_lookup = [&](const std::vector<int64_t>& ids) {
+    for (auto id : ids) {
+      selected_rows.AutoGrownIndex(id, true);
+    }
+  };
+  double selected_rows_qps = Run(thread_num, selected_rows_lookup);
+
+  ShardedSparseTable::Config config;
+  config.value_width = FLAGS_value_width;
+  ShardedSparseTable table(config);
+  auto table_lookup = [&](const std::vector<int64_t>& ids) {
+    std::vector<float> out(static_cast<size_t>(FLAGS_batch_size) *
+                           FLAGS_value_width);
+    for (size_t i = 0; i < ids.size(); i += FLAGS_batch_size) {
+      table.Get(ids.data() + i, FLAGS_batch_size, out.data());
+    }
+  };
+  double table_qps = Run(thread_num, table_lookup);
+
+  LOG(INFO) << "threads: " << thread_num
+            << ", SelectedRows ids/s: " << selected_rows_qps
+            << ", ShardedSparseTable ids/s: " << table_qps;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  for (int thread_num = 1; thread_num <= FLAGS_threads; thread_num *= 2) {
+    paddle::framework::Benchmark(thread_num);
+  }
+  return 0;
+}
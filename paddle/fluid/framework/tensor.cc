@@ -113,5 +113,17 @@ void Tensor::ResetHolder(std::shared_ptr<memory::Allocation> holder) {
   holder_ = holder;
 }
 
+void Tensor::ResetHolderWithType(std::shared_ptr<memory::Allocation> holder,
+                                 proto::VarType::Type type) {
+  // also for a fresh tensor, whose holder may not come from mutable_data
+  if (holder && numel() > 0) {
+    PADDLE_ENFORCE_LE(offset_ + numel() * SizeOfType(type), holder->size(),
+                      "The holder is smaller than the tensor of dims %s.",
+                      dims_);
+  }
+  holder_ = holder;
+  type_ = type;
+}
+
 }  // namespace framework
 }  // namespace paddle
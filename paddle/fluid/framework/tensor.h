@@ -168,6 +168,12 @@ class Tensor {
 
   void ResetHolder(std::shared_ptr<memory::Allocation> holder);
 
+  // Makes the tensor of the given type reference the holder, e.g. an
+  // allocation of memory not allocated by the allocators. The holder should
+  // be large enough for the dims.
+  void ResetHolderWithType(std::shared_ptr<memory::Allocation> holder,
+                           proto::VarType::Type type);
+
  private:
   /*! holds the memory block if allocated. */
   std::shared_ptr<memory::Allocation> holder_;
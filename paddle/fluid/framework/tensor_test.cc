@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/tensor.h"
 #include <gtest/gtest.h>
+#include <memory>
 #include <string>
 #include "paddle/fluid/platform/float16.h"
 
@@ -237,6 +238,26 @@ TEST(Tensor, Slice) {
 #endif
 }
 
+TEST(Tensor, ResetHolderWithType) {
+  float buf[6];
+  auto holder = std::make_shared<paddle::memory::Allocation>(
+      buf, sizeof(buf), paddle::platform::CPUPlace());
+  paddle::framework::Tensor src;
+  src.Resize({2, 3});
+  src.ResetHolderWithType(holder, paddle::framework::proto::VarType::FP32);
+  ASSERT_EQ(src.data<float>(), buf);
+
+  // a fresh tensor larger than the holder
+  paddle::framework::Tensor large;
+  large.Resize({2, 4});
+  ASSERT_THROW(large.ResetHolderWithType(
+                   holder, paddle::framework::proto::VarType::FP32),
+               paddle::platform::EnforceNotMet);
+  ASSERT_THROW(src.ResetHolderWithType(
+                   holder, paddle::framework::proto::VarType::FP64),
+               paddle::platform::EnforceNotMet);
+}
+
 TEST(Tensor, ReshapeToMatrix) {
   framework::Tensor src;
   int* src_ptr = src.mutable_data<int>({2, 3, 4, 9}, platform::CPUPlace());
@@ -13,6 +13,11 @@
    limitations under the License. */
 
 #include "paddle/fluid/framework/threadpool.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -22,10 +27,21 @@
 DEFINE_int32(io_threadpool_size, 100,
              "number of threads used for doing IO, default 100");
 
+DEFINE_bool(threadpool_bind_cpu, false,
+            "whether to bind the threads of the global ThreadPool to CPUs");
+
 DECLARE_int32(dist_threadpool_size);
 
 namespace paddle {
 namespace framework {
+
+namespace {
+// The ThreadPool and the worker index of the current thread, so that a task
+// scheduled inside a worker is pushed to its own deque.
+thread_local ThreadPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+}  // namespace
+
 std::unique_ptr<ThreadPool> ThreadPool::threadpool_(nullptr);
 std::once_flag ThreadPool::init_flag_;
 
@@ -43,21 +59,26 @@ void ThreadPool::Init() {
       VLOG(1) << "set dist_threadpool_size to " << num_threads;
     }
     PADDLE_ENFORCE_GT(num_threads, 0);
-    threadpool_.reset(new ThreadPool(num_threads));
+    threadpool_.reset(new ThreadPool(num_threads, FLAGS_threadpool_bind_cpu));
   }
 }
 
-ThreadPool::ThreadPool(int num_threads) : running_(true) {
+ThreadPool::ThreadPool(int num_threads, bool bind_cpu) : running_(true) {
+  PADDLE_ENFORCE_GT(num_threads, 0);
+  workers_.resize(num_threads);
+  for (auto& worker : workers_) {
+    worker.reset(new Worker);
+  }
   threads_.resize(num_threads);
-  for (auto& thread : threads_) {
-    // TODO(Yancey1989): binding the thread on the specify CPU number
-    thread.reset(new std::thread(std::bind(&ThreadPool::TaskLoop, this)));
+  for (int i = 0; i < num_threads; ++i) {
+    threads_[i].reset(
+        new std::thread(std::bind(&ThreadPool::TaskLoop, this, i, bind_cpu)));
   }
 }
 
 ThreadPool::~ThreadPool() {
   {
-    // notify all threads to stop running
+    // notify all threads to stop running, the pending tasks are still run
     std::unique_lock<std::mutex> l(mutex_);
     running_ = false;
   }
@@ -69,29 +90,91 @@ ThreadPool::~ThreadPool() {
   }
 }
 
-void ThreadPool::TaskLoop() {
-  while (true) {
-    Task task;
+void ThreadPool::Schedule(Task&& task) {
+  if (!running_) {
+    PADDLE_THROW("enqueue on stopped ThreadPool");
+  }
+  int index = current_pool == this
+                  ? current_worker
+                  : static_cast<int>(next_worker_.fetch_add(
+                                         1, std::memory_order_relaxed) %
+                                     workers_.size());
+  {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    workers_[index]->tasks.push_back(std::move(task));
+  }
+  // pairs with TaskLoop: either the idle worker sees the new task before it
+  // sleeps, or we see the idle worker here and wake it up.
+  pending_.fetch_add(1);
+  if (idle_.load() != 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scheduled_.notify_one();
+  }
+}
 
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-      scheduled_.wait(
-          lock, [this] { return !this->tasks_.empty() || !this->running_; });
+bool ThreadPool::PopTask(int index, Task* task) {
+  Worker* worker = workers_[index].get();
+  std::lock_guard<std::mutex> lock(worker->mutex);
+  if (worker->tasks.empty()) {
+    return false;
+  }
+  *task = std::move(worker->tasks.front());
+  worker->tasks.pop_front();
+  return true;
+}
 
-      if (!running_ && tasks_.empty()) {
-        return;
-      }
+bool ThreadPool::StealTask(int index, Task* task) {
+  size_t num = workers_.size();
+  for (size_t i = 1; i < num; ++i) {
+    Worker* victim = workers_[(index + i) % num].get();
+    std::unique_lock<std::mutex> lock(victim->mutex, std::try_to_lock);
+    if (!lock.owns_lock() || victim->tasks.empty()) {
+      continue;
+    }
+    *task = std::move(victim->tasks.back());
+    victim->tasks.pop_back();
+    return true;
+  }
+  return false;
+}
 
-      if (tasks_.empty()) {
-        PADDLE_THROW("This thread has no task to Run");
-      }
+void ThreadPool::TaskLoop(int index, bool bind_cpu) {
+#ifdef __linux__
+  if (bind_cpu) {
+    unsigned int cpu_num = std::max(1U, std::thread::hardware_concurrency());
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(index % cpu_num, &mask);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) != 0) {
+      LOG(WARNING) << "Failed to bind the thread " << index << " to CPU";
+    }
+  }
+#endif
+  current_pool = this;
+  current_worker = index;
+  while (true) {
+    Task task;
+    // Stealing may miss a task when the deque of the victim is locked, so
+    // try again before sleeping while there are pending tasks.
+    if (PopTask(index, &task) || StealTask(index, &task)) {
+      pending_.fetch_sub(1);
+      // run the task
+      task();
+      continue;
+    }
+    if (pending_.load() > 0) {
+      std::this_thread::yield();
+      continue;
+    }
 
-      // pop a task from the task queue
-      task = std::move(tasks_.front());
-      tasks_.pop();
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.fetch_add(1);
+    scheduled_.wait(lock,
+                    [this] { return pending_.load() > 0 || !running_; });
+    idle_.fetch_sub(1);
+    if (!running_ && pending_.load() == 0) {
+      return;
     }
-    // run the task
-    task();
   }
 }
 
@@ -14,12 +14,15 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>  // NOLINT
+#include <deque>
 #include <functional>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
-#include <queue>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 #include "glog/logging.h"
 #include "paddle/fluid/platform/enforce.h"
@@ -44,19 +47,79 @@ struct ExceptionHandler {
   }
 };
 
-// ThreadPool maintains a queue of tasks, and runs them using a fixed
-// number of threads.
+// TaskGroup waits for a group of tasks run by ThreadPool::Run(fn, group). It
+// is cheaper than holding one std::future per task: finishing a task is one
+// atomic decrement, only the last task takes the mutex to wake the waiter.
+// A TaskGroup can be reused after Wait returns.
+class TaskGroup {
+ public:
+  TaskGroup() {}
+
+  // Called before a task of the group is scheduled.
+  void Add(int n = 1) { count_.fetch_add(n, std::memory_order_relaxed); }
+
+  // Called when a task of the group is finished.
+  void Done() {
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_ = true;
+      cond_.notify_all();
+    }
+  }
+
+  // Keeps the first exception thrown by the tasks of the group.
+  void SetException(std::unique_ptr<platform::EnforceNotMet>&& ex) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (exception_ == nullptr) {
+      exception_ = std::move(ex);
+    }
+  }
+
+  // Blocks until all of the added tasks are done, returns the first
+  // exception thrown by them, or nullptr.
+  std::unique_ptr<platform::EnforceNotMet> Wait() {
+    // count_ starts from 1 so that the last Done always sets finished_, and
+    // the waiter returns only after it, when no task touches the group.
+    Done();
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this] { return finished_; });
+    finished_ = false;
+    count_.store(1, std::memory_order_relaxed);
+    return std::move(exception_);
+  }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(TaskGroup);
+
+  std::atomic<int> count_{1};
+  bool finished_{false};
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::unique_ptr<platform::EnforceNotMet> exception_;
+};
+
+// ThreadPool runs tasks using a fixed number of threads, with a
+// work-stealing scheduler. Every worker thread owns a task deque. A task
+// scheduled inside a worker thread is pushed to the deque of that worker,
+// and a task scheduled by other threads is pushed to the deques in
+// round-robin. A worker runs the tasks of its own deque from the front, and
+// steals tasks from the back of the other deques when its own is empty, so
+// that the workers do not contend on one queue.
 class ThreadPool {
  public:
-  explicit ThreadPool(int num_threads);
+  // If bind_cpu is true, the i-th worker thread is bound to the CPU
+  // (i % hardware_concurrency) on Linux.
+  explicit ThreadPool(int num_threads, bool bind_cpu = false);
 
-  using Task = std::packaged_task<std::unique_ptr<platform::EnforceNotMet>()>;
+  using Task = std::function<void()>;
 
   // Returns the singleton of ThreadPool.
   static ThreadPool* GetInstance();
 
   ~ThreadPool();
 
+  int NumThreads() const { return static_cast<int>(threads_.size()); }
+
   // Run pushes a function to the task queue and returns a std::future
   // object. To wait for the completion of the task, call
   // std::future::wait().
@@ -69,37 +132,70 @@ class ThreadPool {
   template <typename Callback>
   std::future<std::unique_ptr<platform::EnforceNotMet>> RunAndGetException(
       Callback fn) {
-    Task task([fn]() -> std::unique_ptr<platform::EnforceNotMet> {
-      try {
-        fn();
-      } catch (platform::EnforceNotMet ex) {
-        return std::unique_ptr<platform::EnforceNotMet>(
-            new platform::EnforceNotMet(ex));
-      } catch (const std::exception& e) {
-        LOG(FATAL) << "Unexpected exception is catched in thread pool. All "
-                      "throwable exception in Fluid should be an EnforceNotMet."
-                   << e.what();
+    using Promise = std::promise<std::unique_ptr<platform::EnforceNotMet>>;
+    auto promise = std::make_shared<Promise>();
+    auto f = promise->get_future();
+    Schedule([fn, promise]() { promise->set_value(RunAndCatch(fn)); });
+    return f;
+  }
+
+  // Run pushes a function to the task queue, and the completion and the
+  // exception of it is reported to group. It does not create a std::future
+  // for every task. If group is nullptr, the exception is LOG(FATAL).
+  template <typename Callback>
+  void Run(Callback fn, TaskGroup* group) {
+    if (group != nullptr) {
+      group->Add();
+    }
+    Schedule([fn, group]() {
+      auto ex = RunAndCatch(fn);
+      if (group != nullptr) {
+        if (ex != nullptr) {
+          group->SetException(std::move(ex));
+        }
+        group->Done();
+      } else if (ex != nullptr) {
+        LOG(FATAL) << "The exception is thrown inside the thread pool. You "
+                      "should run the task with a TaskGroup to handle the "
+                      "exception.\n"
+                   << ex->what();
       }
-      return nullptr;
     });
-    std::future<std::unique_ptr<platform::EnforceNotMet>> f = task.get_future();
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-      if (!running_) {
-        PADDLE_THROW("enqueue on stopped ThreadPool");
-      }
-      tasks_.push(std::move(task));
-    }
-    scheduled_.notify_one();
-    return f;
   }
 
  private:
   DISABLE_COPY_AND_ASSIGN(ThreadPool);
 
-  // The constructor starts threads to run TaskLoop, which retrieves
-  // and runs tasks from the queue.
-  void TaskLoop();
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  template <typename Callback>
+  static std::unique_ptr<platform::EnforceNotMet> RunAndCatch(
+      const Callback& fn) {
+    try {
+      fn();
+    } catch (platform::EnforceNotMet ex) {
+      return std::unique_ptr<platform::EnforceNotMet>(
+          new platform::EnforceNotMet(ex));
+    } catch (const std::exception& e) {
+      LOG(FATAL) << "Unexpected exception is catched in thread pool. All "
+                    "throwable exception in Fluid should be an EnforceNotMet."
+                 << e.what();
+    }
+    return nullptr;
+  }
+
+  // Push a task to a worker deque and wake up an idle worker if any.
+  void Schedule(Task&& task);
+
+  // The constructor starts threads to run TaskLoop, which runs the tasks of
+  // its own deque and steals tasks from the others.
+  void TaskLoop(int index, bool bind_cpu);
+
+  bool PopTask(int index, Task* task);
+  bool StealTask(int index, Task* task);
 
   // Init is called by GetInstance.
   static void Init();
@@ -109,10 +205,15 @@ class ThreadPool {
   static std::once_flag init_flag_;
 
   std::vector<std::unique_ptr<std::thread>> threads_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<unsigned> next_worker_{0};
+
+  // the number of tasks in the deques, and of the sleeping workers
+  std::atomic<int64_t> pending_{0};
+  std::atomic<int> idle_{0};
 
-  std::queue<Task> tasks_;
   std::mutex mutex_;
-  bool running_;
+  std::atomic<bool> running_;
   std::condition_variable scheduled_;
 };
 
@@ -135,6 +236,12 @@ std::future<void> Async(Callback callback) {
   return ThreadPool::GetInstance()->Run(callback);
 }
 
+// Run a function asynchronously, the completion is reported to group.
+template <typename Callback>
+void Async(Callback callback, TaskGroup* group) {
+  ThreadPool::GetInstance()->Run(callback, group);
+}
+
 template <typename Callback>
 std::future<void> AsyncIO(Callback callback) {
   return ThreadPoolIO::GetInstanceIO()->Run(callback);
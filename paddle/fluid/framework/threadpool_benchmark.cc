@@ -0,0 +1,206 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Benchmark of the scheduling overhead per op of a graph of small ops, the
+// way FastThreadedSSAGraphExecutor runs it: every op is a task, and a
+// finished op schedules its ready successors. It compares the single-queue
+// ::ThreadPool in third_party with the work-stealing framework::ThreadPool,
+// and std::future with TaskGroup for waiting independent tasks.
+//
+//   ./threadpool_benchmark --threads=4 --op_num=100000 --op_work=50
+
+#include <ThreadPool.h>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <future>  // NOLINT
+#include <mutex>  // NOLINT
+#include <random>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/threadpool.h"
+
+DEFINE_int32(threads, 4, "The number of threads of the pools.");
+DEFINE_int32(op_num, 100000, "The number of ops in the graph.");
+DEFINE_int32(max_outputs, 3, "The max number of successors of an op.");
+DEFINE_int32(op_work, 50, "The number of loop iterations in an op.");
+DEFINE_int32(repeat, 5, "Repeat times of each case.");
+
+namespace paddle {
+namespace framework {
+
+struct OpGraph {
+  std::vector<std::vector<int>> outputs;
+  std::vector<int> deps;
+  std::vector<int> bootstrap;
+};
+
+// Every op links to up to max_outputs random ops in the next 64 ops, so
+// there is enough parallelism while the graph stays connected.
+OpGraph MakeGraph() {
+  OpGraph graph;
+  std::mt19937 rng(0);
+  graph.outputs.resize(FLAGS_op_num);
+  graph.deps.resize(FLAGS_op_num, 0);
+  for (int i = 0; i < FLAGS_op_num; ++i) {
+    int out_num = rng() % (FLAGS_max_outputs + 1);
+    for (int j = 0; j < out_num; ++j) {
+      int out = i + 1 + rng() % 64;
+      if (out < FLAGS_op_num) {
+        graph.outputs[i].push_back(out);
+        ++graph.deps[out];
+      }
+    }
+  }
+  for (int i = 0; i < FLAGS_op_num; ++i) {
+    if (graph.deps[i] == 0) {
+      graph.bootstrap.push_back(i);
+    }
+  }
+  return graph;
+}
+
+inline void OpWork() {
+  volatile int x = 0;
+  for (int i = 0; i < FLAGS_op_work; ++i) {
+    x = x + i;
+  }
+}
+
+// Run the graph with submit(std::function<void()>), returns ns per op.
+template <typename Submit>
+double RunGraph(const OpGraph& graph, Submit submit) {
+  std::vector<std::atomic<int>> deps(graph.deps.size());
+  for (size_t i = 0; i < deps.size(); ++i) {
+    deps[i] = graph.deps[i];
+  }
+  std::atomic<int> remaining(FLAGS_op_num);
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool finished = false;
+
+  std::function<void(int)> run_op = [&](int op) {
+    OpWork();
+    for (int out : graph.outputs[op]) {
+      if (deps[out].fetch_sub(1) == 1) {
+        submit([&run_op, out] { run_op(out); });
+      }
+    }
+    if (remaining.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished = true;
+      cond.notify_all();
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (int op : graph.bootstrap) {
+    submit([&run_op, op] { run_op(op); });
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&] { return finished; });
+  }
+  std::chrono::duration<double, std::nano> ns =
+      std::chrono::steady_clock::now() - start;
+  return ns.count() / FLAGS_op_num;
+}
+
+template <typename Fn>
+double Best(Fn fn) {
+  double best = 0;
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    double t = fn();
+    best = (i == 0 || t < best) ? t : best;
+  }
+  return best;
+}
+
+void Run() {
+  OpGraph graph = MakeGraph();
+  LOG(INFO) << FLAGS_op_num << " ops, " << graph.bootstrap.size()
+            << " bootstrap ops, " << FLAGS_threads << " threads";
+
+  double work = Best([] {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FLAGS_op_num; ++i) {
+      OpWork();
+    }
+    std::chrono::duration<double, std::nano> ns =
+        std::chrono::steady_clock::now() - start;
+    return ns.count() / FLAGS_op_num;
+  });
+  LOG(INFO) << "op work only: " << work << " ns/op";
+
+  {
+    ::ThreadPool pool(FLAGS_threads);
+    double t = Best([&] {
+      return RunGraph(graph, [&pool](std::function<void()> fn) {
+        pool.enqueue(fn);
+      });
+    });
+    LOG(INFO) << "graph, ::ThreadPool (single queue): " << t << " ns/op";
+  }
+  {
+    ThreadPool pool(FLAGS_threads);
+    double t = Best([&] {
+      return RunGraph(graph, [&pool](std::function<void()> fn) {
+        pool.Run(fn, nullptr);
+      });
+    });
+    LOG(INFO) << "graph, framework::ThreadPool (work stealing): " << t
+              << " ns/op";
+  }
+
+  // independent tasks waited by the caller
+  ThreadPool pool(FLAGS_threads);
+  double future_ns = Best([&] {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> fs;
+    fs.reserve(FLAGS_op_num);
+    for (int i = 0; i < FLAGS_op_num; ++i) {
+      fs.push_back(pool.Run(OpWork));
+    }
+    for (auto& f : fs) {
+      f.wait();
+    }
+    std::chrono::duration<double, std::nano> ns =
+        std::chrono::steady_clock::now() - start;
+    return ns.count() / FLAGS_op_num;
+  });
+  double group_ns = Best([&] {
+    auto start = std::chrono::steady_clock::now();
+    TaskGroup group;
+    for (int i = 0; i < FLAGS_op_num; ++i) {
+      pool.Run(OpWork, &group);
+    }
+    group.Wait();
+    std::chrono::duration<double, std::nano> ns =
+        std::chrono::steady_clock::now() - start;
+    return ns.count() / FLAGS_op_num;
+  });
+  LOG(INFO) << "independent tasks, std::future: " << future_ns
+            << " ns/op, TaskGroup: " << group_ns << " ns/op";
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::Run();
+  return 0;
+}
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <gtest/gtest.h>
 #include <atomic>
+#include <string>
 
 #include "paddle/fluid/framework/threadpool.h"
 
@@ -59,3 +60,40 @@ TEST(ThreadPool, ConcurrentRun) {
   }
   EXPECT_EQ(sum, ((n + 1) * n) / 2);
 }
+
+TEST(ThreadPool, TaskGroup) {
+  framework::ThreadPool pool(4);
+  framework::TaskGroup group;
+  std::atomic<int> sum(0);
+  // the tasks spawn tasks in the same group, which are pushed to the deque of
+  // the current worker and may be stolen by the others
+  for (int i = 0; i < 100; ++i) {
+    pool.Run(
+        [&pool, &group, &sum]() {
+          for (int j = 0; j < 10; ++j) {
+            pool.Run([&sum]() { sum.fetch_add(1); }, &group);
+          }
+          sum.fetch_add(1);
+        },
+        &group);
+  }
+  EXPECT_EQ(group.Wait(), nullptr);
+  EXPECT_EQ(sum, 1100);
+
+  // the group can be reused, and an empty group returns immediately
+  EXPECT_EQ(group.Wait(), nullptr);
+  pool.Run([]() { PADDLE_THROW("error in task"); }, &group);
+  pool.Run([&sum]() { sum.fetch_add(1); }, &group);
+  auto ex = group.Wait();
+  ASSERT_NE(ex, nullptr);
+  EXPECT_NE(std::string(ex->what()).find("error in task"), std::string::npos);
+  EXPECT_EQ(sum, 1101);
+}
+
+TEST(ThreadPool, RunAndGetException) {
+  framework::ThreadPool pool(2, true);
+  auto ok = pool.RunAndGetException([]() {});
+  auto failed = pool.RunAndGetException([]() { PADDLE_THROW("failed"); });
+  EXPECT_EQ(ok.get(), nullptr);
+  EXPECT_NE(failed.get(), nullptr);
+}
@@ -196,6 +196,18 @@ static std::string GetOrCreateModelOptCacheDir(const std::string &model_root) {
   return opt_cache_dir;
 }
 
+// The optimized program and its parameters cached by AnalysisPredictor, see
+// AnalysisConfig::SwitchOptimProgramCache.
+static std::string GetOptimProgramCachePath(
+    const std::string &model_opt_cache_dir, const std::string &cache_key) {
+  return model_opt_cache_dir + "/optim_program_" + cache_key;
+}
+
+static std::string GetOptimParamsCachePath(
+    const std::string &model_opt_cache_dir, const std::string &cache_key) {
+  return model_opt_cache_dir + "/optim_params_" + cache_key;
+}
+
 static std::string GetTrtCalibPath(const std::string &model_root,
                                    const std::string &engine_key) {
   return model_root + "/trt_calib_" + engine_key;
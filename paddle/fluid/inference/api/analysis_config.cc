@@ -103,6 +103,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_memory_optim_);
   CP_MEMBER(static_memory_optim_);
   CP_MEMBER(static_memory_optim_force_update_);
+  CP_MEMBER(activation_arena_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -134,6 +135,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_ir_optim_);
   CP_MEMBER(use_feed_fetch_ops_);
   CP_MEMBER(ir_debug_);
+  CP_MEMBER(shape_signature_cache_);
+  CP_MEMBER(optim_program_cache_);
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
@@ -319,6 +322,17 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  // It sets an attribute of all the ops, so it should be after the passes
+  // creating ops.
+  pass_builder()->DeletePass("shape_signature_cache_pass");
+  if (shape_signature_cache_) {
+    if (!enable_ir_optim_) {
+      LOG(ERROR) << "SwitchShapeSignatureCache() only works when IR "
+                    "optimization is enabled.";
+    }
+    pass_builder()->AppendPass("shape_signature_cache_pass");
+  }
+
 #ifdef PADDLE_WITH_MKLDNN
   // Do not optimize before quantization
   if (enable_memory_optim_ && !use_mkldnn_quantizer_) {
@@ -370,6 +384,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << enable_memory_optim_;
   ss << static_memory_optim_;
   ss << static_memory_optim_force_update_;
+  ss << activation_arena_;
 
   ss << use_ngraph_;
 
@@ -384,6 +399,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << enable_ir_optim_;
   ss << use_feed_fetch_ops_;
   ss << ir_debug_;
+  ss << shape_signature_cache_;
+  ss << optim_program_cache_;
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
@@ -455,6 +472,11 @@ void AnalysisConfig::SwitchIrDebug(int x) {
   ir_debug_ = x;
   Update();
 }
+
+void AnalysisConfig::SwitchShapeSignatureCache(int x) {
+  shape_signature_cache_ = x;
+  Update();
+}
 void AnalysisConfig::EnableAnakinEngine(
     int max_batch_size, std::map<std::string, std::vector<int>> max_input_shape,
     int min_subgraph_size, AnalysisConfig::Precision precision_mode,
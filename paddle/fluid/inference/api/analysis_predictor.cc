@@ -14,16 +14,25 @@
 
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
+#include <xxhash.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
+#include "paddle/fluid/framework/commit.h"
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 #include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/mmap_param_file.h"
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/var_type_traits.h"
@@ -171,6 +180,9 @@ bool AnalysisPredictor::CreateExecutor() {
 bool AnalysisPredictor::PrepareExecutor() {
   executor_->Prepare(sub_scope_, *inference_program_, 0,
                      config_.use_feed_fetch_ops_);
+  if (config_.activation_arena_enabled()) {
+    executor_->EnableActivationArena(*inference_program_, 0);
+  }
 
   PADDLE_ENFORCE_NOT_NULL(sub_scope_);
 
@@ -460,6 +472,19 @@ void AnalysisPredictor::PrepareArgument() {
 
 // NOTE All the members in AnalysisConfig should be copied to Argument.
 void AnalysisPredictor::OptimizeInferenceProgram() {
+  inference::Timer timer;
+  timer.tic();
+  std::string cache_key;
+  if (OptimProgramCacheEnabled()) {
+    cache_key = OptimProgramCacheKey();
+    if (LoadOptimProgramCache(cache_key)) {
+      config_.PartiallyRelease();
+      LOG(INFO) << "== optimized program loaded from the cache in "
+                << timer.toc() << " ms ==";
+      return;
+    }
+  }
+
   PrepareArgument();
   Analyzer().Run(&argument_);
 
@@ -468,6 +493,10 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
   ARGUMENT_CHECK_FIELD((&argument_), ir_analyzed_program);
   inference_program_.reset(
       new framework::ProgramDesc(argument_.ir_analyzed_program()));
+  if (!cache_key.empty()) {
+    LOG(INFO) << "== optimized the program in " << timer.toc() << " ms ==";
+    SaveOptimProgramCache(cache_key);
+  }
   // The config and argument take a lot of storage,
   // when the predictor settings are complete, we release these stores.
   argument_.PartiallyRelease();
@@ -714,7 +743,8 @@ bool AnalysisPredictor::LoadParameters() {
   if (!config_.params_file().empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
-    // append just the load_combine op
+    // append just the load_combine op, which maps the file instead of
+    // reading it if it was saved with mmap_format
     framework::OpDesc *op = load_block->AppendOp();
     op->SetType("load_combine");
     op->SetOutput("Out", params);
@@ -731,6 +761,145 @@ bool AnalysisPredictor::LoadParameters() {
   return true;
 }
 
+bool AnalysisPredictor::OptimProgramCacheEnabled() const {
+  // The subgraph engines hold states that are not in the program.
+  return config_.optim_program_cache_enabled() &&
+         !config_.opt_cache_dir_.empty() && config_.ir_optim() &&
+         !config_.use_gpu() && !config_.anakin_engine_enabled() &&
+         !config_.ngraph_enabled() && !config_.mkldnn_quantizer_enabled();
+}
+
+std::string AnalysisPredictor::OptimProgramCacheKey() {
+  std::stringstream ss;
+  // The passes of another build may optimize the program differently.
+  ss << framework::paddle_version() << ";" << framework::paddle_commit()
+     << ";";
+  ss << inference_program_->Proto()->SerializeAsString();
+  // The parameter files are identified by their sizes and modification times,
+  // hashing their content would take about as long as optimizing the program.
+  auto file_signature = [&ss](const std::string &path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+      ss << path << ":" << st.st_size << ":" << st.st_mtime << ";";
+    }
+  };
+  if (config_.model_from_memory()) {
+    ss << config_.params_file();
+  } else if (!config_.params_file().empty()) {
+    file_signature(config_.params_file());
+  } else {
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var)) {
+        file_signature(config_.model_dir() + "/" + var->Name());
+      }
+    }
+  }
+  for (auto &pass : config_.pass_builder()->AllPasses()) {
+    ss << pass << ";";
+  }
+  for (auto &pass : config_.pass_builder()->AnalysisPasses()) {
+    ss << pass << ";";
+  }
+  ss << config_.use_mkldnn_;
+  for (auto &type : config_.mkldnn_enabled_op_types_) ss << type << ";";
+  ss << config_.enable_memory_optim_;
+  ss << config_.static_memory_optim_;
+  // std::hash differs between the standard libraries, the key should be
+  // stable across the builds sharing the cache directory.
+  auto key = ss.str();
+  char digest[17];
+  snprintf(digest, sizeof(digest), "%016llx",
+           static_cast<unsigned long long>(  // NOLINT
+               XXH64(key.data(), key.size(), 0)));
+  return digest;
+}
+
+bool AnalysisPredictor::LoadOptimProgramCache(const std::string &cache_key) {
+  auto program_path = inference::analysis::GetOptimProgramCachePath(
+      config_.opt_cache_dir_, cache_key);
+  auto params_path = inference::analysis::GetOptimParamsCachePath(
+      config_.opt_cache_dir_, cache_key);
+  // The program is written after the parameters, so the parameters are
+  // complete if the program exists.
+  if (!inference::analysis::FileExists(program_path) ||
+      !framework::MmapParamFile::IsMmapParamFile(params_path)) {
+    return false;
+  }
+
+  auto params = framework::MmapParamFile::Open(params_path);
+  for (size_t i = 0; i < params->size(); ++i) {
+    auto *tensor =
+        scope_->Var(params->name(i))->GetMutable<framework::LoDTensor>();
+    params->LoadTensor(i, place_, tensor);
+  }
+  inference_program_.reset(new framework::ProgramDesc(
+      inference::analysis::LoadProgramDesc(program_path)));
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimProgramCache(const std::string &cache_key) {
+  auto &cache_dir = config_.opt_cache_dir_;
+  if (!inference::analysis::PathExists(cache_dir) &&
+      MKDIR(cache_dir.c_str()) == -1) {
+    LOG(WARNING) << "Cannot create the optimize cache directory " << cache_dir;
+    return;
+  }
+  auto program_path =
+      inference::analysis::GetOptimProgramCachePath(cache_dir, cache_key);
+  auto params_path =
+      inference::analysis::GetOptimParamsCachePath(cache_dir, cache_key);
+  // The files are written under temporary names and renamed, so that the
+  // predictors starting concurrently never see a partial cache.
+  // The pid tells apart the predictors of the processes sharing the cache
+  // directory, whose addresses and ids may be the same.
+  std::string tmp_suffix = ".tmp" + std::to_string(getpid()) + "_" +
+                           std::to_string(predictor_id_) + "_" +
+                           std::to_string(reinterpret_cast<uintptr_t>(this));
+
+  std::vector<std::string> params;
+  for (auto *var : inference_program_->Block(0).AllVars()) {
+    if (!IsPersistable(var)) continue;
+    auto *scope_var = scope_->FindVar(var->Name());
+    if (scope_var && scope_var->IsType<framework::LoDTensor>() &&
+        scope_var->Get<framework::LoDTensor>().IsInitialized()) {
+      params.push_back(var->Name());
+    }
+  }
+  std::sort(params.begin(), params.end());
+  {
+    std::ofstream fout(params_path + tmp_suffix,
+                       std::ios::out | std::ios::binary);
+    if (!fout) {
+      LOG(WARNING) << "Cannot write the optimized parameters to "
+                   << params_path;
+      return;
+    }
+    auto &dev_ctx = *platform::DeviceContextPool::Instance().Get(place_);
+    framework::MmapParamFileWriter writer(&fout);
+    for (auto &name : params) {
+      writer.Append(name, scope_->FindVar(name)->Get<framework::LoDTensor>(),
+                    dev_ctx);
+    }
+    writer.Finish();
+  }
+  {
+    std::ofstream fout(program_path + tmp_suffix,
+                       std::ios::out | std::ios::binary);
+    fout << GetSerializedProgram();
+  }
+  if (std::rename((params_path + tmp_suffix).c_str(), params_path.c_str()) !=
+          0 ||
+      std::rename((program_path + tmp_suffix).c_str(),
+                  program_path.c_str()) != 0) {
+    LOG(WARNING) << "Cannot save the optimized program cache to " << cache_dir;
+    std::remove((params_path + tmp_suffix).c_str());
+    std::remove((program_path + tmp_suffix).c_str());
+    return;
+  }
+  LOG(INFO) << "Saved the optimized program and " << params.size()
+            << " parameters to the cache " << program_path;
+}
+
 #if PADDLE_WITH_TENSORRT
 bool AnalysisPredictor::SaveTrtCalibToDisk() {
   PADDLE_ENFORCE(config_.tensorrt_engine_enabled(),
@@ -822,6 +991,24 @@ std::unique_ptr<PaddlePredictor> AnalysisPredictor::Clone() {
   return std::unique_ptr<PaddlePredictor>(x);
 }
 
+std::unique_ptr<PaddlePredictor> AnalysisPredictor::CloneWithParamsCopy() {
+  std::lock_guard<std::mutex> lk(clone_mutex_);
+  auto scope = std::make_shared<framework::Scope>();
+  executor_->CreateVariables(*inference_program_, 0, true, scope.get());
+  for (auto &name : scope->LocalVarNames()) {
+    auto *src = scope_->FindVar(name);
+    if (!src || !src->IsType<framework::LoDTensor>()) continue;
+    auto &src_tensor = src->Get<framework::LoDTensor>();
+    if (!src_tensor.IsInitialized()) continue;
+    auto *dst_tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+    framework::TensorCopySync(src_tensor, src_tensor.place(), dst_tensor);
+    dst_tensor->set_lod(src_tensor.lod());
+  }
+  auto *x = new AnalysisPredictor(config_);
+  x->Init(scope, inference_program_);
+  return std::unique_ptr<PaddlePredictor>(x);
+}
+
 void AnalysisPredictor::CollectVarShapes() {
   VLOG(4) << "Collecting var shapes";
   if (batch_var_shapes_.size() >= max_shape_collect_count_) return;
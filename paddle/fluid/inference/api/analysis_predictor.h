@@ -17,6 +17,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/inference/analysis/analyzer.h"
@@ -76,12 +77,23 @@ class AnalysisPredictor : public PaddlePredictor {
   Argument &analysis_argument() { return argument_; }
 
   std::unique_ptr<PaddlePredictor> Clone() override;
+  // Clone with its own copy of the parameters, allocated by the calling
+  // thread, so the copy is placed on the NUMA node of the thread.
+  std::unique_ptr<PaddlePredictor> CloneWithParamsCopy();
 
   framework::Scope *scope() { return scope_.get(); }
   framework::ProgramDesc &program() { return *inference_program_; }
 
   std::string GetSerializedProgram() const override;
 
+  // The statistics of the runs of the ops by op type, e.g. the InferShape
+  // calls skipped by AnalysisConfig::SwitchShapeSignatureCache(). Only the
+  // ops with the cache enabled are counted.
+  std::unordered_map<std::string, framework::OpRunStats> GetOpRunStats()
+      const {
+    return executor_->GetOpRunStats();
+  }
+
   bool MkldnnQuantize();
 
   // save program to  model
@@ -102,6 +114,12 @@ class AnalysisPredictor : public PaddlePredictor {
   bool LoadProgramDesc();
   bool LoadParameters();
 
+  // The optimized program cache, see AnalysisConfig::SwitchOptimProgramCache.
+  bool OptimProgramCacheEnabled() const;
+  std::string OptimProgramCacheKey();
+  bool LoadOptimProgramCache(const std::string &cache_key);
+  void SaveOptimProgramCache(const std::string &cache_key);
+
   bool SetFeed(const std::vector<PaddleTensor> &input_datas,
                framework::Scope *scope);
   bool GetFetch(std::vector<PaddleTensor> *output_data,
@@ -193,6 +193,88 @@ TEST(AnalysisPredictor, Clone) {
   }
 }
 
+TEST(AnalysisPredictor, CloneWithParamsCopy) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  auto* analysis = static_cast<AnalysisPredictor*>(predictor.get());
+  auto copy = analysis->CloneWithParamsCopy();
+  auto* copy_scope = static_cast<AnalysisPredictor*>(copy.get())->scope();
+  ASSERT_NE(copy_scope, analysis->scope());
+
+  // The parameters are copied, not shared.
+  for (auto* var : analysis->program().Block(0).AllVars()) {
+    if (!var->Persistable() ||
+        var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+      continue;
+    }
+    auto* src = analysis->scope()->FindVar(var->Name());
+    if (!src || !src->Get<framework::LoDTensor>().IsInitialized()) continue;
+    auto& dst = copy_scope->FindVar(var->Name())->Get<framework::LoDTensor>();
+    ASSERT_NE(dst.data<void>(), src->Get<framework::LoDTensor>().data<void>());
+  }
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs, copy_outputs;
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  ASSERT_TRUE(copy->Run(inputs, &copy_outputs));
+  ASSERT_EQ(outputs.size(), copy_outputs.size());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    inference::CompareTensor(outputs[i], copy_outputs[i]);
+  }
+}
+
+TEST(AnalysisPredictor, optim_program_cache) {
+  std::string cache_dir = FLAGS_dirname + "/_optim_program_cache";
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SetOptimCacheDir(cache_dir);
+  config.SwitchOptimProgramCache();
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs, cached_outputs;
+  std::string program, cached_program;
+
+  inference::Timer timer;
+  {
+    // The first predictor optimizes the program and writes the cache.
+    timer.tic();
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    LOG(INFO) << "startup without the cache: " << timer.toc() << " ms";
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    program = predictor->GetSerializedProgram();
+  }
+  {
+    // The second predictor loads the optimized program from the cache.
+    timer.tic();
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    LOG(INFO) << "startup with the cache: " << timer.toc() << " ms";
+    ASSERT_TRUE(predictor->Run(inputs, &cached_outputs));
+    cached_program = predictor->GetSerializedProgram();
+  }
+
+  ASSERT_EQ(program, cached_program);
+  ASSERT_EQ(outputs.size(), cached_outputs.size());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    inference::CompareTensor(outputs[i], cached_outputs[i]);
+  }
+}
+
 // This function is not released yet, will fail on some machine.
 // TODO(Superjomn) Turn on it latter.
 /*
@@ -0,0 +1,347 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/batching_predictor.h"
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstring>
+#include <future>  // NOLINT
+#include <sstream>
+#include <utility>
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+namespace {
+
+constexpr int kLatencyBuckets = 32;
+
+int64_t NumElements(const std::vector<int> &shape) {
+  int64_t num = 1;
+  for (auto d : shape) num *= d;
+  return num;
+}
+
+size_t TensorBytes(const PaddleTensor &tensor) {
+  return NumElements(tensor.shape) * PaddleDtypeSize(tensor.dtype);
+}
+
+// The number of samples of a request, decided by its first input.
+int64_t SampleNum(const PaddleTensor &tensor) {
+  if (!tensor.lod.empty()) return tensor.lod[0].size() - 1;
+  return tensor.shape.empty() ? 0 : tensor.shape[0];
+}
+
+bool Mergeable(const std::vector<PaddleTensor> &a,
+               const std::vector<PaddleTensor> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].name != b[i].name || a[i].dtype != b[i].dtype ||
+        a[i].lod.size() != b[i].lod.size() ||
+        a[i].shape.size() != b[i].shape.size() || a[i].shape.empty() ||
+        !std::equal(a[i].shape.begin() + 1, a[i].shape.end(),
+                    b[i].shape.begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Copies the rows [begin, end) of the tensor, with the given LoD.
+void SliceRows(const PaddleTensor &tensor, int64_t begin, int64_t end,
+               std::vector<std::vector<size_t>> lod, PaddleTensor *out) {
+  int64_t row_bytes =
+      tensor.shape[0] == 0 ? 0 : TensorBytes(tensor) / tensor.shape[0];
+  out->name = tensor.name;
+  out->dtype = tensor.dtype;
+  out->shape = tensor.shape;
+  out->shape[0] = end - begin;
+  out->lod = std::move(lod);
+  out->data.Resize((end - begin) * row_bytes);
+  if (end > begin) {
+    std::memcpy(out->data.data(),
+                static_cast<const char *>(tensor.data.data()) +
+                    begin * row_bytes,
+                (end - begin) * row_bytes);
+  }
+}
+
+// Copies the sequences [begin, end) of the top LoD level of the tensor.
+void SliceSequences(const PaddleTensor &tensor, size_t begin, size_t end,
+                    PaddleTensor *out) {
+  std::vector<std::vector<size_t>> lod(tensor.lod.size());
+  for (size_t level = 0; level < tensor.lod.size(); ++level) {
+    auto &offsets = tensor.lod[level];
+    for (size_t i = begin; i <= end; ++i) {
+      lod[level].push_back(offsets[i] - offsets[begin]);
+    }
+    begin = offsets[begin];
+    end = offsets[end];
+  }
+  SliceRows(tensor, begin, end, std::move(lod), out);
+}
+
+}  // namespace
+
+int64_t BatchingStats::QueueLatencyPercentileUs(double fraction) const {
+  int64_t total = 0;
+  for (auto n : queue_latency_us) total += n;
+  int64_t target = static_cast<int64_t>(fraction * total + 0.5);
+  int64_t count = 0;
+  for (size_t k = 0; k < queue_latency_us.size(); ++k) {
+    count += queue_latency_us[k];
+    if (count >= target && count > 0) return int64_t(1) << (k + 1);
+  }
+  return 0;
+}
+
+double BatchingStats::AverageBatchSize() const {
+  int64_t samples = 0;
+  for (size_t k = 0; k < batch_size.size(); ++k) samples += k * batch_size[k];
+  return batches == 0 ? 0. : static_cast<double>(samples) / batches;
+}
+
+std::string BatchingStats::DebugString() const {
+  std::stringstream ss;
+  ss << "requests: " << requests << ", batches: " << batches
+     << ", average batch size: " << AverageBatchSize()
+     << ", queue latency p50/p90/p99: " << QueueLatencyPercentileUs(0.5)
+     << "/" << QueueLatencyPercentileUs(0.9) << "/"
+     << QueueLatencyPercentileUs(0.99) << " us";
+  return ss.str();
+}
+
+struct BatchingPredictor::Request {
+  const std::vector<PaddleTensor> *inputs;
+  std::vector<PaddleTensor> *outputs;
+  int64_t samples;
+  Clock::time_point enqueue_time;
+  std::promise<bool> done;
+};
+
+BatchingPredictor::BatchingPredictor(
+    std::unique_ptr<PaddlePredictor> predictor, const BatchingConfig &config)
+    : predictor_(std::move(predictor)), config_(config) {
+  PADDLE_ENFORCE_NOT_NULL(predictor_);
+  PADDLE_ENFORCE_GT(config_.max_batch_size, 0);
+  PADDLE_ENFORCE_GE(config_.max_delay_us, 0);
+  stats_.queue_latency_us.resize(kLatencyBuckets, 0);
+  stats_.batch_size.resize(config_.max_batch_size + 1, 0);
+  worker_ = std::thread([this] { WorkerLoop(); });
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+bool BatchingPredictor::Run(const std::vector<PaddleTensor> &inputs,
+                            std::vector<PaddleTensor> *output_data,
+                            int batch_size) {
+  if (inputs.empty() || inputs[0].shape.empty()) {
+    LOG(ERROR) << "The batching predictor needs the batch dimension of the "
+                  "first input";
+    return false;
+  }
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = output_data;
+  request.samples = SampleNum(inputs[0]);
+  request.enqueue_time = Clock::now();
+  auto done = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stop_) return false;
+    queue_.push_back(&request);
+    queued_samples_ += request.samples;
+  }
+  cv_.notify_one();
+  return done.get();
+}
+
+std::vector<std::string> BatchingPredictor::GetInputNames() {
+  return predictor_->GetInputNames();
+}
+
+std::vector<std::string> BatchingPredictor::GetOutputNames() {
+  return predictor_->GetOutputNames();
+}
+
+std::unique_ptr<PaddlePredictor> BatchingPredictor::Clone() {
+  return std::unique_ptr<PaddlePredictor>(
+      new BatchingPredictor(predictor_->Clone(), config_));
+}
+
+std::string BatchingPredictor::GetSerializedProgram() const {
+  return predictor_->GetSerializedProgram();
+}
+
+BatchingStats BatchingPredictor::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void BatchingPredictor::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    // The queued requests are still served when stopping.
+    if (queue_.empty()) return;
+    // Only the worker pops the queue, so the oldest request stays in front.
+    auto deadline = queue_.front()->enqueue_time +
+                    std::chrono::microseconds(config_.max_delay_us);
+    while (!stop_ && queued_samples_ < config_.max_batch_size &&
+           Clock::now() < deadline) {
+      cv_.wait_until(lock, deadline);
+    }
+    auto batch = PopBatch();
+    lock.unlock();
+    RunBatch(batch);
+    lock.lock();
+  }
+}
+
+std::vector<BatchingPredictor::Request *> BatchingPredictor::PopBatch() {
+  std::vector<Request *> batch{queue_.front()};
+  queue_.pop_front();
+  int64_t samples = batch[0]->samples;
+  for (auto it = queue_.begin();
+       it != queue_.end() && samples < config_.max_batch_size;) {
+    if (samples + (*it)->samples <= config_.max_batch_size &&
+        Mergeable(*batch[0]->inputs, *(*it)->inputs)) {
+      samples += (*it)->samples;
+      batch.push_back(*it);
+      it = queue_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  queued_samples_ -= samples;
+
+  auto now = Clock::now();
+  for (auto *request : batch) {
+    int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     now - request->enqueue_time)
+                     .count();
+    int bucket = 0;
+    while (us > 1 && bucket + 1 < kLatencyBuckets) {
+      us >>= 1;
+      ++bucket;
+    }
+    ++stats_.queue_latency_us[bucket];
+  }
+  stats_.requests += batch.size();
+  ++stats_.batches;
+  ++stats_.batch_size[std::min<int64_t>(samples, config_.max_batch_size)];
+  return batch;
+}
+
+void BatchingPredictor::RunBatch(const std::vector<Request *> &batch) {
+  bool success = false;
+  try {
+    if (batch.size() == 1) {
+      success = predictor_->Run(*batch[0]->inputs, batch[0]->outputs);
+    } else {
+      success = RunMerged(batch);
+    }
+  } catch (const std::exception &e) {
+    LOG(ERROR) << "The batch of " << batch.size()
+               << " requests failed: " << e.what();
+  }
+  for (auto *request : batch) {
+    request->done.set_value(success);
+  }
+}
+
+bool BatchingPredictor::RunMerged(const std::vector<Request *> &batch) {
+  auto &first = *batch[0]->inputs;
+  std::vector<PaddleTensor> inputs(first.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    auto &merged = inputs[i];
+    merged.name = first[i].name;
+    merged.dtype = first[i].dtype;
+    merged.shape = first[i].shape;
+    merged.shape[0] = 0;
+    merged.lod.assign(first[i].lod.size(), std::vector<size_t>{0});
+    size_t bytes = 0;
+    for (auto *request : batch) {
+      auto &input = (*request->inputs)[i];
+      PADDLE_ENFORCE_GE(input.data.length(), TensorBytes(input),
+                        "The data of the input %s is smaller than its shape",
+                        input.name);
+      merged.shape[0] += input.shape[0];
+      bytes += TensorBytes(input);
+      for (size_t level = 0; level < input.lod.size(); ++level) {
+        auto &offsets = input.lod[level];
+        size_t shift = merged.lod[level].back() - offsets.front();
+        for (size_t k = 1; k < offsets.size(); ++k) {
+          merged.lod[level].push_back(offsets[k] + shift);
+        }
+      }
+    }
+    merged.data.Resize(bytes);
+    char *dst = static_cast<char *>(merged.data.data());
+    for (auto *request : batch) {
+      auto &input = (*request->inputs)[i];
+      std::memcpy(dst, input.data.data(), TensorBytes(input));
+      dst += TensorBytes(input);
+    }
+  }
+
+  std::vector<PaddleTensor> outputs;
+  if (!predictor_->Run(inputs, &outputs)) return false;
+
+  int64_t total_samples = 0;
+  for (auto *request : batch) {
+    request->outputs->assign(outputs.size(), PaddleTensor());
+    total_samples += request->samples;
+  }
+  int64_t total_rows = inputs[0].shape[0];
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    auto &output = outputs[i];
+    if (!output.lod.empty() &&
+        static_cast<int64_t>(output.lod[0].size()) - 1 == total_samples) {
+      size_t begin = 0;
+      for (auto *request : batch) {
+        SliceSequences(output, begin, begin + request->samples,
+                       &(*request->outputs)[i]);
+        begin += request->samples;
+      }
+    } else if (output.lod.empty() && !output.shape.empty() &&
+               (output.shape[0] == total_samples ||
+                output.shape[0] == total_rows)) {
+      bool by_sample = output.shape[0] == total_samples;
+      int64_t begin = 0;
+      for (auto *request : batch) {
+        int64_t rows =
+            by_sample ? request->samples : (*request->inputs)[0].shape[0];
+        SliceRows(output, begin, begin + rows, {}, &(*request->outputs)[i]);
+        begin += rows;
+      }
+    } else {
+      LOG(ERROR) << "Cannot split the output " << output.name
+                 << " to the requests, its first dimension is "
+                 << (output.shape.empty() ? 0 : output.shape[0]) << " of "
+                 << total_samples << " samples";
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace paddle
@@ -0,0 +1,117 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+namespace paddle {
+
+struct BatchingConfig {
+  // The maximum number of samples of a merged batch. A request larger than it
+  // runs alone.
+  int max_batch_size{32};
+  // The maximum time the oldest queued request waits for more requests before
+  // its batch runs.
+  int max_delay_us{1000};
+};
+
+struct BatchingStats {
+  int64_t requests{0};
+  int64_t batches{0};
+  // queue_latency_us[k] counts the requests which waited in [2^k, 2^(k+1)) us
+  // before their batch started, queue_latency_us[0] also counts those waited
+  // less than 1 us.
+  std::vector<int64_t> queue_latency_us;
+  // batch_size[k] counts the batches of k samples, the batches larger than
+  // the max batch size are counted in the last one.
+  std::vector<int64_t> batch_size;
+
+  // The upper bound of the queueing latency of the given fraction (0, 1] of
+  // the requests, estimated from the histogram.
+  int64_t QueueLatencyPercentileUs(double fraction) const;
+  double AverageBatchSize() const;
+  std::string DebugString() const;
+};
+
+/** \brief A predictor merging the concurrent Run calls into batches.
+ *
+ * The requests are queued and a worker thread concatenates the inputs of the
+ * queued requests along the batch dimension, merging the LoD of the sequence
+ * inputs, runs the wrapped predictor once and splits the outputs back to the
+ * callers. A batch runs when it reaches `max_batch_size` samples or when its
+ * oldest request has waited `max_delay_us`.
+ *
+ * The number of samples of a request is the number of sequences of its first
+ * input if it has LoD, otherwise its first dimension. Only the requests whose
+ * inputs have the same names, types and the same shapes except the first
+ * dimension are merged. An output is split by its LoD if it has one sequence
+ * per sample, otherwise by its first dimension which should be the number of
+ * samples or the number of rows of the first input.
+ *
+ * The ZeroCopy interface binds the tensors to one predictor, so it is not
+ * batched and ZeroCopyRun returns false.
+ */
+class BatchingPredictor : public PaddlePredictor {
+ public:
+  BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                    const BatchingConfig &config);
+  ~BatchingPredictor();
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *output_data,
+           int batch_size = -1) override;
+
+  std::vector<std::string> GetInputNames() override;
+  std::vector<std::string> GetOutputNames() override;
+
+  // The clone has its own queue and worker over a clone of the predictor.
+  std::unique_ptr<PaddlePredictor> Clone() override;
+
+  std::string GetSerializedProgram() const override;
+
+  const BatchingConfig &config() const { return config_; }
+  BatchingStats stats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Request;
+
+  void WorkerLoop();
+  // Pops the requests of the next batch from the queue, should hold mutex_.
+  std::vector<Request *> PopBatch();
+  void RunBatch(const std::vector<Request *> &batch);
+  bool RunMerged(const std::vector<Request *> &batch);
+
+  std::unique_ptr<PaddlePredictor> predictor_;
+  BatchingConfig config_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request *> queue_;
+  int64_t queued_samples_{0};
+  bool stop_{false};
+  BatchingStats stats_;
+
+  std::thread worker_;
+};
+
+}  // namespace paddle
@@ -0,0 +1,148 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Load generator for the BatchingPredictor. `clients` threads send requests
+// of `request_batch` samples back to back to the model, first each with its
+// own clone of the AnalysisPredictor and then all through one
+// BatchingPredictor, and reports the throughput and the latency percentiles.
+// All the feeds of the model are float tensors of the shape
+// [request_batch, sample_shape...].
+//
+//   ./batching_predictor_benchmark --model_dir=./mobilenet \
+//       --sample_shape=3,224,224 --clients=16 --max_batch_size=16
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/batching_predictor.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+DEFINE_string(model_dir, "", "The directory of the inference model.");
+DEFINE_string(sample_shape, "", "The shape of a sample, like 3,224,224.");
+DEFINE_int32(clients, 16, "The number of the client threads.");
+DEFINE_int32(requests, 200, "The number of requests of every client.");
+DEFINE_int32(request_batch, 1, "The number of samples of a request.");
+DEFINE_int32(max_batch_size, 16, "The max batch size of the batching.");
+DEFINE_int32(max_delay_us, 2000, "The max queueing delay of the batching.");
+DEFINE_int32(cpu_math_library_num_threads, 1,
+             "The math library threads of a predictor.");
+
+namespace paddle {
+
+static double Now() {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static std::vector<int> ParseShape(const std::string &str) {
+  std::vector<int> shape{FLAGS_request_batch};
+  std::stringstream ss(str);
+  std::string dim;
+  while (std::getline(ss, dim, ',')) {
+    if (!dim.empty()) shape.push_back(std::stoi(dim));
+  }
+  return shape;
+}
+
+// Runs the clients, client i sends its requests to predictors[i], and
+// reports the throughput and the latency of the requests.
+static void RunClients(const std::string &name,
+                       const std::vector<PaddlePredictor *> &predictors,
+                       const std::vector<std::string> &feeds) {
+  std::vector<int> shape = ParseShape(FLAGS_sample_shape);
+  int64_t numel = 1;
+  for (auto d : shape) numel *= d;
+
+  std::vector<std::vector<double>> latencies(FLAGS_clients);
+  std::vector<std::thread> threads;
+  double start = Now();
+  for (int i = 0; i < FLAGS_clients; ++i) {
+    threads.emplace_back([&, i] {
+      std::vector<PaddleTensor> inputs(feeds.size());
+      for (size_t j = 0; j < feeds.size(); ++j) {
+        inputs[j].name = feeds[j];
+        inputs[j].shape = shape;
+        inputs[j].dtype = PaddleDType::FLOAT32;
+        inputs[j].data.Resize(numel * sizeof(float));
+        float *data = static_cast<float *>(inputs[j].data.data());
+        for (int64_t k = 0; k < numel; ++k) data[k] = (k % 255) / 255.f;
+      }
+      std::vector<PaddleTensor> outputs;
+      for (int r = 0; r < FLAGS_requests; ++r) {
+        double begin = Now();
+        CHECK(predictors[i]->Run(inputs, &outputs));
+        latencies[i].push_back(Now() - begin);
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  double seconds = (Now() - start) / 1000;
+
+  std::vector<double> all;
+  for (auto &l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double fraction) {
+    return all[std::min(all.size() - 1,
+                        static_cast<size_t>(fraction * all.size()))];
+  };
+  LOG(INFO) << name << ": " << all.size() / seconds << " requests/s, "
+            << all.size() * FLAGS_request_batch / seconds
+            << " samples/s, latency p50 " << percentile(0.5) << " ms, p99 "
+            << percentile(0.99) << " ms";
+}
+
+void Benchmark() {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_model_dir);
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_math_library_num_threads);
+  auto main_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  auto feeds = main_predictor->GetInputNames();
+
+  {
+    std::vector<std::unique_ptr<PaddlePredictor>> clones;
+    std::vector<PaddlePredictor *> predictors;
+    for (int i = 0; i < FLAGS_clients; ++i) {
+      clones.emplace_back(main_predictor->Clone());
+      predictors.push_back(clones.back().get());
+    }
+    RunClients("a predictor per client", predictors, feeds);
+  }
+  {
+    BatchingConfig batching_config;
+    batching_config.max_batch_size = FLAGS_max_batch_size;
+    batching_config.max_delay_us = FLAGS_max_delay_us;
+    BatchingPredictor batching(main_predictor->Clone(), batching_config);
+    RunClients("batching",
+               std::vector<PaddlePredictor *>(FLAGS_clients, &batching),
+               feeds);
+    LOG(INFO) << batching.stats().DebugString();
+  }
+}
+
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::Benchmark();
+  return 0;
+}
@@ -0,0 +1,201 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/batching_predictor.h"
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+
+// Doubles the first input as "out" and sums every sequence (or row) of it
+// as "sum", recording the number of rows of the runs.
+class FakePredictor : public PaddlePredictor {
+ public:
+  explicit FakePredictor(std::vector<int> *runs) : runs_(runs) {}
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *outputs, int batch_size) override {
+    auto &input = inputs[0];
+    const float *x = static_cast<const float *>(input.data.data());
+    int rows = input.shape[0];
+    int width = input.shape[1];
+    runs_->push_back(rows);
+
+    outputs->resize(2);
+    auto &out = (*outputs)[0];
+    out.name = "out";
+    out.dtype = PaddleDType::FLOAT32;
+    out.shape = input.shape;
+    out.lod = input.lod;
+    out.data.Resize(rows * width * sizeof(float));
+    float *y = static_cast<float *>(out.data.data());
+    for (int i = 0; i < rows * width; ++i) y[i] = 2 * x[i];
+
+    std::vector<size_t> offsets;
+    if (input.lod.empty()) {
+      for (int i = 0; i <= rows; ++i) offsets.push_back(i);
+    } else {
+      offsets = input.lod[0];
+    }
+    auto &sum = (*outputs)[1];
+    sum.name = "sum";
+    sum.dtype = PaddleDType::FLOAT32;
+    sum.shape = {static_cast<int>(offsets.size()) - 1, 1};
+    sum.data.Resize((offsets.size() - 1) * sizeof(float));
+    float *s = static_cast<float *>(sum.data.data());
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+      s[i] = 0;
+      for (size_t j = offsets[i] * width; j < offsets[i + 1] * width; ++j) {
+        s[i] += x[j];
+      }
+    }
+    return true;
+  }
+
+  std::unique_ptr<PaddlePredictor> Clone() override {
+    return std::unique_ptr<PaddlePredictor>(new FakePredictor(runs_));
+  }
+
+ private:
+  std::vector<int> *runs_;
+};
+
+PaddleTensor MakeInput(int rows, int width, float value,
+                       const std::vector<size_t> &offsets = {}) {
+  PaddleTensor tensor;
+  tensor.name = "x";
+  tensor.dtype = PaddleDType::FLOAT32;
+  tensor.shape = {rows, width};
+  if (!offsets.empty()) tensor.lod.push_back(offsets);
+  tensor.data.Resize(rows * width * sizeof(float));
+  float *data = static_cast<float *>(tensor.data.data());
+  for (int i = 0; i < rows * width; ++i) data[i] = value + i;
+  return tensor;
+}
+
+TEST(BatchingPredictor, merge_and_split) {
+  std::vector<int> runs;
+  BatchingConfig config;
+  config.max_batch_size = 64;
+  // Long enough for all the threads to queue their requests.
+  config.max_delay_us = 200000;
+  const int kThreads = 8;
+  const int kWidth = 3;
+  {
+    BatchingPredictor predictor(
+        std::unique_ptr<PaddlePredictor>(new FakePredictor(&runs)), config);
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        int rows = t + 1;
+        std::vector<PaddleTensor> inputs{MakeInput(rows, kWidth, 100 * t)};
+        std::vector<PaddleTensor> outputs;
+        if (!predictor.Run(inputs, &outputs) || outputs.size() != 2UL ||
+            outputs[0].shape != std::vector<int>({rows, kWidth}) ||
+            outputs[1].shape != std::vector<int>({rows, 1})) {
+          ++failures;
+          return;
+        }
+        const float *y = static_cast<const float *>(outputs[0].data.data());
+        const float *s = static_cast<const float *>(outputs[1].data.data());
+        for (int i = 0; i < rows * kWidth; ++i) {
+          if (y[i] != 2 * (100 * t + i)) ++failures;
+        }
+        for (int i = 0; i < rows; ++i) {
+          float expected = 0;
+          for (int j = 0; j < kWidth; ++j) expected += 100 * t + i * kWidth + j;
+          if (s[i] != expected) ++failures;
+        }
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    EXPECT_EQ(failures.load(), 0);
+
+    auto stats = predictor.stats();
+    LOG(INFO) << stats.DebugString();
+    EXPECT_EQ(stats.requests, kThreads);
+    EXPECT_EQ(stats.batches, static_cast<int64_t>(runs.size()));
+  }
+  // The threads queue their requests well within the delay, so the requests
+  // are merged.
+  EXPECT_LT(runs.size(), static_cast<size_t>(kThreads));
+  int rows = 0;
+  for (auto r : runs) rows += r;
+  EXPECT_EQ(rows, kThreads * (kThreads + 1) / 2);
+}
+
+TEST(BatchingPredictor, merge_lod) {
+  std::vector<int> runs;
+  BatchingConfig config;
+  config.max_batch_size = 3;
+  config.max_delay_us = 200000;
+  BatchingPredictor predictor(
+      std::unique_ptr<PaddlePredictor>(new FakePredictor(&runs)), config);
+
+  // 2 sequences of 3 and 1 rows, and 1 sequence of 2 rows.
+  std::vector<PaddleTensor> inputs0{MakeInput(4, 2, 0, {0, 3, 4})};
+  std::vector<PaddleTensor> inputs1{MakeInput(2, 2, 10, {0, 2})};
+  std::vector<PaddleTensor> outputs0, outputs1;
+  bool ok0 = false, ok1 = false;
+  std::thread t0([&] { ok0 = predictor.Run(inputs0, &outputs0); });
+  std::thread t1([&] { ok1 = predictor.Run(inputs1, &outputs1); });
+  t0.join();
+  t1.join();
+  ASSERT_TRUE(ok0);
+  ASSERT_TRUE(ok1);
+
+  // The 3 sequences make a full batch.
+  ASSERT_EQ(runs.size(), 1UL);
+  EXPECT_EQ(runs[0], 6);
+
+  EXPECT_EQ(outputs0[0].lod, std::vector<std::vector<size_t>>({{0, 3, 4}}));
+  EXPECT_EQ(outputs1[0].lod, std::vector<std::vector<size_t>>({{0, 2}}));
+  EXPECT_EQ(outputs0[0].shape, std::vector<int>({4, 2}));
+  EXPECT_EQ(outputs1[0].shape, std::vector<int>({2, 2}));
+  const float *y1 = static_cast<const float *>(outputs1[0].data.data());
+  for (int i = 0; i < 4; ++i) EXPECT_EQ(y1[i], 2 * (10 + i));
+
+  ASSERT_EQ(outputs0[1].shape, std::vector<int>({2, 1}));
+  ASSERT_EQ(outputs1[1].shape, std::vector<int>({1, 1}));
+  const float *s0 = static_cast<const float *>(outputs0[1].data.data());
+  const float *s1 = static_cast<const float *>(outputs1[1].data.data());
+  EXPECT_EQ(s0[0], 0 + 1 + 2 + 3 + 4 + 5);
+  EXPECT_EQ(s0[1], 6 + 7);
+  EXPECT_EQ(s1[0], 10 + 11 + 12 + 13);
+}
+
+TEST(BatchingPredictor, unmergeable) {
+  std::vector<int> runs;
+  BatchingConfig config;
+  config.max_batch_size = 8;
+  config.max_delay_us = 0;
+  BatchingPredictor predictor(
+      std::unique_ptr<PaddlePredictor>(new FakePredictor(&runs)), config);
+
+  // A request larger than the max batch size runs alone.
+  std::vector<PaddleTensor> inputs{MakeInput(10, 2, 0)};
+  std::vector<PaddleTensor> outputs;
+  ASSERT_TRUE(predictor.Run(inputs, &outputs));
+  EXPECT_EQ(outputs[0].shape, std::vector<int>({10, 2}));
+  EXPECT_EQ(predictor.stats().batch_size.back(), 1);
+
+  std::vector<PaddleTensor> empty;
+  EXPECT_FALSE(predictor.Run(empty, &outputs));
+}
+
+}  // namespace paddle
@@ -67,6 +67,15 @@ struct AnalysisConfig {
   void SetOptimCacheDir(const std::string& opt_cache_dir) {
     opt_cache_dir_ = opt_cache_dir;
   }
+  /** \brief Control whether to save the optimized program and its parameters
+   * in the opt cache dir, so that the next predictor of the same model, pass
+   * list and config loads them instead of running the IR passes again.
+   * It works only on CPU with IR optimization and the opt cache dir set.
+   */
+  void SwitchOptimProgramCache(int x = true) { optim_program_cache_ = x; }
+  /** A boolean state telling whether the optimized program cache is enabled.
+   */
+  bool optim_program_cache_enabled() const { return optim_program_cache_; }
   /** Get the model directory path.
    */
   const std::string& model_dir() const { return model_dir_; }
@@ -126,6 +135,18 @@ struct AnalysisConfig {
    */
   bool use_feed_fetch_ops_enabled() const { return use_feed_fetch_ops_; }
 
+  /** \brief Control whether the operators skip InferShape and the data
+   * transform checks while the shapes, LoD, data types and places of their
+   * inputs are the same as in the last run, e.g. for serving with fixed input
+   * shapes. Only the operators whose output shapes depend on the input shapes
+   * alone are cached, not the control flow and sequence operators. It works
+   * only when IR optimization is enabled.
+   */
+  void SwitchShapeSignatureCache(int x = true);
+  /** A boolean state telling whether the shape signature cache is enabled.
+   */
+  bool shape_signature_cache_enabled() const { return shape_signature_cache_; }
+
   /** \brief Control whether to specify the inputs' names.
    *
    * The PaddleTensor type has a `name` member, assign it with the corresponding
@@ -248,6 +269,15 @@ struct AnalysisConfig {
                          bool force_update_static_cache = false);
   /** Tell whether the memory optimization is activated. */
   bool enable_memory_optim() const;
+  /** \brief Control whether to pack the temporary variables into one arena,
+   * at the offsets planned from their lifetimes and their sizes in the first
+   * run, so the later runs bind them to the arena instead of allocating. The
+   * first run should feed the largest inputs expected, the arena is planned
+   * again when a later run needs more memory.
+   */
+  void SwitchActivationArena(int x = true) { activation_arena_ = x; }
+  /** A boolean state telling whether the activation arena is enabled. */
+  bool activation_arena_enabled() const { return activation_arena_; }
   void SetInValid() const { is_valid_ = false; }
   bool is_valid() const { return is_valid_; }
 
@@ -301,6 +331,7 @@ struct AnalysisConfig {
   bool enable_memory_optim_{false};
   bool static_memory_optim_{false};
   bool static_memory_optim_force_update_{false};
+  bool activation_arena_{false};
 
   bool use_ngraph_{false};
   bool use_mkldnn_{false};
@@ -311,6 +342,8 @@ struct AnalysisConfig {
   bool enable_ir_optim_{true};
   bool use_feed_fetch_ops_{true};
   bool ir_debug_{false};
+  bool shape_signature_cache_{false};
+  bool optim_program_cache_{false};
 
   bool specify_input_name_{false};
 
@@ -0,0 +1,208 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/predictor_pool.h"
+#include <glog/logging.h>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include "paddle/fluid/inference/api/analysis_predictor.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+struct PredictorPool::Request {
+  const std::vector<PaddleTensor> *inputs;
+  std::vector<PaddleTensor> *outputs;
+  std::promise<bool> done;
+};
+
+struct PredictorPool::Worker {
+  using Creator = std::function<std::unique_ptr<PaddlePredictor>()>;
+
+  ~Worker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    cv.notify_one();
+    if (thread.joinable()) thread.join();
+  }
+
+  // Starts the thread and creates the predictor on it, returns after the
+  // predictor is created.
+  void Start(Creator create) {
+    std::promise<void> created;
+    auto future = created.get_future();
+    thread = std::thread([this, &created, &create] {
+      if (!platform::BindCurrentThreadToCpus(cpus)) {
+        LOG(WARNING) << "Failed to bind the predictor thread to the CPUs of "
+                        "the NUMA node "
+                     << node;
+      }
+      try {
+        predictor = create();
+      } catch (...) {
+        created.set_exception(std::current_exception());
+        return;
+      }
+      created.set_value();
+      Loop();
+    });
+    future.get();
+  }
+
+  void Loop() {
+    while (true) {
+      Request *request;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return stop || !queue.empty(); });
+        if (queue.empty()) return;
+        request = queue.front();
+        queue.pop_front();
+      }
+      bool success = false;
+      try {
+        success = predictor->Run(*request->inputs, request->outputs);
+      } catch (const std::exception &e) {
+        LOG(ERROR) << "The predictor on the NUMA node " << node
+                   << " failed: " << e.what();
+      }
+      ++processed;
+      --load;
+      request->done.set_value(success);
+    }
+  }
+
+  int node;
+  std::vector<int> cpus;
+  std::unique_ptr<PaddlePredictor> predictor;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Request *> queue;
+  bool stop{false};
+  std::atomic<int> load{0};
+  std::atomic<int64_t> processed{0};
+
+  std::thread thread;
+};
+
+PredictorPool::PredictorPool(const AnalysisConfig &config,
+                             const PredictorPoolConfig &pool_config)
+    : pool_config_(pool_config) {
+  PADDLE_ENFORCE(!config.use_gpu(), "PredictorPool is for CPU inference");
+  PADDLE_ENFORCE_GT(pool_config_.predictors_per_node, 0);
+  auto nodes = platform::NumaNodeCpus();
+  auto node_ids = pool_config_.numa_nodes;
+  if (node_ids.empty()) {
+    // the memory-only nodes have no CPUs to run the predictors
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (!nodes[i].empty()) node_ids.push_back(i);
+    }
+  }
+
+  PaddlePredictor *main_predictor = nullptr;
+  for (int node : node_ids) {
+    PADDLE_ENFORCE(node >= 0 && node < static_cast<int>(nodes.size()),
+                   "There is no NUMA node %d", node);
+    auto &cpus = nodes[node];
+    PADDLE_ENFORCE(!cpus.empty(), "The NUMA node %d has no CPUs", node);
+    int per_node = pool_config_.predictors_per_node;
+    bool share_cpus = !pool_config_.bind_cores ||
+                      static_cast<int>(cpus.size()) < per_node;
+    PaddlePredictor *node_predictor = nullptr;
+    for (int i = 0; i < per_node; ++i) {
+      std::unique_ptr<Worker> worker(new Worker);
+      worker->node = node;
+      if (share_cpus) {
+        worker->cpus = cpus;
+      } else {
+        worker->cpus.assign(cpus.begin() + i * cpus.size() / per_node,
+                            cpus.begin() + (i + 1) * cpus.size() / per_node);
+      }
+
+      if (!main_predictor) {
+        worker->Start([&config] {
+          return CreatePaddlePredictor<AnalysisConfig>(config);
+        });
+        main_predictor = worker->predictor.get();
+      } else if (!node_predictor && pool_config_.replicate_params) {
+        auto *analysis = static_cast<AnalysisPredictor *>(main_predictor);
+        worker->Start([analysis] { return analysis->CloneWithParamsCopy(); });
+      } else {
+        auto *parent = node_predictor ? node_predictor : main_predictor;
+        worker->Start([parent] { return parent->Clone(); });
+      }
+      if (!node_predictor) node_predictor = worker->predictor.get();
+      workers_.push_back(std::move(worker));
+    }
+  }
+  LOG(INFO) << "Created " << workers_.size() << " predictors on "
+            << node_ids.size() << " NUMA nodes";
+}
+
+PredictorPool::~PredictorPool() {
+  // The clones are released before the predictors they are cloned from.
+  while (!workers_.empty()) workers_.pop_back();
+}
+
+int PredictorPool::numa_node(size_t i) const { return workers_.at(i)->node; }
+
+int64_t PredictorPool::processed(size_t i) const {
+  return workers_.at(i)->processed.load();
+}
+
+size_t PredictorPool::PickWorker() {
+  size_t start = next_.fetch_add(1) % workers_.size();
+  if (pool_config_.dispatch == PredictorPoolConfig::kRoundRobin) {
+    return start;
+  }
+  // Starts from a rotating worker, so the ties are spread.
+  size_t best = start;
+  int best_load = workers_[start]->load.load();
+  for (size_t k = 1; k < workers_.size() && best_load > 0; ++k) {
+    size_t i = (start + k) % workers_.size();
+    int load = workers_[i]->load.load();
+    if (load < best_load) {
+      best = i;
+      best_load = load;
+    }
+  }
+  return best;
+}
+
+bool PredictorPool::Run(const std::vector<PaddleTensor> &inputs,
+                        std::vector<PaddleTensor> *output_data) {
+  auto &worker = *workers_[PickWorker()];
+  Request request;
+  request.inputs = &inputs;
+  request.outputs = output_data;
+  auto done = request.done.get_future();
+  ++worker.load;
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.queue.push_back(&request);
+  }
+  worker.cv.notify_one();
+  return done.get();
+}
+
+}  // namespace paddle
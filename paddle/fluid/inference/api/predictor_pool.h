@@ -0,0 +1,83 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+
+namespace paddle {
+
+struct PredictorPoolConfig {
+  enum Dispatch {
+    kRoundRobin,
+    // The predictor with the fewest running and queued requests.
+    kLeastLoaded,
+  };
+
+  // The number of predictors on every NUMA node.
+  int predictors_per_node{1};
+  // The ids of the NUMA nodes to place the predictors on, all the nodes with
+  // CPUs if empty.
+  std::vector<int> numa_nodes;
+  // Copy the parameters once per NUMA node, otherwise all the predictors
+  // share the parameters of the first one like Clone().
+  bool replicate_params{true};
+  // Bind the thread of every predictor, and the math library threads it
+  // creates, to an equal share of the CPUs of its node. Otherwise they are
+  // bound to the whole node.
+  bool bind_cores{true};
+  Dispatch dispatch{kLeastLoaded};
+};
+
+/** \brief A pool of AnalysisPredictors placed on the NUMA nodes.
+ *
+ * Every predictor runs on its own thread bound to the CPUs of its node. The
+ * first predictor of a node copies the parameters on that thread, so the
+ * pages are allocated on the node by the first touch policy of Linux, and
+ * the other predictors of the node are its clones sharing the copy. The
+ * activations are allocated by the bound threads too.
+ *
+ * Run dispatches a request to a predictor and blocks until it is done, it is
+ * safe to call from many threads.
+ */
+class PredictorPool {
+ public:
+  PredictorPool(const AnalysisConfig &config,
+                const PredictorPoolConfig &pool_config);
+  ~PredictorPool();
+
+  bool Run(const std::vector<PaddleTensor> &inputs,
+           std::vector<PaddleTensor> *output_data);
+
+  size_t size() const { return workers_.size(); }
+  // The NUMA node of the predictor i.
+  int numa_node(size_t i) const;
+  // The number of requests run by the predictor i.
+  int64_t processed(size_t i) const;
+
+ private:
+  struct Worker;
+  struct Request;
+
+  size_t PickWorker();
+
+  PredictorPoolConfig pool_config_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> next_{0};
+};
+
+}  // namespace paddle
@@ -0,0 +1,158 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the PredictorPool with the clones of a predictor. Every one of
+// `predictors_per_node` x nodes client threads sends `requests` requests,
+// first to its own Clone() of the predictor, unbound and sharing the
+// parameters, and then through a PredictorPool of the same number of
+// predictors. All the feeds of the model are float tensors of the shape
+// [batch_size, sample_shape...].
+//
+//   ./predictor_pool_benchmark --model_dir=./resnet50 \
+//       --sample_shape=3,224,224 --predictors_per_node=4
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/inference/api/predictor_pool.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DEFINE_string(model_dir, "", "The directory of the inference model.");
+DEFINE_string(sample_shape, "", "The shape of a sample, like 3,224,224.");
+DEFINE_int32(batch_size, 1, "The batch size of a request.");
+DEFINE_int32(requests, 100, "The number of requests of every client.");
+DEFINE_int32(predictors_per_node, 4, "The predictors of every NUMA node.");
+DEFINE_int32(cpu_math_library_num_threads, 1,
+             "The math library threads of a predictor.");
+DEFINE_bool(least_loaded, true,
+            "Dispatch to the least loaded predictor, or round robin.");
+
+namespace paddle {
+
+static double Now() {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Runs the clients, client i calls run(i, inputs, outputs), and reports the
+// throughput and the latency.
+static void RunClients(
+    const std::string &name, int clients, const std::vector<std::string> &feeds,
+    std::function<bool(int, const std::vector<PaddleTensor> &,
+                       std::vector<PaddleTensor> *)>
+        run) {
+  std::vector<int> shape{FLAGS_batch_size};
+  std::stringstream ss(FLAGS_sample_shape);
+  std::string dim;
+  while (std::getline(ss, dim, ',')) {
+    if (!dim.empty()) shape.push_back(std::stoi(dim));
+  }
+  int64_t numel = 1;
+  for (auto d : shape) numel *= d;
+
+  std::vector<std::vector<double>> latencies(clients);
+  std::vector<std::thread> threads;
+  double start = Now();
+  for (int i = 0; i < clients; ++i) {
+    threads.emplace_back([&, i] {
+      std::vector<PaddleTensor> inputs(feeds.size());
+      for (size_t j = 0; j < feeds.size(); ++j) {
+        inputs[j].name = feeds[j];
+        inputs[j].shape = shape;
+        inputs[j].dtype = PaddleDType::FLOAT32;
+        inputs[j].data.Resize(numel * sizeof(float));
+        float *data = static_cast<float *>(inputs[j].data.data());
+        for (int64_t k = 0; k < numel; ++k) data[k] = (k % 255) / 255.f;
+      }
+      std::vector<PaddleTensor> outputs;
+      for (int r = 0; r < FLAGS_requests; ++r) {
+        double begin = Now();
+        CHECK(run(i, inputs, &outputs));
+        latencies[i].push_back(Now() - begin);
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  double seconds = (Now() - start) / 1000;
+
+  std::vector<double> all;
+  for (auto &l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double fraction) {
+    return all[std::min(all.size() - 1,
+                        static_cast<size_t>(fraction * all.size()))];
+  };
+  LOG(INFO) << name << ": " << all.size() / seconds
+            << " requests/s, latency p50 " << percentile(0.5) << " ms, p99 "
+            << percentile(0.99) << " ms";
+}
+
+void Benchmark() {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_model_dir);
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_math_library_num_threads);
+  auto nodes = platform::NumaNodeCpus();
+  int node_num = std::count_if(
+      nodes.begin(), nodes.end(),
+      [](const std::vector<int> &cpus) { return !cpus.empty(); });
+  int clients = FLAGS_predictors_per_node * node_num;
+  LOG(INFO) << clients << " predictors on " << node_num << " NUMA nodes";
+
+  std::vector<std::string> feeds;
+  {
+    auto main_predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    feeds = main_predictor->GetInputNames();
+    std::vector<std::unique_ptr<PaddlePredictor>> clones;
+    for (int i = 0; i < clients; ++i) {
+      clones.emplace_back(main_predictor->Clone());
+    }
+    RunClients("Clone()", clients, feeds,
+               [&clones](int i, const std::vector<PaddleTensor> &inputs,
+                         std::vector<PaddleTensor> *outputs) {
+                 return clones[i]->Run(inputs, outputs);
+               });
+  }
+  {
+    PredictorPoolConfig pool_config;
+    pool_config.predictors_per_node = FLAGS_predictors_per_node;
+    pool_config.dispatch = FLAGS_least_loaded
+                               ? PredictorPoolConfig::kLeastLoaded
+                               : PredictorPoolConfig::kRoundRobin;
+    PredictorPool pool(config, pool_config);
+    RunClients("PredictorPool", clients, feeds,
+               [&pool](int i, const std::vector<PaddleTensor> &inputs,
+                       std::vector<PaddleTensor> *outputs) {
+                 return pool.Run(inputs, outputs);
+               });
+  }
+}
+
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::Benchmark();
+  return 0;
+}
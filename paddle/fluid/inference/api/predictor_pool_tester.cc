@@ -0,0 +1,76 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/predictor_pool.h"
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <thread>  // NOLINT
+#include "paddle/fluid/inference/tests/api/tester_helper.h"
+
+DEFINE_string(dirname, "", "dirname to tests.");
+
+namespace paddle {
+
+static void TestPool(PredictorPoolConfig::Dispatch dispatch) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  PredictorPoolConfig pool_config;
+  pool_config.predictors_per_node = 2;
+  pool_config.dispatch = dispatch;
+  PredictorPool pool(config, pool_config);
+  ASSERT_GE(pool.size(), 2UL);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  std::vector<PaddleTensor> expected;
+  ASSERT_TRUE(predictor->Run(inputs, &expected));
+
+  const int num_threads = 4;
+  const int num_requests = 10;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_requests; ++j) {
+        std::vector<PaddleTensor> outputs;
+        ASSERT_TRUE(pool.Run(inputs, &outputs));
+        ASSERT_EQ(outputs.size(), expected.size());
+        inference::CompareTensor(outputs.front(), expected.front());
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  int64_t processed = 0;
+  for (size_t i = 0; i < pool.size(); ++i) {
+    LOG(INFO) << "predictor " << i << " on NUMA node " << pool.numa_node(i)
+              << " processed " << pool.processed(i) << " requests";
+    processed += pool.processed(i);
+  }
+  ASSERT_EQ(processed, num_threads * num_requests);
+}
+
+TEST(PredictorPool, round_robin) { TestPool(PredictorPoolConfig::kRoundRobin); }
+
+TEST(PredictorPool, least_loaded) {
+  TestPool(PredictorPoolConfig::kLeastLoaded);
+}
+
+}  // namespace paddle
@@ -26,6 +26,7 @@
 #include "paddle/fluid/memory/allocation/locked_allocator.h"
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -41,6 +42,15 @@ DEFINE_int64(
     "The retry time (milliseconds) when allocator fails "
     "to allocate memory. No retry if this value is not greater than 0");
 
+DEFINE_int64(cpu_thread_cache_max_block_size, 1 << 20,
+             "The max size (bytes) of the CPU allocations cached by the "
+             "threads when FLAGS_allocator_strategy is thread_caching, "
+             "larger allocations are allocated from the shared pool directly");
+
+DEFINE_int64(cpu_thread_cache_size, 8 << 20,
+             "The max size (bytes) of the free blocks cached by every thread "
+             "when FLAGS_allocator_strategy is thread_caching");
+
 namespace paddle {
 namespace memory {
 namespace allocation {
@@ -74,6 +84,18 @@ class AllocatorFacadePrivate {
         break;
       }
 
+      case AllocatorStrategy::kThreadCaching: {
+        InitThreadCachingCPUAllocator();
+#ifdef PADDLE_WITH_CUDA
+        for (int dev_id = 0; dev_id < platform::GetCUDADeviceCount();
+             ++dev_id) {
+          InitAutoGrowthCUDAAllocator(platform::CUDAPlace(dev_id));
+        }
+        InitNaiveBestFitCUDAPinnedAllocator();
+#endif
+        break;
+      }
+
       default: {
         PADDLE_THROW("Unsupported allocator strategy: %d",
                      static_cast<int>(strategy));
@@ -103,6 +125,15 @@ class AllocatorFacadePrivate {
         std::make_shared<NaiveBestFitAllocator>(platform::CPUPlace());
   }
 
+  void InitThreadCachingCPUAllocator() {
+    auto pool = std::make_shared<AutoGrowthBestFitAllocator>(
+        std::make_shared<CPUAllocator>(), 64, platform::CpuMaxChunkSize());
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<ThreadCachingAllocator>(
+            pool, FLAGS_cpu_thread_cache_max_block_size,
+            FLAGS_cpu_thread_cache_size);
+  }
+
 #ifdef PADDLE_WITH_CUDA
   void InitNaiveBestFitCUDAPinnedAllocator() {
     allocators_[platform::CUDAPinnedPlace()] =
@@ -0,0 +1,399 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+namespace {
+
+// size classes: 64, 128, ..., 1024, and then 4 classes in (2^p, 2^(p+1)]
+constexpr size_t kClassAlignment = 64;
+constexpr size_t kSmallMaxSize = 1024;
+constexpr size_t kSmallClassNum = kSmallMaxSize / kClassAlignment;
+constexpr size_t kClassesPerDoubling = 4;
+constexpr size_t kSmallMaxSizeLog2 = 10;
+
+// The number of blocks moved between a thread cache and the central free
+// list at a time, about 64KB and in [2, 32].
+size_t BatchSize(size_t class_size) {
+  return std::min<size_t>(32, std::max<size_t>(2, (64 << 10) / class_size));
+}
+
+// The counters of a thread cache are only written by its own thread, so a
+// relaxed load and store is enough and avoids a locked instruction.
+template <typename T>
+inline void AddRelaxed(std::atomic<T>* counter, T n) {
+  counter->store(counter->load(std::memory_order_relaxed) + n,
+                 std::memory_order_relaxed);
+}
+
+}  // namespace
+
+size_t ThreadCachingAllocator::SizeClassOf(size_t size) {
+  if (size <= kSmallMaxSize) {
+    return size == 0 ? 0 : (size - 1) / kClassAlignment;
+  }
+  // 2^p < size <= 2^(p+1)
+  size_t p = kSmallMaxSizeLog2;
+  while (((size - 1) >> (p + 1)) != 0) {
+    ++p;
+  }
+  size_t step = static_cast<size_t>(1) << (p - 2);
+  size_t offset = (size - (static_cast<size_t>(1) << p) + step - 1) / step;
+  return kSmallClassNum + (p - kSmallMaxSizeLog2) * kClassesPerDoubling +
+         offset - 1;
+}
+
+size_t ThreadCachingAllocator::ClassSize(size_t size_class) {
+  if (size_class < kSmallClassNum) {
+    return (size_class + 1) * kClassAlignment;
+  }
+  size_t k = size_class - kSmallClassNum;
+  size_t p = kSmallMaxSizeLog2 + k / kClassesPerDoubling;
+  size_t step = static_cast<size_t>(1) << (p - 2);
+  return (static_cast<size_t>(1) << p) + (k % kClassesPerDoubling + 1) * step;
+}
+
+class ThreadCachingAllocator::CentralCache {
+ public:
+  CentralCache(const std::shared_ptr<Allocator>& underlying_allocator,
+               size_t class_num, size_t thread_cache_size)
+      : underlying_allocator_(underlying_allocator),
+        class_num_(class_num),
+        thread_cache_size_(thread_cache_size),
+        free_lists_(new FreeList[class_num]) {}
+
+  ~CentralCache() { Release(); }
+
+  size_t ClassNum() const { return class_num_; }
+  size_t ThreadCacheSize() const { return thread_cache_size_; }
+
+  // Allocate from the underlying allocator, if it fails, return the blocks
+  // in the central free lists to it and try again.
+  Allocation* AllocateUnderlying(size_t size) {
+    try {
+      return underlying_allocator_->Allocate(size).release();
+    } catch (BadAlloc&) {
+      VLOG(2) << "Fail to allocate " << size
+              << " bytes, release the central cache and retry";
+      Release();
+      return underlying_allocator_->Allocate(size).release();
+    }
+  }
+
+  void FreeUnderlying(Allocation* allocation) {
+    underlying_allocator_->Free(allocation);
+  }
+
+  // Move up to n blocks of the size class from the central free list to
+  // out, and allocate the rest from the underlying allocator.
+  void Fetch(size_t size_class, size_t n, std::vector<Allocation*>* out) {
+    auto& list = free_lists_[size_class];
+    size_t m = 0;
+    {
+      std::lock_guard<std::mutex> guard(list.mutex);
+      m = std::min(n, list.blocks.size());
+      out->insert(out->end(), list.blocks.end() - m, list.blocks.end());
+      list.blocks.resize(list.blocks.size() - m);
+    }
+    size_t class_size = ClassSize(size_class);
+    central_hit_count_ += m;
+    central_cached_bytes_ -= m * class_size;
+    for (size_t i = m; i < n; ++i) {
+      try {
+        out->push_back(AllocateUnderlying(class_size));
+      } catch (BadAlloc&) {
+        // it is enough to get one block
+        if (i == 0) throw;
+        break;
+      }
+      ++underlying_alloc_count_;
+    }
+  }
+
+  void Put(size_t size_class, Allocation* const* blocks, size_t n) {
+    auto& list = free_lists_[size_class];
+    {
+      std::lock_guard<std::mutex> guard(list.mutex);
+      list.blocks.insert(list.blocks.end(), blocks, blocks + n);
+    }
+    central_cached_bytes_ += n * ClassSize(size_class);
+  }
+
+  void Release() {
+    for (size_t i = 0; i < class_num_; ++i) {
+      std::vector<Allocation*> blocks;
+      {
+        std::lock_guard<std::mutex> guard(free_lists_[i].mutex);
+        blocks.swap(free_lists_[i].blocks);
+      }
+      central_cached_bytes_ -= blocks.size() * ClassSize(i);
+      for (auto* block : blocks) {
+        FreeUnderlying(block);
+      }
+    }
+  }
+
+  void AddLargeAllocation(int64_t size) {
+    if (size > 0) {
+      ++large_alloc_count_;
+    }
+    large_allocated_bytes_ += size;
+  }
+
+  void Register(ThreadCache* cache) {
+    std::lock_guard<std::mutex> guard(threads_mutex_);
+    threads_.insert(cache);
+  }
+
+  // Unregister the cache of an exiting thread and keep its counters.
+  void Unregister(ThreadCache* cache);
+
+  Stats GetStats() const;
+
+ private:
+  struct FreeList {
+    std::mutex mutex;
+    std::vector<Allocation*> blocks;
+  };
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  size_t class_num_;
+  size_t thread_cache_size_;
+  std::unique_ptr<FreeList[]> free_lists_;
+
+  std::atomic<uint64_t> central_hit_count_{0};
+  std::atomic<uint64_t> underlying_alloc_count_{0};
+  std::atomic<uint64_t> central_cached_bytes_{0};
+  std::atomic<uint64_t> large_alloc_count_{0};
+  std::atomic<int64_t> large_allocated_bytes_{0};
+
+  mutable std::mutex threads_mutex_;
+  std::unordered_set<ThreadCache*> threads_;
+  // the counters of the exited threads
+  uint64_t retired_alloc_count_{0};
+  uint64_t retired_hit_count_{0};
+  int64_t retired_allocated_bytes_{0};
+};
+
+class ThreadCachingAllocator::ThreadCache {
+ public:
+  explicit ThreadCache(const std::shared_ptr<CentralCache>& central)
+      : central_(central), lists_(central->ClassNum()) {
+    central_->Register(this);
+  }
+
+  ~ThreadCache() {
+    for (size_t i = 0; i < lists_.size(); ++i) {
+      if (!lists_[i].empty()) {
+        central_->Put(i, lists_[i].data(), lists_[i].size());
+      }
+    }
+    central_->Unregister(this);
+  }
+
+  Allocation* Allocate(size_t size_class) {
+    auto& list = lists_[size_class];
+    size_t class_size = ClassSize(size_class);
+    AddRelaxed<uint64_t>(&alloc_count_, 1);
+    AddRelaxed<int64_t>(&allocated_bytes_, class_size);
+    if (list.empty()) {
+      central_->Fetch(size_class, BatchSize(class_size), &list);
+      AddRelaxed<uint64_t>(&cached_bytes_, list.size() * class_size);
+    } else {
+      AddRelaxed<uint64_t>(&hit_count_, 1);
+    }
+    Allocation* allocation = list.back();
+    list.pop_back();
+    AddRelaxed<uint64_t>(&cached_bytes_, -class_size);
+    return allocation;
+  }
+
+  void Free(size_t size_class, Allocation* allocation) {
+    auto& list = lists_[size_class];
+    size_t class_size = ClassSize(size_class);
+    AddRelaxed<int64_t>(&allocated_bytes_, -static_cast<int64_t>(class_size));
+    list.push_back(allocation);
+    AddRelaxed<uint64_t>(&cached_bytes_, class_size);
+    size_t batch = BatchSize(class_size);
+    if (list.size() > 2 * batch) {
+      ReleaseBatch(size_class, batch);
+    }
+    if (cached_bytes_.load(std::memory_order_relaxed) >
+        central_->ThreadCacheSize()) {
+      Scavenge();
+    }
+  }
+
+ private:
+  friend class CentralCache;
+
+  // Return the n least recently freed blocks of the size class.
+  void ReleaseBatch(size_t size_class, size_t n) {
+    auto& list = lists_[size_class];
+    n = std::min(n, list.size());
+    central_->Put(size_class, list.data(), n);
+    list.erase(list.begin(), list.begin() + n);
+    AddRelaxed<uint64_t>(&cached_bytes_, -n * ClassSize(size_class));
+  }
+
+  // Return half of the blocks of every size class.
+  void Scavenge() {
+    for (size_t i = 0; i < lists_.size(); ++i) {
+      ReleaseBatch(i, (lists_[i].size() + 1) / 2);
+    }
+  }
+
+  std::shared_ptr<CentralCache> central_;
+  std::vector<std::vector<Allocation*>> lists_;
+
+  std::atomic<uint64_t> alloc_count_{0};
+  std::atomic<uint64_t> hit_count_{0};
+  std::atomic<uint64_t> cached_bytes_{0};
+  std::atomic<int64_t> allocated_bytes_{0};
+};
+
+void ThreadCachingAllocator::CentralCache::Unregister(ThreadCache* cache) {
+  std::lock_guard<std::mutex> guard(threads_mutex_);
+  threads_.erase(cache);
+  retired_alloc_count_ += cache->alloc_count_;
+  retired_hit_count_ += cache->hit_count_;
+  retired_allocated_bytes_ += cache->allocated_bytes_;
+}
+
+ThreadCachingAllocator::Stats ThreadCachingAllocator::CentralCache::GetStats()
+    const {
+  Stats stats;
+  std::lock_guard<std::mutex> guard(threads_mutex_);
+  stats.alloc_count = retired_alloc_count_;
+  stats.thread_cache_hit_count = retired_hit_count_;
+  stats.allocated_bytes = retired_allocated_bytes_;
+  for (auto* cache : threads_) {
+    stats.alloc_count += cache->alloc_count_.load(std::memory_order_relaxed);
+    stats.thread_cache_hit_count +=
+        cache->hit_count_.load(std::memory_order_relaxed);
+    stats.thread_cached_bytes +=
+        cache->cached_bytes_.load(std::memory_order_relaxed);
+    stats.allocated_bytes +=
+        cache->allocated_bytes_.load(std::memory_order_relaxed);
+  }
+  stats.large_alloc_count = large_alloc_count_;
+  stats.allocated_bytes += large_allocated_bytes_;
+  stats.central_cache_hit_count = central_hit_count_;
+  stats.underlying_alloc_count = underlying_alloc_count_;
+  stats.central_cached_bytes = central_cached_bytes_;
+  return stats;
+}
+
+ThreadCachingAllocator::ThreadCachingAllocator(
+    const std::shared_ptr<Allocator>& underlying_allocator,
+    size_t max_cached_size, size_t thread_cache_size) {
+  PADDLE_ENFORCE_NOT_NULL(underlying_allocator);
+  PADDLE_ENFORCE_GT(max_cached_size, 0);
+  size_t class_num = SizeClassOf(max_cached_size) + 1;
+  max_cached_size_ = ClassSize(class_num - 1);
+  central_ = std::make_shared<CentralCache>(underlying_allocator, class_num,
+                                            thread_cache_size);
+}
+
+// The thread caches keep the central cache alive until the threads exit, the
+// blocks in the central free lists are returned now.
+ThreadCachingAllocator::~ThreadCachingAllocator() { central_->Release(); }
+
+ThreadCachingAllocator::ThreadCache* ThreadCachingAllocator::GetThreadCache() {
+  static thread_local CentralCache* last_central = nullptr;
+  static thread_local ThreadCache* last_cache = nullptr;
+  // set when the thread is exiting, then the blocks are allocated from and
+  // freed to the central free lists directly
+  static thread_local bool exiting = false;
+  // the ThreadCaches of the current thread, for every ThreadCachingAllocator
+  struct ThreadCacheMap {
+    std::unordered_map<CentralCache*, std::unique_ptr<ThreadCache>> caches;
+    ~ThreadCacheMap() {
+      exiting = true;
+      last_central = nullptr;
+      last_cache = nullptr;
+    }
+  };
+
+  if (last_central == central_.get()) {
+    return last_cache;
+  }
+  if (exiting) {
+    return nullptr;
+  }
+  static thread_local ThreadCacheMap cache_map;
+  auto& cache = cache_map.caches[central_.get()];
+  if (cache == nullptr) {
+    cache.reset(new ThreadCache(central_));
+  }
+  last_central = central_.get();
+  last_cache = cache.get();
+  return last_cache;
+}
+
+Allocation* ThreadCachingAllocator::AllocateImpl(size_t size) {
+  if (size > max_cached_size_) {
+    auto* allocation =
+        central_->AllocateUnderlying(AlignedSize(size, kClassAlignment));
+    central_->AddLargeAllocation(allocation->size());
+    return allocation;
+  }
+  size_t size_class = SizeClassOf(size);
+  auto* cache = GetThreadCache();
+  if (cache != nullptr) {
+    return cache->Allocate(size_class);
+  }
+  std::vector<Allocation*> blocks;
+  central_->Fetch(size_class, 1, &blocks);
+  return blocks[0];
+}
+
+void ThreadCachingAllocator::FreeImpl(Allocation* allocation) {
+  size_t size = allocation->size();
+  if (size > max_cached_size_) {
+    central_->AddLargeAllocation(-static_cast<int64_t>(size));
+    central_->FreeUnderlying(allocation);
+    return;
+  }
+  size_t size_class = SizeClassOf(size);
+  auto* cache = GetThreadCache();
+  if (cache != nullptr) {
+    cache->Free(size_class, allocation);
+  } else {
+    central_->Put(size_class, &allocation, 1);
+  }
+}
+
+ThreadCachingAllocator::Stats ThreadCachingAllocator::GetStats() const {
+  return central_->GetStats();
+}
+
+void ThreadCachingAllocator::ReleaseCentralCache() { central_->Release(); }
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,95 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// ThreadCachingAllocator keeps per-thread caches of free blocks in front of
+// an underlying allocator (e.g. AutoGrowthBestFitAllocator), so that most of
+// the small allocations do not take any lock.
+//
+// Sizes up to max_cached_size are rounded up to size classes: multiples of
+// 64 bytes up to 1KB, and then 4 classes between every two powers of two.
+// Every thread has a free list per size class. When a thread cache has no
+// block of a class, a batch of blocks is fetched from the central free list
+// of that class, or allocated from the underlying allocator. When a free
+// list of a thread is too long, or the thread caches more than
+// thread_cache_size bytes, a batch of blocks is returned to the central free
+// lists, where other threads can fetch them. The blocks cached by a thread
+// are returned to the central free lists when the thread exits.
+//
+// Sizes larger than max_cached_size are allocated from and freed to the
+// underlying allocator directly.
+class ThreadCachingAllocator : public Allocator {
+ public:
+  struct Stats {
+    // the number of allocations of cached sizes and of large sizes
+    uint64_t alloc_count{0};
+    uint64_t large_alloc_count{0};
+    // where the cached sizes come from
+    uint64_t thread_cache_hit_count{0};
+    uint64_t central_cache_hit_count{0};
+    uint64_t underlying_alloc_count{0};
+    // the bytes of free blocks kept in the thread caches and the central
+    // free lists
+    uint64_t thread_cached_bytes{0};
+    uint64_t central_cached_bytes{0};
+    // the bytes allocated by users and not freed yet
+    int64_t allocated_bytes{0};
+  };
+
+  ThreadCachingAllocator(const std::shared_ptr<Allocator>& underlying_allocator,
+                         size_t max_cached_size = 1 << 20,
+                         size_t thread_cache_size = 8 << 20);
+
+  ~ThreadCachingAllocator();
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // The statistics summed over all of the threads, the counters of running
+  // threads are read without synchronization, so they are approximate.
+  Stats GetStats() const;
+
+  // Return all of the blocks in the central free lists to the underlying
+  // allocator, so that they can be coalesced.
+  void ReleaseCentralCache();
+
+  static size_t SizeClassOf(size_t size);
+  static size_t ClassSize(size_t size_class);
+
+ protected:
+  Allocation* AllocateImpl(size_t size) override;
+
+  void FreeImpl(Allocation* allocation) override;
+
+ private:
+  class CentralCache;
+  class ThreadCache;
+
+  ThreadCache* GetThreadCache();
+
+  std::shared_ptr<CentralCache> central_;
+  size_t max_cached_size_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,113 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the small CPU allocations done by many threads, like the
+// temporary tensors of the ops run by the inter-op threads. It compares the
+// allocators of the allocator strategies: naive_best_fit (the buddy
+// allocator), auto_growth and thread_caching.
+//
+//   ./thread_caching_allocator_benchmark --threads=1,2,4,8,16 --max_size=4096
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+#include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
+#include "paddle/fluid/string/split.h"
+
+DEFINE_string(threads, "1,2,4,8,16", "The numbers of threads.");
+DEFINE_int64(max_size, 4096, "The max size of the allocations.");
+DEFINE_int32(live_num, 32,
+             "The number of allocations held by every thread, every new "
+             "allocation frees a random one of them.");
+DEFINE_int64(alloc_per_thread, 1 << 20,
+             "The number of allocations done by every thread.");
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+std::vector<int> ParseIntList(const std::string &str) {
+  std::vector<int> res;
+  for (auto &s : string::Split(str, ',')) {
+    res.push_back(std::stoi(s));
+  }
+  return res;
+}
+
+// returns ns per allocation and free
+double RunOnce(Allocator *allocator, int threads) {
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([allocator, t] {
+      std::mt19937 rng(t);
+      std::vector<AllocationPtr> live(FLAGS_live_num);
+      for (int64_t i = 0; i < FLAGS_alloc_per_thread; ++i) {
+        size_t size = 1 + rng() % FLAGS_max_size;
+        live[rng() % live.size()] = allocator->Allocate(size);
+      }
+    });
+  }
+  for (auto &th : workers) {
+    th.join();
+  }
+  std::chrono::duration<double, std::nano> ns =
+      std::chrono::steady_clock::now() - start;
+  return ns.count() / FLAGS_alloc_per_thread / threads;
+}
+
+void Run() {
+  LOG(INFO) << "hardware concurrency " << std::thread::hardware_concurrency()
+            << ", sizes in [1, " << FLAGS_max_size << "]";
+  NaiveBestFitAllocator naive_best_fit(platform::CPUPlace{});
+  auto auto_growth = std::make_shared<AutoGrowthBestFitAllocator>(
+      std::make_shared<CPUAllocator>(), 64, 64 << 20);
+  ThreadCachingAllocator thread_caching(
+      std::make_shared<AutoGrowthBestFitAllocator>(
+          std::make_shared<CPUAllocator>(), 64, 64 << 20));
+  for (int threads : ParseIntList(FLAGS_threads)) {
+    double naive_ns = RunOnce(&naive_best_fit, threads);
+    double auto_growth_ns = RunOnce(auto_growth.get(), threads);
+    double thread_caching_ns = RunOnce(&thread_caching, threads);
+    LOG(INFO) << threads << " threads: naive_best_fit " << naive_ns
+              << " ns, auto_growth " << auto_growth_ns
+              << " ns, thread_caching " << thread_caching_ns
+              << " ns, speedup over auto_growth "
+              << auto_growth_ns / thread_caching_ns;
+  }
+  auto stats = thread_caching.GetStats();
+  LOG(INFO) << "thread_caching: " << stats.alloc_count << " allocations, "
+            << stats.thread_cache_hit_count << " thread cache hits, "
+            << stats.central_cache_hit_count << " central cache hits, "
+            << stats.underlying_alloc_count << " underlying allocations";
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::memory::allocation::Run();
+  return 0;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+
+DECLARE_string(allocator_strategy);
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+TEST(allocator, thread_caching) {
+  FLAGS_allocator_strategy = "thread_caching";
+
+  auto &instance = AllocatorFacade::Instance();
+  platform::CPUPlace place;
+  {
+    auto allocation = instance.Alloc(place, 1000);
+    ASSERT_NE(allocation, nullptr);
+    ASSERT_NE(allocation->ptr(), nullptr);
+    ASSERT_TRUE(platform::is_cpu_place(allocation->place()));
+    ASSERT_EQ(allocation->size(), 1024UL);
+  }
+  {
+    auto allocation = instance.Alloc(place, 16 << 20);
+    ASSERT_NE(allocation, nullptr);
+    ASSERT_GE(allocation->size(), 16UL << 20);
+  }
+
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      std::vector<AllocationPtr> allocations;
+      for (int i = 0; i < 1000; ++i) {
+        size_t size = 1 + rng() % (4 << 10);
+        allocations.emplace_back(instance.Alloc(place, size));
+        ASSERT_GE(allocations.back()->size(), size);
+        if (rng() % 2 == 0) {
+          allocations.erase(allocations.begin());
+        }
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
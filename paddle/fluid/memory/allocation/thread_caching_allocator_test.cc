@@ -0,0 +1,212 @@
+// Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_caching_allocator.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/allocation/auto_growth_best_fit_allocator.h"
+#include "paddle/fluid/memory/allocation/cpu_allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+// Counts the allocations which are not freed yet.
+class CountingAllocator : public Allocator {
+ public:
+  explicit CountingAllocator(std::shared_ptr<Allocator> underlying_allocator)
+      : underlying_allocator_(std::move(underlying_allocator)) {}
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  int64_t AllocCount() const { return alloc_count_; }
+  int64_t LiveCount() const { return live_count_; }
+
+ protected:
+  Allocation *AllocateImpl(size_t size) override {
+    ++alloc_count_;
+    ++live_count_;
+    return underlying_allocator_->Allocate(size).release();
+  }
+
+  void FreeImpl(Allocation *allocation) override {
+    --live_count_;
+    underlying_allocator_->Free(allocation);
+  }
+
+ private:
+  std::shared_ptr<Allocator> underlying_allocator_;
+  std::atomic<int64_t> alloc_count_{0};
+  std::atomic<int64_t> live_count_{0};
+};
+
+TEST(ThreadCachingAllocator, SizeClass) {
+  size_t last_size = 0;
+  for (size_t size_class = 0; size_class < 100; ++size_class) {
+    size_t class_size = ThreadCachingAllocator::ClassSize(size_class);
+    ASSERT_GT(class_size, last_size);
+    ASSERT_EQ(class_size % 64, 0UL);
+    ASSERT_EQ(ThreadCachingAllocator::SizeClassOf(class_size), size_class);
+    ASSERT_EQ(ThreadCachingAllocator::SizeClassOf(last_size + 1), size_class);
+    // the internal fragmentation is less than 25% for large classes
+    ASSERT_LE(class_size - last_size, std::max<size_t>(64, class_size / 4));
+    last_size = class_size;
+  }
+  ASSERT_EQ(ThreadCachingAllocator::SizeClassOf(1), 0UL);
+  ASSERT_EQ(ThreadCachingAllocator::ClassSize(
+                ThreadCachingAllocator::SizeClassOf(1000)),
+            1024UL);
+  ASSERT_EQ(ThreadCachingAllocator::ClassSize(
+                ThreadCachingAllocator::SizeClassOf(1025)),
+            1280UL);
+  ASSERT_EQ(ThreadCachingAllocator::ClassSize(
+                ThreadCachingAllocator::SizeClassOf(5000)),
+            5120UL);
+}
+
+TEST(ThreadCachingAllocator, SingleThread) {
+  auto counting =
+      std::make_shared<CountingAllocator>(std::make_shared<CPUAllocator>());
+  {
+    ThreadCachingAllocator allocator(counting, 1 << 16, 1 << 20);
+    void *ptr = nullptr;
+    {
+      auto allocation = allocator.Allocate(100);
+      ASSERT_NE(allocation->ptr(), nullptr);
+      ASSERT_EQ(allocation->size(), 128UL);
+      ASSERT_TRUE(platform::is_cpu_place(allocation->place()));
+      ptr = allocation->ptr();
+    }
+    // the freed block is reused by the same thread
+    {
+      auto allocation = allocator.Allocate(128);
+      ASSERT_EQ(allocation->ptr(), ptr);
+    }
+    int64_t alloc_count = counting->AllocCount();
+    for (int i = 0; i < 1000; ++i) {
+      auto allocation = allocator.Allocate(100);
+    }
+    ASSERT_EQ(counting->AllocCount(), alloc_count);
+
+    auto stats = allocator.GetStats();
+    ASSERT_EQ(stats.alloc_count, 1002UL);
+    ASSERT_EQ(stats.thread_cache_hit_count, 1001UL);
+    ASSERT_EQ(stats.allocated_bytes, 0);
+    ASSERT_GE(stats.underlying_alloc_count, 1UL);
+
+    // large allocations are not cached
+    {
+      auto allocation = allocator.Allocate((1 << 16) + 1);
+      ASSERT_GE(allocation->size(), (1UL << 16) + 1);
+      ASSERT_EQ(allocator.GetStats().large_alloc_count, 1UL);
+      ASSERT_GT(allocator.GetStats().allocated_bytes, 1 << 16);
+    }
+    ASSERT_EQ(allocator.GetStats().allocated_bytes, 0);
+
+    // zero size
+    { auto allocation = allocator.Allocate(0); }
+  }
+}
+
+TEST(ThreadCachingAllocator, ThreadCacheLimit) {
+  auto counting =
+      std::make_shared<CountingAllocator>(std::make_shared<CPUAllocator>());
+  size_t thread_cache_size = 64 << 10;
+  auto allocator = std::make_shared<ThreadCachingAllocator>(
+      counting, 1 << 16, thread_cache_size);
+  std::thread([&] {
+    std::vector<AllocationPtr> allocations;
+    for (int i = 0; i < 1000; ++i) {
+      allocations.emplace_back(allocator->Allocate(1000));
+    }
+    allocations.clear();
+    auto stats = allocator->GetStats();
+    ASSERT_LE(stats.thread_cached_bytes, thread_cache_size);
+    ASSERT_EQ(stats.thread_cached_bytes + stats.central_cached_bytes,
+              counting->AllocCount() * 1024UL);
+  }).join();
+  // the exited thread returns its blocks to the central free lists
+  auto stats = allocator->GetStats();
+  ASSERT_EQ(stats.thread_cached_bytes, 0UL);
+  ASSERT_EQ(stats.central_cached_bytes, counting->AllocCount() * 1024UL);
+  ASSERT_EQ(stats.alloc_count, 1000UL);
+  ASSERT_EQ(counting->LiveCount(), counting->AllocCount());
+
+  allocator->ReleaseCentralCache();
+  ASSERT_EQ(allocator->GetStats().central_cached_bytes, 0UL);
+  ASSERT_EQ(counting->LiveCount(), 0);
+}
+
+TEST(ThreadCachingAllocator, MultiThread) {
+  auto counting = std::make_shared<CountingAllocator>(
+      std::make_shared<AutoGrowthBestFitAllocator>(
+          std::make_shared<CPUAllocator>(), 64, 1 << 20));
+  auto allocator =
+      std::make_shared<ThreadCachingAllocator>(counting, 1 << 16, 1 << 18);
+
+  size_t thread_num = 8;
+  // the allocations are freed by another thread
+  std::vector<std::vector<AllocationPtr>> handoff(thread_num);
+  std::mutex mutex;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<size_t> dist(1, 1 << 17);
+      std::vector<AllocationPtr> allocations;
+      for (int i = 0; i < 5000; ++i) {
+        size_t size = dist(rng) >> (rng() % 8);
+        auto allocation = allocator->Allocate(size);
+        ASSERT_GE(allocation->size(), size);
+        if (size > 0) {
+          std::memset(allocation->ptr(), static_cast<int>(t), size);
+        }
+        allocations.emplace_back(std::move(allocation));
+        if (allocations.size() > 64) {
+          allocations.erase(allocations.begin() + rng() % 64);
+        }
+        if (i % 100 == 0) {
+          std::lock_guard<std::mutex> guard(mutex);
+          handoff[(t + 1) % thread_num].emplace_back(
+              std::move(allocations.back()));
+          allocations.pop_back();
+          handoff[t].clear();
+        }
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  // the blocks freed by this thread would stay in its cache until it exits
+  std::thread([&] { handoff.clear(); }).join();
+
+  auto stats = allocator->GetStats();
+  ASSERT_EQ(stats.alloc_count + stats.large_alloc_count, thread_num * 5000);
+  ASSERT_EQ(stats.allocated_bytes, 0);
+  // every miss of the thread caches fetches at least one block
+  ASSERT_GE(stats.central_cache_hit_count + stats.underlying_alloc_count,
+            stats.alloc_count - stats.thread_cache_hit_count);
+  allocator.reset();
+  ASSERT_EQ(counting->LiveCount(), 0);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
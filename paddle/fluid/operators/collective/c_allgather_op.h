@@ -22,6 +22,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#if !defined(_WIN32)
+#include "paddle/fluid/platform/cpu_collective.h"
+#endif
 
 namespace paddle {
 namespace operators {
@@ -30,7 +33,22 @@ template <typename T>
 class CAllGatherOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("unimplemented cpu kernel for CAllGatherOp.");
+#if !defined(_WIN32)
+    auto in = ctx.Input<framework::Tensor>("X");
+    auto out = ctx.Output<framework::Tensor>("Out");
+
+    int nranks = ctx.Attr<int>("nranks");
+    int rid = ctx.Attr<int>("ring_id");
+    auto comm = platform::CPUCommContext::Instance().Get(rid);
+    PADDLE_ENFORCE_EQ(nranks, comm->nranks());
+
+    framework::DDim out_dims = in->dims();
+    out_dims[0] *= nranks;
+    T* recv_buff = out->mutable_data<T>(out_dims, ctx.GetPlace());
+    comm->AllGather(in->data<T>(), recv_buff, in->numel() * sizeof(T));
+#else
+    PADDLE_THROW("unimplemented cpu kernel for CAllGatherOp on Windows.");
+#endif
   }
 };
 
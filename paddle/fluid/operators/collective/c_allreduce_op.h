@@ -24,6 +24,9 @@ limitations under the License. */
 #include "paddle/fluid/platform/collective_helper.h"
 #include "paddle/fluid/platform/nccl_helper.h"
 #endif
+#if !defined(_WIN32)
+#include "paddle/fluid/platform/cpu_collective.h"
+#endif
 
 namespace paddle {
 namespace operators {
@@ -50,7 +53,44 @@ template <ReduceType red_type, typename T>
 class CAllReduceOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("CAllReduce op do not support CPUKernel for now.");
+#if !defined(_WIN32)
+    auto in = ctx.Input<framework::Tensor>("X");
+    auto out = ctx.Output<framework::Tensor>("Out");
+
+    const void* sendbuff = in->data<void>();
+    out->Resize(in->dims());
+    void* recvbuff = out->mutable_data<T>(ctx.GetPlace());
+
+    int rid = ctx.Attr<int>("ring_id");
+    auto comm = platform::CPUCommContext::Instance().Get(rid);
+
+    platform::CPUReduceType cpu_red_type = platform::CPUReduceType::kSum;
+    switch (red_type) {
+      case kRedSum:
+        cpu_red_type = platform::CPUReduceType::kSum;
+        break;
+
+      case kRedMax:
+        cpu_red_type = platform::CPUReduceType::kMax;
+        break;
+
+      case kRedMin:
+        cpu_red_type = platform::CPUReduceType::kMin;
+        break;
+
+      case kRedProd:
+        cpu_red_type = platform::CPUReduceType::kProd;
+        break;
+
+      default:
+        PADDLE_THROW("Invalid reduce type: %d", red_type);
+    }
+
+    // the CPU collectives are synchronous, use_calc_stream is ignored
+    comm->AllReduce(sendbuff, recvbuff, in->numel(), in->type(), cpu_red_type);
+#else
+    PADDLE_THROW("CAllReduce op do not support CPUKernel on Windows.");
+#endif
   }
 };
 
@@ -21,6 +21,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#if !defined(_WIN32)
+#include "paddle/fluid/platform/cpu_collective.h"
+#endif
 
 namespace paddle {
 namespace operators {
@@ -29,7 +32,23 @@ template <typename T>
 class CBroadcastOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("Unimplemented cpu kernel for CBroadcastOp.");
+#if !defined(_WIN32)
+    auto x = ctx.Input<framework::LoDTensor>("X");
+    auto out = ctx.Output<framework::LoDTensor>("Out");
+    int root = ctx.Attr<int>("root");
+    int rid = ctx.Attr<int>("ring_id");
+    auto comm = platform::CPUCommContext::Instance().Get(rid);
+
+    out->Resize(x->dims());
+    T* data = out->mutable_data<T>(ctx.GetPlace());
+    if (root == comm->rank() && x->data<T>() != data) {
+      std::copy(x->data<T>(), x->data<T>() + x->numel(), data);
+    }
+    comm->Broadcast(data, x->numel() * sizeof(T), root);
+    out->set_lod(x->lod());
+#else
+    PADDLE_THROW("Unimplemented cpu kernel for CBroadcastOp on Windows.");
+#endif
   }
 };
 
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <stdint.h>
 #include <ostream>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/lod_tensor.h"
@@ -28,6 +29,9 @@ limitations under the License. */
 #include "paddle/fluid/platform/collective_helper.h"
 #include "paddle/fluid/platform/nccl_helper.h"
 #endif
+#if !defined(_WIN32)
+#include "paddle/fluid/platform/cpu_collective.h"
+#endif
 
 namespace paddle {
 namespace operators {
@@ -41,8 +45,24 @@ class CCommInitOp : public framework::OperatorBase {
 
   void RunImpl(const framework::Scope& scope,
                const platform::Place& place) const override {
+    if (is_cpu_place(place)) {
+#if !defined(_WIN32)
+      // the CPU ranks connect to each other by the endpoints, X is not used
+      auto endpoints = Attr<std::vector<std::string>>("endpoints");
+      PADDLE_ENFORCE_EQ(endpoints.size(),
+                        static_cast<size_t>(Attr<int>("nranks")),
+                        "The endpoints of all the ranks should be set to run "
+                        "CCommInitOp on cpu place.");
+      platform::CPUCommContext::Instance().CreateComm(
+          endpoints, Attr<int>("rank"), Attr<int>("ring_id"),
+          platform::CPUCommOptions::FromFlags());
+      return;
+#else
+      PADDLE_THROW("CCommInitOp does not support cpu place on Windows.");
+#endif
+    }
     PADDLE_ENFORCE(is_gpu_place(place),
-                   "CCommInitOp can run on gpu place only.");
+                   "CCommInitOp can run on gpu or cpu place only.");
 
     auto var = scope.FindVar(Input("X"));
     PADDLE_ENFORCE_NOT_NULL(var);
@@ -65,7 +85,8 @@ class CCommInitOp : public framework::OperatorBase {
 class CCommInitOpMaker : public framework::OpProtoAndCheckerMaker {
  public:
   void Make() override {
-    AddInput("X", "Raw variable contains a NCCL UniqueId instaces.");
+    AddInput("X", "Raw variable contains a NCCL UniqueId instaces.")
+        .AsDispensable();
     AddComment(R"DOC(
 CCommInit operator
 
@@ -76,6 +97,11 @@ Initialize collective communicatoin context within this trainer
                  "(int) The rank of the trainer in distributed training.");
     AddAttr<int>("ring_id", "(int default 0) user specified ring id")
         .SetDefault(0);
+    AddAttr<std::vector<std::string>>(
+        "endpoints",
+        "(vector<string> default []) The ip:port of all the ranks, used to "
+        "connect the ranks on cpu place.")
+        .SetDefault({});
   }
 };
 
@@ -22,6 +22,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#if !defined(_WIN32)
+#include "paddle/fluid/platform/cpu_collective.h"
+#endif
 
 namespace paddle {
 namespace operators {
@@ -30,7 +33,26 @@ template <typename T>
 class CReduceScatterOpCPUKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_THROW("Unimplemented cpu kernel for CReduceScatterOp.");
+#if !defined(_WIN32)
+    auto in = ctx.Input<framework::Tensor>("X");
+    auto out = ctx.Output<framework::Tensor>("Out");
+
+    int rid = ctx.Attr<int>("ring_id");
+    auto comm = platform::CPUCommContext::Instance().Get(rid);
+    int nranks = comm->nranks();
+
+    auto out_dims = in->dims();
+    PADDLE_ENFORCE_EQ(out_dims[0] % nranks, 0,
+                      "The first dimension of X should be divisible by the "
+                      "number of ranks %d.",
+                      nranks);
+    out_dims[0] = out_dims[0] / nranks;
+    T* recv_buff = out->mutable_data<T>(out_dims, ctx.GetPlace());
+    comm->ReduceScatter(in->data<T>(), recv_buff, in->numel() / nranks,
+                        in->type(), platform::CPUReduceType::kSum);
+#else
+    PADDLE_THROW("Unimplemented cpu kernel for CReduceScatterOp on Windows.");
+#endif
   }
 };
 
@@ -0,0 +1,94 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace operators {
+
+// The prepared context of the sub-block of a control flow op, like while and
+// recurrent. The operators of the block are created at the first run of the
+// op and reused by the later runs, instead of created for every run.
+class PreparedSubBlock {
+ public:
+  framework::ExecutorPrepareContext *Get(
+      const framework::BlockDesc &block,
+      const std::vector<std::string> &skip_vars) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ctx_ == nullptr || block_ != &block) {
+      ctx_ = framework::Executor::Prepare(*block.Program(), block.ID(),
+                                          skip_vars);
+      block_ = &block;
+    }
+    return ctx_.get();
+  }
+
+ private:
+  std::mutex mutex_;
+  const framework::BlockDesc *block_{nullptr};
+  std::unique_ptr<framework::ExecutorPrepareContext> ctx_;
+};
+
+// Step scopes kept by a control flow op between its runs, so the variables of
+// the sub-block and their tensor buffers are reused by the later steps and
+// batches instead of created again.
+//
+// The scopes are owned by the pool rather than by the parent scope, so they
+// survive the parent dropping its kids, and a scope is reused only under the
+// same parent it was created with. The parent is never dereferenced by the
+// pool, the scopes of a former parent are just released.
+class StepScopePool {
+ public:
+  std::unique_ptr<framework::Scope> Acquire(const framework::Scope &parent) {
+    std::unique_ptr<framework::Scope> scope;
+    std::vector<std::unique_ptr<framework::Scope>> released;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (parent_ != &parent) {
+        released.swap(scopes_);
+        parent_ = &parent;
+      } else if (!scopes_.empty()) {
+        scope = std::move(scopes_.back());
+        scopes_.pop_back();
+      }
+    }
+    if (scope == nullptr) {
+      scope = parent.NewTmpScope();
+    }
+    return scope;
+  }
+
+  void Release(std::unique_ptr<framework::Scope> scope) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (scope->parent() == parent_) {
+      scopes_.push_back(std::move(scope));
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  const framework::Scope *parent_{nullptr};
+  std::vector<std::unique_ptr<framework::Scope>> scopes_;
+};
+
+}  // namespace operators
+}  // namespace paddle
@@ -18,6 +18,7 @@
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/var_type.h"
+#include "paddle/fluid/operators/controlflow/sub_block_cache.h"
 #include "paddle/fluid/operators/controlflow/while_op_helper.h"
 #include "paddle/fluid/operators/detail/safe_ref.h"
 
@@ -70,20 +71,25 @@ class WhileOp : public framework::OperatorBase {
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
 
-    auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
+    auto *ctx = sub_block_.Get(*block, skip_vars);
     if (!is_test) {
       while (cond.data<bool>()[0]) {
         auto &current_scope = scope.NewScope();
         step_scopes->push_back(&current_scope);
-        executor.RunPreparedContext(ctx.get(), &current_scope, false, true,
-                                    true);
+        executor.RunPreparedContext(ctx, &current_scope, false, true, true);
       }
     } else {
-      auto &current_scope = scope.NewScope();
-      executor.CreateVariables(*program, &current_scope, block->ID());
-      while (cond.data<bool>()[0]) {
-        for (auto &name : current_scope.LocalVarNames()) {
-          auto *var = current_scope.Var(name);
+      // The step scope is reused by all the steps and the later runs under
+      // the same scope.
+      auto current_scope = step_scope_pool_.Acquire(scope);
+      executor.CreateVariables(*program, current_scope.get(), block->ID());
+      auto vars = ResetVars(*current_scope);
+      for (size_t step = 0; cond.data<bool>()[0]; ++step) {
+        if (step == 1) {
+          // Some operators create variables at the first step.
+          vars = ResetVars(*current_scope);
+        }
+        for (auto *var : vars) {
           if (var->IsType<framework::LoDTensor>()) {
             // Clear all lod information for all lod_tensors.
             auto *t = var->GetMutable<framework::LoDTensor>();
@@ -95,12 +101,25 @@ class WhileOp : public framework::OperatorBase {
             t->clear();
           }
         }
-        executor.RunPreparedContext(ctx.get(), &current_scope, false, false,
+        executor.RunPreparedContext(ctx, current_scope.get(), false, false,
                                     false);
       }
-      scope.DeleteScope(&current_scope);
+      step_scope_pool_.Release(std::move(current_scope));
+    }
+  }
+
+  // The local variables of the step scope, which are reset before every step.
+  static std::vector<framework::Variable *> ResetVars(
+      const framework::Scope &step_scope) {
+    std::vector<framework::Variable *> vars;
+    for (auto &name : step_scope.LocalVarNames()) {
+      vars.push_back(step_scope.FindLocalVar(name));
     }
+    return vars;
   }
+
+  mutable PreparedSubBlock sub_block_;
+  mutable StepScopePool step_scope_pool_;
 };
 
 class WhileOpMaker : public framework::OpProtoAndCheckerMaker {
@@ -154,11 +173,10 @@ class WhileGradOp : public framework::OperatorBase {
     auto &dev_ctx = *pool.Get(dev_place);
     framework::Executor executor(dev_place);
     auto *block = Attr<framework::BlockDesc *>(kStepBlock);
-    auto *program = block->Program();
 
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
-    auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
+    auto *ctx = sub_block_.Get(*block, skip_vars);
 
     auto *step_scopes =
         scope.FindVar(Input(kStepScopes))->GetMutable<StepScopeVar>();
@@ -221,8 +239,7 @@ class WhileGradOp : public framework::OperatorBase {
           PADDLE_THROW("Currently only support LoDTensor and LoDTensorArray.");
         }
       }
-      executor.RunPreparedContext(ctx.get(), *cur_scope_iter, false, true,
-                                  true);
+      executor.RunPreparedContext(ctx, *cur_scope_iter, false, true, true);
 
       // The Outputs(kXGRAD) contains the names of the gradient of parameters
       // and inputs.
@@ -307,6 +324,8 @@ class WhileGradOp : public framework::OperatorBase {
     }
     step_scopes->clear();
   }
+
+  mutable PreparedSubBlock sub_block_;
 };
 
 class WhileGradOpDescMaker : public framework::SingleGradOpDescMaker {
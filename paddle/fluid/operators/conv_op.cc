@@ -196,7 +196,7 @@ void Conv2DOpMaker::Make() {
       "(bool, default false) Only used in cudnn kernel, need install cudnn")
       .SetDefault(false);
   AddAttr<bool>("fuse_relu_before_depthwise_conv",
-                "(bool, default false) Only used in cuda depthwise kernel")
+                "(bool, default false) Only used in depthwise kernel")
       .SetDefault(false);
   AddAttr<bool>("use_mkldnn",
                 "(bool, default false) Only used in mkldnn kernel")
@@ -684,17 +684,16 @@ REGISTER_OPERATOR(conv3d_grad_grad, ops::ConvOpDoubleGrad);
 // TODO(xingzhaolong): neon kernel for mobile
 REGISTER_OP_CPU_KERNEL(
     depthwise_conv2d,
-    ops::GemmConvKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::GemmConvKernel<paddle::platform::CPUDeviceContext, double>);
+    ops::DepthwiseConvKernel<paddle::platform::CPUDeviceContext, float>,
+    ops::DepthwiseConvKernel<paddle::platform::CPUDeviceContext, double>);
 
 REGISTER_OP_CPU_KERNEL(
     depthwise_conv2d_grad,
-    ops::GemmConvGradKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::GemmConvGradKernel<paddle::platform::CPUDeviceContext, double>);
+    ops::DepthwiseConvGradKernel<paddle::platform::CPUDeviceContext, float>,
+    ops::DepthwiseConvGradKernel<paddle::platform::CPUDeviceContext, double>);
 
 REGISTER_OP_CPU_KERNEL(
-    conv2d, ops::GemmConvKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::GemmConvKernel<paddle::platform::CPUDeviceContext, double>);
+    conv2d, ops::CPUConvKernel<float>, ops::CPUConvKernel<double>);
 REGISTER_OP_CPU_KERNEL(
     conv2d_grad,
     ops::GemmConvGradKernel<paddle::platform::CPUDeviceContext, float>,
@@ -705,8 +704,7 @@ REGISTER_OP_CPU_KERNEL(
     ops::GemmConvDoubleGradKernel<paddle::platform::CPUDeviceContext, double>);
 
 REGISTER_OP_CPU_KERNEL(
-    conv3d, ops::GemmConvKernel<paddle::platform::CPUDeviceContext, float>,
-    ops::GemmConvKernel<paddle::platform::CPUDeviceContext, double>);
+    conv3d, ops::CPUConvKernel<float>, ops::CPUConvKernel<double>);
 REGISTER_OP_CPU_KERNEL(
     conv3d_grad,
     ops::GemmConvGradKernel<paddle::platform::CPUDeviceContext, float>,
@@ -14,16 +14,22 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/detail/safe_ref.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/conv_nchw16c.h"
 #include "paddle/fluid/operators/math/depthwise_conv.h"
 #include "paddle/fluid/operators/math/im2col.h"
 #include "paddle/fluid/operators/math/vol2col.h"
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
 
 namespace paddle {
 namespace operators {
@@ -32,6 +38,9 @@ using Tensor = framework::Tensor;
 constexpr int kConvMKLDNNFP32 = 1;
 constexpr int kConvMKLDNNINT8 = 2;
 constexpr int MaxKeyLength = 256;
+// The GEMMs of the conv slices smaller than this, in multiply-adds, are run in
+// parallel even if there are fewer slices than threads.
+constexpr int64_t kConvSmallGemmSize = 1 << 20;
 
 // Base convolution operator definations for other conv
 // like operators to reuse the implementation.
@@ -226,6 +235,135 @@ class GemmConvKernel : public framework::OpKernel<T> {
   }
 };
 
+// The conv kernel of CPU. The (image, group) slices are convolved in parallel
+// when there are enough of them or their GEMMs are small, each thread with its
+// own col buffer, otherwise one by one on the threads of the BLAS library. The
+// float conv2d whose channels are multiples of 16 runs on the direct
+// convolution of the ConvNCHW16C jit kernel when a jit code of it is
+// registered for the CPU, and the conv2d of one input channel per group on the
+// depthwise kernels.
+template <typename T>
+class CPUConvKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& context) const override {
+    const Tensor* input = context.Input<Tensor>("Input");
+    Tensor filter = *context.Input<Tensor>("Filter");
+    Tensor* output = context.Output<Tensor>("Output");
+    output->mutable_data<T>(context.GetPlace());
+
+    int groups = context.Attr<int>("groups");
+    std::vector<int> strides = context.Attr<std::vector<int>>("strides");
+    std::vector<int> paddings = context.Attr<std::vector<int>>("paddings");
+    std::vector<int> dilations = context.Attr<std::vector<int>>("dilations");
+
+    if (input->dims().size() == 4 && groups > 1 &&
+        groups == input->dims()[1]) {
+      auto& dev_ctx =
+          context.template device_context<platform::CPUDeviceContext>();
+      math::DepthwiseConvFunctor<platform::CPUDeviceContext, T, false>
+          depthwise_conv;
+      depthwise_conv(dev_ctx, *input, filter, strides, paddings, dilations,
+                     output);
+      return;
+    }
+    if (std::is_same<T, float>::value &&
+        math::CanUseConvNCHW16C(input->dims(), filter.dims(), output->dims(),
+                                strides, paddings, dilations, groups)) {
+      math::ConvNCHW16C(*input, filter, strides, paddings, output);
+      return;
+    }
+
+    auto& dev_ctx =
+        context.template device_context<platform::CPUDeviceContext>();
+    const int batch_size = static_cast<int>(input->dims()[0]);
+
+    std::vector<int64_t> filter_shape_vec(framework::vectorize(filter.dims()));
+    std::vector<int64_t> output_shape_vec(framework::vectorize(output->dims()));
+    size_t data_dim = filter_shape_vec.size() - 2;
+    std::vector<int64_t> col_shape_vec(1 + 2 * data_dim);
+    col_shape_vec[0] = input->dims()[1] / groups;
+    for (size_t j = 0; j < data_dim; ++j) {
+      col_shape_vec[j + 1] = filter_shape_vec[j + 2];
+      col_shape_vec[j + 1 + data_dim] = output_shape_vec[j + 2];
+    }
+    framework::DDim col_shape(framework::make_ddim(col_shape_vec));
+    framework::DDim col_matrix_shape =
+        framework::flatten_to_2d(col_shape, data_dim + 1);
+    bool is_expand = IsExpand(filter_shape_vec, strides, paddings, dilations);
+
+    framework::DDim input_shape =
+        framework::slice_ddim(input->dims(), 1, input->dims().size());
+    framework::DDim filter_matrix_shape = {filter.dims()[0],
+                                           filter.numel() / filter.dims()[0]};
+    filter.Resize(filter_matrix_shape);
+    framework::DDim output_matrix_shape = {
+        output->dims()[1],
+        output->numel() / (output->dims()[0] * output->dims()[1])};
+
+    int in_step = static_cast<int>(input->dims()[1]) / groups;
+    int out_step = static_cast<int>(output->dims()[1]) / groups;
+    int slices = batch_size * groups;
+    int threads = 1;
+#ifdef PADDLE_WITH_MKLML
+    int64_t gemm_size = out_step * col_matrix_shape[0] * col_matrix_shape[1];
+    int max_threads = omp_get_max_threads();
+    if (slices >= max_threads || gemm_size < kConvSmallGemmSize) {
+      threads = std::min(max_threads, slices);
+    }
+#endif
+
+    // The col buffers of the threads, the 1x1 conv of stride 1 and no padding
+    // runs the GEMM on the input directly.
+    Tensor cols;
+    int64_t col_numel = framework::product(col_shape);
+    if (is_expand) {
+      cols = context.AllocateTmpTensor<T, platform::CPUDeviceContext>(
+          framework::make_ddim({threads * col_numel}), dev_ctx);
+    }
+
+    math::Vol2ColFunctor<platform::CPUDeviceContext, T> vol2col;
+    math::Im2ColFunctor<math::ColFormat::kCFO, platform::CPUDeviceContext, T>
+        im2col;
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(dev_ctx);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for num_threads(threads) if (threads > 1)
+#endif
+    for (int s = 0; s < slices; ++s) {
+      int i = s / groups;
+      int g = s % groups;
+      int tid = 0;
+#ifdef PADDLE_WITH_MKLML
+      tid = omp_get_thread_num();
+#endif
+      Tensor in_batch = input->Slice(i, i + 1).Resize(input_shape);
+      Tensor in_slice = in_batch.Slice(g * in_step, (g + 1) * in_step);
+      Tensor col, col_matrix;
+      if (!is_expand) {
+        col.ShareDataWith(in_slice);
+      } else {
+        col = cols.Slice(tid * col_numel, (tid + 1) * col_numel)
+                  .Resize(col_shape);
+        if (data_dim == 2U) {
+          im2col(dev_ctx, in_slice, dilations, strides,
+                 std::vector<int>{paddings[0], paddings[1], paddings[0],
+                                  paddings[1]},
+                 &col);
+        } else if (data_dim == 3U) {
+          vol2col(dev_ctx, in_slice, dilations, strides, paddings, &col);
+        }
+      }
+      col_matrix.ShareDataWith(col);
+      col_matrix.Resize(col_matrix_shape);
+
+      Tensor out_batch = output->Slice(i, i + 1).Resize(output_matrix_shape);
+      Tensor out_slice = out_batch.Slice(g * out_step, (g + 1) * out_step);
+      Tensor filter_slice = filter.Slice(g * out_step, (g + 1) * out_step);
+      blas.MatMul(filter_slice, false, col_matrix, false, T(1.0), &out_slice,
+                  T(0.0));
+    }
+  }
+};
+
 template <typename DeviceContext, typename T>
 class GemmConvGradKernel : public framework::OpKernel<T> {
  public:
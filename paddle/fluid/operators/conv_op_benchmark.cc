@@ -0,0 +1,229 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the CPU conv kernel against the former im2col + GEMM kernel,
+// which convolves the images and groups one by one, on the convolutions of
+// ResNet-50 and MobileNet-v1. The gradient of the depthwise convolutions is
+// also compared between the depthwise kernel and the im2col + GEMM one.
+//
+//   OMP_NUM_THREADS=16 ./conv_op_benchmark --batch_size=8 --repeat=20
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/conv_op.h"
+#include "paddle/fluid/platform/init.h"
+
+DEFINE_int32(batch_size, 1, "The batch size of the input.");
+DEFINE_int32(repeat, 20, "The runs of every kernel on every shape.");
+DEFINE_string(filter, "", "Only the shape of this name is run if it is set.");
+
+USE_OP(conv2d);
+USE_OP(depthwise_conv2d);
+
+namespace paddle {
+namespace operators {
+
+struct ConvShape {
+  std::string name;
+  int ic, oc, size, k, stride, padding, groups;
+};
+
+static const std::vector<ConvShape>& BenchmarkShapes() {
+  static const std::vector<ConvShape> shapes = {
+      {"resnet_conv1", 3, 64, 224, 7, 2, 3, 1},
+      {"resnet_res2_1x1", 64, 256, 56, 1, 1, 0, 1},
+      {"resnet_res2_3x3", 64, 64, 56, 3, 1, 1, 1},
+      {"resnet_res3_3x3_s2", 128, 128, 56, 3, 2, 1, 1},
+      {"resnet_res3_3x3", 128, 128, 28, 3, 1, 1, 1},
+      {"resnet_res4_3x3", 256, 256, 14, 3, 1, 1, 1},
+      {"resnet_res4_1x1_s2", 512, 1024, 28, 1, 2, 0, 1},
+      {"resnet_res5_3x3", 512, 512, 7, 3, 1, 1, 1},
+      {"mobilenet_dw_112", 32, 32, 112, 3, 1, 1, 32},
+      {"mobilenet_pw_112", 32, 64, 112, 1, 1, 0, 1},
+      {"mobilenet_dw_112_s2", 64, 64, 112, 3, 2, 1, 64},
+      {"mobilenet_dw_28", 256, 256, 28, 3, 1, 1, 256},
+      {"mobilenet_dw_14", 512, 512, 14, 3, 1, 1, 512},
+      {"mobilenetv3_dw_5x5_s2", 72, 72, 56, 5, 2, 2, 72},
+      {"mobilenetv3_dw_5x5", 480, 480, 14, 5, 1, 2, 480},
+      {"mobilenet_pw_14", 512, 512, 14, 1, 1, 0, 1},
+      {"mobilenet_pw_7", 1024, 1024, 7, 1, 1, 0, 1}};
+  return shapes;
+}
+
+static void RandomFill(framework::LoDTensor* tensor) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  float* data = tensor->data<float>();
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+template <typename Kernel>
+double MsPerRun(const Kernel& kernel, const framework::ExecutionContext& ctx) {
+  kernel.Compute(ctx);
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    kernel.Compute(ctx);
+  }
+  std::chrono::duration<double, std::milli> ms =
+      std::chrono::steady_clock::now() - start;
+  return ms.count() / FLAGS_repeat;
+}
+
+static float MaxDiff(const framework::LoDTensor& a,
+                     const framework::LoDTensor& b) {
+  float max_diff = 0.f;
+  for (int64_t i = 0; i < a.numel(); ++i) {
+    max_diff = std::max(max_diff, std::fabs(a.data<float>()[i] -
+                                            b.data<float>()[i]));
+  }
+  return max_diff;
+}
+
+static bool IsDepthwise(const ConvShape& shape) {
+  return shape.groups > 1 && shape.groups == shape.ic;
+}
+
+static void RunDepthwiseGrad(const ConvShape& shape, framework::Scope* scope,
+                             const framework::AttributeMap& attrs) {
+  platform::CPUPlace place;
+  auto* input = scope->FindVar("input")->GetMutable<framework::LoDTensor>();
+  auto* filter = scope->FindVar("filter")->GetMutable<framework::LoDTensor>();
+  auto* output = scope->FindVar("output")->GetMutable<framework::LoDTensor>();
+  auto* output_grad =
+      scope->Var("output_grad")->GetMutable<framework::LoDTensor>();
+  output_grad->mutable_data<float>(output->dims(), place);
+  RandomFill(output_grad);
+  auto* input_grad =
+      scope->Var("input_grad")->GetMutable<framework::LoDTensor>();
+  input_grad->Resize(input->dims());
+  auto* filter_grad =
+      scope->Var("filter_grad")->GetMutable<framework::LoDTensor>();
+  filter_grad->Resize(filter->dims());
+
+  auto op = framework::OpRegistry::CreateOp(
+      "depthwise_conv2d_grad",
+      {{"Input", {"input"}},
+       {"Filter", {"filter"}},
+       {framework::GradVarName("Output"), {"output_grad"}}},
+      {{framework::GradVarName("Input"), {"input_grad"}},
+       {framework::GradVarName("Filter"), {"filter_grad"}}},
+      attrs);
+  framework::RuntimeContext run_ctx(op->Inputs(), op->Outputs(), *scope);
+  auto* dev_ctx = platform::DeviceContextPool::Instance().Get(place);
+  framework::ExecutionContext ctx(*op, *scope, *dev_ctx, run_ctx, nullptr);
+
+  GemmConvGradKernel<platform::CPUDeviceContext, float> gemm_kernel;
+  double gemm_ms = MsPerRun(gemm_kernel, ctx);
+  framework::LoDTensor expected_input_grad, expected_filter_grad;
+  expected_input_grad.ShareDataWith(*input_grad);
+  expected_filter_grad.ShareDataWith(*filter_grad);
+  input_grad->clear();
+  filter_grad->clear();
+
+  DepthwiseConvGradKernel<platform::CPUDeviceContext, float> depthwise_kernel;
+  double depthwise_ms = MsPerRun(depthwise_kernel, ctx);
+
+  LOG(INFO) << shape.name << " grad: im2col + gemm " << gemm_ms
+            << " ms, depthwise " << depthwise_ms << " ms, speedup "
+            << gemm_ms / depthwise_ms << ", max diff of input grad "
+            << MaxDiff(*input_grad, expected_input_grad) << ", filter grad "
+            << MaxDiff(*filter_grad, expected_filter_grad);
+}
+
+static void RunShape(const ConvShape& shape) {
+  platform::CPUPlace place;
+  framework::Scope scope;
+  auto* input = scope.Var("input")->GetMutable<framework::LoDTensor>();
+  input->mutable_data<float>(
+      framework::make_ddim(
+          {FLAGS_batch_size, shape.ic, shape.size, shape.size}),
+      place);
+  RandomFill(input);
+  auto* filter = scope.Var("filter")->GetMutable<framework::LoDTensor>();
+  filter->mutable_data<float>(
+      framework::make_ddim(
+          {shape.oc, shape.ic / shape.groups, shape.k, shape.k}),
+      place);
+  RandomFill(filter);
+  auto* output = scope.Var("output")->GetMutable<framework::LoDTensor>();
+
+  framework::AttributeMap attrs;
+  attrs["strides"] = std::vector<int>{shape.stride, shape.stride};
+  attrs["paddings"] = std::vector<int>{shape.padding, shape.padding};
+  attrs["dilations"] = std::vector<int>{1, 1};
+  attrs["groups"] = shape.groups;
+  auto op = framework::OpRegistry::CreateOp(
+      "conv2d", {{"Input", {"input"}}, {"Filter", {"filter"}}},
+      {{"Output", {"output"}}}, attrs);
+  // infers the output shape
+  op->Run(scope, place);
+
+  framework::RuntimeContext run_ctx(op->Inputs(), op->Outputs(), scope);
+  auto* dev_ctx = platform::DeviceContextPool::Instance().Get(place);
+  framework::ExecutionContext ctx(*op, scope, *dev_ctx, run_ctx, nullptr);
+
+  GemmConvKernel<platform::CPUDeviceContext, float> gemm_kernel;
+  double gemm_ms = MsPerRun(gemm_kernel, ctx);
+  framework::LoDTensor expected;
+  expected.ShareDataWith(*output);
+  output->clear();
+  output->mutable_data<float>(expected.dims(), place);
+
+  CPUConvKernel<float> cpu_kernel;
+  double cpu_ms = MsPerRun(cpu_kernel, ctx);
+  float max_diff = MaxDiff(*output, expected);
+  bool direct = math::CanUseConvNCHW16C(
+      input->dims(), filter->dims(), output->dims(),
+      {shape.stride, shape.stride}, {shape.padding, shape.padding}, {1, 1},
+      shape.groups);
+
+  LOG(INFO) << shape.name << ": im2col + gemm " << gemm_ms << " ms, cpu conv "
+            << cpu_ms << " ms" << (direct ? " (direct NCHW16C)" : "")
+            << (IsDepthwise(shape) ? " (depthwise)" : "") << ", speedup "
+            << gemm_ms / cpu_ms << ", max diff " << max_diff;
+
+  if (IsDepthwise(shape)) {
+    // the attributes of the forward op have the defaults filled in
+    RunDepthwiseGrad(shape, &scope, op->Attrs());
+  }
+}
+
+void Run() {
+  framework::InitDevices(false);
+  for (auto& shape : BenchmarkShapes()) {
+    if (!FLAGS_filter.empty() && FLAGS_filter != shape.name) {
+      continue;
+    }
+    RunShape(shape);
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::operators::Run();
+  return 0;
+}
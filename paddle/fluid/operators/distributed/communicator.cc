@@ -17,6 +17,7 @@ limitations under the License. */
 #include <gflags/gflags.h>
 #include <paddle/fluid/framework/program_desc.h>
 #include <chrono>  // NOLINT
+#include <cstring>
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/eigen.h"
@@ -41,6 +42,12 @@ DEFINE_bool(communicator_fake_rpc, false,
             "fake mode does not really send any thing");
 DEFINE_bool(communicator_merge_sparse_grad, true,
             "merge sparse gradient before sending");
+DEFINE_bool(communicator_merge_grad_on_arrival, false,
+            "merge every dense gradient into a buffer of its var when it is "
+            "sent by the trainer, instead of queueing a copy of it");
+DEFINE_int64(communicator_send_bucket_size, 1 << 20,
+             "the bytes of the buckets the small dense gradients are packed "
+             "into for sending, used with communicator_merge_grad_on_arrival");
 
 namespace paddle {
 namespace operators {
@@ -76,6 +83,10 @@ Communicator::Communicator(const RpcCtxMap &send_varname_to_ctx,
   VLOG(0) << "communicator_fake_rpc: " << FLAGS_communicator_fake_rpc;
   VLOG(0) << "communicator_merge_sparse_grad: "
           << FLAGS_communicator_merge_sparse_grad;
+  VLOG(0) << "communicator_merge_grad_on_arrival: "
+          << FLAGS_communicator_merge_grad_on_arrival;
+  VLOG(0) << "communicator_send_bucket_size: "
+          << FLAGS_communicator_send_bucket_size;
 
   if (send_varname_to_ctx.size() == 0) {
     VLOG(0) << "nothing need to be send, will not start send_thread";
@@ -85,6 +96,7 @@ Communicator::Communicator(const RpcCtxMap &send_varname_to_ctx,
       send_varname_to_queue_[iter.first] =
           std::make_shared<BlockingQueue<std::shared_ptr<Variable>>>(
               FLAGS_communicator_send_queue_size);
+      send_varname_to_accumulator_[iter.first].reset(new GradAccumulator);
     }
     send_threadpool_.reset(
         new ::ThreadPool(FLAGS_communicator_thread_pool_size));
@@ -161,6 +173,8 @@ void Communicator::SendThread() {
           auto after_send = GetCurrentUS();
           VLOG(3) << "send " << var_name << " use time "
                   << after_send - after_merge;
+          RecordSendStat(var_name, merged_var_num, after_merge - before_merge,
+                         after_send - after_merge);
         };
         task_futures.emplace_back(
             send_threadpool_->enqueue(std::move(send_task)));
@@ -168,6 +182,12 @@ void Communicator::SendThread() {
         VLOG(4) << var_name << " queue empty";
       }
     }
+    if (FLAGS_communicator_merge_grad_on_arrival) {
+      SendMergedGrads(&task_futures);
+      if (task_futures.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
     for (auto &task_f : task_futures) {
       task_f.wait();
     }
@@ -180,6 +200,136 @@ void Communicator::SendThread() {
   VLOG(0) << "communicator stopped, send thread exit";
 }
 
+void Communicator::AccumulateGrad(const std::string &var_name,
+                                  const framework::LoDTensor &grad) {
+  auto &accumulator = *send_varname_to_accumulator_.at(var_name);
+  std::unique_lock<std::mutex> lock(accumulator.mutex);
+  // block the trainer like a full send queue
+  accumulator.cv.wait(lock, [&] {
+    return accumulator.merged_num < FLAGS_communicator_max_merge_var_num ||
+           !running_;
+  });
+  auto before_merge = GetCurrentUS();
+  if (accumulator.merged_num == 0) {
+    // the buffer swapped back may have the dims of another batch
+    auto *merged = accumulator.merged.mutable_data<float>(grad.dims(),
+                                                          platform::CPUPlace());
+    std::memcpy(merged, grad.data<float>(), grad.numel() * sizeof(float));
+  } else {
+    PADDLE_ENFORCE_EQ(accumulator.merged.dims(), grad.dims(),
+                      "The gradient %s should have the same dims as the "
+                      "merged ones",
+                      var_name);
+    auto *merged = accumulator.merged.data<float>();
+    SumAndScale({merged, grad.data<float>()}, grad.numel(), 1.f, merged);
+  }
+  ++accumulator.merged_num;
+  accumulator.merge_us += GetCurrentUS() - before_merge;
+}
+
+int64_t Communicator::TakeMergedGrad(const std::string &var_name,
+                                     double *merge_us) {
+  auto &accumulator = *send_varname_to_accumulator_.at(var_name);
+  auto *send_tensor =
+      send_scope_->Var(var_name)->GetMutable<framework::LoDTensor>();
+  int64_t merged_num = 0;
+  {
+    std::lock_guard<std::mutex> lock(accumulator.mutex);
+    merged_num = accumulator.merged_num;
+    if (merged_num == 0) {
+      return 0;
+    }
+    // swap the buffers, the next gradients are merged while this is sent
+    std::swap(*send_tensor, accumulator.merged);
+    accumulator.merged_num = 0;
+    *merge_us = accumulator.merge_us;
+    accumulator.merge_us = 0;
+  }
+  accumulator.cv.notify_all();
+
+  auto before_scale = GetCurrentUS();
+  auto *data = send_tensor->data<float>();
+  SumAndScale({data}, send_tensor->numel(),
+              1.f / static_cast<float>(merged_num), data);
+  *merge_us += GetCurrentUS() - before_scale;
+  return merged_num;
+}
+
+void Communicator::SendMergedGrads(
+    std::vector<std::future<void>> *task_futures) {
+  struct Bucket {
+    std::vector<std::string> var_names;
+    std::vector<int64_t> merged_nums;
+    std::vector<double> merge_us;
+    int64_t bytes{0};
+  };
+  Bucket bucket;
+  auto send_bucket = [this, task_futures](Bucket *bucket) {
+    auto send_task = [this](const Bucket &bucket) {
+      auto send_functor = distributed::ParameterSend<float>();
+      for (size_t i = 0; i < bucket.var_names.size(); ++i) {
+        auto &var_name = bucket.var_names[i];
+        auto before_send = GetCurrentUS();
+        if (!FLAGS_communicator_fake_rpc) {
+          send_functor(send_varname_to_ctx_.at(var_name), *send_scope_, true);
+        }
+        auto after_send = GetCurrentUS();
+        VLOG(3) << "send " << var_name << " use time "
+                << after_send - before_send;
+        RecordSendStat(var_name, bucket.merged_nums[i], bucket.merge_us[i],
+                       after_send - before_send);
+      }
+    };
+    task_futures->emplace_back(
+        send_threadpool_->enqueue(std::bind(send_task, std::move(*bucket))));
+    *bucket = Bucket();
+  };
+
+  for (auto &iter : send_varname_to_accumulator_) {
+    auto &var_name = iter.first;
+    double merge_us = 0;
+    int64_t merged_num = TakeMergedGrad(var_name, &merge_us);
+    if (merged_num == 0) {
+      continue;
+    }
+    // only count the send number of the first var
+    if (var_name == send_varname_to_queue_.begin()->first) {
+      grad_num_.fetch_add(merged_num, std::memory_order_relaxed);
+    }
+    VLOG(3) << "merge " << merged_num << " " << var_name << " use time "
+            << merge_us;
+    bucket.var_names.push_back(var_name);
+    bucket.merged_nums.push_back(merged_num);
+    bucket.merge_us.push_back(merge_us);
+    bucket.bytes += send_scope_->FindVar(var_name)
+                        ->Get<framework::LoDTensor>()
+                        .memory_size();
+    if (bucket.bytes >= FLAGS_communicator_send_bucket_size) {
+      send_bucket(&bucket);
+    }
+  }
+  if (!bucket.var_names.empty()) {
+    send_bucket(&bucket);
+  }
+}
+
+void Communicator::RecordSendStat(const std::string &var_name,
+                                  int64_t merged_num, double merge_us,
+                                  double send_us) {
+  std::lock_guard<std::mutex> lock(send_stat_mutex_);
+  auto &stat = send_stats_[var_name];
+  stat.merged_num += merged_num;
+  stat.send_num += 1;
+  stat.merge_us += merge_us;
+  stat.send_us += send_us;
+}
+
+std::unordered_map<std::string, Communicator::SendStat>
+Communicator::GetSendStats() const {
+  std::lock_guard<std::mutex> lock(send_stat_mutex_);
+  return send_stats_;
+}
+
 void Communicator::RecvNonIndependent() {
   if (FLAGS_communicator_independent_recv_thread) {
     return;
@@ -246,6 +396,9 @@ void Communicator::Send(const std::string &var_name,
     if (!FLAGS_communicator_fake_rpc) {
       send_functor(ctx, scope, true);
     }
+  } else if (grad_var->IsType<framework::LoDTensor>() &&
+             FLAGS_communicator_merge_grad_on_arrival) {
+    AccumulateGrad(var_name, grad_var->Get<framework::LoDTensor>());
   } else {
     auto tmp_grad_var = std::make_shared<Variable>();
     framework::CopyVariable(*grad_var, tmp_grad_var.get());
@@ -324,6 +477,11 @@ void Communicator::Start() {
 void Communicator::Stop() {
   VLOG(0) << "Communicator stop";
   running_ = false;
+  // wake up the trainers blocked on the merged gradients
+  for (auto &iter : send_varname_to_accumulator_) {
+    std::lock_guard<std::mutex> lock(iter.second->mutex);
+    iter.second->cv.notify_all();
+  }
   if (!communicator_) {
     VLOG(0) << "Communicator is not inited, do nothing";
   } else {
@@ -338,6 +496,12 @@ void Communicator::Stop() {
       recv_thread_.reset(nullptr);
     }
   }
+  for (auto &iter : GetSendStats()) {
+    auto &stat = iter.second;
+    VLOG(1) << "var " << iter.first << " merged " << stat.merged_num
+            << " gradients in " << stat.merge_us << " us, sent "
+            << stat.send_num << " times in " << stat.send_us << " us";
+  }
   VLOG(0) << "Communicator stop done";
 }
 
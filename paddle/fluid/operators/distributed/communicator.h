@@ -14,9 +14,12 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -100,6 +103,43 @@ template <typename T, int MajorType = Eigen::RowMajor,
           typename IndexType = Eigen::DenseIndex>
 using EigenVector = framework::EigenVector<T, MajorType, IndexType>;
 
+// out[i] = (ins[0][i] + ... + ins[n - 1][i]) * scale. It is one pass over
+// out without zero-filling it: the inputs are summed block by block, so that
+// the block of out stays in the cache, 4 inputs at a time, and the loops are
+// vectorized by the compiler. out may be ins[0].
+inline void SumAndScale(const std::vector<const float*>& ins, int64_t numel,
+                        float scale, float* out) {
+  constexpr int64_t kBlockSize = 1024;
+  for (int64_t begin = 0; begin < numel; begin += kBlockSize) {
+    int64_t end = std::min(begin + kBlockSize, numel);
+    const float* in0 = ins[0];
+    for (int64_t i = begin; i < end; ++i) {
+      out[i] = in0[i];
+    }
+    size_t k = 1;
+    for (; k + 4 <= ins.size(); k += 4) {
+      const float* in1 = ins[k];
+      const float* in2 = ins[k + 1];
+      const float* in3 = ins[k + 2];
+      const float* in4 = ins[k + 3];
+      for (int64_t i = begin; i < end; ++i) {
+        out[i] += (in1[i] + in2[i]) + (in3[i] + in4[i]);
+      }
+    }
+    for (; k < ins.size(); ++k) {
+      const float* in = ins[k];
+      for (int64_t i = begin; i < end; ++i) {
+        out[i] += in[i];
+      }
+    }
+    if (scale != 1.f) {
+      for (int64_t i = begin; i < end; ++i) {
+        out[i] *= scale;
+      }
+    }
+  }
+}
+
 inline void MergeVars(const std::string& var_name,
                       const std::vector<std::shared_ptr<Variable>>& vars,
                       Scope* scope) {
@@ -116,26 +156,17 @@ inline void MergeVars(const std::string& var_name,
     out_t->mutable_data<float>(dims, cpu_place);
 
     // check the input dims
+    std::vector<const float*> ins;
+    ins.reserve(vars.size());
     for (auto& var : vars) {
       auto& var_t = var->Get<framework::LoDTensor>();
       PADDLE_ENFORCE_EQ(var_t.dims(), dims, "should have the same dims");
+      ins.push_back(var_t.data<float>());
     }
 
-    // set output tensor to 0.
-    auto cpu_ctx = paddle::platform::CPUDeviceContext();
-    math::SetConstant<paddle::platform::CPUDeviceContext, float>
-        constant_functor;
-    constant_functor(cpu_ctx, out_t, static_cast<float>(0));
-
-    // sum all vars to out
-    auto result = EigenVector<float>::Flatten(*out_t);
-    for (auto& var : vars) {
-      auto& in_t = var->Get<framework::LoDTensor>();
-      auto in = EigenVector<float>::Flatten(in_t);
-      result.device(*cpu_ctx.eigen_device()) = result + in;
-    }
-    result.device(*cpu_ctx.eigen_device()) =
-        result / static_cast<float>(vars.size());
+    // average all vars to out
+    SumAndScale(ins, out_t->numel(), 1.f / static_cast<float>(vars.size()),
+                out_t->data<float>());
   } else if (var0->IsType<framework::SelectedRows>()) {
     auto& slr0 = var0->Get<framework::SelectedRows>();
     auto* out_slr = out_var->GetMutable<framework::SelectedRows>();
@@ -174,6 +205,16 @@ class Communicator {
   // send grad
   void Send(const std::string& var_name, const framework::Scope& scope);
 
+  struct SendStat {
+    int64_t merged_num{0};  // the number of the merged gradients
+    int64_t send_num{0};    // the number of the sends
+    double merge_us{0};
+    double send_us{0};
+  };
+
+  // The merge and send time of every var since the communicator is created.
+  std::unordered_map<std::string, SendStat> GetSendStats() const;
+
  private:
   // recv all parameter
   void RecvAll();
@@ -181,7 +222,33 @@ class Communicator {
   void SendThread();
   void RecvThread();
 
-  bool running_ = false;
+  // The dense gradients are merged on arrival if
+  // FLAGS_communicator_merge_grad_on_arrival is true: every gradient is
+  // added to the merged gradient of its var when it is sent by the trainer,
+  // instead of being copied into the send queue and merged by the send
+  // thread.
+  struct GradAccumulator {
+    std::mutex mutex;
+    std::condition_variable cv;
+    framework::LoDTensor merged;
+    int64_t merged_num{0};
+    double merge_us{0};
+  };
+  void AccumulateGrad(const std::string& var_name,
+                      const framework::LoDTensor& grad);
+  // Move the merged gradient of var_name into send_scope_ and average it,
+  // returns the number of the merged gradients.
+  int64_t TakeMergedGrad(const std::string& var_name, double* merge_us);
+  // Send the merged dense gradients in buckets: the small vars are packed
+  // into buckets of FLAGS_communicator_send_bucket_size bytes, every bucket
+  // is sent by a task of send_threadpool_, so that taking the gradients of
+  // a bucket overlaps with the RPCs of the previous buckets.
+  void SendMergedGrads(std::vector<std::future<void>>* task_futures);
+
+  void RecordSendStat(const std::string& var_name, int64_t merged_num,
+                      double merge_us, double send_us);
+
+  std::atomic<bool> running_{false};
   std::unordered_map<std::string,
                      std::shared_ptr<BlockingQueue<std::shared_ptr<Variable>>>>
       send_varname_to_queue_;
@@ -194,6 +261,10 @@ class Communicator {
   std::unique_ptr<::ThreadPool> send_threadpool_{nullptr};
   std::unique_ptr<::ThreadPool> recv_threadpool_{nullptr};
   std::atomic_uint grad_num_{0};  // the num of gradient sent since last recv
+  std::unordered_map<std::string, std::unique_ptr<GradAccumulator>>
+      send_varname_to_accumulator_;
+  mutable std::mutex send_stat_mutex_;
+  std::unordered_map<std::string, SendStat> send_stats_;
 
   // the following code is for initialize the commnunicator
  public:
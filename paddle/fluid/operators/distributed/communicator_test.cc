@@ -15,11 +15,17 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <memory>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "paddle/fluid/operators/distributed/communicator.h"
 
+DECLARE_bool(communicator_fake_rpc);
+DECLARE_bool(communicator_merge_grad_on_arrival);
+DECLARE_int64(communicator_send_bucket_size);
+
 namespace paddle {
 namespace operators {
 namespace distributed {
@@ -106,6 +112,76 @@ TEST(communicator, merge_selected_rows) {
   }
 }
 
+TEST(communicator, sum_and_scale) {
+  const int64_t numel = 2500;
+  std::vector<std::vector<float>> ins(3, std::vector<float>(numel));
+  std::vector<const float*> in_ptrs;
+  for (size_t k = 0; k < ins.size(); ++k) {
+    for (int64_t i = 0; i < numel; ++i) {
+      ins[k][i] = static_cast<float>(i * (k + 1));
+    }
+    in_ptrs.push_back(ins[k].data());
+  }
+  std::vector<float> out(numel, -1.f);
+  SumAndScale(in_ptrs, numel, 0.5f, out.data());
+  for (int64_t i = 0; i < numel; ++i) {
+    ASSERT_EQ(out[i], static_cast<float>(i * 6) * 0.5f);
+  }
+  // in place
+  SumAndScale({out.data(), ins[0].data()}, numel, 1.f, out.data());
+  for (int64_t i = 0; i < numel; ++i) {
+    ASSERT_EQ(out[i], static_cast<float>(i * 4));
+  }
+}
+
+TEST(communicator, merge_grad_on_arrival) {
+  FLAGS_communicator_fake_rpc = true;
+  FLAGS_communicator_merge_grad_on_arrival = true;
+  FLAGS_communicator_send_bucket_size = 64;
+  auto cpu_place = platform::CPUPlace();
+  std::vector<std::string> var_names{"w0@GRAD", "w1@GRAD", "w2@GRAD"};
+  RpcCtxMap send_varname_to_ctx;
+  framework::Scope scope;
+  for (size_t i = 0; i < var_names.size(); ++i) {
+    auto& var_name = var_names[i];
+    send_varname_to_ctx[var_name] =
+        RpcContext(var_name, {var_name}, {"127.0.0.1:0"}, {}, 0);
+    auto* tensor = scope.Var(var_name)->GetMutable<LoDTensor>();
+    auto dims = framework::make_ddim({static_cast<int64_t>(i + 1) * 10, 4});
+    auto* data = tensor->mutable_data<float>(dims, cpu_place);
+    std::fill(data, data + tensor->numel(), 1.f);
+  }
+  Communicator::Init(send_varname_to_ctx, RpcCtxMap(), &scope);
+  auto* communicator = Communicator::GetInstance();
+  communicator->Start();
+
+  const int64_t send_num = 50;
+  for (int64_t i = 0; i < send_num; ++i) {
+    for (auto& var_name : var_names) {
+      communicator->Send(var_name, scope);
+    }
+  }
+  auto all_sent = [&] {
+    auto stats = communicator->GetSendStats();
+    for (auto& var_name : var_names) {
+      if (stats[var_name].merged_num != send_num) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (int i = 0; i < 1000 && !all_sent(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  communicator->Stop();
+  ASSERT_TRUE(all_sent());
+  for (auto& iter : communicator->GetSendStats()) {
+    ASSERT_GE(iter.second.send_num, 1);
+    ASSERT_LE(iter.second.send_num, send_num);
+  }
+  FLAGS_communicator_merge_grad_on_arrival = false;
+}
+
 }  // namespace distributed
 }  // namespace operators
 }  // namespace paddle
@@ -14,9 +14,11 @@ limitations under the License. */
 
 #pragma once
 
+#include <cstring>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/operators/elementwise/elementwise_op.h"
 #include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
 
 namespace paddle {
@@ -27,6 +29,32 @@ struct AddFunctor {
   inline HOSTDEVICE T operator()(T a, T b) const { return a + b; }
 };
 
+// Run the jit kernels VAdd and VAddBias in the CPU broadcast engine.
+template <typename T>
+class BroadcastInnerKernel<
+    AddFunctor<T>, T, T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+ public:
+  BroadcastInnerKernel(AddFunctor<T> func, int64_t n)
+      : n_(BroadcastJitSize(n)),
+        vadd_(jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                  .At(n_)),
+        vadd_bias_(
+            jit::KernelFuncs<jit::VAddBiasTuple<T>, platform::CPUPlace>::Cache()
+                .At(n_)) {}
+
+  void Compute(const T *x, const T *y, T *z) const { vadd_(x, y, z, n_); }
+
+  void ComputeScalarY(const T *x, T y, T *z) const {
+    vadd_bias_(&y, x, z, n_);
+  }
+
+ private:
+  int n_;
+  typename jit::VAddTuple<T>::func_type vadd_;
+  typename jit::VAddBiasTuple<T>::func_type vadd_bias_;
+};
+
 template <typename DeviceContext, typename T>
 void default_elementwise_add(const framework::ExecutionContext &ctx,
                              const framework::Tensor *x,
@@ -86,6 +114,58 @@ struct IdentityGrad {
   HOSTDEVICE T operator()(T x, T y, T out, T dout) const { return dout; }
 };
 
+// dx = dout and dy = sum(dout) by the jit kernels in the CPU broadcast
+// engine.
+template <typename T>
+class BroadcastGradInnerKernel<
+    T, IdentityGrad<T>, IdentityGrad<T>,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+ public:
+  BroadcastGradInnerKernel(IdentityGrad<T> dx_op, IdentityGrad<T> dy_op,
+                           int64_t n)
+      : n_(BroadcastJitSize(n)),
+        vadd_(jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                  .At(n_)),
+        hsum_(jit::KernelFuncs<jit::HSumTuple<T>, platform::CPUPlace>::Cache()
+                  .At(n_)) {}
+
+  void Compute(const T *x, const T *y, const T *out, const T *dout, T *dx,
+               T *dy) const {
+    Copy(dout, dy);
+    Copy(dout, dx);
+  }
+
+  void ComputeAccumulate(const T *x, const T *y, const T *out, const T *dout,
+                         T *dx, T *dy) const {
+    if (dy != nullptr) {
+      vadd_(dy, dout, dy, n_);
+    }
+    Copy(dout, dx);
+  }
+
+  void ComputeScalarYAccumulate(const T *x, T y, const T *out, const T *dout,
+                                T *dx, T *dy) const {
+    if (dy != nullptr) {
+      T sum;
+      hsum_(dout, &sum, n_);
+      *dy += sum;
+    }
+    Copy(dout, dx);
+  }
+
+ private:
+  // dx shares the memory of dout when the grad op is inplace
+  void Copy(const T *dout, T *d) const {
+    if (d != nullptr && d != dout) {
+      std::memcpy(d, dout, n_ * sizeof(T));
+    }
+  }
+
+  int n_;
+  typename jit::VAddTuple<T>::func_type vadd_;
+  typename jit::HSumTuple<T>::func_type hsum_;
+};
+
 template <typename DeviceContext, typename T>
 void default_elementwise_add_grad(const framework::ExecutionContext &ctx,
                                   const framework::Tensor *x,
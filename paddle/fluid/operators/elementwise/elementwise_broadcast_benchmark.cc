@@ -0,0 +1,162 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Benchmark of the CPU elementwise ops over the typical broadcast shapes. The
+// forward ops are run by the broadcast engine and by TransformFunctor with
+// the broadcast iterators, the gradients are run by the broadcast engine.
+//
+//   ./elementwise_broadcast_benchmark --repeat=100
+
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/elementwise/elementwise_add_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_div_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_max_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_min_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_mul_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_sub_op.h"
+
+DEFINE_int32(repeat, 100, "The number of the runs of every case.");
+
+namespace paddle {
+namespace operators {
+
+struct BenchmarkCase {
+  std::string name;
+  std::vector<int64_t> x_dims;
+  std::vector<int64_t> y_dims;
+  int axis;
+};
+
+static std::vector<BenchmarkCase> BenchmarkCases() {
+  return {{"same dims", {64, 16384}, {64, 16384}, 0},
+          {"scalar", {64, 16384}, {1}, 1},
+          {"fc bias (row)", {256, 1024}, {1024}, 1},
+          {"conv bias (column)", {8, 64, 56, 56}, {64}, 1},
+          {"channel scale (column)", {8, 512, 7, 7}, {8, 512}, 0},
+          {"mid", {32, 128, 256}, {32, 1, 256}, 0}};
+}
+
+template <typename Callback>
+static double RunMs(Callback callback) {
+  callback();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) {
+    callback();
+  }
+  std::chrono::duration<double, std::milli> ms =
+      std::chrono::steady_clock::now() - start;
+  return ms.count() / FLAGS_repeat;
+}
+
+template <typename Functor>
+static void BenchmarkForward(const std::string &op, const BenchmarkCase &c,
+                             const framework::Tensor &x,
+                             const framework::Tensor &y, framework::Tensor *z) {
+  platform::CPUDeviceContext ctx;
+  auto x_dims = x.dims();
+  auto y_dims = trim_trailing_singular_dims(y.dims());
+  int axis = y_dims.size() == 0 ? x_dims.size() : c.axis;
+  double engine_ms = RunMs([&] {
+    BroadcastComputeCPU(x.data<float>(), y.data<float>(), z->data<float>(),
+                        x_dims, y_dims, axis, Functor());
+  });
+  double transform_ms = RunMs([&] {
+    TransformFunctor<Functor, float, platform::CPUDeviceContext> functor(
+        &x, &y, z, ctx, Functor());
+    if (x_dims == y_dims) {
+      functor.Run();
+      return;
+    }
+    int pre, n, post, mid_flag = 0;
+    get_mid_dims(x_dims, y_dims, axis, &pre, &n, &post, &mid_flag);
+    if (mid_flag) {
+      functor.RunMidRowWise(n, pre, post);
+    } else if (post == 1) {
+      functor.RunRowWise(n, pre);
+    } else {
+      functor.RunMidWise(n, pre, post);
+    }
+  });
+  LOG(INFO) << op << ", " << c.name << ", x: " << x_dims
+            << ", y: " << y.dims() << ", engine: " << engine_ms
+            << " ms, transform: " << transform_ms << " ms";
+}
+
+template <typename DX_OP, typename DY_OP>
+static void BenchmarkGrad(const std::string &op, const BenchmarkCase &c,
+                          const framework::Tensor &x,
+                          const framework::Tensor &y, framework::Tensor *dx,
+                          framework::Tensor *dy) {
+  auto x_dims = x.dims();
+  auto y_dims = trim_trailing_singular_dims(y.dims());
+  int axis = y_dims.size() == 0 ? x_dims.size() : c.axis;
+  double engine_ms = RunMs([&] {
+    BroadcastGradComputeCPU(x.data<float>(), y.data<float>(), x.data<float>(),
+                            x.data<float>(), x_dims, y_dims, axis, DX_OP(),
+                            DY_OP(), dx->data<float>(), dy->data<float>());
+  });
+  LOG(INFO) << op << ", " << c.name << ", x: " << x_dims
+            << ", y: " << y.dims() << ", engine: " << engine_ms << " ms";
+}
+
+static void Benchmark(const BenchmarkCase &c) {
+  platform::CPUPlace place;
+  framework::Tensor x, y, z, dy;
+  auto *x_data = x.mutable_data<float>(framework::make_ddim(c.x_dims), place);
+  auto *y_data = y.mutable_data<float>(framework::make_ddim(c.y_dims), place);
+  z.mutable_data<float>(x.dims(), place);
+  dy.mutable_data<float>(y.dims(), place);
+  for (int64_t i = 0; i < x.numel(); ++i) {
+    x_data[i] = static_cast<float>(i % 97) + 1.f;
+  }
+  for (int64_t i = 0; i < y.numel(); ++i) {
+    y_data[i] = static_cast<float>(i % 89) + 1.f;
+  }
+
+  BenchmarkForward<AddFunctor<float>>("elementwise_add", c, x, y, &z);
+  BenchmarkForward<SubFunctor<float>>("elementwise_sub", c, x, y, &z);
+  BenchmarkForward<MulFunctor<float>>("elementwise_mul", c, x, y, &z);
+  BenchmarkForward<DivFunctor<float>>("elementwise_div", c, x, y, &z);
+  BenchmarkForward<MaxFunctor<float>>("elementwise_max", c, x, y, &z);
+  BenchmarkForward<MinFunctor<float>>("elementwise_min", c, x, y, &z);
+
+  BenchmarkGrad<IdentityGrad<float>, IdentityGrad<float>>(
+      "elementwise_add_grad", c, x, y, &z, &dy);
+  BenchmarkGrad<SubGradDX<float>, SubGradDY<float>>("elementwise_sub_grad", c,
+                                                    x, y, &z, &dy);
+  BenchmarkGrad<MulGradDX<float>, MulGradDY<float>>("elementwise_mul_grad", c,
+                                                    x, y, &z, &dy);
+  BenchmarkGrad<DivGradDX<float>, DivGradDY<float>>("elementwise_div_grad", c,
+                                                    x, y, &z, &dy);
+  BenchmarkGrad<MaxGradDx<float>, MaxGradDy<float>>("elementwise_max_grad", c,
+                                                    x, y, &z, &dy);
+  BenchmarkGrad<MinGradDx<float>, MinGradDy<float>>("elementwise_min_grad", c,
+                                                    x, y, &z, &dy);
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char **argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  for (auto &c : paddle::operators::BenchmarkCases()) {
+    paddle::operators::Benchmark(c);
+  }
+  return 0;
+}
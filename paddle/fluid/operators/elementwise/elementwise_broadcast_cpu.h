@@ -0,0 +1,423 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/platform/enforce.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+
+/*
+ * The CPU broadcast engine of the elementwise ops, Out = X ⊙ Y where Y is
+ * broadcast to the shape of X.
+ *
+ * The dims of X are collapsed: the dims of size 1 are dropped, and the
+ * adjacent dims in which Y is broadcast (or not) are merged. E.g. X of
+ * (N, C, H, W) and Y of (C) with axis = 1 are collapsed to (N, C, H * W),
+ * Y is broadcast in the first and the last dim. The last collapsed dim is the
+ * inner dim and the others are the rows. A row is computed by a contiguous
+ * inner kernel with a slice of Y (Y is not broadcast in the inner dim), or
+ * with a scalar of Y (Y is broadcast in the inner dim), so that no index is
+ * computed per element. The rows are split among the OpenMP threads.
+ */
+struct BroadcastDims {
+  // the collapsed dims of X, the last one is the inner dim
+  std::vector<int64_t> sizes;
+  // the strides of Y in the collapsed dims, 0 if Y is broadcast in the dim
+  std::vector<int64_t> y_strides;
+  int64_t rows{1};
+  int64_t inner{1};
+  // Y is broadcast in the inner dim, a row uses a scalar of Y
+  bool inner_broadcast{false};
+  int64_t y_numel{1};
+
+  int64_t numel() const { return rows * inner; }
+};
+
+// y_dims are aligned with x_dims from axis, the dims of x_dims out of
+// [axis, axis + y_dims.size()) are broadcast in Y.
+inline BroadcastDims CollapseBroadcastDims(const framework::DDim &x_dims,
+                                           const framework::DDim &y_dims,
+                                           int axis) {
+  PADDLE_ENFORCE(axis >= 0 && axis + y_dims.size() <= x_dims.size(),
+                 "Broadcast dimension mismatch, x_dims: %s, y_dims: %s, "
+                 "axis: %d.",
+                 x_dims, y_dims, axis);
+  BroadcastDims dims;
+  std::vector<bool> broadcast;
+  for (int i = 0; i < x_dims.size(); ++i) {
+    int64_t x_size = x_dims[i];
+    int64_t y_size =
+        (i >= axis && i < axis + y_dims.size()) ? y_dims[i - axis] : 1;
+    PADDLE_ENFORCE(y_size == x_size || y_size == 1,
+                   "Broadcast dimension mismatch, x_dims: %s, y_dims: %s, "
+                   "axis: %d.",
+                   x_dims, y_dims, axis);
+    if (x_size == 1) {
+      continue;
+    }
+    bool is_broadcast = y_size != x_size;
+    if (!broadcast.empty() && broadcast.back() == is_broadcast) {
+      dims.sizes.back() *= x_size;
+    } else {
+      dims.sizes.push_back(x_size);
+      broadcast.push_back(is_broadcast);
+    }
+  }
+  if (dims.sizes.empty()) {
+    dims.sizes.push_back(1);
+    broadcast.push_back(false);
+  }
+
+  size_t rank = dims.sizes.size();
+  dims.y_strides.resize(rank);
+  int64_t stride = 1;
+  for (size_t i = rank; i > 0; --i) {
+    if (broadcast[i - 1]) {
+      dims.y_strides[i - 1] = 0;
+    } else {
+      dims.y_strides[i - 1] = stride;
+      stride *= dims.sizes[i - 1];
+    }
+  }
+  dims.y_numel = stride;
+  dims.inner = dims.sizes.back();
+  dims.inner_broadcast = broadcast.back();
+  for (size_t i = 0; i + 1 < rank; ++i) {
+    dims.rows *= dims.sizes[i];
+  }
+  return dims;
+}
+
+// The threads get at least kBroadcastMinChunkSize elements each.
+constexpr int64_t kBroadcastMinChunkSize = 1 << 14;
+
+// The number of the chunks of numel elements to be run in parallel.
+inline int GetBroadcastChunkNum(int64_t numel) {
+#ifdef PADDLE_WITH_MKLML
+  int64_t chunk_num = std::min<int64_t>(omp_get_max_threads(),
+                                        numel / kBroadcastMinChunkSize);
+  return static_cast<int>(std::max<int64_t>(chunk_num, 1));
+#else
+  return 1;
+#endif
+}
+
+// Returns the number of the chunks of the rows. If there are fewer rows than
+// the threads, the inner dim is split into blocks when it is divisible.
+inline int SplitBroadcastRows(BroadcastDims *dims) {
+  int chunk_num = GetBroadcastChunkNum(dims->numel());
+  if (dims->rows >= chunk_num) {
+    return chunk_num;
+  }
+  int64_t parts = (chunk_num + dims->rows - 1) / dims->rows;
+  int64_t max_block = dims->inner / parts;
+  for (int64_t block = max_block; block * 2 > max_block; --block) {
+    if (dims->inner % block != 0) {
+      continue;
+    }
+    int64_t y_stride = dims->inner_broadcast ? 0 : block;
+    dims->sizes.back() = block;
+    dims->sizes.insert(dims->sizes.end() - 1, dims->inner / block);
+    dims->y_strides.insert(dims->y_strides.end() - 1, y_stride);
+    dims->rows *= dims->inner / block;
+    dims->inner = block;
+    break;
+  }
+  return static_cast<int>(std::min<int64_t>(chunk_num, dims->rows));
+}
+
+// Iterates the offsets of Y of the rows of the collapsed dims.
+class BroadcastRowIterator {
+ public:
+  BroadcastRowIterator(const BroadcastDims &dims, int64_t row)
+      : sizes_(dims.sizes), strides_(dims.y_strides) {
+    index_.resize(sizes_.size() - 1);
+    for (size_t i = index_.size(); i > 0; --i) {
+      index_[i - 1] = row % sizes_[i - 1];
+      row /= sizes_[i - 1];
+      y_offset_ += index_[i - 1] * strides_[i - 1];
+    }
+  }
+
+  int64_t y_offset() const { return y_offset_; }
+
+  void Next() {
+    for (size_t i = index_.size(); i > 0; --i) {
+      y_offset_ += strides_[i - 1];
+      if (++index_[i - 1] < sizes_[i - 1]) {
+        return;
+      }
+      y_offset_ -= index_[i - 1] * strides_[i - 1];
+      index_[i - 1] = 0;
+    }
+  }
+
+ private:
+  const std::vector<int64_t> &sizes_;
+  const std::vector<int64_t> &strides_;
+  std::vector<int64_t> index_;
+  int64_t y_offset_{0};
+};
+
+// Call callback(chunk, begin, end) for the chunks of [0, n) in parallel.
+template <typename Callback>
+void ParallelForChunks(int64_t n, int chunk_num, Callback callback) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (chunk_num > 1)
+#endif
+  for (int chunk = 0; chunk < chunk_num; ++chunk) {
+    callback(chunk, n * chunk / chunk_num, n * (chunk + 1) / chunk_num);
+  }
+}
+
+// The size of the jit kernels run by the specialized inner kernels, which
+// take an int.
+inline int BroadcastJitSize(int64_t n) {
+  PADDLE_ENFORCE_LE(n, std::numeric_limits<int>::max(),
+                    "The inner size %d of the broadcast is too large for the "
+                    "jit kernels.",
+                    n);
+  return static_cast<int>(n);
+}
+
+/*
+ * The inner kernel of the forward computation of n elements. The ops
+ * specialize it for their functors to run the jit kernels, e.g. VAdd.
+ */
+template <typename Functor, typename T, typename OutType,
+          typename Enable = void>
+class BroadcastInnerKernel {
+ public:
+  BroadcastInnerKernel(Functor func, int64_t n) : func_(func), n_(n) {}
+
+  // z[i] = func(x[i], y[i])
+  void Compute(const T *x, const T *y, OutType *z) const {
+    for (int64_t i = 0; i < n_; ++i) {
+      z[i] = func_(x[i], y[i]);
+    }
+  }
+
+  // z[i] = func(x[i], y)
+  void ComputeScalarY(const T *x, T y, OutType *z) const {
+    for (int64_t i = 0; i < n_; ++i) {
+      z[i] = func_(x[i], y);
+    }
+  }
+
+ private:
+  Functor func_;
+  int64_t n_;
+};
+
+/*
+ * The inner kernel of the gradient computation of n elements, dx or dy is
+ * nullptr if it is not computed. dy is computed before dx, since dx may
+ * share the memory of dout, e.g. in elementwise_add_grad.
+ */
+template <typename T, typename DX_OP, typename DY_OP, typename Enable = void>
+class BroadcastGradInnerKernel {
+ public:
+  BroadcastGradInnerKernel(DX_OP dx_op, DY_OP dy_op, int64_t n)
+      : dx_op_(dx_op), dy_op_(dy_op), n_(n) {}
+
+  // dy[i] = dy_op(x[i], y[i], out[i], dout[i]), dx[i] = dx_op(...)
+  void Compute(const T *x, const T *y, const T *out, const T *dout, T *dx,
+               T *dy) const {
+    if (dy != nullptr) {
+      for (int64_t i = 0; i < n_; ++i) {
+        dy[i] = dy_op_(x[i], y[i], out[i], dout[i]);
+      }
+    }
+    ComputeDX(x, y, out, dout, dx);
+  }
+
+  // dy[i] += dy_op(x[i], y[i], out[i], dout[i]), dx[i] = dx_op(...)
+  void ComputeAccumulate(const T *x, const T *y, const T *out, const T *dout,
+                         T *dx, T *dy) const {
+    if (dy != nullptr) {
+      for (int64_t i = 0; i < n_; ++i) {
+        dy[i] += dy_op_(x[i], y[i], out[i], dout[i]);
+      }
+    }
+    ComputeDX(x, y, out, dout, dx);
+  }
+
+  // *dy += sum(dy_op(x[i], y, out[i], dout[i])), dx[i] = dx_op(...)
+  void ComputeScalarYAccumulate(const T *x, T y, const T *out, const T *dout,
+                                T *dx, T *dy) const {
+    if (dy != nullptr) {
+      T sum = 0;
+      for (int64_t i = 0; i < n_; ++i) {
+        sum += dy_op_(x[i], y, out[i], dout[i]);
+      }
+      *dy += sum;
+    }
+    if (dx != nullptr) {
+      for (int64_t i = 0; i < n_; ++i) {
+        dx[i] = dx_op_(x[i], y, out[i], dout[i]);
+      }
+    }
+  }
+
+ private:
+  void ComputeDX(const T *x, const T *y, const T *out, const T *dout,
+                 T *dx) const {
+    if (dx != nullptr) {
+      for (int64_t i = 0; i < n_; ++i) {
+        dx[i] = dx_op_(x[i], y[i], out[i], dout[i]);
+      }
+    }
+  }
+
+  DX_OP dx_op_;
+  DY_OP dy_op_;
+  int64_t n_;
+};
+
+// z = func(x, y) of numel elements of the same shape.
+template <typename Functor, typename T, typename OutType>
+void SameDimsComputeCPU(const T *x, const T *y, OutType *z, int64_t numel,
+                        Functor func) {
+  int chunk_num = GetBroadcastChunkNum(numel);
+  int64_t block = (numel + chunk_num - 1) / chunk_num;
+  int64_t tail = numel - block * (chunk_num - 1);
+  BroadcastInnerKernel<Functor, T, OutType> kernel(func, block);
+  BroadcastInnerKernel<Functor, T, OutType> tail_kernel(func, tail);
+  ParallelForChunks(chunk_num, chunk_num, [&](int chunk, int64_t, int64_t) {
+    int64_t offset = chunk * block;
+    auto &k = chunk + 1 == chunk_num ? tail_kernel : kernel;
+    k.Compute(x + offset, y + offset, z + offset);
+  });
+}
+
+// z = func(x, y), y_dims are aligned with x_dims from axis.
+template <typename Functor, typename T, typename OutType>
+void BroadcastComputeCPU(const T *x, const T *y, OutType *z,
+                         const framework::DDim &x_dims,
+                         const framework::DDim &y_dims, int axis,
+                         Functor func) {
+  BroadcastDims dims = CollapseBroadcastDims(x_dims, y_dims, axis);
+  if (dims.numel() == 0) {
+    return;
+  }
+  if (dims.y_numel == dims.numel()) {
+    SameDimsComputeCPU(x, y, z, dims.numel(), func);
+    return;
+  }
+  int chunk_num = SplitBroadcastRows(&dims);
+  BroadcastInnerKernel<Functor, T, OutType> kernel(func, dims.inner);
+  ParallelForChunks(
+      dims.rows, chunk_num, [&](int chunk, int64_t begin, int64_t end) {
+        BroadcastRowIterator iter(dims, begin);
+        for (int64_t row = begin; row < end; ++row, iter.Next()) {
+          int64_t offset = row * dims.inner;
+          if (dims.inner_broadcast) {
+            kernel.ComputeScalarY(x + offset, y[iter.y_offset()], z + offset);
+          } else {
+            kernel.Compute(x + offset, y + iter.y_offset(), z + offset);
+          }
+        }
+      });
+}
+
+// The gradients of numel elements of the same shape.
+template <typename T, typename DX_OP, typename DY_OP>
+void SameDimsGradComputeCPU(const T *x, const T *y, const T *out,
+                            const T *dout, int64_t numel, DX_OP dx_op,
+                            DY_OP dy_op, T *dx, T *dy) {
+  int chunk_num = GetBroadcastChunkNum(numel);
+  int64_t block = (numel + chunk_num - 1) / chunk_num;
+  int64_t tail = numel - block * (chunk_num - 1);
+  BroadcastGradInnerKernel<T, DX_OP, DY_OP> kernel(dx_op, dy_op, block);
+  BroadcastGradInnerKernel<T, DX_OP, DY_OP> tail_kernel(dx_op, dy_op, tail);
+  ParallelForChunks(chunk_num, chunk_num, [&](int chunk, int64_t, int64_t) {
+    int64_t offset = chunk * block;
+    auto &k = chunk + 1 == chunk_num ? tail_kernel : kernel;
+    k.Compute(x + offset, y + offset, out + offset, dout + offset,
+              dx == nullptr ? nullptr : dx + offset,
+              dy == nullptr ? nullptr : dy + offset);
+  });
+}
+
+// The gradients of z = func(x, y), dy is summed over the broadcast dims.
+template <typename T, typename DX_OP, typename DY_OP>
+void BroadcastGradComputeCPU(const T *x, const T *y, const T *out,
+                             const T *dout, const framework::DDim &x_dims,
+                             const framework::DDim &y_dims, int axis,
+                             DX_OP dx_op, DY_OP dy_op, T *dx, T *dy) {
+  BroadcastDims dims = CollapseBroadcastDims(x_dims, y_dims, axis);
+  if (dims.numel() == 0) {
+    if (dy != nullptr) {
+      std::fill(dy, dy + dims.y_numel, static_cast<T>(0));
+    }
+    return;
+  }
+  if (dims.y_numel == dims.numel()) {
+    SameDimsGradComputeCPU(x, y, out, dout, dims.numel(), dx_op, dy_op, dx,
+                           dy);
+    return;
+  }
+  int chunk_num = SplitBroadcastRows(&dims);
+  // Every chunk sums dy in its own buffer, the buffers take at most the
+  // memory of X.
+  std::vector<T> dy_buffers;
+  if (dy != nullptr) {
+    std::fill(dy, dy + dims.y_numel, static_cast<T>(0));
+    int64_t max_chunk_num = 1 + dims.numel() / dims.y_numel;
+    chunk_num = static_cast<int>(std::min<int64_t>(chunk_num, max_chunk_num));
+    dy_buffers.resize((chunk_num - 1) * dims.y_numel, static_cast<T>(0));
+  }
+  BroadcastGradInnerKernel<T, DX_OP, DY_OP> kernel(dx_op, dy_op, dims.inner);
+  ParallelForChunks(
+      dims.rows, chunk_num, [&](int chunk, int64_t begin, int64_t end) {
+        T *dy_sum = dy;
+        if (dy != nullptr && chunk > 0) {
+          dy_sum = dy_buffers.data() + (chunk - 1) * dims.y_numel;
+        }
+        BroadcastRowIterator iter(dims, begin);
+        for (int64_t row = begin; row < end; ++row, iter.Next()) {
+          int64_t offset = row * dims.inner;
+          int64_t y_offset = iter.y_offset();
+          T *dx_row = dx == nullptr ? nullptr : dx + offset;
+          T *dy_row = dy_sum == nullptr ? nullptr : dy_sum + y_offset;
+          if (dims.inner_broadcast) {
+            kernel.ComputeScalarYAccumulate(x + offset, y[y_offset],
+                                            out + offset, dout + offset,
+                                            dx_row, dy_row);
+          } else {
+            kernel.ComputeAccumulate(x + offset, y + y_offset, out + offset,
+                                     dout + offset, dx_row, dy_row);
+          }
+        }
+      });
+  for (int chunk = 1; chunk < chunk_num && dy != nullptr; ++chunk) {
+    const T *buffer = dy_buffers.data() + (chunk - 1) * dims.y_numel;
+    for (int64_t i = 0; i < dims.y_numel; ++i) {
+      dy[i] += buffer[i];
+    }
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
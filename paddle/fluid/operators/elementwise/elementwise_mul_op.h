@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 #include "paddle/fluid/operators/elementwise/elementwise_op.h"
 #include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
 
 namespace paddle {
@@ -25,6 +26,29 @@ struct MulFunctor {
   inline HOSTDEVICE T operator()(T a, T b) const { return a * b; }
 };
 
+// Run the jit kernels VMul and VScal in the CPU broadcast engine.
+template <typename T>
+class BroadcastInnerKernel<
+    MulFunctor<T>, T, T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+ public:
+  BroadcastInnerKernel(MulFunctor<T> func, int64_t n)
+      : n_(BroadcastJitSize(n)),
+        vmul_(jit::KernelFuncs<jit::VMulTuple<T>, platform::CPUPlace>::Cache()
+                  .At(n_)),
+        vscal_(jit::KernelFuncs<jit::VScalTuple<T>, platform::CPUPlace>::Cache()
+                   .At(n_)) {}
+
+  void Compute(const T* x, const T* y, T* z) const { vmul_(x, y, z, n_); }
+
+  void ComputeScalarY(const T* x, T y, T* z) const { vscal_(&y, x, z, n_); }
+
+ private:
+  int n_;
+  typename jit::VMulTuple<T>::func_type vmul_;
+  typename jit::VScalTuple<T>::func_type vscal_;
+};
+
 template <typename DeviceContext, typename T>
 void default_elementwise_mul(const framework::ExecutionContext& ctx,
                              const framework::Tensor* x,
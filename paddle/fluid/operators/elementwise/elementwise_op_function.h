@@ -17,10 +17,12 @@ limitations under the License. */
 #include <glog/logging.h>
 #include <algorithm>
 #include <iterator>
+#include <type_traits>
 #include <vector>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/operators/elementwise/elementwise_broadcast_cpu.h"
 #include "paddle/fluid/platform/transform.h"
 
 #ifdef __NVCC__
@@ -347,28 +349,6 @@ struct ElemwiseGradNoBroadcast {
   T *dy_;
 };
 
-template <typename T, typename DX_OP, typename DY_OP>
-static void ElemwiseGradBroadcast1CPU(const T *x, const T *y, const T *out,
-                                      const T *dout, int h, int w, DX_OP dx_op,
-                                      DY_OP dy_op, T *dx, T *dy) {
-  for (int i = 0; i < h; ++i) {
-    for (int j = 0; j < w; ++j) {
-      int x_offset = i * w + j;
-      if (dx != nullptr) {
-        dx[x_offset] = dx_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-      }
-      if (dy != nullptr) {
-        T tmp = dy_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-        if (i == 0) {
-          dy[j] = tmp;
-        } else {
-          dy[j] += tmp;
-        }
-      }
-    }
-  }
-}
-
 #ifdef __NVCC__
 template <typename T, typename DX_OP, typename DY_OP>
 static __global__ void ElemwiseGradBroadcast1CUDAKernel(
@@ -472,31 +452,6 @@ static void ElemwiseGradBroadcast1CUDA(cudaStream_t stream, const T *x,
 
 #endif
 
-template <typename T, typename DX_OP, typename DY_OP>
-static void ElemwiseGradBroadcast2CPU(const T *x, const T *y, const T *out,
-                                      const T *dout, int pre, int n, int post,
-                                      DX_OP dx_op, DY_OP dy_op, T *dx, T *dy) {
-  for (int i = 0; i < pre; ++i) {
-    for (int j = 0; j < n; ++j) {
-      for (int k = 0; k < post; ++k) {
-        int x_offset = i * n * post + j * post + k;
-        if (dx != nullptr) {
-          dx[x_offset] =
-              dx_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-        }
-        if (dy != nullptr) {
-          T tmp = dy_op(x[x_offset], y[j], out[x_offset], dout[x_offset]);
-          if (i == 0 && k == 0) {
-            dy[j] = tmp;
-          } else {
-            dy[j] += tmp;
-          }
-        }
-      }
-    }
-  }
-}
-
 #ifdef __NVCC__
 template <typename T, typename DX_OP, typename DY_OP>
 static __global__ void ElemwiseGradBroadcast2CUDAKernel(
@@ -549,34 +504,6 @@ static void ElemwiseGradBroadcast2CUDA(cudaStream_t stream, const T *x,
 
 #endif
 
-template <typename T, typename DX_OP, typename DY_OP>
-static void ElemwiseGradBroadcastMid2CPU(const T *x, const T *y, const T *out,
-                                         const T *dout, int pre, int n,
-                                         int post, DX_OP dx_op, DY_OP dy_op,
-                                         T *dx, T *dy) {
-  for (int i = 0; i < pre; ++i) {
-    for (int j = 0; j < n; ++j) {
-      for (int k = 0; k < post; ++k) {
-        int x_offset = i * n * post + j * post + k;
-        int y_offset = i * post + k;
-        if (dx != nullptr) {
-          dx[x_offset] =
-              dx_op(x[x_offset], y[y_offset], out[x_offset], dout[x_offset]);
-        }
-        if (dy != nullptr) {
-          T tmp =
-              dy_op(x[x_offset], y[y_offset], out[x_offset], dout[x_offset]);
-          if (j == 0) {
-            dy[y_offset] = tmp;
-          } else {
-            dy[y_offset] += tmp;
-          }
-        }
-      }
-    }
-  }
-}
-
 #ifdef __NVCC__
 template <typename T, typename DX_OP, typename DY_OP>
 static __global__ void ElemwiseGradBroadcastMid2CUDAKernel(
@@ -632,7 +559,25 @@ static void ElemwiseGradBroadcastMid2CUDA(cudaStream_t stream, const T *x,
 #endif
 
 template <typename DeviceContext, typename T, typename DX_OP, typename DY_OP>
-void ElemwiseGradComputeNoBroadcast(
+typename std::enable_if<
+    std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type
+ElemwiseGradComputeNoBroadcast(
+    const framework::ExecutionContext &ctx, const framework::DDim &x_dim,
+    const framework::DDim &y_dim, const framework::Tensor &x,
+    const framework::Tensor &y, const framework::Tensor &out,
+    const framework::Tensor &dout, int axis, framework::Tensor *dx,
+    framework::Tensor *dy, DX_OP dx_op, DY_OP dy_op) {
+  SameDimsGradComputeCPU(
+      x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(),
+      framework::product(x_dim), dx_op, dy_op,
+      dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+      dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
+}
+
+template <typename DeviceContext, typename T, typename DX_OP, typename DY_OP>
+typename std::enable_if<
+    !std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type
+ElemwiseGradComputeNoBroadcast(
     const framework::ExecutionContext &ctx, const framework::DDim &x_dim,
     const framework::DDim &y_dim, const framework::Tensor &x,
     const framework::Tensor &y, const framework::Tensor &out,
@@ -653,7 +598,29 @@ void ElemwiseGradComputeNoBroadcast(
 }
 
 template <typename DeviceContext, typename T, typename DX_OP, typename DY_OP>
-void ElemwiseGradComputeWithBroadcast(
+typename std::enable_if<
+    std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type
+ElemwiseGradComputeWithBroadcast(
+    const framework::ExecutionContext &ctx, const framework::DDim &x_dim,
+    const framework::DDim &y_dim_untrimed, const framework::Tensor &x,
+    const framework::Tensor &y, const framework::Tensor &out,
+    const framework::Tensor &dout, int axis, framework::Tensor *dx,
+    framework::Tensor *dy, DX_OP dx_op, DY_OP dy_op) {
+  axis = (axis == -1 ? x_dim.size() - y_dim_untrimed.size() : axis);
+  auto y_dim = trim_trailing_singular_dims(y_dim_untrimed);
+  axis = (y_dim.size() == 0) ? x_dim.size() : axis;
+
+  BroadcastGradComputeCPU(
+      x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), x_dim, y_dim,
+      axis, dx_op, dy_op,
+      dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+      dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
+}
+
+template <typename DeviceContext, typename T, typename DX_OP, typename DY_OP>
+typename std::enable_if<
+    !std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type
+ElemwiseGradComputeWithBroadcast(
     const framework::ExecutionContext &ctx, const framework::DDim &x_dim,
     const framework::DDim &y_dim_untrimed, const framework::Tensor &x,
     const framework::Tensor &y, const framework::Tensor &out,
@@ -665,56 +632,28 @@ void ElemwiseGradComputeWithBroadcast(
 
   int pre, n, post, mid_flag = 0;
   get_mid_dims(x_dim, y_dim, axis, &pre, &n, &post, &mid_flag);
+#ifdef __NVCC__
   if (mid_flag) {
     PADDLE_ENFORCE_EQ(mid_flag, 1, "mid_flag should be no more than 1.");
-    if (platform::is_gpu_place(ctx.GetPlace())) {
-#ifdef __NVCC__
-      ElemwiseGradBroadcastMid2CUDA(
-          ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
-          y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post, dx_op,
-          dy_op, dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-#endif
-    } else {
-      ElemwiseGradBroadcastMid2CPU(
-          x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post,
-          dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-    }
+    ElemwiseGradBroadcastMid2CUDA(
+        ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
+        y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post, dx_op, dy_op,
+        dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+        dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
   } else if (post == 1) {
-    if (platform::is_gpu_place(ctx.GetPlace())) {
-#ifdef __NVCC__
-      ElemwiseGradBroadcast1CUDA(
-          ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
-          y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-#endif
-    } else {
-      ElemwiseGradBroadcast1CPU(
-          x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), pre, n,
-          dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-    }
+    ElemwiseGradBroadcast1CUDA(
+        ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
+        y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, dx_op, dy_op,
+        dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+        dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
   } else {
-    if (platform::is_gpu_place(ctx.GetPlace())) {
-#ifdef __NVCC__
-      ElemwiseGradBroadcast2CUDA(
-          ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
-          y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post, dx_op,
-          dy_op, dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-#endif
-    } else {
-      ElemwiseGradBroadcast2CPU(
-          x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post,
-          dx_op, dy_op,
-          dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
-          dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
-    }
+    ElemwiseGradBroadcast2CUDA(
+        ctx.template device_context<DeviceContext>().stream(), x.data<T>(),
+        y.data<T>(), out.data<T>(), dout.data<T>(), pre, n, post, dx_op, dy_op,
+        dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+        dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
   }
+#endif
 }
 
 template <typename DeviceContext, typename T, typename DX_OP, typename DY_OP>
@@ -813,30 +752,36 @@ void ElementwiseGradCompute(const framework::ExecutionContext &ctx,
 }
 
 template <typename Functor, typename DeviceContext, typename T,
-          typename OutType = T>
+          typename OutType>
+typename std::enable_if<
+    std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type
+ElementwiseComputeWithBroadcast(const framework::ExecutionContext &ctx,
+                                const framework::Tensor *x,
+                                const framework::Tensor *y,
+                                const framework::DDim &y_dims, int axis,
+                                Functor func, framework::Tensor *z) {
+  BroadcastComputeCPU(x->data<T>(), y->data<T>(),
+                      z->mutable_data<OutType>(ctx.GetPlace()), x->dims(),
+                      y_dims, axis, func);
+}
 
-void ElementwiseComputeEx(const framework::ExecutionContext &ctx,
-                          const framework::Tensor *x,
-                          const framework::Tensor *y, int axis, Functor func,
-                          framework::Tensor *z) {
+template <typename Functor, typename DeviceContext, typename T,
+          typename OutType>
+typename std::enable_if<
+    !std::is_same<DeviceContext, platform::CPUDeviceContext>::value>::type
+ElementwiseComputeWithBroadcast(const framework::ExecutionContext &ctx,
+                                const framework::Tensor *x,
+                                const framework::Tensor *y,
+                                const framework::DDim &y_dims, int axis,
+                                Functor func, framework::Tensor *z) {
   TransformFunctor<Functor, T, DeviceContext, OutType> functor(
       x, y, z, ctx.template device_context<DeviceContext>(), func);
-  auto x_dims = x->dims();
-  auto y_dims_untrimed = y->dims();
-  PADDLE_ENFORCE_GE(x_dims.size(), y_dims_untrimed.size(),
-                    "Rank of first input must >= rank of second input.");
-  if (x_dims == y_dims_untrimed) {
+  if (x->dims() == y_dims) {
     functor.Run();
     return;
   }
-
-  axis = (axis == -1 ? x_dims.size() - y_dims_untrimed.size() : axis);
-  PADDLE_ENFORCE(axis >= 0 && axis < x_dims.size(),
-                 "Axis should be in range [0, x_dims)");
-  auto y_dims = trim_trailing_singular_dims(y_dims_untrimed);
-  axis = (y_dims.size() == 0) ? x_dims.size() : axis;
   int pre, n, post, mid_flag = 0;
-  get_mid_dims(x_dims, y_dims, axis, &pre, &n, &post, &mid_flag);
+  get_mid_dims(x->dims(), y_dims, axis, &pre, &n, &post, &mid_flag);
   if (mid_flag) {
     functor.RunMidRowWise(n, pre, post);
     return;
@@ -850,6 +795,31 @@ void ElementwiseComputeEx(const framework::ExecutionContext &ctx,
   }
 }
 
+template <typename Functor, typename DeviceContext, typename T,
+          typename OutType = T>
+void ElementwiseComputeEx(const framework::ExecutionContext &ctx,
+                          const framework::Tensor *x,
+                          const framework::Tensor *y, int axis, Functor func,
+                          framework::Tensor *z) {
+  auto x_dims = x->dims();
+  auto y_dims_untrimed = y->dims();
+  PADDLE_ENFORCE_GE(x_dims.size(), y_dims_untrimed.size(),
+                    "Rank of first input must >= rank of second input.");
+  if (x_dims == y_dims_untrimed) {
+    ElementwiseComputeWithBroadcast<Functor, DeviceContext, T, OutType>(
+        ctx, x, y, x_dims, 0, func, z);
+    return;
+  }
+
+  axis = (axis == -1 ? x_dims.size() - y_dims_untrimed.size() : axis);
+  PADDLE_ENFORCE(axis >= 0 && axis < x_dims.size(),
+                 "Axis should be in range [0, x_dims)");
+  auto y_dims = trim_trailing_singular_dims(y_dims_untrimed);
+  axis = (y_dims.size() == 0) ? x_dims.size() : axis;
+  ElementwiseComputeWithBroadcast<Functor, DeviceContext, T, OutType>(
+      ctx, x, y, y_dims, axis, func, z);
+}
+
 // FusedElemwiseAndAct
 // --- forward
 template <typename T, typename CompoundFunctor, bool KeepIntermediateOut>
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 #include "paddle/fluid/operators/elementwise/elementwise_op.h"
 #include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 
 namespace paddle {
 namespace operators {
@@ -24,6 +25,34 @@ struct SubFunctor {
   inline HOSTDEVICE T operator()(T a, T b) const { return a - b; }
 };
 
+// Run the jit kernels VSub and VAddBias in the CPU broadcast engine.
+template <typename T>
+class BroadcastInnerKernel<
+    SubFunctor<T>, T, T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+ public:
+  BroadcastInnerKernel(SubFunctor<T> func, int64_t n)
+      : n_(BroadcastJitSize(n)),
+        vsub_(jit::KernelFuncs<jit::VSubTuple<T>, platform::CPUPlace>::Cache()
+                  .At(n_)),
+        vadd_bias_(
+            jit::KernelFuncs<jit::VAddBiasTuple<T>, platform::CPUPlace>::Cache()
+                .At(n_)) {}
+
+  void Compute(const T* x, const T* y, T* z) const { vsub_(x, y, z, n_); }
+
+  // x - y is exactly x + (-y)
+  void ComputeScalarY(const T* x, T y, T* z) const {
+    T neg_y = -y;
+    vadd_bias_(&neg_y, x, z, n_);
+  }
+
+ private:
+  int n_;
+  typename jit::VSubTuple<T>::func_type vsub_;
+  typename jit::VAddBiasTuple<T>::func_type vadd_bias_;
+};
+
 template <typename DeviceContext, typename T>
 class ElementwiseSubKernel : public framework::OpKernel<T> {
  public:
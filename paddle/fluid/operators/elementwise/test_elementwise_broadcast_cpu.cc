@@ -0,0 +1,195 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/elementwise/elementwise_add_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_broadcast_cpu.h"
+#include "paddle/fluid/operators/elementwise/elementwise_div_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_max_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_mul_op.h"
+#include "paddle/fluid/operators/elementwise/elementwise_sub_op.h"
+
+namespace paddle {
+namespace operators {
+
+struct BroadcastCase {
+  std::vector<int64_t> x_dims;
+  std::vector<int64_t> y_dims;
+  int axis;
+};
+
+static std::vector<BroadcastCase> BroadcastCases() {
+  return {{{2, 3, 4, 5}, {3, 4}, 1},       {{2, 3, 4, 5}, {4, 5}, 2},
+          {{2, 3, 4, 5}, {2, 1, 4, 5}, 0}, {{2, 3, 4, 5}, {1}, 3},
+          {{2, 3, 4, 5}, {2, 1, 4, 1}, 0}, {{6, 1, 7}, {6, 1, 7}, 0},
+          {{4, 1, 3}, {1, 1, 3}, 0},       {{3, 4, 5}, {3, 1, 1}, 0},
+          {{64, 4096}, {4096}, 1},         {{2, 65536}, {2, 1}, 0},
+          {{3, 100003}, {100003}, 1},      {{0, 5}, {5}, 1}};
+}
+
+// The offset of Y of every element of X.
+static std::vector<int64_t> ReferenceYOffsets(const BroadcastCase &c) {
+  int64_t numel = framework::product(framework::make_ddim(c.x_dims));
+  std::vector<int64_t> offsets(numel);
+  int rank = c.x_dims.size();
+  for (int64_t k = 0; k < numel; ++k) {
+    int64_t rest = k;
+    int64_t offset = 0;
+    int64_t stride = 1;
+    for (int i = rank - 1; i >= 0; --i) {
+      int64_t index = rest % c.x_dims[i];
+      rest /= c.x_dims[i];
+      int y_i = i - c.axis;
+      if (y_i >= 0 && y_i < static_cast<int>(c.y_dims.size())) {
+        if (c.y_dims[y_i] != 1) {
+          offset += index * stride;
+        }
+        stride *= c.y_dims[y_i];
+      }
+    }
+    offsets[k] = offset;
+  }
+  return offsets;
+}
+
+template <typename T>
+static std::vector<T> RandomVector(int64_t n, std::mt19937 *engine) {
+  std::uniform_real_distribution<double> dist(0.5, 2.0);
+  std::vector<T> v(n);
+  for (auto &e : v) {
+    e = static_cast<T>(dist(*engine));
+  }
+  return v;
+}
+
+template <typename T, typename Functor>
+static void TestBroadcast(Functor func) {
+  std::mt19937 engine(0);
+  for (auto &c : BroadcastCases()) {
+    auto x_dims = framework::make_ddim(c.x_dims);
+    auto y_dims = framework::make_ddim(c.y_dims);
+    auto x = RandomVector<T>(framework::product(x_dims), &engine);
+    auto y = RandomVector<T>(framework::product(y_dims), &engine);
+    std::vector<T> z(x.size());
+    BroadcastComputeCPU(x.data(), y.data(), z.data(), x_dims, y_dims, c.axis,
+                        func);
+    auto offsets = ReferenceYOffsets(c);
+    for (size_t k = 0; k < x.size(); ++k) {
+      ASSERT_EQ(z[k], func(x[k], y[offsets[k]])) << "x_dims: " << x_dims
+                                                 << ", y_dims: " << y_dims;
+    }
+    // inplace
+    BroadcastComputeCPU(x.data(), y.data(), x.data(), x_dims, y_dims, c.axis,
+                        func);
+    ASSERT_EQ(x, z);
+  }
+}
+
+TEST(ElementwiseBroadcastCPU, collapse_dims) {
+  auto dims = CollapseBroadcastDims(framework::make_ddim({2, 3, 4, 5}),
+                                    framework::make_ddim({3, 4}), 1);
+  ASSERT_EQ(dims.sizes, std::vector<int64_t>({2, 12, 5}));
+  ASSERT_EQ(dims.y_strides, std::vector<int64_t>({0, 1, 0}));
+  ASSERT_EQ(dims.rows, 24);
+  ASSERT_EQ(dims.inner, 5);
+  ASSERT_TRUE(dims.inner_broadcast);
+  ASSERT_EQ(dims.y_numel, 12);
+
+  dims = CollapseBroadcastDims(framework::make_ddim({8, 1, 16}),
+                               framework::make_ddim({1, 1, 16}), 0);
+  ASSERT_EQ(dims.sizes, std::vector<int64_t>({8, 16}));
+  ASSERT_EQ(dims.y_strides, std::vector<int64_t>({0, 1}));
+  ASSERT_FALSE(dims.inner_broadcast);
+
+  ASSERT_THROW(CollapseBroadcastDims(framework::make_ddim({2, 3}),
+                                     framework::make_ddim({2}), 1),
+               platform::EnforceNotMet);
+  ASSERT_THROW(CollapseBroadcastDims(framework::make_ddim({2, 3}),
+                                     framework::make_ddim({3, 1}), 1),
+               platform::EnforceNotMet);
+}
+
+TEST(ElementwiseBroadcastCPU, forward) {
+  TestBroadcast<float>(AddFunctor<float>());
+  TestBroadcast<float>(SubFunctor<float>());
+  TestBroadcast<float>(MulFunctor<float>());
+  TestBroadcast<float>(DivFunctor<float>());
+  TestBroadcast<float>(MaxFunctor<float>());
+  TestBroadcast<double>(AddFunctor<double>());
+  TestBroadcast<int64_t>(AddFunctor<int64_t>());
+  TestBroadcast<int>(MulFunctor<int>());
+}
+
+template <typename T, typename DX_OP, typename DY_OP>
+static void TestBroadcastGrad(DX_OP dx_op, DY_OP dy_op, bool inplace) {
+  std::mt19937 engine(0);
+  for (auto &c : BroadcastCases()) {
+    auto x_dims = framework::make_ddim(c.x_dims);
+    auto y_dims = framework::make_ddim(c.y_dims);
+    auto x = RandomVector<T>(framework::product(x_dims), &engine);
+    auto y = RandomVector<T>(framework::product(y_dims), &engine);
+    auto dout = RandomVector<T>(x.size(), &engine);
+    auto offsets = ReferenceYOffsets(c);
+    std::vector<T> dx_ref(x.size());
+    std::vector<double> dy_ref(y.size(), 0.);
+    for (size_t k = 0; k < x.size(); ++k) {
+      T y_k = y[offsets[k]];
+      dx_ref[k] = dx_op(x[k], y_k, x[k], dout[k]);
+      dy_ref[offsets[k]] += dy_op(x[k], y_k, x[k], dout[k]);
+    }
+
+    std::vector<T> dx(x.size());
+    std::vector<T> dy(y.size(), static_cast<T>(-1));
+    T *dx_data = inplace ? dout.data() : dx.data();
+    BroadcastGradComputeCPU(x.data(), y.data(), x.data(), dout.data(), x_dims,
+                            y_dims, c.axis, dx_op, dy_op, dx_data, dy.data());
+    for (size_t k = 0; k < x.size(); ++k) {
+      ASSERT_EQ(dx_data[k], dx_ref[k]);
+    }
+    for (size_t j = 0; j < y.size(); ++j) {
+      ASSERT_NEAR(dy[j], dy_ref[j], 1e-5 * std::abs(dy_ref[j]))
+          << "x_dims: " << x_dims << ", y_dims: " << y_dims;
+    }
+
+    // only dy
+    std::fill(dy.begin(), dy.end(), static_cast<T>(-1));
+    BroadcastGradComputeCPU(x.data(), y.data(), x.data(), dout.data(),
+                            x_dims, y_dims, c.axis, dx_op, dy_op,
+                            static_cast<T *>(nullptr), dy.data());
+    for (size_t j = 0; j < y.size(); ++j) {
+      ASSERT_NEAR(dy[j], dy_ref[j], 1e-5 * std::abs(dy_ref[j]));
+    }
+  }
+}
+
+TEST(ElementwiseBroadcastCPU, grad) {
+  TestBroadcastGrad<float>(IdentityGrad<float>(), IdentityGrad<float>(),
+                           false);
+  TestBroadcastGrad<float>(IdentityGrad<float>(), IdentityGrad<float>(), true);
+  TestBroadcastGrad<float>(SubGradDX<float>(), SubGradDY<float>(), true);
+  TestBroadcastGrad<float>(MulGradDX<float>(), MulGradDY<float>(), false);
+  TestBroadcastGrad<double>(MaxGradDx<double>(), MaxGradDy<double>(), false);
+}
+
+TEST(ElementwiseBroadcastCPU, jit_size) {
+  EXPECT_EQ(BroadcastJitSize(1000), 1000);
+  // the jit kernels take an int
+  EXPECT_THROW(BroadcastJitSize(1LL << 31), platform::EnforceNotMet);
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,240 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/fused/multihead_matmul_op.h"
+#include <cstring>
+#include <string>
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
+
+namespace paddle {
+namespace operators {
+
+void MultiHeadMatMulOp::InferShape(framework::InferShapeContext* ctx) const {
+  for (auto& name : {"Q", "K", "V", "BiasQ", "BiasK", "BiasV", "BiasQK"}) {
+    PADDLE_ENFORCE(ctx->HasInput(name),
+                   "Input(%s) of MultiHeadMatMulOp should not be null.", name);
+  }
+  PADDLE_ENFORCE(ctx->HasOutput("Out"),
+                 "Output(Out) of MultiHeadMatMulOp should not be null.");
+
+  auto q_dims = ctx->GetInputDim("Q");
+  PADDLE_ENFORCE_EQ(q_dims.size(), 3,
+                    "Input(Q) should be [batch_size, seq_len, hidden].");
+  PADDLE_ENFORCE_EQ(ctx->GetInputDim("K"), q_dims,
+                    "Input(K) should have the same dims as Input(Q).");
+  PADDLE_ENFORCE_EQ(ctx->GetInputDim("V"), q_dims,
+                    "Input(V) should have the same dims as Input(Q).");
+  int64_t hidden = q_dims[2];
+  for (auto& name : {"BiasQ", "BiasK", "BiasV"}) {
+    auto bias_dims = ctx->GetInputDim(name);
+    PADDLE_ENFORCE_EQ(bias_dims.size(), 1, "Input(%s) should be a vector.",
+                      name);
+    if (hidden > 0 && bias_dims[0] > 0) {
+      PADDLE_ENFORCE_EQ(bias_dims[0], hidden,
+                        "The size of Input(%s) should be the hidden size.",
+                        name);
+    }
+  }
+  int head_number = ctx->Attrs().Get<int>("head_number");
+  PADDLE_ENFORCE_GT(head_number, 0, "Attr(head_number) should be positive.");
+  if (hidden > 0) {
+    PADDLE_ENFORCE_EQ(hidden % head_number, 0,
+                      "The hidden size should be divisible by head_number.");
+  }
+  PADDLE_ENFORCE_EQ(ctx->GetInputDim("BiasQK").size(), 4,
+                    "Input(BiasQK) should be [batch_size, head_number, "
+                    "seq_len, seq_len] or broadcastable to it.");
+
+  ctx->SetOutputDim("Out", q_dims);
+  ctx->ShareLoD("Q", "Out");
+}
+
+framework::OpKernelType MultiHeadMatMulOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(framework::GetDataTypeOfVar(ctx.InputVar("Q")),
+                                 ctx.GetPlace());
+}
+
+void MultiHeadMatMulOpMaker::Make() {
+  AddInput("Q", "(Tensor) The queries of shape [batch_size, seq_len, hidden].");
+  AddInput("K", "(Tensor) The keys, with the same shape as Q.");
+  AddInput("V", "(Tensor) The values, with the same shape as Q.");
+  AddInput("BiasQ", "(Tensor) The bias of Q, of shape [hidden].");
+  AddInput("BiasK", "(Tensor) The bias of K, of shape [hidden].");
+  AddInput("BiasV", "(Tensor) The bias of V, of shape [hidden].");
+  AddInput("BiasQK",
+           "(Tensor) The attention bias of shape [batch_size, head_number, "
+           "seq_len, seq_len], any of the first three dimensions may be 1 "
+           "to be broadcast.");
+  AddOutput("Out", "(Tensor) The merged heads, with the same shape as Q.");
+  AddAttr<float>("alpha", "The scale of Q * K^T.").SetDefault(1.f);
+  AddAttr<int>("head_number", "The number of the attention heads.")
+      .SetDefault(1);
+  AddComment(R"DOC(
+    Fused multi-head attention operator for inference.
+
+    Q, K and V are split into head_number heads of hidden / head_number
+    columns, and for every head
+
+        Out = softmax(alpha * (Q + BiasQ) * (K + BiasK)^T + BiasQK)
+              * (V + BiasV)
+
+    The heads are merged back to the shape of Q.
+)DOC");
+}
+
+template <typename T>
+class MultiHeadMatMulKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto* q = ctx.Input<Tensor>("Q");
+    auto* k = ctx.Input<Tensor>("K");
+    auto* v = ctx.Input<Tensor>("V");
+    auto* bias_qk = ctx.Input<Tensor>("BiasQK");
+    auto* out = ctx.Output<Tensor>("Out");
+    auto place = ctx.GetPlace();
+    T alpha = static_cast<T>(ctx.Attr<float>("alpha"));
+    int head_number = ctx.Attr<int>("head_number");
+
+    auto q_dims = q->dims();
+    int batch_size = q_dims[0];
+    int seq_len = q_dims[1];
+    int hidden = q_dims[2];
+    int head_size = hidden / head_number;
+
+    // The broadcast BiasQK rows, a dimension of size 1 is not advanced.
+    auto bias_dims = bias_qk->dims();
+    PADDLE_ENFORCE_EQ(bias_dims[3], seq_len,
+                      "The last dimension of BiasQK should be seq_len.");
+    int bias_dims_full[3] = {batch_size, head_number, seq_len};
+    for (int i = 0; i < 3; ++i) {
+      PADDLE_ENFORCE(bias_dims[i] == 1 || bias_dims[i] == bias_dims_full[i],
+                     "The dimension %d of BiasQK cannot be broadcast.", i);
+    }
+
+    // Q, K and V with the bias are laid out head by head as
+    // [batch_size, head_number, seq_len, head_size], so that every head is a
+    // contiguous matrix for the batched GEMMs.
+    Tensor qkv;
+    T* q_data = qkv.mutable_data<T>(
+        framework::make_ddim({3, batch_size, head_number, seq_len, head_size}),
+        place);
+    T* k_data = q_data + q->numel();
+    T* v_data = k_data + q->numel();
+    SplitHeads(*q, *ctx.Input<Tensor>("BiasQ"), head_number, q_data);
+    SplitHeads(*k, *ctx.Input<Tensor>("BiasK"), head_number, k_data);
+    SplitHeads(*v, *ctx.Input<Tensor>("BiasV"), head_number, v_data);
+
+    // The batches are processed one by one, so the scores of a batch stay in
+    // the cache between the two GEMMs.
+    Tensor scores, context;
+    T* scores_data = scores.mutable_data<T>(
+        framework::make_ddim({head_number, seq_len, seq_len}), place);
+    T* context_data = context.mutable_data<T>(
+        framework::make_ddim({head_number, seq_len, head_size}), place);
+    const T* bias_data = bias_qk->data<T>();
+    T* out_data = out->mutable_data<T>(place);
+
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(ctx);
+    auto vadd = jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                    .At(seq_len);
+    auto softmax =
+        jit::KernelFuncs<jit::SoftmaxTuple<T>, platform::CPUPlace>::Cache().At(
+            seq_len);
+    int64_t head_stride = static_cast<int64_t>(seq_len) * head_size;
+    int rows = head_number * seq_len;
+    for (int b = 0; b < batch_size; ++b) {
+      int64_t batch_offset =
+          static_cast<int64_t>(b) * head_number * head_stride;
+      blas.BatchedGEMM(CblasNoTrans, CblasTrans, seq_len, seq_len, head_size,
+                       alpha, q_data + batch_offset, k_data + batch_offset,
+                       static_cast<T>(0), scores_data, head_number, head_stride,
+                       head_stride);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+      for (int r = 0; r < rows; ++r) {
+        int h = r / seq_len;
+        int s = r % seq_len;
+        int64_t bias_row =
+            ((bias_dims[0] == 1 ? 0 : b) * bias_dims[1] +
+             (bias_dims[1] == 1 ? 0 : h)) *
+                bias_dims[2] +
+            (bias_dims[2] == 1 ? 0 : s);
+        T* row = scores_data + static_cast<int64_t>(r) * seq_len;
+        vadd(bias_data + bias_row * seq_len, row, row, seq_len);
+        softmax(row, row, seq_len, 1, 1);
+      }
+      blas.BatchedGEMM(CblasNoTrans, CblasNoTrans, seq_len, head_size, seq_len,
+                       static_cast<T>(1), scores_data, v_data + batch_offset,
+                       static_cast<T>(0), context_data, head_number,
+                       static_cast<int64_t>(seq_len) * seq_len, head_stride);
+      // merge the heads: [head_number, seq_len, head_size] to
+      // [seq_len, hidden]
+      T* out_batch = out_data + static_cast<int64_t>(b) * seq_len * hidden;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+      for (int s = 0; s < seq_len; ++s) {
+        for (int h = 0; h < head_number; ++h) {
+          std::memcpy(out_batch + static_cast<int64_t>(s) * hidden +
+                          h * head_size,
+                      context_data + h * head_stride +
+                          static_cast<int64_t>(s) * head_size,
+                      head_size * sizeof(T));
+        }
+      }
+    }
+  }
+
+ private:
+  // dst[b][h][s] = src[b][s][h] + bias[h] for every head h.
+  static void SplitHeads(const Tensor& src, const Tensor& bias,
+                         int head_number, T* dst) {
+    auto dims = src.dims();
+    int seq_len = dims[1];
+    int hidden = dims[2];
+    int head_size = hidden / head_number;
+    int rows = dims[0] * seq_len;
+    const T* src_data = src.data<T>();
+    const T* bias_data = bias.data<T>();
+    auto vadd = jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                    .At(head_size);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int r = 0; r < rows; ++r) {
+      int b = r / seq_len;
+      int s = r % seq_len;
+      for (int h = 0; h < head_number; ++h) {
+        vadd(src_data + static_cast<int64_t>(r) * hidden + h * head_size,
+             bias_data + h * head_size,
+             dst + ((static_cast<int64_t>(b) * head_number + h) * seq_len + s) *
+                       head_size,
+             head_size);
+      }
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(multihead_matmul, ops::MultiHeadMatMulOp,
+                  ops::MultiHeadMatMulOpMaker);
+
+REGISTER_OP_CPU_KERNEL(multihead_matmul, ops::MultiHeadMatMulKernel<float>,
+                       ops::MultiHeadMatMulKernel<double>);
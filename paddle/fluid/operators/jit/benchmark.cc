@@ -375,6 +375,35 @@ void BenchKernelMatMul() {
   }
 }
 
+// The output rows of the 3x3 convolutions of ResNet and the 1x1 ones of
+// ResNet and MobileNet: {input channels, filter size, stride, output width}.
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelConvNCHW16C() {
+  using T = typename KernelTuple::data_type;
+  constexpr int block = ZMM_FLOAT_BLOCK;
+  const std::vector<std::vector<int>> shapes = {
+      {64, 3, 1, 56},  {128, 3, 1, 28}, {256, 3, 1, 14}, {512, 3, 1, 7},
+      {128, 3, 2, 28}, {256, 1, 2, 14}, {64, 1, 1, 112}, {256, 1, 1, 28},
+      {512, 1, 1, 14}, {1024, 1, 1, 7}};
+  for (auto& shape : shapes) {
+    const int ic_blocks = shape[0] / block, k = shape[1], stride = shape[2],
+              ow = shape[3];
+    const int ih = ow * stride + k, iw = (ow - 1) * stride + k;
+    Tensor x, w, y;
+    x.Resize({ic_blocks * ih * iw * block});
+    w.Resize({ic_blocks * k * k * block * block});
+    y.Resize({ow * block});
+    RandomVec<T>(x.numel(), x.mutable_data<T>(PlaceType()), -2.f, 2.f);
+    RandomVec<T>(w.numel(), w.mutable_data<T>(PlaceType()), -2.f, 2.f);
+    const T* x_data = x.data<T>();
+    const T* w_data = w.data<T>();
+    T* y_data = y.mutable_data<T>(PlaceType());
+    const jit::conv_nchw16c_attr_t attr(ic_blocks, k, k, stride, ih, iw, ow);
+    BenchAllImpls<KernelTuple, PlaceType>(attr, x_data, w_data, y_data,
+                                          &attr);
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelSoftmax() {
   using T = typename KernelTuple::data_type;
@@ -547,6 +576,7 @@ BENCH_FP32_CPU(CRFDecoding);
 BENCH_FP32_CPU(SeqPool);
 BENCH_FP32_CPU(EmbSeqPool);
 BENCH_FP32_CPU(MatMul);
+BENCH_FP32_CPU(ConvNCHW16C);
 BENCH_FP32_CPU(Softmax);
 BENCH_FP32_CPU(Sgd);
 BENCH_FP32_CPU(VBroadcast);
@@ -50,6 +50,7 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kGRUHtPart1);
     ONE_CASE(kGRUHtPart2);
     ONE_CASE(kCRFDecoding);
+    ONE_CASE(kConvNCHW16C);
     ONE_CASE(kLayerNorm);
     ONE_CASE(kNCHW16CMulNC);
     ONE_CASE(kSeqPool);
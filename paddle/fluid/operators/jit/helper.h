@@ -261,6 +261,14 @@ inline std::ostream& operator<<(std::ostream& os, const matmul_attr_t& attr) {
   return os;
 }
 
+inline std::ostream& operator<<(std::ostream& os,
+                                const conv_nchw16c_attr_t& attr) {
+  os << "ic_blocks[" << attr.ic_blocks << "],kh[" << attr.kh << "],kw["
+     << attr.kw << "],stride_w[" << attr.stride_w << "],ih[" << attr.ih
+     << "],iw[" << attr.iw << "],ow[" << attr.ow << "]";
+  return os;
+}
+
 // expose the method to pack matmul weight
 template <typename T>
 void pack_weights(const T* src, T* dst, int n, int k);
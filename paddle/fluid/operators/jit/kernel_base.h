@@ -25,7 +25,8 @@ typedef enum {
   kNone = 0,
   // sort by alphabet
   kCRFDecoding = 1,
-  kEmbSeqPool = 2,
+  kConvNCHW16C,
+  kEmbSeqPool,
   kGRUH1,
   kGRUHtPart1,
   kGRUHtPart2,
@@ -319,6 +320,38 @@ struct NCHW16CMulNCTuple {
   typedef void (*func_type)(const T*, const T*, T*, int, int);
 };
 
+// The direct convolution of one output row of 16 output channels.
+// x: the padded input in nChw16c from the first input row of the window,
+// w: the filter of the 16 output channels in [ic/16, kh, kw, 16i, 16o],
+// y: the output row in [ow, 16o]. The input rows are iw wide, and ih rows make
+// a block of 16 input channels.
+typedef struct conv_nchw16c_attr_s {
+  int ic_blocks;
+  int kh, kw;
+  int stride_w;
+  int ih, iw;
+  int ow;
+  conv_nchw16c_attr_s() = default;
+  explicit conv_nchw16c_attr_s(int ic_blocks_, int kh_, int kw_,
+                               int stride_w_, int ih_, int iw_, int ow_)
+      : ic_blocks(ic_blocks_),
+        kh(kh_),
+        kw(kw_),
+        stride_w(stride_w_),
+        ih(ih_),
+        iw(iw_),
+        ow(ow_) {}
+} conv_nchw16c_attr_t;
+
+template <typename T>
+struct ConvNCHW16CTuple {
+  static constexpr KernelType kernel_type = kConvNCHW16C;
+  typedef T data_type;
+  typedef conv_nchw16c_attr_t attr_type;
+  typedef void (*func_type)(const T*, const T*, T*,
+                            const conv_nchw16c_attr_t*);
+};
+
 // Just for adding to kernel pool without template
 class Kernel {
  public:
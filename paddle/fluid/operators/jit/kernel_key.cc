@@ -54,6 +54,11 @@ int64_t JitCodeKey<matmul_attr_t>(const matmul_attr_t& attr) {
   return XXH64(&attr, sizeof(int) * 3, 0);  // m, n, k
 }
 
+template <>
+int64_t JitCodeKey<conv_nchw16c_attr_t>(const conv_nchw16c_attr_t& attr) {
+  return XXH64(&attr, sizeof(conv_nchw16c_attr_t), 0);
+}
+
 template <>
 int64_t JitCodeKey<emb_seq_pool_attr_t>(const emb_seq_pool_attr_t& attr) {
   return attr.table_width;
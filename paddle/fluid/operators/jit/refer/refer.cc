@@ -46,6 +46,7 @@ REGISTER_REFER_KERNEL(GRUHtPart1);
 REGISTER_REFER_KERNEL(GRUHtPart2);
 
 REGISTER_REFER_KERNEL(CRFDecoding);
+REGISTER_REFER_KERNEL(ConvNCHW16C);
 REGISTER_REFER_KERNEL(LayerNorm);
 REGISTER_REFER_KERNEL(NCHW16CMulNC);
 REGISTER_REFER_KERNEL(SeqPool);
@@ -354,6 +354,37 @@ void NCHW16CMulNC(const T* x, const T* y, T* z, int height, int width) {
   }
 }
 
+// y[ow][o] = sum(x[icb][kh][ow * stride_w + kw][i] * w[icb][kh][kw][i][o])
+template <typename T>
+void ConvNCHW16C(const T* x, const T* w, T* y,
+                 const conv_nchw16c_attr_t* attr) {
+  constexpr int block = ZMM_FLOAT_BLOCK;
+  const int row_size = attr->iw * block;
+  const int plane_size = attr->ih * row_size;
+  for (int ow = 0; ow < attr->ow; ++ow) {
+    T* dst = y + ow * block;
+    for (int o = 0; o < block; ++o) {
+      dst[o] = static_cast<T>(0);
+    }
+    const T* wgt = w;
+    for (int icb = 0; icb < attr->ic_blocks; ++icb) {
+      for (int kh = 0; kh < attr->kh; ++kh) {
+        const T* src = x + icb * plane_size + kh * row_size +
+                       ow * attr->stride_w * block;
+        for (int kw = 0; kw < attr->kw; ++kw) {
+          for (int i = 0; i < block; ++i) {
+            for (int o = 0; o < block; ++o) {
+              dst[o] += src[i] * wgt[o];
+            }
+            wgt += block;
+          }
+          src += block;
+        }
+      }
+    }
+  }
+}
+
 template <typename T>
 void SeqPool(const T* x, T* y, const seq_pool_attr_t* attr) {
   for (int w = 0; w < attr->w; ++w) {
@@ -563,6 +594,7 @@ DECLARE_REFER_KERNEL(StrideASum);
 
 // others
 DECLARE_REFER_KERNEL(CRFDecoding);
+DECLARE_REFER_KERNEL(ConvNCHW16C);
 DECLARE_REFER_KERNEL(LayerNorm);
 DECLARE_REFER_KERNEL(NCHW16CMulNC);
 DECLARE_REFER_KERNEL(SeqPool);
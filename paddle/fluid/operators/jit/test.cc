@@ -399,6 +399,47 @@ void TestKernelGRU() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void TestKernelConvNCHW16C() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  constexpr int block = ZMM_FLOAT_BLOCK;
+  auto last_acc = FLAGS_acc;
+  FLAGS_acc = 1e-3;
+  for (int ic_blocks : {1, 3}) {
+    for (int k : {1, 3}) {
+      for (int stride : {1, 2}) {
+        for (int ow : {1, 7, 28, 30, 57}) {
+          // one more input row than the filter, to test the plane size
+          const int ih = k + 1, iw = (ow - 1) * stride + k;
+          const jit::conv_nchw16c_attr_t attr(ic_blocks, k, k, stride, ih, iw,
+                                              ow);
+          auto ref = jit::GetReferFunc<KernelTuple>();
+          EXPECT_TRUE(ref != nullptr);
+          std::vector<T> x(ic_blocks * ih * iw * block);
+          std::vector<T> w(ic_blocks * k * k * block * block);
+          std::vector<T> yref(ow * block);
+          RandomVec<T>(x.size(), x.data());
+          RandomVec<T>(w.size(), w.data());
+          ref(x.data(), w.data(), yref.data(), &attr);
+          auto verifier = [](const typename KernelTuple::func_type tgt,
+                             const std::vector<T>& x, const std::vector<T>& w,
+                             const std::vector<T>& yref,
+                             const typename KernelTuple::attr_type& attr) {
+            EXPECT_TRUE(tgt != nullptr);
+            std::vector<T> y(yref.size());
+            tgt(x.data(), w.data(), y.data(), &attr);
+            ExpectEQ<T>(y.data(), yref.data(), yref.size());
+          };
+          TestAllImpls<KernelTuple, PlaceType>(attr, verifier, x, w, yref,
+                                               attr);
+        }
+      }
+    }
+  }
+  FLAGS_acc = last_acc;
+}
+
 template <typename KernelTuple, typename PlaceType>
 void TestKernelNCHW16CMulNC() {
   using T = typename KernelTuple::data_type;
@@ -972,7 +1013,7 @@ TEST(JITKernel_pool, jitcreator) {
 #if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
   EXPECT_EQ(jitcreators.size(), 0UL);
 #else
-  EXPECT_EQ(jitcreators.size(), 25UL);
+  EXPECT_EQ(jitcreators.size(), 26UL);
 #endif
 }
 
@@ -1006,7 +1047,7 @@ TEST(JITKernel_pool, more) {
 
 TEST(JITKernel_pool, refer) {
   const auto& kers = jit::ReferKernelPool::Instance().AllKernels();
-  EXPECT_EQ(kers.size(), 31UL);
+  EXPECT_EQ(kers.size(), 32UL);
 }
 
 // test helper
@@ -1127,7 +1168,8 @@ TEST(JITKernel_helper, attr) {
   std::ostringstream out;
   // KernelTypes
   out << jit::to_string(jit::kNone) << jit::to_string(jit::kCRFDecoding)
-      << jit::to_string(jit::kEmbSeqPool) << jit::to_string(jit::kGRUH1)
+      << jit::to_string(jit::kConvNCHW16C) << jit::to_string(jit::kEmbSeqPool)
+      << jit::to_string(jit::kGRUH1)
       << jit::to_string(jit::kGRUHtPart1) << jit::to_string(jit::kGRUHtPart2)
       << jit::to_string(jit::kHSum) << jit::to_string(jit::kHMax)
       << jit::to_string(jit::kLSTMCtHt) << jit::to_string(jit::kLSTMC1H1)
@@ -1141,7 +1183,7 @@ TEST(JITKernel_helper, attr) {
       << jit::to_string(jit::kVScal) << jit::to_string(jit::kSgd)
       << jit::to_string(jit::kVSigmoid) << jit::to_string(jit::kVSquare)
       << jit::to_string(jit::kVSub) << jit::to_string(jit::kVTanh);
-  EXPECT_EQ(out.str().size(), 234);
+  EXPECT_EQ(out.str().size(), 246);
 
   // SeqPoolTypes
   out.str("");
@@ -1178,6 +1220,10 @@ TEST(JITKernel_helper, attr) {
   out.str("");
   out << jit::matmul_attr_t(1, 2, 3);
   EXPECT_EQ(out.str().size(), 14);
+
+  out.str("");
+  out << jit::conv_nchw16c_attr_t(1, 3, 3, 1, 5, 6, 4);
+  EXPECT_EQ(out.str().size(), 54);
 }
 
 // test keys
@@ -1268,6 +1314,23 @@ TEST(JITKernel_key, matmul) {
   EXPECT_TRUE(key3 != key4);
 }
 
+TEST(JITKernel_key, conv_nchw16c) {
+  jit::conv_nchw16c_attr_t attr1(1, 3, 3, 1, 5, 6, 4);
+  jit::conv_nchw16c_attr_t attr2(1, 3, 3, 1, 5, 6, 4);
+  jit::conv_nchw16c_attr_t attr3(1, 3, 3, 2, 5, 6, 4);
+  jit::conv_nchw16c_attr_t attr4(2, 3, 3, 1, 5, 6, 4);
+
+  auto key1 = jit::JitCodeKey<jit::conv_nchw16c_attr_t>(attr1);
+  auto key2 = jit::JitCodeKey<jit::conv_nchw16c_attr_t>(attr2);
+  auto key3 = jit::JitCodeKey<jit::conv_nchw16c_attr_t>(attr3);
+  auto key4 = jit::JitCodeKey<jit::conv_nchw16c_attr_t>(attr4);
+
+  EXPECT_TRUE(key1 == key2);
+  EXPECT_TRUE(key2 != key3);
+  EXPECT_TRUE(key2 != key4);
+  EXPECT_TRUE(key3 != key4);
+}
+
 TEST(JITKernel_key, emb_seq_pool) {
   jit::emb_seq_pool_attr_t attr1(1, 2, 3, 4, 5, jit::SeqPoolType::kSum);
   jit::emb_seq_pool_attr_t attr2(1, 2, 3, 4, 5, jit::SeqPoolType::kSum);
@@ -1368,6 +1431,7 @@ TEST_CPU_KERNEL(GRUHtPart1);
 TEST_CPU_KERNEL(GRUHtPart2);
 
 TEST_CPU_KERNEL(NCHW16CMulNC);
+TEST_CPU_KERNEL(ConvNCHW16C);
 TEST_CPU_KERNEL(LayerNorm);
 TEST_CPU_KERNEL(CRFDecoding);
 
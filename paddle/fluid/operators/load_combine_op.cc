@@ -69,7 +69,9 @@ LoadCombine operator applies a deserialization strategy to appropriately load
 the LodTensors, and this strategy complements the serialization strategy used
 in the SaveCombine operator. Hence, the LoadCombine operator is tightly coupled
 with the SaveCombine operator, and can only deserialize one or more LoDTensors
-that were saved using the SaveCombine operator.
+that were saved using the SaveCombine operator. The files saved with
+mmap_format are memory mapped, and the LoDTensors loaded on CPU reference the
+mapped file instead of copying it.
 
 )DOC");
   }
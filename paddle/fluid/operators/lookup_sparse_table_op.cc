@@ -65,6 +65,16 @@ class LookupSparseTableOp : public framework::OperatorBase {
     out_t->mutable_data(cpu, w_t->value().type());
     PADDLE_ENFORCE_EQ(w_t->value().type(), framework::proto::VarType::FP32,
                       "The sparse table only support FP32");
+    if (Attr<bool>("use_sharded_table")) {
+      framework::ShardedSparseTable::Config config;
+      config.shard_num = Attr<int>("shard_num");
+      config.admit_count = Attr<int>("admit_count");
+      config.max_rows = Attr<int64_t>("max_rows");
+      config.init_min = Attr<float>("min");
+      config.init_max = Attr<float>("max");
+      config.seed = static_cast<unsigned int>(Attr<int>("seed"));
+      w_t->EnableShardedTable(config);
+    }
     w_t->Get(ids_t, out_t, true, is_test);
     out_t->set_lod(ids_t.lod());
   }
@@ -96,6 +106,36 @@ class LookupSparseTableOpMaker : public framework::OpProtoAndCheckerMaker {
                   "In test mode, lookup_sparse_table will "
                   "return a 0 for unknown id")
         .SetDefault(false);
+    AddAttr<bool>("use_sharded_table",
+                  "(bool, default false) "
+                  "Whether to move W into a sharded table at the first "
+                  "lookup, which has a lock per shard and grows by chunks "
+                  "instead of reallocating the rows.")
+        .SetDefault(false);
+    AddAttr<int>("shard_num", "(int, default 64) The shards of the table.")
+        .SetDefault(64);
+    AddAttr<int>("admit_count",
+                 "(int, default 0) "
+                 "A new id gets a row after it is looked up admit_count "
+                 "times, 0 or 1 admits it at once.")
+        .SetDefault(0);
+    AddAttr<int64_t>("max_rows",
+                     "(int64, default 0) "
+                     "The least recently used rows are evicted above it, "
+                     "0 means unlimited.")
+        .SetDefault(0);
+    AddAttr<float>("min",
+                   "(float, default 0.0) "
+                   "Minimum value of the new rows of the sharded table.")
+        .SetDefault(0.0f);
+    AddAttr<float>("max",
+                   "(float, default 0.0) "
+                   "Maximum value of the new rows of the sharded table.")
+        .SetDefault(0.0f);
+    AddAttr<int>("seed",
+                 "(int, default 0) "
+                 "Random seed of the new rows of the sharded table.")
+        .SetDefault(0);
     AddComment(R"DOC(
 Lookup Sprase Tablel Operator.
 
@@ -107,6 +147,11 @@ the ids to be looked up in W;
 if the Id is not in the sparse table, this operator will return a
 random value and set the value into the table for the next looking up.
 
+With use_sharded_table, W is moved into a sharded table at the first lookup,
+and the sgd op updates the rows of the table. The new rows are initialized
+uniformly in [min, max], and the ids are admitted and evicted by admit_count
+and max_rows.
+
 )DOC");
   }
 };
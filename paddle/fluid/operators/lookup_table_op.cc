@@ -57,6 +57,12 @@ class LookupTableOp : public framework::OperatorWithKernel {
   framework::OpKernelType GetExpectedKernelType(
       const framework::ExecutionContext& ctx) const override {
     auto data_type = framework::GetDataTypeOfVar(ctx.InputVar("W"));
+    // the CPU kernel dequantizes the compressed table to float
+    if (platform::is_cpu_place(ctx.GetPlace()) &&
+        (data_type == framework::proto::VarType::FP16 ||
+         data_type == framework::proto::VarType::INT8)) {
+      data_type = framework::proto::VarType::FP32;
+    }
     return framework::OpKernelType(data_type, ctx.device_context());
   }
 };
@@ -71,7 +77,14 @@ class LookupTableOpMaker : public framework::OpProtoAndCheckerMaker {
              "An input with type int32 or int64 "
              "contains the ids to be looked up in W. "
              "The last dimension size must be 1.");
-    AddOutput("Out", "The lookup results, which have the same type as W.");
+    AddInput("WScale",
+             "(Tensor, optional) The float scale of every row of an int8 W, "
+             "row i of W is W[i] * WScale[i]. An int8 or float16 W is "
+             "dequantized to float by the CPU kernel.")
+        .AsDispensable();
+    AddOutput("Out",
+              "The lookup results, which have the same type as W, or float "
+              "if W is int8 or float16.");
     AddAttr<bool>("is_sparse",
                   "(boolean, default false) "
                   "Sparse update.")
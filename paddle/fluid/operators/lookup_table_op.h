@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/embedding_gather.h"
 
 #ifdef PADDLE_WITH_DISTRIBUTE
 #include "paddle/fluid/operators/distributed/parameter_prefetch.h"
@@ -37,6 +38,41 @@ using DDim = framework::DDim;
 
 constexpr int64_t kNoPadding = -1;
 
+// Gathers the table rows of the deduplicated ids into output, rows[u] is the
+// table row of the u-th unique id.
+template <typename T>
+void GatherDeduplicatedRows(const framework::ExecutionContext &context,
+                            const math::EmbeddingTable &table,
+                            const math::DedupIds &dedup,
+                            const std::vector<int64_t> &rows, T *output) {
+  int64_t ids_numel = static_cast<int64_t>(dedup.index.size());
+  if (static_cast<int64_t>(rows.size()) == ids_numel) {
+    // neither duplicated ids nor padding, index[i] is i
+    math::GatherRows(table, rows.data(), ids_numel, output);
+    return;
+  }
+  Tensor unique_rows;
+  T *buffer = unique_rows.mutable_data<T>(
+      {static_cast<int64_t>(rows.size()), table.width}, context.GetPlace());
+  math::GatherRows(table, rows.data(), rows.size(), buffer);
+  math::ScatterRows(buffer, dedup.index.data(), ids_numel, table.width,
+                    output);
+}
+
+// The per-row scales of an int8 table, nullptr for the other types.
+inline const float *TableScales(const framework::ExecutionContext &context,
+                                const Tensor &table) {
+  if (table.type() != framework::proto::VarType::INT8) {
+    return nullptr;
+  }
+  auto *scale_t = context.Input<Tensor>("WScale");
+  PADDLE_ENFORCE_NOT_NULL(scale_t,
+                          "Input(WScale) should be set for the int8 table.");
+  PADDLE_ENFORCE_EQ(scale_t->numel(), table.dims()[0],
+                    "The int8 table should have a scale per row.");
+  return scale_t->data<float>();
+}
+
 template <typename T>
 class LookupTableKernel : public framework::OpKernel<T> {
  public:
@@ -79,47 +115,45 @@ class LookupTableKernel : public framework::OpKernel<T> {
         int64_t row_number = table_t->dims()[0];
         int64_t row_width = table_t->dims()[1];
 
-        auto *table = table_t->data<T>();
         auto *output = output_t->mutable_data<T>(context.GetPlace());
 
-        for (int64_t i = 0; i < ids_numel; ++i) {
-          if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_LT(
-                ids[i], row_number,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number, ids[i]);
-            PADDLE_ENFORCE_GE(
-                ids[i], 0,
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number, ids[i]);
-            memcpy(output + i * row_width, table + ids[i] * row_width,
-                   row_width * sizeof(T));
-          }
+        math::DedupIds dedup;
+        math::DeduplicateIds(ids, ids_numel, padding_idx, &dedup);
+        for (int64_t id : dedup.unique) {
+          PADDLE_ENFORCE_LT(
+              id, row_number,
+              "Variable value (input) of OP(fluid.layers.embedding) "
+              "expected >= 0 and < %ld, but got %ld. Please check input "
+              "value.",
+              row_number, id);
+          PADDLE_ENFORCE_GE(
+              id, 0,
+              "Variable value (input) of OP(fluid.layers.embedding) "
+              "expected >= 0 and < %ld, but got %ld. Please check input "
+              "value.",
+              row_number, id);
         }
+        math::EmbeddingTable table{table_t->data<void>(), table_t->type(),
+                                   TableScales(context, *table_t), row_width};
+        GatherDeduplicatedRows<T>(context, table, dedup, dedup.unique,
+                                  output);
       } else if (table_var->IsType<SelectedRows>()) {
         const auto &table_t = table_var->Get<SelectedRows>();
         int64_t row_width = table_t.value().dims()[1];
-        const auto *table = table_t.value().data<T>();
         auto *output = output_t->mutable_data<T>(context.GetPlace());
 
-        auto blas = math::GetBlas<platform::CPUDeviceContext, T>(context);
-        for (int64_t i = 0; i < ids_numel; ++i) {
-          if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-            memset(output + i * row_width, 0, row_width * sizeof(T));
-          } else {
-            PADDLE_ENFORCE_GE(ids[i], 0);
-            auto id_index = table_t.Index(ids[i]);
-            PADDLE_ENFORCE_GE(id_index, 0, "the input key should be exists.");
-            blas.VCOPY(row_width, table + id_index * row_width,
-                       output + i * row_width);
-          }
+        math::DedupIds dedup;
+        math::DeduplicateIds(ids, ids_numel, padding_idx, &dedup);
+        std::vector<int64_t> rows(dedup.unique.size());
+        for (size_t u = 0; u < rows.size(); ++u) {
+          PADDLE_ENFORCE_GE(dedup.unique[u], 0);
+          rows[u] = table_t.Index(dedup.unique[u]);
+          PADDLE_ENFORCE_GE(rows[u], 0, "the input key should be exists.");
         }
+        math::EmbeddingTable table{
+            table_t.value().data<void>(), table_t.value().type(),
+            TableScales(context, table_t.value()), row_width};
+        GatherDeduplicatedRows<T>(context, table, dedup, rows, output);
       }
     }
   }
@@ -153,14 +187,24 @@ class LookupTableGradKernel : public framework::OpKernel<T> {
 
       auto *ids_data = ids->data<int64_t>();
       int64_t ids_num = ids->numel();
+      bool grad_inplace = context.Attr<bool>("grad_inplace");
 
-      std::vector<int64_t> new_rows;
-      new_rows.resize(ids_num);
-      std::memcpy(&new_rows[0], ids_data, ids_num * sizeof(int64_t));
-      d_table->set_rows(new_rows);
+      // The rows of the duplicated ids are merged unless the gradient shares
+      // the buffer of Out@GRAD. The rows of padding_idx are kept as before.
+      math::DedupIds dedup;
+      if (grad_inplace) {
+        std::vector<int64_t> new_rows;
+        new_rows.resize(ids_num);
+        std::memcpy(&new_rows[0], ids_data, ids_num * sizeof(int64_t));
+        d_table->set_rows(new_rows);
+      } else {
+        math::DeduplicateIds(ids_data, ids_num, kNoPadding, &dedup);
+        d_table->set_rows(dedup.unique);
+      }
+      int64_t rows_num = static_cast<int64_t>(d_table->rows().size());
 
       auto *d_table_value = d_table->mutable_value();
-      d_table_value->Resize({ids_num, table_dim[1]});
+      d_table_value->Resize({rows_num, table_dim[1]});
       // FIXME(minqiyang):
       // memory optimization will NOT reuse Tensor with SelectedRows
       // so we could just share the tensor here directly.
@@ -168,7 +212,6 @@ class LookupTableGradKernel : public framework::OpKernel<T> {
       // to Tensor sometimes, which is a bug, so we will add an attribute
       // here to indicate the inplace and remove this attribute after
       // the InferVarType's bug was fixed
-      bool grad_inplace = context.Attr<bool>("grad_inplace");
       if (grad_inplace) {
         d_table_value->ShareDataWith(*d_output);
       } else {
@@ -181,9 +224,10 @@ class LookupTableGradKernel : public framework::OpKernel<T> {
 
         auto d_output_dims = d_output->dims();
         PADDLE_ENFORCE_EQ(
-            d_table_value->dims(),
+            framework::make_ddim({ids_num, table_dim[1]}),
             framework::flatten_to_2d(d_output_dims, d_output_dims.size() - 1));
-        memcpy(d_table_data, d_output_data, sizeof(T) * d_output->numel());
+        math::MergeRows(d_output_data, dedup.index.data(), ids_num,
+                        table_dim[1], rows_num, nullptr, d_table_data);
       }
     } else {
       auto *ids = context.Input<LoDTensor>("Ids");
@@ -200,26 +244,25 @@ class LookupTableGradKernel : public framework::OpKernel<T> {
 
       memset(d_table_data, 0, d_table->numel() * sizeof(T));
 
-      for (int64_t i = 0; i < ids->numel(); ++i) {
-        if (padding_idx != kNoPadding && ids_data[i] == padding_idx) {
-          // the gradient of padding_idx should be 0, already done by memset, so
-          // do nothing.
-        } else {
-          PADDLE_ENFORCE_LT(
-              ids_data[i], N,
-              "Variable value (input) of OP(fluid.layers.embedding) "
-              "expected >= 0 and < %ld, but got %ld. Please check input value.",
-              N, ids_data[i]);
-          PADDLE_ENFORCE_GE(
-              ids_data[i], 0,
-              "Variable value (input) of OP(fluid.layers.embedding) "
-              "expected >= 0 and < %ld, but got %ld. Please check input value.",
-              N, ids_data[i]);
-          for (int j = 0; j < D; ++j) {
-            d_table_data[ids_data[i] * D + j] += d_output_data[i * D + j];
-          }
-        }
+      // the gradient of padding_idx should be 0, already done by memset, so
+      // its index is -1 and it is skipped.
+      math::DedupIds dedup;
+      math::DeduplicateIds(ids_data, ids->numel(), padding_idx, &dedup);
+      for (int64_t id : dedup.unique) {
+        PADDLE_ENFORCE_LT(
+            id, N,
+            "Variable value (input) of OP(fluid.layers.embedding) "
+            "expected >= 0 and < %ld, but got %ld. Please check input value.",
+            N, id);
+        PADDLE_ENFORCE_GE(
+            id, 0,
+            "Variable value (input) of OP(fluid.layers.embedding) "
+            "expected >= 0 and < %ld, but got %ld. Please check input value.",
+            N, id);
       }
+      math::MergeRows(d_output_data, dedup.index.data(), ids->numel(), D,
+                      static_cast<int64_t>(dedup.unique.size()),
+                      dedup.unique.data(), d_table_data);
     }
   }
 };
@@ -0,0 +1,176 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+
+#include "paddle/fluid/operators/math/conv_nchw16c.h"
+#include <algorithm>
+#include <vector>
+#include "paddle/fluid/operators/jit/kernels.h"
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+constexpr int kBlock = ZMM_FLOAT_BLOCK;
+
+static jit::conv_nchw16c_attr_t ConvNCHW16CAttr(
+    const framework::DDim& input_dims, const framework::DDim& filter_dims,
+    const framework::DDim& output_dims, const std::vector<int>& strides,
+    const std::vector<int>& paddings) {
+  return jit::conv_nchw16c_attr_t(
+      static_cast<int>(input_dims[1] / kBlock),
+      static_cast<int>(filter_dims[2]), static_cast<int>(filter_dims[3]),
+      strides[1], static_cast<int>(input_dims[2] + 2 * paddings[0]),
+      static_cast<int>(input_dims[3] + 2 * paddings[1]),
+      static_cast<int>(output_dims[3]));
+}
+
+bool CanUseConvNCHW16C(const framework::DDim& input_dims,
+                       const framework::DDim& filter_dims,
+                       const framework::DDim& output_dims,
+                       const std::vector<int>& strides,
+                       const std::vector<int>& paddings,
+                       const std::vector<int>& dilations, int groups) {
+  if (input_dims.size() != 4 || groups != 1 || input_dims[1] % kBlock != 0 ||
+      filter_dims[0] % kBlock != 0) {
+    return false;
+  }
+  if (dilations[0] != 1 || dilations[1] != 1) {
+    return false;
+  }
+  bool no_im2col = filter_dims[2] == 1 && filter_dims[3] == 1 &&
+                   strides[0] == 1 && strides[1] == 1 && paddings[0] == 0 &&
+                   paddings[1] == 0;
+  if (no_im2col) {
+    return false;
+  }
+  auto attr = ConvNCHW16CAttr(input_dims, filter_dims, output_dims, strides,
+                              paddings);
+  return jit::GetJitCode<jit::ConvNCHW16CTuple<float>, platform::CPUPlace>(
+             attr) != nullptr;
+}
+
+void ConvNCHW16C(const framework::Tensor& input,
+                 const framework::Tensor& filter,
+                 const std::vector<int>& strides,
+                 const std::vector<int>& paddings, framework::Tensor* output) {
+  auto attr = ConvNCHW16CAttr(input.dims(), filter.dims(), output->dims(),
+                              strides, paddings);
+  const int batch_size = static_cast<int>(input.dims()[0]);
+  const int ic = static_cast<int>(input.dims()[1]);
+  const int ih = static_cast<int>(input.dims()[2]);
+  const int iw = static_cast<int>(input.dims()[3]);
+  const int oc = static_cast<int>(output->dims()[1]);
+  const int oh = static_cast<int>(output->dims()[2]);
+  const int ow = static_cast<int>(output->dims()[3]);
+  const int kh = attr.kh, kw = attr.kw;
+  const int ic_blocks = attr.ic_blocks, oc_blocks = oc / kBlock;
+  const int pad_h = paddings[0], pad_w = paddings[1];
+  const int ph = attr.ih, pw = attr.iw;
+  PADDLE_ENFORCE_EQ(ic % kBlock, 0);
+  PADDLE_ENFORCE_EQ(oc % kBlock, 0);
+
+  // The input in nChw16c with the paddings.
+  framework::Tensor x_blocked;
+  float* x = x_blocked.mutable_data<float>(
+      framework::make_ddim({batch_size, ic_blocks, ph, pw, kBlock}),
+      platform::CPUPlace());
+  const float* in = input.data<float>();
+  const int64_t planes = static_cast<int64_t>(batch_size) * ic_blocks;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t p = 0; p < planes; ++p) {
+    const float* src = in + p * kBlock * ih * iw;
+    for (int h = 0; h < ph; ++h) {
+      float* dst = x + (p * ph + h) * pw * kBlock;
+      int sh = h - pad_h;
+      if (sh < 0 || sh >= ih) {
+        std::fill(dst, dst + pw * kBlock, 0.f);
+        continue;
+      }
+      std::fill(dst, dst + pad_w * kBlock, 0.f);
+      std::fill(dst + (pad_w + iw) * kBlock, dst + pw * kBlock, 0.f);
+      for (int c = 0; c < kBlock; ++c) {
+        const float* src_row = src + (c * ih + sh) * iw;
+        float* dst_row = dst + pad_w * kBlock + c;
+        for (int w = 0; w < iw; ++w) {
+          dst_row[w * kBlock] = src_row[w];
+        }
+      }
+    }
+  }
+
+  // The filter in [oc/16, ic/16, kh, kw, 16i, 16o].
+  framework::Tensor w_blocked;
+  float* w = w_blocked.mutable_data<float>(
+      framework::make_ddim({oc_blocks, ic_blocks, kh, kw, kBlock, kBlock}),
+      platform::CPUPlace());
+  const float* flt = filter.data<float>();
+  const int filter_size = kh * kw;
+  for (int ocb = 0; ocb < oc_blocks; ++ocb) {
+    for (int icb = 0; icb < ic_blocks; ++icb) {
+      for (int k = 0; k < filter_size; ++k) {
+        float* dst = w + ((ocb * ic_blocks + icb) * filter_size + k) * kBlock *
+                             kBlock;
+        for (int i = 0; i < kBlock; ++i) {
+          for (int o = 0; o < kBlock; ++o) {
+            dst[i * kBlock + o] =
+                flt[((ocb * kBlock + o) * ic + icb * kBlock + i) *
+                        filter_size +
+                    k];
+          }
+        }
+      }
+    }
+  }
+
+  auto conv = jit::KernelFuncs<jit::ConvNCHW16CTuple<float>,
+                               platform::CPUPlace>::Cache()
+                  .At(attr);
+  float* out = output->data<float>();
+  const int64_t rows = static_cast<int64_t>(batch_size) * oc_blocks * oh;
+  const int64_t x_image_size =
+      static_cast<int64_t>(ic_blocks) * ph * pw * kBlock;
+  const int64_t w_block_size = ic_blocks * filter_size * kBlock * kBlock;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+  {
+    std::vector<float> row(ow * kBlock);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+    for (int64_t r = 0; r < rows; ++r) {
+      const int h = static_cast<int>(r % oh);
+      const int ocb = static_cast<int>(r / oh % oc_blocks);
+      const int64_t b = r / oh / oc_blocks;
+      conv(x + b * x_image_size + h * strides[0] * pw * kBlock,
+           w + ocb * w_block_size, row.data(), &attr);
+      float* dst = out + ((b * oc + ocb * kBlock) * oh + h) * ow;
+      for (int o = 0; o < kBlock; ++o) {
+        for (int j = 0; j < ow; ++j) {
+          dst[o * oh * ow + j] = row[j * kBlock + o];
+        }
+      }
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
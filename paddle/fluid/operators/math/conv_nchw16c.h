@@ -0,0 +1,50 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+
+#pragma once
+
+#include <vector>
+#include "paddle/fluid/framework/tensor.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// Whether the float conv2d had better run on ConvNCHW16C. The channels should
+// be multiples of 16, with no groups or dilations, and a ConvNCHW16C jit code
+// should be registered for this CPU. There is only the refer kernel for now,
+// slower than the GEMM, so conv2d keeps the GEMM until a jit code is added.
+// The 1x1 convolutions of stride 1 and no padding are left to the GEMM on the
+// input.
+bool CanUseConvNCHW16C(const framework::DDim& input_dims,
+                       const framework::DDim& filter_dims,
+                       const framework::DDim& output_dims,
+                       const std::vector<int>& strides,
+                       const std::vector<int>& paddings,
+                       const std::vector<int>& dilations, int groups);
+
+// The direct conv2d of a float NCHW input with an OIHW filter. The input is
+// reordered to nChw16c with the paddings, and the filter to [oc/16, ic/16, kh,
+// kw, 16i, 16o]. The output rows of every 16 output channels are computed in
+// parallel by the ConvNCHW16C jit kernel, or its refer kernel, and written
+// back to NCHW.
+void ConvNCHW16C(const framework::Tensor& input,
+                 const framework::Tensor& filter,
+                 const std::vector<int>& strides,
+                 const std::vector<int>& paddings, framework::Tensor* output);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
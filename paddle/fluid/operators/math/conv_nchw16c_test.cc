@@ -0,0 +1,120 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+
+#include "paddle/fluid/operators/math/conv_nchw16c.h"
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static void RandomFill(framework::Tensor* tensor) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  float* data = tensor->data<float>();
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+// Plain conv2d of NCHW and OIHW.
+static void NaiveConv(const framework::Tensor& input,
+                      const framework::Tensor& filter,
+                      const std::vector<int>& strides,
+                      const std::vector<int>& paddings,
+                      framework::Tensor* output) {
+  auto in = input.dims(), flt = filter.dims(), out = output->dims();
+  const float* x = input.data<float>();
+  const float* w = filter.data<float>();
+  float* y = output->data<float>();
+  for (int64_t n = 0; n < out[0]; ++n) {
+    for (int64_t o = 0; o < out[1]; ++o) {
+      for (int64_t oh = 0; oh < out[2]; ++oh) {
+        for (int64_t ow = 0; ow < out[3]; ++ow) {
+          float sum = 0.f;
+          for (int64_t i = 0; i < in[1]; ++i) {
+            for (int64_t kh = 0; kh < flt[2]; ++kh) {
+              for (int64_t kw = 0; kw < flt[3]; ++kw) {
+                int64_t ih = oh * strides[0] + kh - paddings[0];
+                int64_t iw = ow * strides[1] + kw - paddings[1];
+                if (ih < 0 || ih >= in[2] || iw < 0 || iw >= in[3]) continue;
+                sum += x[((n * in[1] + i) * in[2] + ih) * in[3] + iw] *
+                       w[((o * flt[1] + i) * flt[2] + kh) * flt[3] + kw];
+              }
+            }
+          }
+          y[((n * out[1] + o) * out[2] + oh) * out[3] + ow] = sum;
+        }
+      }
+    }
+  }
+}
+
+static void TestConvNCHW16C(int batch_size, int ic, int oc, int size, int k,
+                            int stride, int padding) {
+  platform::CPUPlace place;
+  int out_size = (size + 2 * padding - k) / stride + 1;
+  framework::Tensor input, filter, output, expected;
+  input.mutable_data<float>(framework::make_ddim({batch_size, ic, size, size}),
+                            place);
+  filter.mutable_data<float>(framework::make_ddim({oc, ic, k, k}), place);
+  auto out_dims = framework::make_ddim({batch_size, oc, out_size, out_size});
+  output.mutable_data<float>(out_dims, place);
+  expected.mutable_data<float>(out_dims, place);
+  RandomFill(&input);
+  RandomFill(&filter);
+
+  std::vector<int> strides{stride, stride}, paddings{padding, padding};
+  ConvNCHW16C(input, filter, strides, paddings, &output);
+  NaiveConv(input, filter, strides, paddings, &expected);
+  for (int64_t i = 0; i < output.numel(); ++i) {
+    ASSERT_NEAR(output.data<float>()[i], expected.data<float>()[i], 1e-3)
+        << "at " << i;
+  }
+}
+
+TEST(ConvNCHW16C, compare_with_naive) {
+  TestConvNCHW16C(1, 16, 16, 7, 3, 1, 1);
+  TestConvNCHW16C(2, 32, 48, 9, 3, 2, 1);
+  TestConvNCHW16C(2, 16, 32, 8, 1, 2, 0);
+  TestConvNCHW16C(1, 32, 16, 35, 5, 1, 2);
+}
+
+TEST(ConvNCHW16C, can_use) {
+  std::vector<int> ones{1, 1}, zeros{0, 0};
+  auto in = framework::make_ddim({1, 32, 8, 8});
+  auto out = framework::make_ddim({1, 16, 8, 8});
+  // no im2col, left to the GEMM
+  EXPECT_FALSE(CanUseConvNCHW16C(in, framework::make_ddim({16, 32, 1, 1}),
+                                 out, ones, zeros, ones, 1));
+  // groups, channels not in blocks of 16 and dilations
+  auto filter = framework::make_ddim({16, 32, 3, 3});
+  EXPECT_FALSE(CanUseConvNCHW16C(in, framework::make_ddim({16, 16, 3, 3}),
+                                 out, ones, ones, ones, 2));
+  EXPECT_FALSE(CanUseConvNCHW16C(framework::make_ddim({1, 24, 8, 8}),
+                                 framework::make_ddim({16, 24, 3, 3}), out,
+                                 ones, ones, ones, 1));
+  EXPECT_FALSE(CanUseConvNCHW16C(in, filter,
+                                 framework::make_ddim({1, 16, 4, 4}), ones,
+                                 zeros, {2, 2}, 1));
+  // no jit code, left to the GEMM
+  EXPECT_FALSE(CanUseConvNCHW16C(in, filter, out, ones, ones, ones, 1));
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,414 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/depthwise_conv.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * The CPU kernels work on one input channel of one image at a time, the
+ * (image, input channel) pairs are split among the threads. The input plane
+ * is copied to a zero padded plane first, with the relu applied if it is
+ * fused, so the inner loops over the output width have no bound checks and
+ * are vectorized by the compiler. The 3x3 and 5x5 filters with stride 1 or 2
+ * are specialized at compile time, the others use the generic loops.
+ */
+struct DepthwiseConvShape {
+  int batch_size;
+  int input_channels;
+  int input_height;
+  int input_width;
+  int output_channels;
+  int output_height;
+  int output_width;
+  int filter_multiplier;
+  int filter_height;
+  int filter_width;
+  int stride_height;
+  int stride_width;
+  int padding_height;
+  int padding_width;
+  int dilation_height;
+  int dilation_width;
+  // the padded input plane
+  int padded_height;
+  int padded_width;
+};
+
+static DepthwiseConvShape GetDepthwiseConvShape(
+    const framework::Tensor& input, const framework::DDim& filter_dims,
+    const framework::DDim& output_dims, const std::vector<int>& strides,
+    const std::vector<int>& paddings, const std::vector<int>& dilations) {
+  PADDLE_ENFORCE_EQ(input.dims().size(), 4,
+                    "The input of depthwise conv should be 4-D NCHW.");
+  PADDLE_ENFORCE_EQ(filter_dims[1], 1,
+                    "The filter of depthwise conv should be [C * M, 1, H, W].");
+  DepthwiseConvShape s;
+  s.batch_size = static_cast<int>(input.dims()[0]);
+  s.input_channels = static_cast<int>(input.dims()[1]);
+  s.input_height = static_cast<int>(input.dims()[2]);
+  s.input_width = static_cast<int>(input.dims()[3]);
+  s.output_channels = static_cast<int>(output_dims[1]);
+  s.output_height = static_cast<int>(output_dims[2]);
+  s.output_width = static_cast<int>(output_dims[3]);
+  PADDLE_ENFORCE_EQ(s.output_channels % s.input_channels, 0,
+                    "The output channels must be a multiple of the input "
+                    "channels");
+  s.filter_multiplier = s.output_channels / s.input_channels;
+  s.filter_height = static_cast<int>(filter_dims[2]);
+  s.filter_width = static_cast<int>(filter_dims[3]);
+  s.stride_height = strides[0];
+  s.stride_width = strides[1];
+  s.padding_height = paddings[0];
+  s.padding_width = paddings[1];
+  s.dilation_height = dilations[0];
+  s.dilation_width = dilations[1];
+  // Large enough for every window of the output, the paddings of the right
+  // and the bottom may be less than the given ones when the stride does not
+  // divide the input.
+  s.padded_height = std::max(
+      s.input_height + 2 * s.padding_height,
+      (s.output_height - 1) * s.stride_height +
+          (s.filter_height - 1) * s.dilation_height + 1);
+  s.padded_width = std::max(
+      s.input_width + 2 * s.padding_width,
+      (s.output_width - 1) * s.stride_width +
+          (s.filter_width - 1) * s.dilation_width + 1);
+  return s;
+}
+
+template <typename T, bool fuse_relu_before_conv>
+static void PadPlane(const DepthwiseConvShape& s, const T* in, T* padded) {
+  std::fill(padded, padded + s.padded_height * s.padded_width, T(0));
+  for (int h = 0; h < s.input_height; ++h) {
+    const T* src = in + h * s.input_width;
+    T* dst = padded + (h + s.padding_height) * s.padded_width + s.padding_width;
+    for (int w = 0; w < s.input_width; ++w) {
+      dst[w] = fuse_relu_before_conv ? std::max(src[w], T(0)) : src[w];
+    }
+  }
+}
+
+// kSize and kStride are the filter size and the stride of both dimensions,
+// or 0 if they are only known at runtime.
+template <typename T, int kSize, int kStride>
+static void DepthwiseConvPlane(const DepthwiseConvShape& s, const T* padded,
+                               const T* filter, T* out) {
+  const int fh = kSize > 0 ? kSize : s.filter_height;
+  const int fw = kSize > 0 ? kSize : s.filter_width;
+  const int sh = kStride > 0 ? kStride : s.stride_height;
+  const int sw = kStride > 0 ? kStride : s.stride_width;
+  const int ow = s.output_width;
+  for (int h = 0; h < s.output_height; ++h) {
+    T* out_row = out + h * ow;
+    std::fill(out_row, out_row + ow, T(0));
+    for (int i = 0; i < fh; ++i) {
+      const T* in_row =
+          padded + (h * sh + i * s.dilation_height) * s.padded_width;
+      for (int j = 0; j < fw; ++j) {
+        const T weight = filter[i * fw + j];
+        const T* in_col = in_row + j * s.dilation_width;
+        for (int w = 0; w < ow; ++w) {
+          out_row[w] += weight * in_col[w * sw];
+        }
+      }
+    }
+  }
+}
+
+// Accumulates the gradient of the padded input plane.
+template <typename T, int kSize, int kStride>
+static void DepthwiseConvInputGradPlane(const DepthwiseConvShape& s,
+                                        const T* filter, const T* output_grad,
+                                        T* padded_grad) {
+  const int fh = kSize > 0 ? kSize : s.filter_height;
+  const int fw = kSize > 0 ? kSize : s.filter_width;
+  const int sh = kStride > 0 ? kStride : s.stride_height;
+  const int sw = kStride > 0 ? kStride : s.stride_width;
+  const int ow = s.output_width;
+  for (int h = 0; h < s.output_height; ++h) {
+    const T* out_row = output_grad + h * ow;
+    for (int i = 0; i < fh; ++i) {
+      T* in_row =
+          padded_grad + (h * sh + i * s.dilation_height) * s.padded_width;
+      for (int j = 0; j < fw; ++j) {
+        const T weight = filter[i * fw + j];
+        T* in_col = in_row + j * s.dilation_width;
+        for (int w = 0; w < ow; ++w) {
+          in_col[w * sw] += weight * out_row[w];
+        }
+      }
+    }
+  }
+}
+
+// Accumulates the products of the output gradient and the padded input of
+// every filter element into acc of [filter_height * filter_width, ow], the
+// reduction over the output width is left to the caller so the inner loop is
+// vectorized.
+template <typename T, int kSize, int kStride>
+static void DepthwiseConvFilterGradPlane(const DepthwiseConvShape& s,
+                                         const T* padded, const T* output_grad,
+                                         T* acc) {
+  const int fh = kSize > 0 ? kSize : s.filter_height;
+  const int fw = kSize > 0 ? kSize : s.filter_width;
+  const int sh = kStride > 0 ? kStride : s.stride_height;
+  const int sw = kStride > 0 ? kStride : s.stride_width;
+  const int ow = s.output_width;
+  for (int h = 0; h < s.output_height; ++h) {
+    const T* out_row = output_grad + h * ow;
+    for (int i = 0; i < fh; ++i) {
+      const T* in_row =
+          padded + (h * sh + i * s.dilation_height) * s.padded_width;
+      for (int j = 0; j < fw; ++j) {
+        const T* in_col = in_row + j * s.dilation_width;
+        T* acc_row = acc + (i * fw + j) * ow;
+        for (int w = 0; w < ow; ++w) {
+          acc_row[w] += out_row[w] * in_col[w * sw];
+        }
+      }
+    }
+  }
+}
+
+// Picks the specialization of the plane function for the filter and strides.
+#define DEPTHWISE_CONV_DISPATCH(func, T, s, ...)                          \
+  do {                                                                    \
+    bool square = (s).filter_height == (s).filter_width &&                \
+                  (s).stride_height == (s).stride_width;                  \
+    int size = square ? (s).filter_height : 0;                            \
+    int stride = square ? (s).stride_height : 0;                          \
+    if (size == 3 && stride == 1) {                                       \
+      func<T, 3, 1>(s, __VA_ARGS__);                                      \
+    } else if (size == 3 && stride == 2) {                                \
+      func<T, 3, 2>(s, __VA_ARGS__);                                      \
+    } else if (size == 5 && stride == 1) {                                \
+      func<T, 5, 1>(s, __VA_ARGS__);                                      \
+    } else if (size == 5 && stride == 2) {                                \
+      func<T, 5, 2>(s, __VA_ARGS__);                                      \
+    } else {                                                              \
+      func<T, 0, 0>(s, __VA_ARGS__);                                      \
+    }                                                                     \
+  } while (0)
+
+template <typename T, bool fuse_relu_before_conv>
+class DepthwiseConvFunctor<platform::CPUDeviceContext, T,
+                           fuse_relu_before_conv> {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& input,
+                  const framework::Tensor& filter,
+                  const std::vector<int>& strides,
+                  const std::vector<int>& paddings,
+                  const std::vector<int>& dilations,
+                  framework::Tensor* output) {
+    auto s = GetDepthwiseConvShape(input, filter.dims(), output->dims(),
+                                   strides, paddings, dilations);
+    const T* input_data = input.data<T>();
+    const T* filter_data = filter.data<T>();
+    T* output_data = output->mutable_data<T>(context.GetPlace());
+    const int64_t in_plane = s.input_height * s.input_width;
+    const int64_t out_plane = s.output_height * s.output_width;
+    const int filter_plane = s.filter_height * s.filter_width;
+    const int64_t planes =
+        static_cast<int64_t>(s.batch_size) * s.input_channels;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+    {
+      std::vector<T> padded(s.padded_height * s.padded_width);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+      for (int64_t p = 0; p < planes; ++p) {
+        PadPlane<T, fuse_relu_before_conv>(s, input_data + p * in_plane,
+                                           padded.data());
+        const int c = static_cast<int>(p % s.input_channels);
+        const int64_t n = p / s.input_channels;
+        for (int m = 0; m < s.filter_multiplier; ++m) {
+          const int oc = c * s.filter_multiplier + m;
+          T* out = output_data + (n * s.output_channels + oc) * out_plane;
+          DEPTHWISE_CONV_DISPATCH(DepthwiseConvPlane, T, s, padded.data(),
+                                  filter_data + oc * filter_plane, out);
+        }
+      }
+    }
+  }
+};
+
+template <typename T, bool fuse_relu_before_conv>
+class DepthwiseConvInputGradFunctor<platform::CPUDeviceContext, T,
+                                    fuse_relu_before_conv> {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& input,
+                  const framework::Tensor& filter,
+                  const framework::Tensor& output_grad,
+                  const std::vector<int>& strides,
+                  const std::vector<int>& paddings,
+                  const std::vector<int>& dilations,
+                  framework::Tensor* input_grad) {
+    auto s = GetDepthwiseConvShape(input, filter.dims(), output_grad.dims(),
+                                   strides, paddings, dilations);
+    const T* input_data = input.data<T>();
+    const T* filter_data = filter.data<T>();
+    const T* output_grad_data = output_grad.data<T>();
+    T* input_grad_data = input_grad->mutable_data<T>(context.GetPlace());
+    const int64_t in_plane = s.input_height * s.input_width;
+    const int64_t out_plane = s.output_height * s.output_width;
+    const int filter_plane = s.filter_height * s.filter_width;
+    const int64_t planes =
+        static_cast<int64_t>(s.batch_size) * s.input_channels;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+    {
+      std::vector<T> padded_grad(s.padded_height * s.padded_width);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+      for (int64_t p = 0; p < planes; ++p) {
+        std::fill(padded_grad.begin(), padded_grad.end(), T(0));
+        const int c = static_cast<int>(p % s.input_channels);
+        const int64_t n = p / s.input_channels;
+        for (int m = 0; m < s.filter_multiplier; ++m) {
+          const int oc = c * s.filter_multiplier + m;
+          const T* out_grad =
+              output_grad_data + (n * s.output_channels + oc) * out_plane;
+          DEPTHWISE_CONV_DISPATCH(DepthwiseConvInputGradPlane, T, s,
+                                  filter_data + oc * filter_plane, out_grad,
+                                  padded_grad.data());
+        }
+
+        const T* in = input_data + p * in_plane;
+        T* in_grad = input_grad_data + p * in_plane;
+        for (int h = 0; h < s.input_height; ++h) {
+          const T* src = padded_grad.data() +
+                         (h + s.padding_height) * s.padded_width +
+                         s.padding_width;
+          const int64_t offset = h * s.input_width;
+          for (int w = 0; w < s.input_width; ++w) {
+            in_grad[offset + w] =
+                fuse_relu_before_conv && in[offset + w] <= T(0) ? T(0)
+                                                                : src[w];
+          }
+        }
+      }
+    }
+  }
+};
+
+template <typename T, bool fuse_relu_before_conv>
+class DepthwiseConvFilterGradFunctor<platform::CPUDeviceContext, T,
+                                     fuse_relu_before_conv> {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& input,
+                  const framework::Tensor& output_grad,
+                  const std::vector<int>& strides,
+                  const std::vector<int>& paddings,
+                  const std::vector<int>& dilations,
+                  framework::Tensor* filter_grad) {
+    auto s = GetDepthwiseConvShape(input, filter_grad->dims(),
+                                   output_grad.dims(), strides, paddings,
+                                   dilations);
+    const T* input_data = input.data<T>();
+    const T* output_grad_data = output_grad.data<T>();
+    T* filter_grad_data = filter_grad->mutable_data<T>(context.GetPlace());
+    const int64_t in_plane = s.input_height * s.input_width;
+    const int64_t out_plane = s.output_height * s.output_width;
+    const int filter_plane = s.filter_height * s.filter_width;
+    const int acc_size = filter_plane * s.output_width;
+
+    // Every thread reduces the whole batch of its channels, so the filter
+    // gradient is written without atomics.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel
+#endif
+    {
+      std::vector<T> padded(s.padded_height * s.padded_width);
+      std::vector<T> acc(s.filter_multiplier * acc_size);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp for
+#endif
+      for (int c = 0; c < s.input_channels; ++c) {
+        std::fill(acc.begin(), acc.end(), T(0));
+        for (int n = 0; n < s.batch_size; ++n) {
+          const int64_t p = static_cast<int64_t>(n) * s.input_channels + c;
+          PadPlane<T, fuse_relu_before_conv>(s, input_data + p * in_plane,
+                                             padded.data());
+          for (int m = 0; m < s.filter_multiplier; ++m) {
+            const int oc = c * s.filter_multiplier + m;
+            const T* out_grad =
+                output_grad_data +
+                (static_cast<int64_t>(n) * s.output_channels + oc) * out_plane;
+            DEPTHWISE_CONV_DISPATCH(DepthwiseConvFilterGradPlane, T, s,
+                                    padded.data(), out_grad,
+                                    acc.data() + m * acc_size);
+          }
+        }
+        for (int m = 0; m < s.filter_multiplier; ++m) {
+          const int oc = c * s.filter_multiplier + m;
+          for (int k = 0; k < filter_plane; ++k) {
+            const T* acc_row = acc.data() + m * acc_size + k * s.output_width;
+            filter_grad_data[oc * filter_plane + k] =
+                std::accumulate(acc_row, acc_row + s.output_width, T(0));
+          }
+        }
+      }
+    }
+  }
+};
+
+#undef DEPTHWISE_CONV_DISPATCH
+
+template class DepthwiseConvFunctor<platform::CPUDeviceContext, float, false>;
+template class DepthwiseConvFunctor<platform::CPUDeviceContext, double, false>;
+
+template class DepthwiseConvInputGradFunctor<platform::CPUDeviceContext, float,
+                                             false>;
+template class DepthwiseConvInputGradFunctor<platform::CPUDeviceContext,
+                                             double, false>;
+
+template class DepthwiseConvFilterGradFunctor<platform::CPUDeviceContext,
+                                              float, false>;
+template class DepthwiseConvFilterGradFunctor<platform::CPUDeviceContext,
+                                              double, false>;
+
+template class DepthwiseConvFunctor<platform::CPUDeviceContext, float, true>;
+template class DepthwiseConvFunctor<platform::CPUDeviceContext, double, true>;
+
+template class DepthwiseConvInputGradFunctor<platform::CPUDeviceContext, float,
+                                             true>;
+template class DepthwiseConvInputGradFunctor<platform::CPUDeviceContext,
+                                             double, true>;
+
+template class DepthwiseConvFilterGradFunctor<platform::CPUDeviceContext,
+                                              float, true>;
+template class DepthwiseConvFilterGradFunctor<platform::CPUDeviceContext,
+                                              double, true>;
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,149 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/depthwise_conv.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static void RandomFill(framework::Tensor* tensor) {
+  static std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  float* data = tensor->data<float>();
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+struct DepthwiseCase {
+  int batch, channels, multiplier, height, width, ksize, stride, padding,
+      dilation;
+};
+
+// Calls fn(input index, filter index, output index) for every product of the
+// depthwise conv.
+template <typename Fn>
+static void ForEachProduct(const DepthwiseCase& c, int oh, int ow, Fn fn) {
+  int oc = c.channels * c.multiplier;
+  for (int n = 0; n < c.batch; ++n) {
+    for (int o = 0; o < oc; ++o) {
+      int i = o / c.multiplier;
+      for (int y = 0; y < oh; ++y) {
+        for (int x = 0; x < ow; ++x) {
+          for (int kh = 0; kh < c.ksize; ++kh) {
+            for (int kw = 0; kw < c.ksize; ++kw) {
+              int ih = y * c.stride + kh * c.dilation - c.padding;
+              int iw = x * c.stride + kw * c.dilation - c.padding;
+              if (ih < 0 || ih >= c.height || iw < 0 || iw >= c.width) {
+                continue;
+              }
+              fn(((n * c.channels + i) * c.height + ih) * c.width + iw,
+                 (o * c.ksize + kh) * c.ksize + kw,
+                 ((n * oc + o) * oh + y) * ow + x);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <bool fuse_relu>
+static void TestDepthwiseConv(const DepthwiseCase& c) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext context(place);
+  int oc = c.channels * c.multiplier;
+  int oh = (c.height + 2 * c.padding - (c.dilation * (c.ksize - 1) + 1)) /
+               c.stride +
+           1;
+  int ow = (c.width + 2 * c.padding - (c.dilation * (c.ksize - 1) + 1)) /
+               c.stride +
+           1;
+  std::vector<int> strides = {c.stride, c.stride};
+  std::vector<int> paddings = {c.padding, c.padding};
+  std::vector<int> dilations = {c.dilation, c.dilation};
+
+  framework::Tensor input, filter, output, output_grad, input_grad,
+      filter_grad;
+  input.mutable_data<float>({c.batch, c.channels, c.height, c.width}, place);
+  filter.mutable_data<float>({oc, 1, c.ksize, c.ksize}, place);
+  output.mutable_data<float>({c.batch, oc, oh, ow}, place);
+  output_grad.mutable_data<float>({c.batch, oc, oh, ow}, place);
+  input_grad.mutable_data<float>(input.dims(), place);
+  filter_grad.mutable_data<float>(filter.dims(), place);
+  RandomFill(&input);
+  RandomFill(&filter);
+  RandomFill(&output_grad);
+
+  DepthwiseConvFunctor<platform::CPUDeviceContext, float, fuse_relu> conv;
+  conv(context, input, filter, strides, paddings, dilations, &output);
+  DepthwiseConvInputGradFunctor<platform::CPUDeviceContext, float, fuse_relu>
+      conv_input_grad;
+  conv_input_grad(context, input, filter, output_grad, strides, paddings,
+                  dilations, &input_grad);
+  DepthwiseConvFilterGradFunctor<platform::CPUDeviceContext, float, fuse_relu>
+      conv_filter_grad;
+  conv_filter_grad(context, input, output_grad, strides, paddings, dilations,
+                   &filter_grad);
+
+  const float* x = input.data<float>();
+  const float* w = filter.data<float>();
+  const float* dy = output_grad.data<float>();
+  auto relu = [](float v) { return fuse_relu ? std::max(v, 0.f) : v; };
+  std::vector<float> y(output.numel(), 0.f), dx(input.numel(), 0.f),
+      dw(filter.numel(), 0.f);
+  ForEachProduct(c, oh, ow, [&](int xi, int wi, int yi) {
+    y[yi] += relu(x[xi]) * w[wi];
+    dx[xi] += dy[yi] * w[wi];
+    dw[wi] += dy[yi] * relu(x[xi]);
+  });
+  if (fuse_relu) {
+    for (int64_t i = 0; i < input.numel(); ++i) {
+      if (x[i] <= 0.f) dx[i] = 0.f;
+    }
+  }
+
+  for (int64_t i = 0; i < output.numel(); ++i) {
+    ASSERT_NEAR(output.data<float>()[i], y[i], 1e-4) << i;
+  }
+  for (int64_t i = 0; i < input.numel(); ++i) {
+    ASSERT_NEAR(input_grad.data<float>()[i], dx[i], 1e-4) << i;
+  }
+  for (int64_t i = 0; i < filter.numel(); ++i) {
+    ASSERT_NEAR(filter_grad.data<float>()[i], dw[i], 1e-3) << i;
+  }
+}
+
+TEST(DepthwiseConv, cpu) {
+  // batch, channels, multiplier, height, width, ksize, stride, padding,
+  // dilation
+  std::vector<DepthwiseCase> cases = {
+      {2, 8, 1, 14, 14, 3, 1, 1, 1}, {2, 8, 1, 15, 13, 3, 2, 1, 1},
+      {1, 4, 1, 17, 16, 5, 1, 2, 1}, {2, 4, 1, 16, 17, 5, 2, 2, 1},
+      {1, 3, 2, 12, 12, 3, 1, 2, 2}, {1, 3, 1, 11, 9, 3, 2, 2, 2},
+      {2, 3, 2, 9, 10, 7, 3, 3, 1},  {1, 2, 1, 8, 8, 3, 1, 0, 1}};
+  for (auto& c : cases) {
+    TestDepthwiseConv<false>(c);
+    TestDepthwiseConv<true>(c);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,201 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/embedding_gather.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+using framework::proto::VarType;
+
+// The rows are prefetched kPrefetchDistance rows ahead, at most
+// kPrefetchBytes of a row.
+static constexpr int64_t kPrefetchDistance = 8;
+static constexpr int64_t kPrefetchBytes = 512;
+// The lookups of fewer elements are not worth the OpenMP threads.
+static constexpr int64_t kParallelElements = 32 * 1024;
+
+static inline void PrefetchRow(const char* row, int64_t bytes) {
+#if defined(__GNUC__)
+  bytes = std::min(bytes, kPrefetchBytes);
+  for (int64_t offset = 0; offset < bytes; offset += 64) {
+    __builtin_prefetch(row + offset);
+  }
+#endif
+}
+
+void DeduplicateIds(const int64_t* ids, int64_t num, int64_t padding_idx,
+                    DedupIds* dedup) {
+  dedup->unique.clear();
+  dedup->index.resize(num);
+  std::unordered_map<int64_t, int64_t> positions;
+  positions.reserve(num);
+  for (int64_t i = 0; i < num; ++i) {
+    if (padding_idx != -1 && ids[i] == padding_idx) {
+      dedup->index[i] = -1;
+      continue;
+    }
+    auto iter = positions.emplace(ids[i], dedup->unique.size());
+    if (iter.second) {
+      dedup->unique.push_back(ids[i]);
+    }
+    dedup->index[i] = iter.first->second;
+  }
+}
+
+// Gathers the rows of type S converted to T by convert(src, row, out).
+template <typename T, typename S, typename Convert>
+static void GatherRowsImpl(const S* table, int64_t width, const int64_t* rows,
+                           int64_t num, T* out, Convert convert) {
+  const char* base = reinterpret_cast<const char*>(table);
+  int64_t row_bytes = width * sizeof(S);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num * width >= kParallelElements)
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    if (i + kPrefetchDistance < num) {
+      PrefetchRow(base + rows[i + kPrefetchDistance] * row_bytes, row_bytes);
+    }
+    convert(table + rows[i] * width, rows[i], out + i * width);
+  }
+}
+
+template <typename T>
+static void GatherPlainRows(const EmbeddingTable& table, const int64_t* rows,
+                            int64_t num, T* out) {
+  int64_t width = table.width;
+  GatherRowsImpl(static_cast<const T*>(table.data), width, rows, num, out,
+                 [width](const T* src, int64_t row, T* dst) {
+                   std::memcpy(dst, src, width * sizeof(T));
+                 });
+}
+
+void GatherRows(const EmbeddingTable& table, const int64_t* rows, int64_t num,
+                float* out) {
+  int64_t width = table.width;
+  switch (table.dtype) {
+    case VarType::FP32:
+      GatherPlainRows<float>(table, rows, num, out);
+      break;
+    case VarType::FP16:
+      GatherRowsImpl(static_cast<const platform::float16*>(table.data), width,
+                     rows, num, out,
+                     [width](const platform::float16* src, int64_t row,
+                             float* dst) {
+                       for (int64_t j = 0; j < width; ++j) {
+                         dst[j] = static_cast<float>(src[j]);
+                       }
+                     });
+      break;
+    case VarType::INT8: {
+      PADDLE_ENFORCE_NOT_NULL(table.scales,
+                              "The int8 table needs the per-row scales.");
+      const float* scales = table.scales;
+      GatherRowsImpl(static_cast<const int8_t*>(table.data), width, rows, num,
+                     out,
+                     [width, scales](const int8_t* src, int64_t row,
+                                     float* dst) {
+                       float scale = scales[row];
+                       for (int64_t j = 0; j < width; ++j) {
+                         dst[j] = src[j] * scale;
+                       }
+                     });
+      break;
+    }
+    default:
+      PADDLE_THROW("The table of type %d cannot be looked up as float.",
+                   static_cast<int>(table.dtype));
+  }
+}
+
+void GatherRows(const EmbeddingTable& table, const int64_t* rows, int64_t num,
+                double* out) {
+  PADDLE_ENFORCE(table.dtype == VarType::FP64,
+                 "The table of type %d cannot be looked up as double.",
+                 static_cast<int>(table.dtype));
+  GatherPlainRows<double>(table, rows, num, out);
+}
+
+template <typename T>
+void ScatterRows(const T* in, const int64_t* index, int64_t num, int64_t width,
+                 T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num * width >= kParallelElements)
+#endif
+  for (int64_t i = 0; i < num; ++i) {
+    if (index[i] < 0) {
+      std::memset(out + i * width, 0, width * sizeof(T));
+    } else {
+      std::memcpy(out + i * width, in + index[i] * width, width * sizeof(T));
+    }
+  }
+}
+
+template <typename T>
+void MergeRows(const T* in, const int64_t* index, int64_t num, int64_t width,
+               int64_t unique_num, const int64_t* out_rows, T* out) {
+  // the positions of every unique row in ascending order, so the sums are
+  // accumulated in the same order as the serial loop
+  std::vector<int64_t> offsets(unique_num + 1, 0);
+  for (int64_t i = 0; i < num; ++i) {
+    if (index[i] >= 0) ++offsets[index[i] + 1];
+  }
+  for (int64_t u = 0; u < unique_num; ++u) {
+    offsets[u + 1] += offsets[u];
+  }
+  std::vector<int64_t> positions(offsets[unique_num]);
+  std::vector<int64_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (int64_t i = 0; i < num; ++i) {
+    if (index[i] >= 0) positions[cursor[index[i]]++] = i;
+  }
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (num * width >= kParallelElements)
+#endif
+  for (int64_t u = 0; u < unique_num; ++u) {
+    T* dst = out + (out_rows != nullptr ? out_rows[u] : u) * width;
+    if (offsets[u] == offsets[u + 1]) {
+      std::memset(dst, 0, width * sizeof(T));
+      continue;
+    }
+    std::memcpy(dst, in + positions[offsets[u]] * width, width * sizeof(T));
+    for (int64_t k = offsets[u] + 1; k < offsets[u + 1]; ++k) {
+      const T* src = in + positions[k] * width;
+      for (int64_t j = 0; j < width; ++j) {
+        dst[j] += src[j];
+      }
+    }
+  }
+}
+
+template void ScatterRows<float>(const float*, const int64_t*, int64_t,
+                                 int64_t, float*);
+template void ScatterRows<double>(const double*, const int64_t*, int64_t,
+                                  int64_t, double*);
+template void MergeRows<float>(const float*, const int64_t*, int64_t, int64_t,
+                               int64_t, const int64_t*, float*);
+template void MergeRows<double>(const double*, const int64_t*, int64_t,
+                                int64_t, int64_t, const int64_t*, double*);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,74 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#pragma once
+
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// The CPU embedding lookup of lookup_table. A batch of CTR models repeats a
+// few hot ids many times, so the ids are deduplicated first, the unique rows
+// are gathered (and dequantized) once in parallel, then scattered to the
+// positions of the ids.
+
+// The ids deduplicated in the order of their first occurrence.
+struct DedupIds {
+  // the unique ids
+  std::vector<int64_t> unique;
+  // index[i] is the position of the i-th id in unique, -1 for padding_idx
+  std::vector<int64_t> index;
+};
+
+// Deduplicates ids. The ids equal to padding_idx are not in unique, unless
+// padding_idx is -1.
+void DeduplicateIds(const int64_t* ids, int64_t num, int64_t padding_idx,
+                    DedupIds* dedup);
+
+// The rows of a table stored as fp32/fp64, or compressed as fp16 or as int8
+// with a scale per row: row i is data[i] * scales[i].
+struct EmbeddingTable {
+  const void* data;
+  framework::proto::VarType::Type dtype;
+  // the per-row scales of an int8 table, nullptr otherwise
+  const float* scales;
+  int64_t width;
+};
+
+// out[i] = table row rows[i] of width elements, the rows are fetched by the
+// OpenMP threads with software prefetch. A compressed table is dequantized
+// to float.
+void GatherRows(const EmbeddingTable& table, const int64_t* rows, int64_t num,
+                float* out);
+void GatherRows(const EmbeddingTable& table, const int64_t* rows, int64_t num,
+                double* out);
+
+// out[i] = in[index[i]], or zeros if index[i] is -1.
+template <typename T>
+void ScatterRows(const T* in, const int64_t* index, int64_t num, int64_t width,
+                 T* out);
+
+// The gradient of the gather: out row out_rows[u] (or u if out_rows is
+// nullptr) = the sum of the rows in[i] with index[i] == u. Every out row is
+// written by one thread, the rows of index -1 are skipped.
+template <typename T>
+void MergeRows(const T* in, const int64_t* index, int64_t num, int64_t width,
+               int64_t unique_num, const int64_t* out_rows, T* out);
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
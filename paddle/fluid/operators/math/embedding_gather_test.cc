@@ -0,0 +1,149 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/embedding_gather.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+using framework::proto::VarType;
+
+TEST(embedding_gather, deduplicate_ids) {
+  std::vector<int64_t> ids{5, 3, 5, 0, 7, 3, 0, 5};
+  DedupIds dedup;
+  DeduplicateIds(ids.data(), ids.size(), -1, &dedup);
+  EXPECT_EQ(dedup.unique, (std::vector<int64_t>{5, 3, 0, 7}));
+  EXPECT_EQ(dedup.index, (std::vector<int64_t>{0, 1, 0, 2, 3, 1, 2, 0}));
+
+  // padding_idx 0 is not looked up
+  DeduplicateIds(ids.data(), ids.size(), 0, &dedup);
+  EXPECT_EQ(dedup.unique, (std::vector<int64_t>{5, 3, 7}));
+  EXPECT_EQ(dedup.index, (std::vector<int64_t>{0, 1, 0, -1, 2, 1, -1, 0}));
+}
+
+TEST(embedding_gather, gather_and_scatter) {
+  const int64_t height = 1000, width = 37, num = 50000;
+  std::mt19937 rng(7);
+  std::vector<float> table(height * width);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (auto& v : table) v = dist(rng);
+  // the skewed ids of a CTR batch
+  std::vector<int64_t> ids(num);
+  std::geometric_distribution<int64_t> id_dist(0.05);
+  for (auto& id : ids) id = std::min<int64_t>(id_dist(rng), height - 1);
+
+  DedupIds dedup;
+  DeduplicateIds(ids.data(), num, 1, &dedup);
+  EmbeddingTable fp32{table.data(), VarType::FP32, nullptr, width};
+  std::vector<float> rows(dedup.unique.size() * width);
+  GatherRows(fp32, dedup.unique.data(), dedup.unique.size(), rows.data());
+  std::vector<float> out(num * width, -1.f);
+  ScatterRows(rows.data(), dedup.index.data(), num, width, out.data());
+  for (int64_t i = 0; i < num; ++i) {
+    for (int64_t j = 0; j < width; ++j) {
+      float expected = ids[i] == 1 ? 0.f : table[ids[i] * width + j];
+      ASSERT_EQ(out[i * width + j], expected);
+    }
+  }
+
+  // float16 and int8 with the per-row scales
+  std::vector<platform::float16> table_fp16(table.size());
+  std::vector<int8_t> table_int8(table.size());
+  std::vector<float> scales(height);
+  for (int64_t r = 0; r < height; ++r) {
+    float max_abs = 0.f;
+    for (int64_t j = 0; j < width; ++j) {
+      max_abs = std::max(max_abs, std::abs(table[r * width + j]));
+    }
+    scales[r] = max_abs / 127.f;
+    for (int64_t j = 0; j < width; ++j) {
+      table_fp16[r * width + j] =
+          static_cast<platform::float16>(table[r * width + j]);
+      table_int8[r * width + j] =
+          static_cast<int8_t>(std::round(table[r * width + j] / scales[r]));
+    }
+  }
+  EmbeddingTable fp16{table_fp16.data(), VarType::FP16, nullptr, width};
+  EmbeddingTable int8{table_int8.data(), VarType::INT8, scales.data(), width};
+  std::vector<float> out_fp16(num * width), out_int8(num * width);
+  GatherRows(fp16, ids.data(), num, out_fp16.data());
+  GatherRows(int8, ids.data(), num, out_int8.data());
+  for (int64_t i = 0; i < num; ++i) {
+    int64_t r = ids[i];
+    for (int64_t j = 0; j < width; ++j) {
+      float expected = table[r * width + j];
+      ASSERT_NEAR(out_fp16[i * width + j], expected, 1e-3);
+      ASSERT_NEAR(out_int8[i * width + j], expected, scales[r] * 0.5f + 1e-6);
+    }
+  }
+
+  std::vector<double> out_double(width);
+  EXPECT_THROW(GatherRows(fp16, ids.data(), 1, out_double.data()),
+               platform::EnforceNotMet);
+  EmbeddingTable no_scales{table_int8.data(), VarType::INT8, nullptr, width};
+  EXPECT_THROW(GatherRows(no_scales, ids.data(), 1, out_int8.data()),
+               platform::EnforceNotMet);
+}
+
+TEST(embedding_gather, merge_rows) {
+  const int64_t height = 20, width = 9;
+  std::vector<int64_t> ids{3, 7, 3, 0, 3, 7, 12, 0, 3};
+  const int64_t num = ids.size();
+  std::vector<double> grad(num * width);
+  for (size_t k = 0; k < grad.size(); ++k) grad[k] = 0.25 * k;
+
+  // the dense gradient skipping padding_idx 0
+  DedupIds dedup;
+  DeduplicateIds(ids.data(), num, 0, &dedup);
+  std::vector<double> table_grad(height * width, 0.);
+  MergeRows(grad.data(), dedup.index.data(), num, width, dedup.unique.size(),
+            dedup.unique.data(), table_grad.data());
+  std::vector<double> expected(height * width, 0.);
+  for (int64_t i = 0; i < num; ++i) {
+    if (ids[i] == 0) continue;
+    for (int64_t j = 0; j < width; ++j) {
+      expected[ids[i] * width + j] += grad[i * width + j];
+    }
+  }
+  EXPECT_EQ(table_grad, expected);
+
+  // the merged rows of a SelectedRows gradient
+  DeduplicateIds(ids.data(), num, -1, &dedup);
+  std::vector<double> value(dedup.unique.size() * width);
+  MergeRows(grad.data(), dedup.index.data(), num, width, dedup.unique.size(),
+            nullptr, value.data());
+  for (size_t u = 0; u < dedup.unique.size(); ++u) {
+    for (int64_t j = 0; j < width; ++j) {
+      double sum = 0.;
+      for (int64_t i = 0; i < num; ++i) {
+        if (ids[i] == dedup.unique[u]) sum += grad[i * width + j];
+      }
+      EXPECT_EQ(value[u * width + j], sum);
+    }
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -500,7 +500,7 @@ class AdamOpKernel : public framework::OpKernel<T> {
           for (size_t i = 0; i < grad_rows.size(); ++i) {
             row_id_to_grad_row_offset[grad_rows[i]] = i;
           }
-          std::vector<std::future<void>> fs;
+          framework::TaskGroup group;
           int64_t line_in_each_thread =
               param_row_count / FLAGS_inner_op_parallelism + 1;
           for (int i = 0; i < FLAGS_inner_op_parallelism; ++i) {
@@ -512,28 +512,31 @@ class AdamOpKernel : public framework::OpKernel<T> {
             if (end > static_cast<int64_t>(param_row_count)) {
               end = static_cast<int64_t>(param_row_count);
             }
-            fs.push_back(
-                framework::Async([&functor, &row_id_to_grad_row_offset,
-                                  &grad_data, row_numel, start, end]() {
-                  for (int64_t row_id = start; row_id < end; ++row_id) {
-                    auto iter = row_id_to_grad_row_offset.find(row_id);
-                    if (iter != row_id_to_grad_row_offset.end()) {
-                      for (size_t row_offset = 0U; row_offset < row_numel;
-                           ++row_offset) {
-                        functor.adam_update(
-                            row_id * row_numel + row_offset,
-                            grad_data[iter->second * row_numel + row_offset]);
-                      }
-                    } else {
-                      for (size_t row_offset = 0U; row_offset < row_numel;
-                           ++row_offset) {
-                        functor.adam_update(row_id * row_numel + row_offset, 0);
-                      }
-                    }
+            auto update_rows = [&functor, &row_id_to_grad_row_offset,
+                                &grad_data, row_numel, start, end]() {
+              for (int64_t row_id = start; row_id < end; ++row_id) {
+                auto iter = row_id_to_grad_row_offset.find(row_id);
+                if (iter != row_id_to_grad_row_offset.end()) {
+                  for (size_t row_offset = 0U; row_offset < row_numel;
+                       ++row_offset) {
+                    functor.adam_update(
+                        row_id * row_numel + row_offset,
+                        grad_data[iter->second * row_numel + row_offset]);
                   }
-                }));
+                } else {
+                  for (size_t row_offset = 0U; row_offset < row_numel;
+                       ++row_offset) {
+                    functor.adam_update(row_id * row_numel + row_offset, 0);
+                  }
+                }
+              }
+            };
+            framework::Async(update_rows, &group);
+          }
+          auto ex = group.Wait();
+          if (ex != nullptr) {
+            throw *ex;
           }
-          for (size_t i = 0; i < fs.size(); ++i) fs[i].wait();
         }
 #endif          // !_WIN32
         else {  // NOLINT
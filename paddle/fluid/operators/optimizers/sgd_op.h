@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <type_traits>
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
@@ -114,6 +115,19 @@ class SGDOpKernel : public framework::OpKernel<T> {
 
       const auto *lr = learning_rate->data<T>();
       const auto *grad_data = grad.value().data<T>();
+      auto table = param_out->sharded_table();
+      if (table != nullptr) {
+        PADDLE_ENFORCE((std::is_same<T, float>::value),
+                       "The sharded table only supports FP32");
+        // the ids not admitted into the table are skipped
+        table->Update(grad.rows().data(), grad.rows().size(),
+                      [&](size_t i, float *row) {
+                        for (int64_t j = 0; j < grad_row_width; j++) {
+                          row[j] -= lr[0] * grad_data[i * grad_row_width + j];
+                        }
+                      });
+        return;
+      }
       auto *out_data = param_out->mutable_value()->data<T>();
       for (size_t i = 0; i < grad.rows().size(); i++) {
         int64_t id_index = param_out->AutoGrownIndex(grad.rows()[i], false);
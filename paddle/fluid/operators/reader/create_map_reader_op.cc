@@ -0,0 +1,153 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/ordered_map_reader.h"
+#include "paddle/fluid/operators/reader/reader_op_registry.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+static std::vector<std::unique_ptr<ReaderTransform>> CreateTransforms(
+    const std::vector<std::string>& specs) {
+  std::vector<std::unique_ptr<ReaderTransform>> transforms;
+  for (auto& spec : specs) {
+    transforms.emplace_back(CreateReaderTransform(spec));
+  }
+  return transforms;
+}
+
+class CreateMapReaderOp : public framework::OperatorBase {
+ public:
+  using framework::OperatorBase::OperatorBase;
+
+ private:
+  void RunImpl(const framework::Scope& scope,
+               const platform::Place& dev_place) const override {
+    auto* out = scope.FindVar(Output("Out"))
+                    ->template GetMutable<framework::ReaderHolder>();
+    if (out->Get() != nullptr) {
+      return;
+    }
+    const auto& underlying_reader = scope.FindVar(Input("UnderlyingReader"))
+                                        ->Get<framework::ReaderHolder>();
+    out->Reset(framework::MakeDecoratedReader<OrderedMapReader>(
+        underlying_reader,
+        CreateTransforms(Attr<std::vector<std::string>>("sample_transforms")),
+        static_cast<size_t>(Attr<int>("batch_size")),
+        CreateTransforms(Attr<std::vector<std::string>>("batch_transforms")),
+        static_cast<size_t>(Attr<int>("num_workers")),
+        static_cast<size_t>(Attr<int>("buffer_size"))));
+  }
+};
+
+class CreateMapReaderOpMaker : public DecoratedReaderMakerBase {
+ protected:
+  void Apply() override {
+    AddAttr<std::vector<std::string>>(
+        "sample_transforms",
+        "The reader transforms applied to every sample in order, each is a "
+        "registered name with optional attributes, like "
+        "'normalize:slot=0;mean=0.5;std=0.25'.")
+        .SetDefault({});
+    AddAttr<int>("batch_size",
+                 "The number of samples merged to a batch, no merging if 1.")
+        .SetDefault(1)
+        .GreaterThan(0);
+    AddAttr<std::vector<std::string>>(
+        "batch_transforms",
+        "The reader transforms applied to every batch in order, like "
+        "'sequence_pad:slot=1;append_length=1'.")
+        .SetDefault({});
+    AddAttr<int>("num_workers", "The number of the worker threads.")
+        .SetDefault(4)
+        .GreaterThan(0);
+    AddAttr<int>("buffer_size",
+                 "The maximum number of batches read but not consumed.")
+        .SetDefault(16)
+        .GreaterThan(0);
+    AddAttr<std::vector<int>>("shape_concat",
+                              "The shapes of the outputs if the transforms "
+                              "change them, all the shapes concatenated.")
+        .SetDefault({});
+    AddAttr<std::vector<int>>("ranks", "The ranks of the output shapes.")
+        .SetDefault({});
+    AddAttr<std::vector<int>>("lod_levels", "The LoD levels of the outputs.")
+        .SetDefault({});
+    AddAttr<std::vector<int>>("dtypes", "The data types of the outputs.")
+        .SetDefault({});
+    AddComment(R"DOC(
+      CreateMapReader Operator
+
+      A map reader applies the registered C++ reader transforms, like
+      normalize and sequence_pad, to the data of its underlying reader on
+      several worker threads, optionally merging the samples to batches. The
+      order of the data is kept and at most buffer_size batches are buffered.
+      If the transforms change the outputs, shape_concat, ranks, lod_levels
+      and dtypes describe the new outputs, otherwise they are the outputs of
+      the underlying reader.
+    )DOC");
+  }
+};
+
+class MapReaderInferShape : public framework::InferShapeBase {
+ public:
+  void operator()(framework::InferShapeContext* ctx) const override {
+    const auto shape_concat =
+        ctx->Attrs().Get<std::vector<int>>("shape_concat");
+    if (shape_concat.empty()) {
+      DecoratedReaderInferShape()(ctx);
+      return;
+    }
+    const auto ranks = ctx->Attrs().Get<std::vector<int>>("ranks");
+    const auto lod_levels = ctx->Attrs().Get<std::vector<int>>("lod_levels");
+    std::vector<framework::DDim> shapes = RestoreShapes(shape_concat, ranks);
+    PADDLE_ENFORCE_EQ(lod_levels.size(), shapes.size(),
+                      "The number of 'lod_levels'(%d) doesn't match the number "
+                      "of 'shapes'(%d).",
+                      lod_levels.size(), shapes.size());
+    ctx->SetReaderDims("Out", shapes);
+    framework::VarDesc* reader =
+        boost::get<framework::VarDesc*>(ctx->GetOutputVarPtrs("Out")[0]);
+    reader->SetLoDLevels(lod_levels);
+  }
+};
+
+class MapReaderInferVarType : public framework::VarTypeInference {
+ public:
+  void operator()(framework::InferVarTypeContext* ctx) const override {
+    auto dtypes = boost::get<std::vector<int>>(ctx->GetAttr("dtypes"));
+    if (dtypes.empty()) {
+      DecoratedReaderInferVarType()(ctx);
+      return;
+    }
+    const std::string& out_reader_name = ctx->Output("Out")[0];
+    ctx->SetType(out_reader_name, framework::proto::VarType::READER);
+    std::vector<framework::proto::VarType::Type> types;
+    for (int dtype : dtypes) {
+      types.push_back(static_cast<framework::proto::VarType::Type>(dtype));
+    }
+    ctx->SetDataTypes(out_reader_name, types);
+  }
+};
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators::reader;
+REGISTER_OPERATOR(create_map_reader, ops::CreateMapReaderOp,
+                  ops::CreateMapReaderOpMaker, ops::MapReaderInferShape,
+                  ops::MapReaderInferVarType,
+                  paddle::framework::EmptyGradOpMaker);
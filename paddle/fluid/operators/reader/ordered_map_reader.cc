@@ -0,0 +1,169 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/ordered_map_reader.h"
+#include <utility>
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+OrderedMapReader::OrderedMapReader(
+    const std::shared_ptr<framework::ReaderBase>& reader,
+    std::vector<std::unique_ptr<ReaderTransform>> sample_transforms,
+    size_t batch_size,
+    std::vector<std::unique_ptr<ReaderTransform>> batch_transforms,
+    size_t num_workers, size_t buffer_size)
+    : framework::DecoratedReader(reader),
+      sample_transforms_(std::move(sample_transforms)),
+      batch_size_(batch_size),
+      batch_transforms_(std::move(batch_transforms)),
+      num_workers_(num_workers),
+      buffer_size_(buffer_size) {
+  PADDLE_ENFORCE_GT(batch_size_, 0UL);
+  PADDLE_ENFORCE_GT(num_workers_, 0UL);
+  PADDLE_ENFORCE_GT(buffer_size_, 0UL);
+  StartWorkers();
+}
+
+OrderedMapReader::~OrderedMapReader() { StopWorkers(); }
+
+void OrderedMapReader::StartWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_read_ = 0;
+    next_output_ = 0;
+    end_ = std::numeric_limits<uint64_t>::max();
+    reorder_buffer_.clear();
+    stopping_ = false;
+  }
+  for (size_t i = 0; i < num_workers_; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+void OrderedMapReader::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  consumed_cv_.notify_all();
+  // Wakes up the workers blocking in the underlying reader.
+  reader_->Shutdown();
+  for (auto& worker : workers_) worker.join();
+  workers_.clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  reorder_buffer_.clear();
+}
+
+void OrderedMapReader::ShutdownImpl() { StopWorkers(); }
+
+void OrderedMapReader::StartImpl() {
+  reader_->Start();
+  StartWorkers();
+}
+
+void OrderedMapReader::WorkerLoop() {
+  while (true) {
+    uint64_t id;
+    std::vector<std::vector<framework::LoDTensor>> samples;
+    Result result;
+    {
+      std::lock_guard<std::mutex> read_lock(read_mutex_);
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        consumed_cv_.wait(lock, [this] {
+          return stopping_ || next_read_ < next_output_ + buffer_size_;
+        });
+        if (stopping_ || next_read_ >= end_) return;
+        id = next_read_++;
+      }
+      try {
+        for (size_t i = 0; i < batch_size_; ++i) {
+          std::vector<framework::LoDTensor> sample;
+          reader_->ReadNext(&sample);
+          if (sample.empty()) break;
+          samples.push_back(std::move(sample));
+        }
+      } catch (...) {
+        result.error = std::current_exception();
+      }
+      if (samples.empty() || result.error) {
+        // Ends the data after the error, or at the read without data.
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (result.error) {
+          reorder_buffer_[id] = std::move(result);
+          end_ = id + 1;
+        } else {
+          end_ = id;
+        }
+        produced_cv_.notify_all();
+        return;
+      }
+    }
+
+    try {
+      Transform(&samples, &result.data);
+    } catch (...) {
+      result.error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    reorder_buffer_[id] = std::move(result);
+    produced_cv_.notify_all();
+  }
+}
+
+void OrderedMapReader::Transform(
+    std::vector<std::vector<framework::LoDTensor>>* samples,
+    std::vector<framework::LoDTensor>* out) const {
+  for (auto& sample : *samples) {
+    for (auto& transform : sample_transforms_) {
+      transform->Apply(&sample);
+    }
+  }
+  if (batch_size_ == 1) {
+    *out = std::move(samples->front());
+  } else {
+    MergeSamples(*samples, out);
+  }
+  for (auto& transform : batch_transforms_) {
+    transform->Apply(out);
+  }
+}
+
+void OrderedMapReader::ReadNextImpl(std::vector<framework::LoDTensor>* out) {
+  out->clear();
+  Result result;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    produced_cv_.wait(lock, [this] {
+      return next_output_ >= end_ || reorder_buffer_.count(next_output_);
+    });
+    auto it = reorder_buffer_.find(next_output_);
+    if (it == reorder_buffer_.end()) {
+      // There is no next data.
+      return;
+    }
+    result = std::move(it->second);
+    reorder_buffer_.erase(it);
+    ++next_output_;
+  }
+  consumed_cv_.notify_all();
+  if (result.error) std::rethrow_exception(result.error);
+  *out = std::move(result.data);
+}
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,95 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/operators/reader/reader_transform.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+/*
+ * A decorated reader transforming the data of its underlying reader on
+ * several worker threads, keeping the order of the data.
+ *
+ * A worker reads `batch_size` samples from the underlying reader, applies
+ * the sample transforms to each of them, merges them to a batch (see
+ * MergeSamples) if batch_size > 1 and applies the batch transforms. The
+ * reads are serialized and numbered, and the results wait in a reorder
+ * buffer until all the former ones are consumed. At most `buffer_size`
+ * batches are read but not consumed, bounding the memory.
+ */
+class OrderedMapReader : public framework::DecoratedReader {
+ public:
+  OrderedMapReader(
+      const std::shared_ptr<framework::ReaderBase>& reader,
+      std::vector<std::unique_ptr<ReaderTransform>> sample_transforms,
+      size_t batch_size,
+      std::vector<std::unique_ptr<ReaderTransform>> batch_transforms,
+      size_t num_workers, size_t buffer_size);
+
+  ~OrderedMapReader() override;
+
+ protected:
+  void ReadNextImpl(std::vector<framework::LoDTensor>* out) override;
+  void ShutdownImpl() override;
+  void StartImpl() override;
+
+ private:
+  struct Result {
+    std::vector<framework::LoDTensor> data;
+    std::exception_ptr error;
+  };
+
+  void StartWorkers();
+  void StopWorkers();
+  void WorkerLoop();
+  void Transform(std::vector<std::vector<framework::LoDTensor>>* samples,
+                 std::vector<framework::LoDTensor>* out) const;
+
+  std::vector<std::unique_ptr<ReaderTransform>> sample_transforms_;
+  size_t batch_size_;
+  std::vector<std::unique_ptr<ReaderTransform>> batch_transforms_;
+  size_t num_workers_;
+  size_t buffer_size_;
+
+  // Serializes the reads of the underlying reader with their numbering.
+  std::mutex read_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable produced_cv_;
+  std::condition_variable consumed_cv_;
+  uint64_t next_read_{0};
+  uint64_t next_output_{0};
+  // The number of the first read without data.
+  uint64_t end_{std::numeric_limits<uint64_t>::max()};
+  std::map<uint64_t, Result> reorder_buffer_;
+  bool stopping_{false};
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
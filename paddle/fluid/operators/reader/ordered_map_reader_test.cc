@@ -0,0 +1,202 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/ordered_map_reader.h"
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+using paddle::framework::LoDTensor;
+using paddle::framework::make_ddim;
+using paddle::operators::reader::CreateReaderTransform;
+using paddle::operators::reader::OrderedMapReader;
+using paddle::operators::reader::ReaderTransform;
+using paddle::operators::reader::ReaderTransformAttrs;
+using paddle::platform::CPUPlace;
+
+// Reads `num` samples, the i-th one has a dense float slot of [3] filled
+// with i and a sequence of i % 3 + 1 int64 values i.
+class CountingReader : public paddle::framework::ReaderBase {
+ public:
+  explicit CountingReader(int num) : num_(num) {}
+
+  int reads() const { return reads_; }
+
+ protected:
+  void ReadNextImpl(std::vector<LoDTensor>* out) override {
+    out->clear();
+    ++reads_;
+    if (next_ >= num_) return;
+    int i = next_++;
+    LoDTensor dense;
+    float* dense_data = dense.mutable_data<float>(make_ddim({3}), CPUPlace());
+    std::fill(dense_data, dense_data + 3, static_cast<float>(i));
+    LoDTensor seq;
+    int len = i % 3 + 1;
+    int64_t* seq_data =
+        seq.mutable_data<int64_t>(make_ddim({len, 1}), CPUPlace());
+    std::fill(seq_data, seq_data + len, i);
+    seq.set_lod({{0, static_cast<size_t>(len)}});
+    out->push_back(std::move(dense));
+    out->push_back(std::move(seq));
+  }
+
+  void StartImpl() override { next_ = 0; }
+
+ private:
+  int num_;
+  int next_{0};
+  std::atomic<int> reads_{0};
+};
+
+// Sleeps randomly to shuffle the finish order of the workers.
+class RandomDelayTransform : public ReaderTransform {
+ public:
+  explicit RandomDelayTransform(const ReaderTransformAttrs& attrs) {}
+
+  void Apply(std::vector<LoDTensor>* data) const override {
+    thread_local std::mt19937 rng(std::hash<std::thread::id>()(
+        std::this_thread::get_id()));
+    std::uniform_int_distribution<int> dist(0, 2000);
+    std::this_thread::sleep_for(std::chrono::microseconds(dist(rng)));
+  }
+};
+
+REGISTER_READER_TRANSFORM(random_delay, RandomDelayTransform);
+
+static std::shared_ptr<paddle::framework::ReaderBase> MakeMapReader(
+    const std::shared_ptr<CountingReader>& reader,
+    const std::vector<std::string>& sample_specs, size_t batch_size,
+    const std::vector<std::string>& batch_specs, size_t num_workers,
+    size_t buffer_size) {
+  std::vector<std::unique_ptr<ReaderTransform>> sample_transforms;
+  for (auto& spec : sample_specs) {
+    sample_transforms.emplace_back(CreateReaderTransform(spec));
+  }
+  std::vector<std::unique_ptr<ReaderTransform>> batch_transforms;
+  for (auto& spec : batch_specs) {
+    batch_transforms.emplace_back(CreateReaderTransform(spec));
+  }
+  return paddle::framework::MakeDecoratedReader<OrderedMapReader>(
+      reader, std::move(sample_transforms), batch_size,
+      std::move(batch_transforms), num_workers, buffer_size);
+}
+
+TEST(OrderedMapReader, keep_order) {
+  auto root = std::make_shared<CountingReader>(100);
+  auto reader = MakeMapReader(root, {"random_delay"}, 1, {}, 8, 4);
+  for (int pass = 0; pass < 2; ++pass) {
+    std::vector<LoDTensor> out;
+    for (int i = 0; i < 100; ++i) {
+      reader->ReadNext(&out);
+      ASSERT_EQ(out.size(), 2UL);
+      EXPECT_EQ(out[0].data<float>()[0], static_cast<float>(i));
+      EXPECT_EQ(out[1].dims()[0], i % 3 + 1);
+    }
+    reader->ReadNext(&out);
+    EXPECT_TRUE(out.empty());
+    reader->ReadNext(&out);
+    EXPECT_TRUE(out.empty());
+
+    reader->Shutdown();
+    reader->Start();
+  }
+}
+
+TEST(OrderedMapReader, bounded_buffer) {
+  auto root = std::make_shared<CountingReader>(100);
+  auto reader = MakeMapReader(root, {}, 1, {}, 4, 3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  // Nothing is consumed, so only buffer_size samples are read.
+  EXPECT_EQ(root->reads(), 3);
+
+  std::vector<LoDTensor> out;
+  reader->ReadNext(&out);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(root->reads(), 4);
+}
+
+TEST(OrderedMapReader, batch) {
+  auto root = std::make_shared<CountingReader>(10);
+  auto reader = MakeMapReader(
+      root, {"normalize:slot=0;mean=1;std=0.5"}, 4,
+      {"sequence_pad:slot=1;pad_value=-1;append_length=1"}, 3, 2);
+
+  std::vector<LoDTensor> out;
+  for (int batch = 0; batch < 3; ++batch) {
+    reader->ReadNext(&out);
+    ASSERT_EQ(out.size(), 3UL);
+    // The last batch has the rest 2 samples.
+    int64_t batch_size = batch < 2 ? 4 : 2;
+
+    EXPECT_EQ(out[0].dims(), make_ddim({batch_size, 3}));
+    const float* dense = out[0].data<float>();
+    for (int64_t i = 0; i < batch_size; ++i) {
+      float sample = static_cast<float>(batch * 4 + i);
+      for (int j = 0; j < 3; ++j) {
+        EXPECT_FLOAT_EQ(dense[i * 3 + j], (sample - 1.f) * 2.f);
+      }
+    }
+
+    // Every batch has a sample of 3 values.
+    int64_t max_len = 3;
+    EXPECT_EQ(out[1].dims(), make_ddim({batch_size, max_len, 1}));
+    EXPECT_TRUE(out[1].lod().empty());
+    EXPECT_EQ(out[2].dims(), make_ddim({batch_size, 1}));
+    const int64_t* padded = out[1].data<int64_t>();
+    const int64_t* length = out[2].data<int64_t>();
+    for (int64_t i = 0; i < batch_size; ++i) {
+      int64_t sample = batch * 4 + i;
+      EXPECT_EQ(length[i], sample % 3 + 1);
+      for (int64_t j = 0; j < max_len; ++j) {
+        EXPECT_EQ(padded[i * max_len + j], j < length[i] ? sample : -1);
+      }
+    }
+  }
+  reader->ReadNext(&out);
+  EXPECT_TRUE(out.empty());
+}
+
+class FailingTransform : public ReaderTransform {
+ public:
+  explicit FailingTransform(const ReaderTransformAttrs& attrs)
+      : fail_at_(paddle::operators::reader::GetTransformAttr(attrs, "at", 0)) {
+  }
+
+  void Apply(std::vector<LoDTensor>* data) const override {
+    PADDLE_ENFORCE_NE(static_cast<int>((*data)[0].data<float>()[0]), fail_at_,
+                      "Fails at %d", fail_at_);
+  }
+
+ private:
+  int fail_at_;
+};
+
+REGISTER_READER_TRANSFORM(failing, FailingTransform);
+
+TEST(OrderedMapReader, error) {
+  auto root = std::make_shared<CountingReader>(10);
+  auto reader = MakeMapReader(root, {"failing:at=5"}, 1, {}, 4, 4);
+  std::vector<LoDTensor> out;
+  for (int i = 0; i < 5; ++i) {
+    reader->ReadNext(&out);
+    ASSERT_EQ(out.size(), 2UL);
+    EXPECT_EQ(out[0].data<float>()[0], static_cast<float>(i));
+  }
+  EXPECT_THROW(reader->ReadNext(&out), paddle::platform::EnforceNotMet);
+}
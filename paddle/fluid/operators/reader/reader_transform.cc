@@ -0,0 +1,231 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/reader_transform.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include "paddle/fluid/framework/data_type.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+std::unordered_map<std::string, ReaderTransformCreator>&
+ReaderTransformRegistry() {
+  static std::unordered_map<std::string, ReaderTransformCreator> registry;
+  return registry;
+}
+
+std::unique_ptr<ReaderTransform> CreateReaderTransform(
+    const std::string& spec) {
+  auto colon = spec.find(':');
+  std::string name = spec.substr(0, colon);
+  ReaderTransformAttrs attrs;
+  if (colon != std::string::npos) {
+    std::stringstream ss(spec.substr(colon + 1));
+    std::string item;
+    while (std::getline(ss, item, ';')) {
+      if (item.empty()) continue;
+      auto eq = item.find('=');
+      PADDLE_ENFORCE(eq != std::string::npos,
+                     "The attribute %s of the reader transform %s should be "
+                     "key=value",
+                     item, name);
+      attrs[item.substr(0, eq)] = item.substr(eq + 1);
+    }
+  }
+  auto it = ReaderTransformRegistry().find(name);
+  PADDLE_ENFORCE(it != ReaderTransformRegistry().end(),
+                 "The reader transform %s is not registered", name);
+  return std::unique_ptr<ReaderTransform>(it->second(attrs));
+}
+
+int GetTransformAttr(const ReaderTransformAttrs& attrs, const std::string& key,
+                     int default_value) {
+  auto it = attrs.find(key);
+  return it == attrs.end() ? default_value : std::stoi(it->second);
+}
+
+float GetTransformAttr(const ReaderTransformAttrs& attrs,
+                       const std::string& key, float default_value) {
+  auto it = attrs.find(key);
+  return it == attrs.end() ? default_value : std::stof(it->second);
+}
+
+std::vector<float> GetTransformAttr(const ReaderTransformAttrs& attrs,
+                                    const std::string& key,
+                                    const std::vector<float>& default_value) {
+  auto it = attrs.find(key);
+  if (it == attrs.end()) return default_value;
+  std::vector<float> values;
+  std::stringstream ss(it->second);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    values.push_back(std::stof(item));
+  }
+  return values;
+}
+
+void MergeSamples(const std::vector<std::vector<framework::LoDTensor>>& samples,
+                  std::vector<framework::LoDTensor>* batch) {
+  PADDLE_ENFORCE(!samples.empty());
+  size_t slot_num = samples[0].size();
+  batch->resize(slot_num);
+  for (size_t slot = 0; slot < slot_num; ++slot) {
+    std::vector<const framework::LoDTensor*> tensors;
+    for (auto& sample : samples) {
+      PADDLE_ENFORCE_EQ(sample.size(), slot_num,
+                        "The samples of a batch have different slots");
+      tensors.push_back(&sample[slot]);
+    }
+    auto& merged = (*batch)[slot];
+    merged.MergeLoDTensor(tensors, platform::CPUPlace());
+    if (samples[0][slot].lod().empty()) {
+      auto dims = framework::vectorize(samples[0][slot].dims());
+      dims.insert(dims.begin(), static_cast<int64_t>(samples.size()));
+      merged.Resize(framework::make_ddim(dims));
+    }
+  }
+}
+
+// (x - mean) / std of a float slot. mean and std are a scalar or the values
+// of the channels along the axis.
+//   normalize:slot=0;axis=0;mean=0.485,0.456,0.406;std=0.229,0.224,0.225
+class NormalizeTransform : public ReaderTransform {
+ public:
+  explicit NormalizeTransform(const ReaderTransformAttrs& attrs)
+      : slot_(GetTransformAttr(attrs, "slot", 0)),
+        axis_(GetTransformAttr(attrs, "axis", 0)),
+        mean_(GetTransformAttr(attrs, "mean", std::vector<float>{0.f})),
+        std_(GetTransformAttr(attrs, "std", std::vector<float>{1.f})) {
+    PADDLE_ENFORCE_EQ(mean_.size(), std_.size(),
+                      "The mean and std of normalize differ in size");
+  }
+
+  void Apply(std::vector<framework::LoDTensor>* data) const override {
+    PADDLE_ENFORCE_LT(slot_, static_cast<int>(data->size()));
+    auto& tensor = (*data)[slot_];
+    auto dims = tensor.dims();
+    PADDLE_ENFORCE_LT(axis_, dims.size());
+    int64_t channels = dims[axis_];
+    PADDLE_ENFORCE(mean_.size() == 1UL ||
+                       static_cast<int64_t>(mean_.size()) == channels,
+                   "normalize has %d mean values for %d channels",
+                   mean_.size(), channels);
+    int64_t outer = framework::product(framework::slice_ddim(dims, 0, axis_));
+    int64_t inner = tensor.numel() / outer / channels;
+    float* x = tensor.data<float>();
+    for (int64_t i = 0; i < outer; ++i) {
+      for (int64_t c = 0; c < channels; ++c) {
+        size_t k = mean_.size() == 1UL ? 0 : c;
+        float mean = mean_[k];
+        float scale = 1.f / std_[k];
+        for (int64_t j = 0; j < inner; ++j) {
+          x[j] = (x[j] - mean) * scale;
+        }
+        x += inner;
+      }
+    }
+  }
+
+ private:
+  int slot_;
+  int axis_;
+  std::vector<float> mean_;
+  std::vector<float> std_;
+};
+
+struct FillPaddingFunctor {
+  framework::LoDTensor* tensor;
+  float value;
+
+  template <typename T>
+  void apply() {
+    T* data = tensor->data<T>();
+    std::fill(data, data + tensor->numel(), static_cast<T>(value));
+  }
+};
+
+// Pads the sequences of a slot with one level of LoD to a dense tensor of
+// [sequence number, max_len, ...], like the sequence_pad op. max_len is the
+// longest sequence if it is 0, the longer sequences are truncated. The
+// lengths are appended as an int64 slot of [sequence number, 1] if
+// append_length is 1.
+//   sequence_pad:slot=1;pad_value=0;max_len=0;append_length=1
+class SequencePadTransform : public ReaderTransform {
+ public:
+  explicit SequencePadTransform(const ReaderTransformAttrs& attrs)
+      : slot_(GetTransformAttr(attrs, "slot", 0)),
+        pad_value_(GetTransformAttr(attrs, "pad_value", 0.f)),
+        max_len_(GetTransformAttr(attrs, "max_len", 0)),
+        append_length_(GetTransformAttr(attrs, "append_length", 0) != 0) {}
+
+  void Apply(std::vector<framework::LoDTensor>* data) const override {
+    PADDLE_ENFORCE_LT(slot_, static_cast<int>(data->size()));
+    auto& tensor = (*data)[slot_];
+    PADDLE_ENFORCE_EQ(tensor.lod().size(), 1UL,
+                      "sequence_pad needs a slot with one level of LoD");
+    auto& offsets = tensor.lod()[0];
+    int64_t seq_num = offsets.size() - 1;
+    int64_t max_len = max_len_;
+    if (max_len <= 0) {
+      for (int64_t i = 0; i < seq_num; ++i) {
+        max_len = std::max<int64_t>(max_len, offsets[i + 1] - offsets[i]);
+      }
+    }
+
+    auto step_dims =
+        framework::slice_ddim(tensor.dims(), 1, tensor.dims().size());
+    size_t step_bytes =
+        framework::product(step_dims) * framework::SizeOfType(tensor.type());
+    auto dims = framework::vectorize(step_dims);
+    dims.insert(dims.begin(), {seq_num, max_len});
+
+    framework::LoDTensor padded;
+    padded.Resize(framework::make_ddim(dims));
+    padded.mutable_data(platform::CPUPlace(), tensor.type());
+    framework::VisitDataType(tensor.type(),
+                             FillPaddingFunctor{&padded, pad_value_});
+
+    framework::LoDTensor length;
+    int64_t* length_data = length.mutable_data<int64_t>(
+        framework::make_ddim({seq_num, 1}), platform::CPUPlace());
+    auto* src = static_cast<const char*>(tensor.data<void>());
+    auto* dst = static_cast<char*>(padded.data<void>());
+    for (int64_t i = 0; i < seq_num; ++i) {
+      int64_t len = std::min<int64_t>(offsets[i + 1] - offsets[i], max_len);
+      std::memcpy(dst + i * max_len * step_bytes,
+                  src + offsets[i] * step_bytes, len * step_bytes);
+      length_data[i] = len;
+    }
+    tensor = std::move(padded);
+    if (append_length_) data->push_back(std::move(length));
+  }
+
+ private:
+  int slot_;
+  float pad_value_;
+  int max_len_;
+  bool append_length_;
+};
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
+
+namespace reader = paddle::operators::reader;
+
+REGISTER_READER_TRANSFORM(normalize, reader::NormalizeTransform);
+REGISTER_READER_TRANSFORM(sequence_pad, reader::SequencePadTransform);
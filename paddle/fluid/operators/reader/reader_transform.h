@@ -0,0 +1,93 @@
+// Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_registry.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+// A C++ transform of the data read from a reader, like decoding, normalizing
+// or padding. The OrderedMapReader applies it on its worker threads, so Apply
+// may be called concurrently.
+class ReaderTransform {
+ public:
+  virtual ~ReaderTransform() {}
+
+  // Transforms the slots of a sample or a batch in place.
+  virtual void Apply(std::vector<framework::LoDTensor>* data) const = 0;
+};
+
+using ReaderTransformAttrs = std::unordered_map<std::string, std::string>;
+
+using ReaderTransformCreator =
+    std::function<ReaderTransform*(const ReaderTransformAttrs&)>;
+
+std::unordered_map<std::string, ReaderTransformCreator>&
+ReaderTransformRegistry();
+
+// Registers the transform, whose constructor takes the ReaderTransformAttrs.
+// Use REGISTER_READER_TRANSFORM and USE_READER_TRANSFORM instead.
+template <typename Transform>
+int RegisterReaderTransform(const std::string& name) {
+  ReaderTransformRegistry()[name] = [](const ReaderTransformAttrs& attrs) {
+    return new Transform(attrs);
+  };
+  return 0;
+}
+
+// Creates the transform from its spec, the name and the optional attributes
+// like "normalize:slot=0;mean=0.485,0.456,0.406;std=0.229,0.224,0.225".
+std::unique_ptr<ReaderTransform> CreateReaderTransform(const std::string& spec);
+
+// Merges the samples to a batch slot by slot. The slots with LoD are
+// concatenated and their LoD are merged, the others are stacked along a new
+// first dimension.
+void MergeSamples(const std::vector<std::vector<framework::LoDTensor>>& samples,
+                  std::vector<framework::LoDTensor>* batch);
+
+// Helpers to read the attributes of the transforms.
+int GetTransformAttr(const ReaderTransformAttrs& attrs, const std::string& key,
+                     int default_value);
+float GetTransformAttr(const ReaderTransformAttrs& attrs,
+                       const std::string& key, float default_value);
+std::vector<float> GetTransformAttr(const ReaderTransformAttrs& attrs,
+                                    const std::string& key,
+                                    const std::vector<float>& default_value);
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
+
+#define REGISTER_READER_TRANSFORM(_name, _transform)                          \
+  STATIC_ASSERT_GLOBAL_NAMESPACE(                                             \
+      _reg_reader_transform_##_name,                                          \
+      "Must use REGISTER_READER_TRANSFORM in global namespace");              \
+  int TouchReaderTransform##_name() { return 0; }                             \
+  int _reg_reader_transform_entry_##_name =                                   \
+      paddle::operators::reader::RegisterReaderTransform<_transform>(#_name)
+
+// Links the transform registered in another library.
+#define USE_READER_TRANSFORM(_name)                                           \
+  extern int TouchReaderTransform##_name();                                   \
+  UNUSED static int _use_reader_transform_##_name =                           \
+      TouchReaderTransform##_name()
@@ -73,6 +73,12 @@ StepScopes::StepScopes(const platform::DeviceContext &dev_ctx,
   }
 }
 
+StepScopes::StepScopes(std::vector<framework::Scope *> *scopes)
+    : counter_(0UL), scopes_(scopes), is_train_(false), is_backward_(false) {
+  PADDLE_ENFORCE_EQ(scopes->size(), 2UL,
+                    "An RNN not training needs two step scopes");
+}
+
 framework::Scope &StepScopes::CurScope() { return GetScope(counter_); }
 
 framework::Scope &StepScopes::ExScope() {
@@ -174,16 +180,26 @@ void RecurrentOp::RunImpl(const framework::Scope &scope,
   auto &dev_ctx = *pool.Get(place);
 
   VLOG(3) << "Static RNN input sequence length = " << seq_len;
-  StepScopes scopes = CreateStepScopes(dev_ctx, scope, seq_len);
+  // The two scopes of an RNN not training are reused by the later runs.
+  bool is_train = Attr<bool>(kIsTrain);
+  std::vector<std::unique_ptr<framework::Scope>> recycled_scopes;
+  std::vector<framework::Scope *> test_scopes;
+  if (!is_train) {
+    for (int i = 0; i < 2; ++i) {
+      recycled_scopes.push_back(step_scope_pool_.Acquire(scope));
+      test_scopes.push_back(recycled_scopes.back().get());
+    }
+  }
+  StepScopes scopes = is_train ? CreateStepScopes(dev_ctx, scope, seq_len)
+                               : StepScopes(&test_scopes);
   auto reverse = Attr<bool>(kReverse);
 
   framework::Executor executor(place);
   auto *block = Attr<framework::BlockDesc *>(kStepBlock);
 
-  auto *program = block->Program();
-  auto ctx = executor.Prepare(
-      *program, block->ID(), Attr<std::vector<std::string>>(
-                                 kSkipEagerDeletionVars) /*skip_ref_cnt_vars*/);
+  auto *ctx = sub_block_.Get(
+      *block, Attr<std::vector<std::string>>(
+                  kSkipEagerDeletionVars) /*skip_ref_cnt_vars*/);
 
   for (size_t i = 0; i < seq_len; ++i) {
     size_t seq_offset = reverse ? seq_len - i - 1 : i;
@@ -219,6 +235,13 @@ void RecurrentOp::RunImpl(const framework::Scope &scope,
     // Link inside::output -> outside::output
     //   outside::output[seq_offset: seq_offset + 1] = inside::output
     executor.CreateVariables(ctx->prog_, &cur_scope, ctx->block_id_);
+    if (i == 0 && !is_train) {
+      // The outputs of a reused scope still share the former outside outputs.
+      for (auto &name : Outputs(kOutputs)) {
+        *cur_scope.Var(name)->GetMutable<framework::LoDTensor>() =
+            framework::LoDTensor();
+      }
+    }
     if (i > 0) {
       LinkTensorWithCallback(scope, Outputs(kOutputs), cur_scope,
                              Outputs(kOutputs),
@@ -231,7 +254,7 @@ void RecurrentOp::RunImpl(const framework::Scope &scope,
     }
 
     // Linked now, execute!
-    executor.RunPreparedContext(ctx.get(), &cur_scope,
+    executor.RunPreparedContext(ctx, &cur_scope,
                                 false /*create_local_scope*/,
                                 false /*create_vars*/, true /* keep_kids */);
     if (i == 0) {
@@ -252,6 +275,13 @@ void RecurrentOp::RunImpl(const framework::Scope &scope,
 
     scopes.ForwardNext();
   }
+  for (auto &step_scope : recycled_scopes) {
+    if (!step_scope->kids().empty()) {
+      dev_ctx.Wait();
+      step_scope->DropKids();
+    }
+    step_scope_pool_.Release(std::move(step_scope));
+  }
 }
 
 StepScopes RecurrentOp::CreateStepScopes(const platform::DeviceContext &dev_ctx,
@@ -283,10 +313,9 @@ void RecurrentGradOp::RunImpl(const framework::Scope &scope,
 
   framework::Executor executor(place);
   auto *block = Attr<framework::BlockDesc *>(kStepBlock);
-  auto *program = block->Program();
-  auto ctx = executor.Prepare(
-      *program, block->ID(), Attr<std::vector<std::string>>(
-                                 kSkipEagerDeletionVars) /*skip_ref_cnt_vars*/);
+  auto *ctx = sub_block_.Get(
+      *block, Attr<std::vector<std::string>>(
+                  kSkipEagerDeletionVars) /*skip_ref_cnt_vars*/);
 
   for (size_t step_id = 0; step_id < seq_len; ++step_id) {
     size_t seq_offset = reverse ? step_id : seq_len - step_id - 1;
@@ -363,7 +392,7 @@ void RecurrentGradOp::RunImpl(const framework::Scope &scope,
 
     VLOG(5) << "Recurrent memory linking finished ";
     // Run step block with cur_scope
-    executor.RunPreparedContext(ctx.get(), &cur_scope,
+    executor.RunPreparedContext(ctx, &cur_scope,
                                 false /*create_local_scope*/,
                                 false /*create_vars*/, true /* keep_kids */);
 
@@ -21,6 +21,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/executor.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/controlflow/sub_block_cache.h"
 
 namespace paddle {
 namespace operators {
@@ -43,6 +44,9 @@ class StepScopes {
              std::vector<framework::Scope *> *scopes, bool is_train,
              size_t seq_len, bool is_backward = false);
 
+  // Uses the two given scopes for the forward of an RNN not training.
+  explicit StepScopes(std::vector<framework::Scope *> *scopes);
+
   // Get the current scope
   framework::Scope &CurScope();
 
@@ -200,6 +204,10 @@ class RecurrentOp : public RecurrentBase {
   StepScopes CreateStepScopes(const platform::DeviceContext &dev_ctx,
                               const framework::Scope &scope,
                               size_t seq_len) const;
+
+  mutable PreparedSubBlock sub_block_;
+  // The two step scopes reused by the runs not training.
+  mutable StepScopePool step_scope_pool_;
 };
 
 class RecurrentGradOp : public RecurrentBase {
@@ -225,6 +233,8 @@ class RecurrentGradOp : public RecurrentBase {
 
   static std::vector<std::string> GradVarLists(
       const std::vector<std::string> &var_names);
+
+  mutable PreparedSubBlock sub_block_;
 };
 
 }  // namespace operators
@@ -65,6 +65,13 @@ to a file on disk.
                   "type and then saved. Otherwise, the tensor will be "
                   "directly saved without data type conversion.")
         .SetDefault(false);
+    AddAttr<bool>("mmap_format",
+                  "(boolean, default false)"
+                  "If true, the tensors are saved in the combined parameter "
+                  "format that load_combine can memory map, see "
+                  "framework/mmap_param_file.h. Otherwise, the tensors are "
+                  "serialized one by one.")
+        .SetDefault(false);
     AddAttr<std::string>(
         "file_path",
         "(string)"
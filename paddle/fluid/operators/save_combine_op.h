@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <stdint.h>
 #include <fstream>
+#include <memory>
 #include <numeric>
 #include <sstream>
 #include <string>
@@ -24,6 +25,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/framework.pb.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/mmap_param_file.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/port.h"
@@ -38,6 +40,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto filename = ctx.Attr<std::string>("file_path");
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
+    auto mmap_format = ctx.Attr<bool>("mmap_format");
 
     bool is_present = FileExists(filename);
     if (is_present && !overwrite) {
@@ -58,6 +61,10 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     // get device context from pool
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     auto &dev_ctx = *pool.Get(place);
+    std::unique_ptr<framework::MmapParamFileWriter> mmap_writer;
+    if (mmap_format) {
+      mmap_writer.reset(new framework::MmapParamFileWriter(&fout));
+    }
 
     for (size_t i = 0; i < inp_var_names.size(); i++) {
       PADDLE_ENFORCE(inp_vars[i] != nullptr,
@@ -82,11 +89,20 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
         // copy LoD info to the new tensor
         out.set_lod(tensor.lod());
         framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
-        framework::SerializeToStream(fout, out, dev_ctx);
+        if (mmap_writer) {
+          mmap_writer->Append(inp_var_names[i], out, dev_ctx);
+        } else {
+          framework::SerializeToStream(fout, out, dev_ctx);
+        }
+      } else if (mmap_writer) {
+        mmap_writer->Append(inp_var_names[i], tensor, dev_ctx);
       } else {
         framework::SerializeToStream(fout, tensor, dev_ctx);
       }
     }
+    if (mmap_writer) {
+      mmap_writer->Finish();
+    }
     fout.close();
   }
 };
@@ -16,6 +16,7 @@ limitations under the License. */
 #include <string>
 #include <vector>
 #include "gtest/gtest.h"
+#include "paddle/fluid/framework/mmap_param_file.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/float16.h"
 
@@ -344,3 +345,67 @@ TEST(SaveLoadTestWithCombineOp, CPU) {
     }
   }
 }
+
+// Save in the format that load_combine_op memory maps, and load the tensors
+// both as they are and as FP16.
+TEST(SaveLoadCombineMmapOp, CPU) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<int> lod1 = {0, 1, 2, 3, 10};
+  int numel1 = 100;
+  paddle::framework::LoD expect_lod1;
+  float* expect1 = CreateForSaveCombineOp<float, paddle::platform::float16>(
+      10, 10, lod1, "test_var1", place, &scope, &expect_lod1);
+
+  std::vector<int> lod2 = {0, 2, 5, 10};
+  int numel2 = 200;
+  paddle::framework::LoD expect_lod2;
+  int* expect2 = CreateForSaveCombineOp<int, int>(10, 20, lod2, "test_var2",
+                                                  place, &scope, &expect_lod2);
+
+  // Set attributes
+  std::string filename = "check_tensor_mmap.ls";
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string(filename)});
+  attrs.insert({"mmap_format", true});
+
+  // Run the save_combine_op
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2"}}}, {}, attrs);
+  save_combine_op->Run(scope, place);
+  EXPECT_TRUE(paddle::framework::MmapParamFile::IsMmapParamFile(filename));
+
+  // Set up output vars
+  auto target1 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+  auto target2 = GeneratePlaceholderBeforeLoad("out_var2", &scope);
+
+  // Run the load_combine_op
+  auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"out_var1", "out_var2"}}}, attrs);
+  load_combine_op->Run(scope, place);
+
+  paddle::framework::LoD actual_lod1, actual_lod2;
+  float* actual1 =
+      GetValuesAfterLoadCombineOp<float>(target1, scope, &actual_lod1);
+  int* actual2 = GetValuesAfterLoadCombineOp<int>(target2, scope, &actual_lod2);
+  CheckValues<float, float>(expect1, actual1, expect_lod1, actual_lod1, numel1);
+  CheckValues<int, int>(expect2, actual2, expect_lod2, actual_lod2, numel2);
+
+  // Load as FP16
+  attrs.insert({"load_as_fp16", true});
+  auto load_fp16_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"out_var1"}}}, attrs);
+  // All the tensors of the file should be loaded
+  EXPECT_THROW(load_fp16_op->Run(scope, place),
+               paddle::platform::EnforceNotMet);
+  load_fp16_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"out_var1", "out_var2"}}}, attrs);
+  load_fp16_op->Run(scope, place);
+  auto target_fp16 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+  paddle::platform::float16* actual_fp16 =
+      GetValuesAfterLoadCombineOp<paddle::platform::float16>(
+          target_fp16, scope, &actual_lod1);
+  CheckValues<float, paddle::platform::float16>(
+      expect1, actual_fp16, expect_lod1, actual_lod1, numel1);
+}
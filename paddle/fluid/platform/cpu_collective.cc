@@ -0,0 +1,838 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#if !defined(_WIN32)
+#include "paddle/fluid/platform/cpu_collective.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <random>
+#include <thread>  // NOLINT
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/platform/float16.h"
+#include "paddle/fluid/string/printf.h"
+
+DEFINE_bool(cpu_comm_use_shm, true,
+            "The CPU collective communicators use the shared memory for the "
+            "ranks on the same host.");
+DEFINE_int64(cpu_comm_tree_threshold_bytes, 64 * 1024,
+             "The CPU allreduce of at most cpu_comm_tree_threshold_bytes "
+             "uses the tree algorithm instead of the ring algorithm.");
+DEFINE_int64(cpu_comm_shm_buffer_bytes, 1 << 20,
+             "The bytes of the shared memory ring buffer between two ranks "
+             "of a CPU collective communicator.");
+DEFINE_int32(cpu_comm_timeout_ms, 300000,
+             "The timeout of connecting the ranks of a CPU collective "
+             "communicator.");
+
+namespace paddle {
+namespace platform {
+
+CPUCommOptions CPUCommOptions::FromFlags() {
+  CPUCommOptions options;
+  options.use_shm = FLAGS_cpu_comm_use_shm;
+  options.tree_threshold_bytes = FLAGS_cpu_comm_tree_threshold_bytes;
+  options.shm_buffer_bytes = FLAGS_cpu_comm_shm_buffer_bytes;
+  options.timeout_ms = FLAGS_cpu_comm_timeout_ms;
+  return options;
+}
+
+static constexpr uint32_t kCPUCommMagic = 0x50444343;
+// The bytes of a step of the ring algorithms, the reduction of a step
+// overlaps the transfer of the next one on the peers.
+static constexpr size_t kRingStepBytes = 1 << 20;
+
+using framework::proto::VarType;
+
+static size_t ElementSize(VarType::Type dtype) {
+  switch (dtype) {
+    case VarType::FP32:
+      return sizeof(float);
+    case VarType::FP64:
+      return sizeof(double);
+    case VarType::INT32:
+      return sizeof(int);
+    case VarType::INT64:
+      return sizeof(int64_t);
+    case VarType::FP16:
+      return sizeof(float16);
+    default:
+      PADDLE_THROW("The data type %d is not supported by CPUComm.",
+                   static_cast<int>(dtype));
+  }
+}
+
+template <typename T>
+static void ReduceTyped(T *dst, const T *src, int64_t count,
+                        CPUReduceType type) {
+  switch (type) {
+    case CPUReduceType::kSum:
+      for (int64_t i = 0; i < count; ++i) dst[i] = dst[i] + src[i];
+      break;
+    case CPUReduceType::kMax:
+      for (int64_t i = 0; i < count; ++i) {
+        dst[i] = dst[i] < src[i] ? src[i] : dst[i];
+      }
+      break;
+    case CPUReduceType::kMin:
+      for (int64_t i = 0; i < count; ++i) {
+        dst[i] = src[i] < dst[i] ? src[i] : dst[i];
+      }
+      break;
+    case CPUReduceType::kProd:
+      for (int64_t i = 0; i < count; ++i) dst[i] = dst[i] * src[i];
+      break;
+  }
+}
+
+static void Reduce(void *dst, const void *src, int64_t count,
+                   VarType::Type dtype, CPUReduceType type) {
+  switch (dtype) {
+    case VarType::FP32:
+      return ReduceTyped(static_cast<float *>(dst),
+                         static_cast<const float *>(src), count, type);
+    case VarType::FP64:
+      return ReduceTyped(static_cast<double *>(dst),
+                         static_cast<const double *>(src), count, type);
+    case VarType::INT32:
+      return ReduceTyped(static_cast<int *>(dst), static_cast<const int *>(src),
+                         count, type);
+    case VarType::INT64:
+      return ReduceTyped(static_cast<int64_t *>(dst),
+                         static_cast<const int64_t *>(src), count, type);
+    case VarType::FP16:
+      return ReduceTyped(static_cast<float16 *>(dst),
+                         static_cast<const float16 *>(src), count, type);
+    default:
+      PADDLE_THROW("The data type %d is not supported by CPUComm.",
+                   static_cast<int>(dtype));
+  }
+}
+
+static void ParseEndpoint(const std::string &endpoint, std::string *host,
+                          int *port) {
+  auto pos = endpoint.rfind(':');
+  PADDLE_ENFORCE(pos != std::string::npos && pos + 1 < endpoint.size(),
+                 "The endpoint %s should be ip:port.", endpoint);
+  *host = endpoint.substr(0, pos);
+  auto port_str = endpoint.substr(pos + 1);
+  // checked before std::stoi, which throws a std::exception
+  bool is_number = port_str.size() <= 5 &&
+                   std::all_of(port_str.begin(), port_str.end(),
+                               [](char c) { return c >= '0' && c <= '9'; });
+  PADDLE_ENFORCE(is_number, "The port of the endpoint %s is invalid.",
+                 endpoint);
+  *port = std::stoi(port_str);
+  PADDLE_ENFORCE(*port > 0 && *port <= 65535,
+                 "The port of the endpoint %s is out of range.", endpoint);
+}
+
+// The blocking IO of the connecting, false if the socket is closed or times
+// out.
+static bool WriteAll(int fd, const void *data, size_t bytes) {
+  const char *p = static_cast<const char *>(data);
+  while (bytes > 0) {
+    ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+static bool ReadAll(int fd, void *data, size_t bytes) {
+  char *p = static_cast<char *>(data);
+  while (bytes > 0) {
+    ssize_t n = recv(fd, p, bytes, 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+static void SetRecvTimeout(int fd, int timeout_ms) {
+  struct timeval tv;
+  tv.tv_sec = timeout_ms / 1000;
+  tv.tv_usec = (timeout_ms % 1000) * 1000;
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+using Clock = std::chrono::steady_clock;
+
+static int RemainingMs(Clock::time_point deadline) {
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Clock::now())
+                .count();
+  return static_cast<int>(std::max<int64_t>(ms, 0));
+}
+
+struct CPUCommHello {
+  uint32_t magic;
+  int32_t ring_id;
+  int32_t rank;
+  int32_t nranks;
+};
+
+// Connects to the endpoint and says hello, retrying until the deadline
+// because the peer may not listen yet.
+static int ConnectToRank(const std::string &endpoint,
+                         const CPUCommHello &hello,
+                         Clock::time_point deadline) {
+  std::string host;
+  int port;
+  ParseEndpoint(endpoint, &host, &port);
+  while (true) {
+    struct addrinfo hints, *result = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints,
+                    &result) == 0) {
+      int fd = socket(result->ai_family, result->ai_socktype,
+                      result->ai_protocol);
+      bool connected =
+          fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) == 0;
+      freeaddrinfo(result);
+      if (connected) {
+        SetRecvTimeout(fd, std::max(RemainingMs(deadline), 1));
+        char ack = 0;
+        if (WriteAll(fd, &hello, sizeof(hello)) && ReadAll(fd, &ack, 1) &&
+            ack == 1) {
+          return fd;
+        }
+      }
+      if (fd >= 0) close(fd);
+    }
+    PADDLE_ENFORCE_GT(RemainingMs(deadline), 0,
+                      "Timeout to connect to the rank at %s.", endpoint);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+}
+
+// The transport to a peer. The data is sent and received without blocking,
+// see CPUComm::SendRecv.
+class CPUChannel {
+ public:
+  CPUChannel(int fd, int peer) : fd_(fd), peer_(peer) {}
+  virtual ~CPUChannel() { close(fd_); }
+
+  // The socket to poll, for the shared memory it is only readable when the
+  // peer has exited.
+  int fd() const { return fd_; }
+  int peer() const { return peer_; }
+  virtual bool is_shm() const = 0;
+
+  // Return the bytes sent or received, maybe 0.
+  virtual size_t TrySend(const char *data, size_t bytes) = 0;
+  virtual size_t TryRecv(char *data, size_t bytes) = 0;
+
+ protected:
+  int fd_;
+  int peer_;
+
+  DISABLE_COPY_AND_ASSIGN(CPUChannel);
+};
+
+class TCPChannel : public CPUChannel {
+ public:
+  TCPChannel(int fd, int peer) : CPUChannel(fd, peer) {
+    int flag = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+  }
+
+  bool is_shm() const override { return false; }
+
+  size_t TrySend(const char *data, size_t bytes) override {
+    ssize_t n = send(fd_, data, bytes, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n >= 0) return static_cast<size_t>(n);
+    PADDLE_ENFORCE(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR,
+                   "Failed to send to the rank %d: %s", peer_,
+                   std::strerror(errno));
+    return 0;
+  }
+
+  size_t TryRecv(char *data, size_t bytes) override {
+    ssize_t n = recv(fd_, data, bytes, MSG_DONTWAIT);
+    if (n > 0) return static_cast<size_t>(n);
+    PADDLE_ENFORCE_NE(n, 0, "The rank %d has closed the connection.", peer_);
+    PADDLE_ENFORCE(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR,
+                   "Failed to receive from the rank %d: %s", peer_,
+                   std::strerror(errno));
+    return 0;
+  }
+};
+
+// The segment shared by two ranks on the same host. Ring 0 is from the lower
+// rank to the higher one, ring 1 is the other direction.
+struct ShmSegmentHeader {
+  uint64_t token;
+  uint64_t ring_bytes;
+};
+
+// A single producer single consumer ring buffer, head and tail increase
+// monotonically.
+struct ShmRing {
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+};
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "The shared memory channel needs the lock free atomics.");
+
+static constexpr size_t kShmHeaderBytes = 64;
+
+static size_t ShmSegmentBytes(size_t ring_bytes) {
+  return kShmHeaderBytes + 2 * (sizeof(ShmRing) + ring_bytes);
+}
+
+class ShmChannel : public CPUChannel {
+ public:
+  ShmChannel(int fd, int peer, char *base, size_t size, bool lower)
+      : CPUChannel(fd, peer), base_(base), size_(size) {
+    ring_bytes_ = reinterpret_cast<ShmSegmentHeader *>(base)->ring_bytes;
+    char *ring0 = base + kShmHeaderBytes;
+    char *ring1 = ring0 + sizeof(ShmRing) + ring_bytes_;
+    char *send = lower ? ring0 : ring1;
+    char *recv = lower ? ring1 : ring0;
+    send_ring_ = reinterpret_cast<ShmRing *>(send);
+    send_data_ = send + sizeof(ShmRing);
+    recv_ring_ = reinterpret_cast<ShmRing *>(recv);
+    recv_data_ = recv + sizeof(ShmRing);
+  }
+
+  ~ShmChannel() { munmap(base_, size_); }
+
+  bool is_shm() const override { return true; }
+
+  size_t TrySend(const char *data, size_t bytes) override {
+    uint64_t head = send_ring_->head.load(std::memory_order_relaxed);
+    uint64_t tail = send_ring_->tail.load(std::memory_order_acquire);
+    size_t n = std::min<size_t>(bytes, ring_bytes_ - (head - tail));
+    if (n == 0) return 0;
+    size_t pos = head % ring_bytes_;
+    size_t first = std::min(n, ring_bytes_ - pos);
+    std::memcpy(send_data_ + pos, data, first);
+    std::memcpy(send_data_, data + first, n - first);
+    send_ring_->head.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  size_t TryRecv(char *data, size_t bytes) override {
+    uint64_t tail = recv_ring_->tail.load(std::memory_order_relaxed);
+    uint64_t head = recv_ring_->head.load(std::memory_order_acquire);
+    size_t n = std::min<size_t>(bytes, head - tail);
+    if (n == 0) return 0;
+    size_t pos = tail % ring_bytes_;
+    size_t first = std::min(n, ring_bytes_ - pos);
+    std::memcpy(data, recv_data_ + pos, first);
+    std::memcpy(data + first, recv_data_, n - first);
+    recv_ring_->tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+ private:
+  char *base_;
+  size_t size_;
+  size_t ring_bytes_;
+  ShmRing *send_ring_;
+  char *send_data_;
+  ShmRing *recv_ring_;
+  char *recv_data_;
+};
+
+// The message of the lower rank offering the shared memory to the higher.
+struct ShmOffer {
+  int32_t ok;
+  uint64_t token;
+  uint64_t size;
+  char path[128];
+};
+
+// The lower rank creates the segment and offers it, it is used if the higher
+// rank can open it and finds the token in it, i.e. they are on the same host
+// and see the same /dev/shm.
+static std::unique_ptr<CPUChannel> OfferShm(int fd, int ring_id, int rank,
+                                            int peer,
+                                            const CPUCommOptions &options) {
+  ShmOffer offer;
+  std::memset(&offer, 0, sizeof(offer));
+  std::random_device rd;
+  offer.token = (static_cast<uint64_t>(rd()) << 32) ^ rd() ^
+                static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+  size_t ring_bytes =
+      (std::max<int64_t>(options.shm_buffer_bytes, 4096) + 63) / 64 * 64;
+  offer.size = ShmSegmentBytes(ring_bytes);
+  std::string path = string::Sprintf(
+      "/dev/shm/paddle_cpu_comm_%d_%d_%d_%d_%x", getpid(), ring_id, rank, peer,
+      static_cast<uint32_t>(offer.token));
+  PADDLE_ENFORCE_LT(path.size(), sizeof(offer.path));
+
+  char *base = nullptr;
+  if (options.use_shm) {
+    int shm_fd = open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (shm_fd >= 0) {
+      if (ftruncate(shm_fd, offer.size) == 0) {
+        void *addr = mmap(nullptr, offer.size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, shm_fd, 0);
+        if (addr != MAP_FAILED) {
+          base = static_cast<char *>(addr);
+          auto *header = reinterpret_cast<ShmSegmentHeader *>(base);
+          header->token = offer.token;
+          header->ring_bytes = ring_bytes;
+          offer.ok = 1;
+          std::strncpy(offer.path, path.c_str(), sizeof(offer.path) - 1);
+        }
+      }
+      close(shm_fd);
+      if (base == nullptr) unlink(path.c_str());
+    }
+  }
+
+  int32_t accepted = 0;
+  bool io_ok = WriteAll(fd, &offer, sizeof(offer)) &&
+               ReadAll(fd, &accepted, sizeof(accepted));
+  if (base != nullptr) {
+    unlink(path.c_str());
+  }
+  PADDLE_ENFORCE(io_ok, "Failed to set up the connection to the rank %d.",
+                 peer);
+  if (accepted != 1) {
+    if (base != nullptr) munmap(base, offer.size);
+    return nullptr;
+  }
+  return std::unique_ptr<CPUChannel>(
+      new ShmChannel(fd, peer, base, offer.size, true));
+}
+
+static std::unique_ptr<CPUChannel> AcceptShm(int fd, int peer,
+                                             const CPUCommOptions &options) {
+  ShmOffer offer;
+  PADDLE_ENFORCE(ReadAll(fd, &offer, sizeof(offer)),
+                 "Failed to set up the connection to the rank %d.", peer);
+  char *base = nullptr;
+  if (offer.ok == 1 && options.use_shm) {
+    offer.path[sizeof(offer.path) - 1] = '\0';
+    int shm_fd = open(offer.path, O_RDWR);
+    struct stat st;
+    if (shm_fd >= 0 && fstat(shm_fd, &st) == 0 &&
+        static_cast<uint64_t>(st.st_size) == offer.size) {
+      void *addr = mmap(nullptr, offer.size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, shm_fd, 0);
+      if (addr != MAP_FAILED) {
+        base = static_cast<char *>(addr);
+        if (reinterpret_cast<ShmSegmentHeader *>(base)->token != offer.token) {
+          munmap(base, offer.size);
+          base = nullptr;
+        }
+      }
+    }
+    if (shm_fd >= 0) close(shm_fd);
+  }
+  int32_t accepted = base != nullptr ? 1 : 0;
+  PADDLE_ENFORCE(WriteAll(fd, &accepted, sizeof(accepted)),
+                 "Failed to set up the connection to the rank %d.", peer);
+  if (base == nullptr) return nullptr;
+  return std::unique_ptr<CPUChannel>(
+      new ShmChannel(fd, peer, base, offer.size, false));
+}
+
+CPUComm::CPUComm(int ring_id, int rank, const std::vector<int> &fds,
+                 const CPUCommOptions &options)
+    : ring_id_(ring_id),
+      rank_(rank),
+      nranks_(static_cast<int>(fds.size())),
+      options_(options) {
+  channels_.resize(nranks_);
+  for (int peer = 0; peer < nranks_; ++peer) {
+    if (peer == rank_) continue;
+    int fd = fds[peer];
+    PADDLE_ENFORCE_GE(fd, 0, "The rank %d is not connected.", peer);
+    channels_[peer] = rank_ < peer
+                          ? OfferShm(fd, ring_id_, rank_, peer, options_)
+                          : AcceptShm(fd, peer, options_);
+    if (channels_[peer] == nullptr) {
+      channels_[peer].reset(new TCPChannel(fd, peer));
+    }
+  }
+  VLOG(1) << "CPUComm of ring " << ring_id_ << ", rank " << rank_ << " of "
+          << nranks_ << ", " << shm_peer_num()
+          << " peers by the shared memory";
+}
+
+CPUComm::~CPUComm() {}
+
+int CPUComm::shm_peer_num() const {
+  int num = 0;
+  for (auto &channel : channels_) {
+    if (channel != nullptr && channel->is_shm()) ++num;
+  }
+  return num;
+}
+
+// Waits until the channels may make progress. The sockets are polled, the
+// shared memory is polled by spinning, then yielding and sleeping.
+static void WaitChannels(CPUChannel *send, CPUChannel *recv, int *idle) {
+  bool shm = (send != nullptr && send->is_shm()) ||
+             (recv != nullptr && recv->is_shm());
+  ++*idle;
+  if (shm && *idle < 2000) {
+    if (*idle > 100) std::this_thread::yield();
+    return;
+  }
+  struct pollfd fds[2];
+  CPUChannel *channels[2];
+  int n = 0;
+  if (send != nullptr) {
+    channels[n] = send;
+    fds[n].fd = send->fd();
+    fds[n].events = send->is_shm() ? POLLIN : POLLOUT;
+    ++n;
+  }
+  if (recv != nullptr && recv != send) {
+    channels[n] = recv;
+    fds[n].fd = recv->fd();
+    fds[n].events = POLLIN;
+    ++n;
+  }
+  int ret = poll(fds, n, shm ? 0 : 1000);
+  PADDLE_ENFORCE(ret >= 0 || errno == EINTR, "Failed to poll the sockets: %s",
+                 std::strerror(errno));
+  // the socket of the shared memory is readable only when the peer exits
+  for (int i = 0; ret > 0 && i < n; ++i) {
+    if (channels[i]->is_shm() && fds[i].revents != 0) {
+      char c;
+      ssize_t peek = ::recv(fds[i].fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+      PADDLE_ENFORCE_NE(peek, 0, "The rank %d has exited.",
+                        channels[i]->peer());
+    }
+  }
+  if (shm) {
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+}
+
+void CPUComm::SendRecv(int send_peer, const void *send, size_t send_bytes,
+                       int recv_peer, void *recv, size_t recv_bytes) {
+  CPUChannel *send_channel = nullptr;
+  CPUChannel *recv_channel = nullptr;
+  if (send_peer >= 0 && send_bytes > 0) {
+    send_channel = channels_.at(send_peer).get();
+    PADDLE_ENFORCE_NOT_NULL(send_channel, "Cannot send to the rank itself.");
+  }
+  if (recv_peer >= 0 && recv_bytes > 0) {
+    recv_channel = channels_.at(recv_peer).get();
+    PADDLE_ENFORCE_NOT_NULL(recv_channel, "Cannot recv from the rank itself.");
+  }
+  const char *send_data = static_cast<const char *>(send);
+  char *recv_data = static_cast<char *>(recv);
+  size_t sent = 0, received = 0;
+  int idle = 0;
+  while (send_channel != nullptr || recv_channel != nullptr) {
+    size_t progress = 0;
+    if (send_channel != nullptr) {
+      size_t n = send_channel->TrySend(send_data + sent, send_bytes - sent);
+      sent += n;
+      progress += n;
+      if (sent == send_bytes) send_channel = nullptr;
+    }
+    if (recv_channel != nullptr) {
+      size_t n =
+          recv_channel->TryRecv(recv_data + received, recv_bytes - received);
+      received += n;
+      progress += n;
+      if (received == recv_bytes) recv_channel = nullptr;
+    }
+    if (progress > 0) {
+      idle = 0;
+    } else {
+      WaitChannels(send_channel, recv_channel, &idle);
+    }
+  }
+}
+
+void CPUComm::AllReduce(const void *send, void *recv, int64_t count,
+                        VarType::Type dtype, CPUReduceType type) {
+  size_t element_size = ElementSize(dtype);
+  if (recv != send) {
+    std::memcpy(recv, send, count * element_size);
+  }
+  if (nranks_ == 1 || count == 0) return;
+  if (static_cast<int64_t>(count * element_size) <=
+          options_.tree_threshold_bytes ||
+      count < nranks_) {
+    TreeAllReduce(recv, count, dtype, type);
+    return;
+  }
+  std::vector<int64_t> offsets(nranks_ + 1, 0);
+  for (int i = 0; i < nranks_; ++i) {
+    int64_t block = count / nranks_ + (i < count % nranks_ ? 1 : 0);
+    offsets[i + 1] = offsets[i] + block * element_size;
+  }
+  RingReduceScatter(static_cast<char *>(recv), offsets, dtype, type);
+  RingAllGather(static_cast<char *>(recv), offsets);
+}
+
+void CPUComm::TreeAllReduce(void *buffer, int64_t count, VarType::Type dtype,
+                            CPUReduceType type) {
+  size_t bytes = count * ElementSize(dtype);
+  if (tmp_.size() < bytes) tmp_.resize(bytes);
+  // the binomial tree reduce to rank 0
+  for (int mask = 1; mask < nranks_; mask <<= 1) {
+    if (rank_ & mask) {
+      Send(rank_ - mask, buffer, bytes);
+      break;
+    }
+    if (rank_ + mask < nranks_) {
+      Recv(rank_ + mask, tmp_.data(), bytes);
+      Reduce(buffer, tmp_.data(), count, dtype, type);
+    }
+  }
+  Broadcast(buffer, bytes, 0);
+}
+
+void CPUComm::Broadcast(void *buffer, int64_t bytes, int root) {
+  PADDLE_ENFORCE(root >= 0 && root < nranks_, "Invalid root %d.", root);
+  if (nranks_ == 1 || bytes == 0) return;
+  // the binomial tree of the ranks relative to root
+  int relative = (rank_ - root + nranks_) % nranks_;
+  int mask = 1;
+  while (mask < nranks_) {
+    if (relative & mask) {
+      Recv((relative - mask + root) % nranks_, buffer, bytes);
+      break;
+    }
+    mask <<= 1;
+  }
+  mask >>= 1;
+  while (mask > 0) {
+    if (relative + mask < nranks_) {
+      Send((relative + mask + root) % nranks_, buffer, bytes);
+    }
+    mask >>= 1;
+  }
+}
+
+void CPUComm::RingReduceScatter(char *buffer,
+                                const std::vector<int64_t> &offsets,
+                                VarType::Type dtype, CPUReduceType type) {
+  size_t element_size = ElementSize(dtype);
+  size_t step_bytes = kRingStepBytes / element_size * element_size;
+  if (tmp_.size() < step_bytes) tmp_.resize(step_bytes);
+  int next = (rank_ + 1) % nranks_;
+  int prev = (rank_ - 1 + nranks_) % nranks_;
+  // At step s, send the block (rank - s - 1), which has been reduced in the
+  // former step, and reduce the block (rank - s - 2) received from prev. The
+  // block rank is received at the last step.
+  for (int s = 0; s < nranks_ - 1; ++s) {
+    int send_block = (rank_ - s - 1 + 2 * nranks_) % nranks_;
+    int recv_block = (rank_ - s - 2 + 2 * nranks_) % nranks_;
+    int64_t send_offset = offsets[send_block];
+    int64_t send_len = offsets[send_block + 1] - send_offset;
+    int64_t recv_offset = offsets[recv_block];
+    int64_t recv_len = offsets[recv_block + 1] - recv_offset;
+    for (int64_t k = 0; k < std::max(send_len, recv_len); k += step_bytes) {
+      size_t send_bytes =
+          k < send_len ? std::min<int64_t>(step_bytes, send_len - k) : 0;
+      size_t recv_bytes =
+          k < recv_len ? std::min<int64_t>(step_bytes, recv_len - k) : 0;
+      SendRecv(next, buffer + send_offset + k, send_bytes, prev, tmp_.data(),
+               recv_bytes);
+      Reduce(buffer + recv_offset + k, tmp_.data(), recv_bytes / element_size,
+             dtype, type);
+    }
+  }
+}
+
+void CPUComm::RingAllGather(char *buffer,
+                            const std::vector<int64_t> &offsets) {
+  int next = (rank_ + 1) % nranks_;
+  int prev = (rank_ - 1 + nranks_) % nranks_;
+  // At step s, send the block (rank - s) and receive the block (rank - s - 1)
+  for (int s = 0; s < nranks_ - 1; ++s) {
+    int send_block = (rank_ - s + nranks_) % nranks_;
+    int recv_block = (rank_ - s - 1 + nranks_) % nranks_;
+    SendRecv(next, buffer + offsets[send_block],
+             offsets[send_block + 1] - offsets[send_block], prev,
+             buffer + offsets[recv_block],
+             offsets[recv_block + 1] - offsets[recv_block]);
+  }
+}
+
+void CPUComm::AllGather(const void *send, void *recv, int64_t bytes) {
+  char *out = static_cast<char *>(recv);
+  if (out + rank_ * bytes != send) {
+    std::memcpy(out + rank_ * bytes, send, bytes);
+  }
+  if (nranks_ == 1 || bytes == 0) return;
+  std::vector<int64_t> offsets(nranks_ + 1);
+  for (int i = 0; i <= nranks_; ++i) {
+    offsets[i] = i * bytes;
+  }
+  RingAllGather(out, offsets);
+}
+
+void CPUComm::ReduceScatter(const void *send, void *recv, int64_t recv_count,
+                            VarType::Type dtype, CPUReduceType type) {
+  int64_t bytes = recv_count * ElementSize(dtype);
+  std::vector<char> work(static_cast<const char *>(send),
+                         static_cast<const char *>(send) + nranks_ * bytes);
+  if (nranks_ > 1 && bytes > 0) {
+    std::vector<int64_t> offsets(nranks_ + 1);
+    for (int i = 0; i <= nranks_; ++i) {
+      offsets[i] = i * bytes;
+    }
+    RingReduceScatter(work.data(), offsets, dtype, type);
+  }
+  std::memcpy(recv, work.data() + rank_ * bytes, bytes);
+}
+
+void CPUComm::Barrier() {
+  // the dissemination barrier
+  for (int k = 1; k < nranks_; k <<= 1) {
+    char out = 0, in = 0;
+    SendRecv((rank_ + k) % nranks_, &out, 1, (rank_ - k + nranks_) % nranks_,
+             &in, 1);
+  }
+}
+
+int CPUCommContext::GetListenSocket(int port) {
+  auto iter = listen_fds_.find(port);
+  if (iter != listen_fds_.end()) return iter->second;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  PADDLE_ENFORCE_GE(fd, 0, "Failed to create the socket: %s",
+                    std::strerror(errno));
+  int flag = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 128) != 0) {
+    int err = errno;
+    close(fd);
+    PADDLE_THROW("Failed to listen on the port %d: %s", port,
+                 std::strerror(err));
+  }
+  listen_fds_[port] = fd;
+  return fd;
+}
+
+CPUComm *CPUCommContext::CreateComm(const std::vector<std::string> &endpoints,
+                                    int rank, int ring_id,
+                                    const CPUCommOptions &options) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  int nranks = static_cast<int>(endpoints.size());
+  PADDLE_ENFORCE(rank >= 0 && rank < nranks,
+                 "The rank %d should be in [0, %d).", rank, nranks);
+  PADDLE_ENFORCE_EQ(comm_map_.count(ring_id), 0,
+                    "The communicator of ring %d has been created.", ring_id);
+  auto deadline =
+      Clock::now() + std::chrono::milliseconds(std::max(options.timeout_ms, 1));
+  std::vector<int> fds(nranks, -1);
+  if (nranks > 1) {
+    std::string host;
+    int port;
+    ParseEndpoint(endpoints[rank], &host, &port);
+    int listen_fd = GetListenSocket(port);
+
+    // Connect to the lower ranks, and accept the higher ranks. The
+    // connections are queued by the listening sockets, so the ranks do not
+    // wait for each other.
+    CPUCommHello hello{kCPUCommMagic, ring_id, rank, nranks};
+    for (int i = 0; i < rank; ++i) {
+      fds[i] = ConnectToRank(endpoints[i], hello, deadline);
+    }
+    int remaining = nranks - rank - 1;
+    for (auto &pair : pending_fds_[ring_id]) {
+      PADDLE_ENFORCE(pair.first > rank && pair.first < nranks &&
+                         fds[pair.first] == -1,
+                     "Unexpected rank %d of ring %d.", pair.first, ring_id);
+      fds[pair.first] = pair.second;
+      --remaining;
+    }
+    pending_fds_.erase(ring_id);
+    while (remaining > 0) {
+      struct pollfd pfd = {listen_fd, POLLIN, 0};
+      int ret = poll(&pfd, 1, RemainingMs(deadline));
+      PADDLE_ENFORCE(ret > 0 || (ret < 0 && errno == EINTR),
+                     "Timeout to wait for the other ranks of ring %d.",
+                     ring_id);
+      if (ret <= 0) continue;
+      int fd = accept(listen_fd, nullptr, nullptr);
+      if (fd < 0) continue;
+      SetRecvTimeout(fd, std::max(RemainingMs(deadline), 1));
+      CPUCommHello peer;
+      char ack = 1;
+      if (!ReadAll(fd, &peer, sizeof(peer)) || peer.magic != kCPUCommMagic ||
+          !WriteAll(fd, &ack, 1)) {
+        close(fd);
+        continue;
+      }
+      if (peer.ring_id != ring_id) {
+        // the other ring is created later
+        pending_fds_[peer.ring_id][peer.rank] = fd;
+        continue;
+      }
+      PADDLE_ENFORCE(peer.nranks == nranks && peer.rank > rank &&
+                         peer.rank < nranks && fds[peer.rank] == -1,
+                     "Unexpected rank %d of %d ranks of ring %d.", peer.rank,
+                     peer.nranks, ring_id);
+      fds[peer.rank] = fd;
+      --remaining;
+    }
+  }
+  auto *comm = new CPUComm(ring_id, rank, fds, options);
+  comm_map_[ring_id].reset(comm);
+  return comm;
+}
+
+CPUComm *CPUCommContext::Get(int ring_id) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto iter = comm_map_.find(ring_id);
+  PADDLE_ENFORCE(iter != comm_map_.end(),
+                 "The CPU communicator of ring %d has not been initialized.",
+                 ring_id);
+  return iter->second.get();
+}
+
+CPUCommContext::~CPUCommContext() {
+  comm_map_.clear();
+  for (auto &ring : pending_fds_) {
+    for (auto &pair : ring.second) close(pair.second);
+  }
+  for (auto &pair : listen_fds_) close(pair.second);
+}
+
+}  // namespace platform
+}  // namespace paddle
+
+#endif
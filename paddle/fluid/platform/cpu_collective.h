@@ -0,0 +1,164 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#if !defined(_WIN32)
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace platform {
+
+// The collective communication of the CPU trainers, the counterpart of the
+// NCCL communicators of collective_helper.h.
+//
+// Every pair of ranks is connected by a TCP socket. The ranks on the same
+// host also share a memory segment in /dev/shm with a ring buffer for every
+// direction, and send the data through it instead of the socket (the socket
+// is kept to detect that the peer has exited). The collectives are
+// synchronous and called by all the ranks in the same order:
+//
+//   AllReduce: the ring algorithm (reduce-scatter then all-gather, every
+//              rank sends 2 * (nranks - 1) / nranks of the data) for the
+//              large messages, the binomial tree reduce and broadcast for the
+//              small ones.
+//   Broadcast: the binomial tree.
+//   AllGather, ReduceScatter: the ring algorithm.
+
+enum class CPUReduceType { kSum, kMax, kMin, kProd };
+
+struct CPUCommOptions {
+  // Use the shared memory for the ranks on the same host.
+  bool use_shm{true};
+  // The AllReduce of at most tree_threshold_bytes uses the tree algorithm.
+  int64_t tree_threshold_bytes{64 * 1024};
+  // The bytes of a ring buffer in the shared memory.
+  int64_t shm_buffer_bytes{1 << 20};
+  // The timeout of connecting to the other ranks.
+  int timeout_ms{300000};
+
+  // The options set by FLAGS_cpu_comm_*.
+  static CPUCommOptions FromFlags();
+};
+
+class CPUChannel;
+
+class CPUComm {
+ public:
+  // fds[i] is the connected socket to rank i, -1 for the rank itself. The
+  // communicator owns the sockets.
+  CPUComm(int ring_id, int rank, const std::vector<int>& fds,
+          const CPUCommOptions& options);
+  ~CPUComm();
+
+  int ring_id() const { return ring_id_; }
+  int nranks() const { return nranks_; }
+  int rank() const { return rank_; }
+  // The number of the peers connected by the shared memory.
+  int shm_peer_num() const;
+
+  // recv = reduce(send of all the ranks), send may be recv.
+  void AllReduce(const void* send, void* recv, int64_t count,
+                 framework::proto::VarType::Type dtype, CPUReduceType type);
+  // buffer of all the ranks = buffer of root
+  void Broadcast(void* buffer, int64_t bytes, int root);
+  // recv = [send of rank 0, send of rank 1, ...], recv has nranks * bytes.
+  void AllGather(const void* send, void* recv, int64_t bytes);
+  // recv = the rank-th block of reduce(send of all the ranks), send has
+  // nranks * recv_count elements.
+  void ReduceScatter(const void* send, void* recv, int64_t recv_count,
+                     framework::proto::VarType::Type dtype,
+                     CPUReduceType type);
+  void Barrier();
+
+ private:
+  // Sends to send_peer and receives from recv_peer at the same time, so that
+  // the ring steps do not deadlock. A peer of -1 or 0 bytes is skipped.
+  void SendRecv(int send_peer, const void* send, size_t send_bytes,
+                int recv_peer, void* recv, size_t recv_bytes);
+  void Send(int peer, const void* data, size_t bytes) {
+    SendRecv(peer, data, bytes, -1, nullptr, 0);
+  }
+  void Recv(int peer, void* data, size_t bytes) {
+    SendRecv(-1, nullptr, 0, peer, data, bytes);
+  }
+
+  void TreeAllReduce(void* buffer, int64_t count,
+                     framework::proto::VarType::Type dtype,
+                     CPUReduceType type);
+  // The ring reduce-scatter of the nranks blocks of buffer, the rank-th block
+  // of buffer is reduced at the end. offsets has nranks + 1 elements.
+  void RingReduceScatter(char* buffer, const std::vector<int64_t>& offsets,
+                         framework::proto::VarType::Type dtype,
+                         CPUReduceType type);
+  // The ring all-gather of the blocks of buffer, the rank-th block is the
+  // block of this rank.
+  void RingAllGather(char* buffer, const std::vector<int64_t>& offsets);
+
+  int ring_id_;
+  int rank_;
+  int nranks_;
+  CPUCommOptions options_;
+  std::vector<std::unique_ptr<CPUChannel>> channels_;
+  std::vector<char> tmp_;
+
+  DISABLE_COPY_AND_ASSIGN(CPUComm);
+};
+
+// A singleton reserves the CPU communicators of the ring ids.
+class CPUCommContext {
+ public:
+  static CPUCommContext& Instance() {
+    static CPUCommContext comm_ctx;
+    return comm_ctx;
+  }
+
+  // Connects to the other ranks, endpoints[i] is the "ip:port" of rank i.
+  // It is called by all the ranks of the ring.
+  CPUComm* CreateComm(const std::vector<std::string>& endpoints, int rank,
+                      int ring_id = 0,
+                      const CPUCommOptions& options = CPUCommOptions());
+
+  CPUComm* Get(int ring_id) const;
+
+  ~CPUCommContext();
+
+ private:
+  CPUCommContext() = default;
+
+  int GetListenSocket(int port);
+
+  mutable std::mutex mutex_;
+  std::map<int, std::unique_ptr<CPUComm>> comm_map_;
+  // The listening sockets are kept for the other rings created later.
+  std::map<int, int> listen_fds_;
+  // The connections accepted for the rings not created yet, ring id ->
+  // rank -> socket.
+  std::map<int, std::map<int, int>> pending_fds_;
+
+  DISABLE_COPY_AND_ASSIGN(CPUCommContext);
+};
+
+}  // namespace platform
+}  // namespace paddle
+
+#endif
@@ -0,0 +1,238 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/cpu_collective.h"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace platform {
+
+using framework::proto::VarType;
+
+// The free ports of the loopback, the sockets are closed before the ranks
+// listen on them.
+static std::vector<std::string> LocalEndpoints(int nranks) {
+  std::vector<int> fds;
+  std::vector<std::string> endpoints;
+  for (int i = 0; i < nranks; ++i) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    PADDLE_ENFORCE_EQ(
+        bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+    endpoints.emplace_back("127.0.0.1:" + std::to_string(ntohs(addr.sin_port)));
+    fds.push_back(fd);
+  }
+  for (int fd : fds) close(fd);
+  return endpoints;
+}
+
+// Runs fn in nranks processes connected by a communicator. fn throws if the
+// result is wrong.
+static void RunRanks(int nranks, bool use_shm,
+                     const std::function<void(CPUComm *)> &fn) {
+  auto endpoints = LocalEndpoints(nranks);
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < nranks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      int code = 0;
+      try {
+        CPUCommOptions options;
+        options.use_shm = use_shm;
+        options.shm_buffer_bytes = 64 * 1024;
+        options.timeout_ms = 60000;
+        auto *comm = CPUCommContext::Instance().CreateComm(endpoints, rank, 0,
+                                                           options);
+        PADDLE_ENFORCE_EQ(comm->shm_peer_num(), use_shm ? nranks - 1 : 0);
+        fn(comm);
+      } catch (std::exception &e) {
+        std::fprintf(stderr, "rank %d: %s\n", rank, e.what());
+        code = 1;
+      }
+      std::fflush(stderr);
+      _exit(code);
+    }
+    pids.push_back(pid);
+  }
+  for (int rank = 0; rank < nranks; ++rank) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pids[rank], &status, 0), pids[rank]);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        << "rank " << rank << " of " << nranks << " failed";
+  }
+}
+
+template <typename T>
+static T Value(int rank, int64_t i) {
+  return static_cast<T>(rank + 1 + i % 5);
+}
+
+template <typename T>
+static void CheckAllReduce(CPUComm *comm, VarType::Type dtype,
+                           CPUReduceType type, int64_t count, bool in_place) {
+  int nranks = comm->nranks();
+  std::vector<T> send(count), recv(count);
+  for (int64_t i = 0; i < count; ++i) send[i] = Value<T>(comm->rank(), i);
+  T *out = in_place ? send.data() : recv.data();
+  comm->AllReduce(send.data(), out, count, dtype, type);
+  for (int64_t i = 0; i < count; ++i) {
+    float expected = Value<float>(0, i);
+    for (int r = 1; r < nranks; ++r) {
+      float v = Value<float>(r, i);
+      switch (type) {
+        case CPUReduceType::kSum:
+          expected += v;
+          break;
+        case CPUReduceType::kMax:
+          expected = std::max(expected, v);
+          break;
+        case CPUReduceType::kMin:
+          expected = std::min(expected, v);
+          break;
+        case CPUReduceType::kProd:
+          expected *= v;
+          break;
+      }
+    }
+    PADDLE_ENFORCE_EQ(static_cast<float>(out[i]), expected,
+                      "allreduce of %d elements, element %d", count, i);
+  }
+}
+
+static void CheckCollectives(CPUComm *comm) {
+  int nranks = comm->nranks();
+  int rank = comm->rank();
+  // the tree and the ring, count < nranks and the uneven blocks
+  for (int64_t count : {1, 3, 1000, 100000, 300007}) {
+    CheckAllReduce<float>(comm, VarType::FP32, CPUReduceType::kSum, count,
+                          false);
+  }
+  CheckAllReduce<float>(comm, VarType::FP32, CPUReduceType::kSum, 70000, true);
+  CheckAllReduce<double>(comm, VarType::FP64, CPUReduceType::kMax, 50000,
+                         false);
+  CheckAllReduce<int>(comm, VarType::INT32, CPUReduceType::kMin, 50000, false);
+  CheckAllReduce<int64_t>(comm, VarType::INT64, CPUReduceType::kProd, 100,
+                          false);
+  CheckAllReduce<float16>(comm, VarType::FP16, CPUReduceType::kSum, 40000,
+                          true);
+
+  for (int root = 0; root < nranks; ++root) {
+    std::vector<int> data(100000, rank == root ? root + 7 : -1);
+    comm->Broadcast(data.data(), data.size() * sizeof(int), root);
+    for (int v : data) PADDLE_ENFORCE_EQ(v, root + 7, "broadcast");
+  }
+
+  for (int64_t count : {1, 20000}) {
+    std::vector<int64_t> send(count, rank), recv(count * nranks, -1);
+    comm->AllGather(send.data(), recv.data(), count * sizeof(int64_t));
+    for (int64_t i = 0; i < count * nranks; ++i) {
+      PADDLE_ENFORCE_EQ(recv[i], i / count, "allgather");
+    }
+  }
+
+  int64_t recv_count = 30000;
+  std::vector<float> send(recv_count * nranks), recv(recv_count);
+  for (size_t i = 0; i < send.size(); ++i) send[i] = Value<float>(rank, i);
+  comm->ReduceScatter(send.data(), recv.data(), recv_count, VarType::FP32,
+                      CPUReduceType::kSum);
+  for (int64_t i = 0; i < recv_count; ++i) {
+    int64_t j = rank * recv_count + i;
+    float expected = 0;
+    for (int r = 0; r < nranks; ++r) expected += Value<float>(r, j);
+    PADDLE_ENFORCE_EQ(recv[i], expected, "reducescatter");
+  }
+
+  comm->Barrier();
+}
+
+TEST(CPUComm, single_rank) {
+  RunRanks(1, true, CheckCollectives);
+}
+
+TEST(CPUComm, shm) {
+  for (int nranks : {2, 3, 4, 5}) {
+    RunRanks(nranks, true, CheckCollectives);
+  }
+}
+
+TEST(CPUComm, tcp) {
+  for (int nranks : {2, 3, 4, 5}) {
+    RunRanks(nranks, false, CheckCollectives);
+  }
+}
+
+TEST(CPUComm, invalid_endpoint) {
+  auto &ctx = CPUCommContext::Instance();
+  EXPECT_THROW(ctx.CreateComm({"127.0.0.1", "127.0.0.1:6170"}, 0, 0),
+               EnforceNotMet);
+  EXPECT_THROW(ctx.CreateComm({"127.0.0.1:61a", "127.0.0.1:6170"}, 0, 0),
+               EnforceNotMet);
+  EXPECT_THROW(ctx.CreateComm({"127.0.0.1:70000", "127.0.0.1:6170"}, 0, 0),
+               EnforceNotMet);
+}
+
+TEST(CPUComm, multiple_rings) {
+  auto endpoints = LocalEndpoints(3);
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < 3; ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      int code = 0;
+      try {
+        // the rings share the listening ports
+        auto &ctx = CPUCommContext::Instance();
+        for (int ring_id : {0, 1}) ctx.CreateComm(endpoints, rank, ring_id);
+        for (int ring_id : {0, 1}) {
+          auto *comm = ctx.Get(ring_id);
+          PADDLE_ENFORCE_EQ(comm->ring_id(), ring_id);
+          int value = rank + ring_id * 10, sum = 0;
+          comm->AllReduce(&value, &sum, 1, VarType::INT32,
+                          CPUReduceType::kSum);
+          PADDLE_ENFORCE_EQ(sum, 3 + ring_id * 30);
+        }
+      } catch (std::exception &e) {
+        std::fprintf(stderr, "rank %d: %s\n", rank, e.what());
+        code = 1;
+      }
+      std::fflush(stderr);
+      _exit(code);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -29,7 +29,15 @@ limitations under the License. */
 #include <unistd.h>
 #endif  // _WIN32
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
 #include "gflags/gflags.h"
 
 DECLARE_double(fraction_of_cpu_memory_to_use);
@@ -144,5 +152,70 @@ bool MayIUse(const cpu_isa_t cpu_isa) {
 }
 #endif
 
+// Parses the cpu list format of sysfs, like "0-11,24-35".
+static std::vector<int> ParseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty()) continue;
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last =
+        dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::vector<std::vector<int>> NumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  // The node ids may have holes, e.g. on hotplug systems, the missing nodes
+  // are left empty so that the index is the node id.
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string online_list;
+  if (online && std::getline(online, online_list)) {
+    for (int node : ParseCpuList(online_list)) {
+      std::ifstream fin("/sys/devices/system/node/node" +
+                        std::to_string(node) + "/cpulist");
+      std::string list;
+      if (!fin || !std::getline(fin, list)) continue;
+      if (node >= static_cast<int>(nodes.size())) nodes.resize(node + 1);
+      nodes[node] = ParseCpuList(list);
+    }
+  }
+#endif
+  bool has_cpus = std::any_of(
+      nodes.begin(), nodes.end(),
+      [](const std::vector<int> &cpus) { return !cpus.empty(); });
+  if (!has_cpus) {
+    int cpu_num = std::max(1U, std::thread::hardware_concurrency());
+    nodes.assign(1, std::vector<int>());
+    for (int cpu = 0; cpu < cpu_num; ++cpu) nodes[0].push_back(cpu);
+  }
+  return nodes;
+}
+
+bool BindCurrentThreadToCpus(const std::vector<int> &cpus) {
+#ifdef __linux__
+  // Only the CPUs the thread may already run on, to respect the taskset or
+  // the cpuset of a container.
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return false;
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+      CPU_SET(cpu, &mask);
+    }
+  }
+  if (CPU_COUNT(&mask) == 0) return false;
+  return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+  return false;
+#endif
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <stddef.h>
+#include <vector>
 
 #ifdef _WIN32
 #if defined(__AVX2__)
@@ -74,5 +75,16 @@ typedef enum {
 // May I use some instruction
 bool MayIUse(const cpu_isa_t cpu_isa);
 
+//! Get the CPUs of every NUMA node, indexed by the node id. The nodes without
+//! CPUs, like the memory-only nodes, and the missing node ids are empty. It
+//! is a single node of all the CPUs when the topology is unknown, like on the
+//! systems other than Linux.
+std::vector<std::vector<int>> NumaNodeCpus();
+
+//! Bind the calling thread to the CPUs it is allowed to run on among the
+//! given ones, the threads it creates later inherit the binding. Returns false
+//! if it fails or none of the CPUs is allowed, the binding is kept then.
+bool BindCurrentThreadToCpus(const std::vector<int> &cpus);
+
 }  // namespace platform
 }  // namespace paddle
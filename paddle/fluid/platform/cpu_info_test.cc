@@ -13,8 +13,13 @@
 // limitations under the License.
 #include "paddle/fluid/platform/cpu_info.h"
 
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 #include <ostream>
 #include <sstream>
+#include <thread>  // NOLINT
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
@@ -32,3 +37,45 @@ TEST(CpuMemoryUsage, Print) {
                                        use_percent, memory_size)
             << std::endl;
 }
+
+TEST(CpuInfo, NumaNodeCpus) {
+  auto nodes = paddle::platform::NumaNodeCpus();
+  ASSERT_GE(nodes.size(), 1UL);
+  size_t cpu_num = 0;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    cpu_num += nodes[i].size();
+    LOG(INFO) << "NUMA node " << i << ": " << nodes[i].size() << " CPUs";
+  }
+  ASSERT_GE(cpu_num, 1UL);
+}
+
+#ifdef __linux__
+TEST(CpuInfo, BindCurrentThreadToCpus) {
+  std::thread thread([] {
+    cpu_set_t allowed;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+    int first = 0;
+    while (!CPU_ISSET(first, &allowed)) ++first;
+    // limited to one CPU like by a taskset
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(first, &one);
+    ASSERT_EQ(sched_setaffinity(0, sizeof(one), &one), 0);
+
+    std::vector<int> all;
+    for (auto &node : paddle::platform::NumaNodeCpus()) {
+      all.insert(all.end(), node.begin(), node.end());
+    }
+    EXPECT_TRUE(paddle::platform::BindCurrentThreadToCpus(all));
+    cpu_set_t bound;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(bound), &bound), 0);
+    EXPECT_TRUE(CPU_EQUAL(&bound, &one));
+
+    // none of the CPUs is allowed
+    EXPECT_FALSE(paddle::platform::BindCurrentThreadToCpus({first + 1}));
+    ASSERT_EQ(sched_getaffinity(0, sizeof(bound), &bound), 0);
+    EXPECT_TRUE(CPU_EQUAL(&bound, &one));
+  });
+  thread.join();
+}
+#endif
@@ -301,7 +301,8 @@ DEFINE_double(memory_fraction_of_eager_deletion, 1.0,
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
  * Since Version: 1.2
- * Value Range: string, {naive_best_fit, auto_groth}, default=naive_best_fit
+ * Value Range: string, {naive_best_fit, auto_growth, thread_caching},
+ *              default=naive_best_fit
  * Example:
  * Note: Allocator policy for selecting Paddle Paddle.
  *       The allocator strategy is under development and the non-legacy
@@ -311,7 +312,9 @@ DEFINE_string(allocator_strategy, "naive_best_fit",
               "The allocation strategy. naive_best_fit means the original best "
               "fit allocator of Fluid. "
               "auto_growth means the experimental auto-growth allocator. "
-              "Enum in [naive_best_fit, auto_growth].");
+              "thread_caching means the auto-growth allocator with "
+              "per-thread caches of small blocks on CPU. "
+              "Enum in [naive_best_fit, auto_growth, thread_caching].");
 
 /**
  * Memory related FLAG
@@ -31,12 +31,14 @@ limitations under the License. */
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/place.h"
+#include "paddle/fluid/platform/trace_profiler.h"
 #include "paddle/fluid/string/piece.h"
 #if defined(PADDLE_WITH_DGC)
 #include "dgc/dgc.h"
 #endif
 
 DECLARE_int32(paddle_num_threads);
+DECLARE_bool(enable_trace_profiler);
 DEFINE_int32(multiple_of_cupti_buffer_size, 1,
              "Multiple of the CUPTI device buffer size. If the timestamps have "
              "been dropped when you are profiling, try increasing this value.");
@@ -158,6 +160,10 @@ void InitDevices(bool init_p2p, const std::vector<int> devices) {
   platform::SetNumThreads(FLAGS_paddle_num_threads);
 #endif
 
+  if (FLAGS_enable_trace_profiler && !platform::IsTraceProfilerEnabled()) {
+    platform::EnableTraceProfiler(platform::TraceProfilerConfig::FromFlags());
+  }
+
 #if !defined(_WIN32) && !defined(__APPLE__) && !defined(__OSX__)
   if (platform::MayIUse(platform::avx)) {
 #ifndef __AVX__
@@ -0,0 +1,445 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/trace_profiler.h"
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <cmath>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/string/printf.h"
+
+DEFINE_bool(enable_trace_profiler, false,
+            "Enable the trace profiler when the devices are initialized.");
+DEFINE_int32(trace_profiler_buffer_size, 1 << 16,
+             "The number of the events of the ring buffer of the trace "
+             "profiler of every thread.");
+DEFINE_int32(trace_profiler_sample_period, 1,
+             "The trace profiler records one of every "
+             "trace_profiler_sample_period events of a thread.");
+DEFINE_string(trace_profiler_dump_path, "",
+              "If not empty, the trace profiler writes the events to "
+              "<trace_profiler_dump_path>.<n>.json periodically.");
+DEFINE_int32(trace_profiler_dump_interval_ms, 60000,
+             "The interval of the dumping of the trace profiler.");
+
+namespace paddle {
+namespace platform {
+
+namespace internal {
+std::atomic<bool> g_trace_profiler_enabled{false};
+}  // namespace internal
+
+TraceProfilerConfig TraceProfilerConfig::FromFlags() {
+  TraceProfilerConfig config;
+  config.buffer_size = static_cast<size_t>(FLAGS_trace_profiler_buffer_size);
+  config.sample_period = FLAGS_trace_profiler_sample_period;
+  config.dump_path = FLAGS_trace_profiler_dump_path;
+  config.dump_interval_ms = FLAGS_trace_profiler_dump_interval_ms;
+  return config;
+}
+
+static inline uint64_t TraceNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+class TraceNameRegistry {
+ public:
+  static TraceNameRegistry &Instance() {
+    static TraceNameRegistry registry;
+    return registry;
+  }
+
+  uint32_t Intern(const std::string &name) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto iter = ids_.find(name);
+    if (iter != ids_.end()) {
+      return iter->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(name);
+    ids_.emplace(name, id);
+    return id;
+  }
+
+  std::string Name(uint32_t id) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    PADDLE_ENFORCE_LT(id, names_.size(), "Unknown trace name id %d.", id);
+    return names_[id];
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::deque<std::string> names_;
+};
+
+// The ring buffer of the events of one thread. Push is only called by the
+// owner thread and Collect only by the snapshot (under the registry mutex).
+//
+// The slots are overwritten without locks like a seqlock: the owner thread
+// writes the event of the index head into the slot head % slot_num and then
+// publishes head + 1. Collect copies the last slot_num - 1 events, skipping the
+// slot being written, and reads head again, the events whose indices are not
+// greater than head - slot_num may have been overwritten during the copy and
+// are dropped.
+class TraceRingBuffer {
+ public:
+  TraceRingBuffer(size_t capacity, uint32_t thread_id, uint64_t generation)
+      : thread_id_(thread_id), generation_(generation) {
+    size_t size = 2;
+    while (size < capacity + 1) {
+      size <<= 1;
+    }
+    mask_ = size - 1;
+    slots_.reset(new Slot[size]);
+  }
+
+  uint64_t generation() const { return generation_; }
+
+  void Push(uint32_t name_id, uint64_t start_ns, uint64_t end_ns) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    // orders the publishing of head before the writing of the slot
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot &slot = slots_[head & mask_];
+    slot.name_id.store(name_id, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  void Collect(std::vector<TraceEvent> *events, uint64_t *dropped) {
+    uint64_t capacity = mask_;
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t begin = std::max(cursor_, head > capacity ? head - capacity : 0);
+    size_t offset = events->size();
+    for (uint64_t i = begin; i < head; ++i) {
+      const Slot &slot = slots_[i & mask_];
+      events->push_back({static_cast<uint32_t>(
+                             slot.name_id.load(std::memory_order_relaxed)),
+                         thread_id_,
+                         slot.start_ns.load(std::memory_order_relaxed),
+                         slot.end_ns.load(std::memory_order_relaxed)});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t head_after = head_.load(std::memory_order_relaxed);
+    uint64_t valid_begin = begin;
+    if (head_after > capacity && head_after - capacity > begin) {
+      valid_begin = std::min(head, head_after - capacity);
+      events->erase(events->begin() + offset,
+                    events->begin() + offset + (valid_begin - begin));
+    }
+    *dropped += valid_begin - cursor_;
+    cursor_ = head;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> name_id{0};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  uint64_t mask_;
+  std::atomic<uint64_t> head_{0};
+  // the index of the first event not collected yet
+  uint64_t cursor_{0};
+  uint32_t thread_id_;
+  uint64_t generation_;
+};
+
+static std::mutex g_trace_mutex;
+// The ring buffers of the threads of the current session, guarded by
+// g_trace_mutex.
+static std::list<std::shared_ptr<TraceRingBuffer>> g_trace_buffers;
+static TraceProfilerConfig g_trace_config;
+static uint32_t g_next_trace_thread_id = 0;
+static std::atomic<uint64_t> g_trace_generation{0};
+static std::atomic<int> g_trace_sample_period{1};
+
+// The ring buffer of the thread is owned by g_trace_buffer, the raw pointer
+// avoids the initialization check of the non-trivial thread_local on the hot
+// path.
+static thread_local std::shared_ptr<TraceRingBuffer> g_trace_buffer;
+static thread_local TraceRingBuffer *g_trace_buffer_ptr = nullptr;
+static thread_local uint64_t g_trace_event_count = 0;
+
+static TraceRingBuffer *GetTraceRingBuffer() {
+  uint64_t generation = g_trace_generation.load(std::memory_order_acquire);
+  if (UNLIKELY(g_trace_buffer_ptr == nullptr ||
+               g_trace_buffer_ptr->generation() != generation)) {
+    std::lock_guard<std::mutex> guard(g_trace_mutex);
+    g_trace_buffer = std::make_shared<TraceRingBuffer>(
+        g_trace_config.buffer_size, g_next_trace_thread_id++,
+        g_trace_generation.load(std::memory_order_relaxed));
+    g_trace_buffers.emplace_back(g_trace_buffer);
+    g_trace_buffer_ptr = g_trace_buffer.get();
+  }
+  return g_trace_buffer_ptr;
+}
+
+void RecordTraceEvent::Begin() {
+  int period = g_trace_sample_period.load(std::memory_order_relaxed);
+  if (period > 1 && (g_trace_event_count++ % period) != 0) {
+    return;
+  }
+  start_ns_ = TraceNowNs();
+}
+
+void RecordTraceEvent::End() {
+  GetTraceRingBuffer()->Push(name_id_, start_ns_, TraceNowNs());
+}
+
+uint32_t InternTraceName(const std::string &name) {
+  return TraceNameRegistry::Instance().Intern(name);
+}
+
+std::string TraceName(uint32_t name_id) {
+  return TraceNameRegistry::Instance().Name(name_id);
+}
+
+static TraceSnapshot TakeTraceSnapshotLocked() {
+  TraceSnapshot snapshot;
+  for (auto iter = g_trace_buffers.begin(); iter != g_trace_buffers.end();) {
+    (*iter)->Collect(&snapshot.events, &snapshot.dropped);
+    // the owner thread has exited
+    if (iter->use_count() == 1) {
+      iter = g_trace_buffers.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  std::stable_sort(snapshot.events.begin(), snapshot.events.end(),
+                   [](const TraceEvent &a, const TraceEvent &b) {
+                     return a.thread_id < b.thread_id ||
+                            (a.thread_id == b.thread_id &&
+                             a.start_ns < b.start_ns);
+                   });
+  return snapshot;
+}
+
+TraceSnapshot TakeTraceSnapshot() {
+  std::lock_guard<std::mutex> guard(g_trace_mutex);
+  return TakeTraceSnapshotLocked();
+}
+
+// Writes the snapshots to the files periodically.
+class TraceDumper {
+ public:
+  TraceDumper(const std::string &path, int interval_ms)
+      : path_(path), interval_ms_(interval_ms) {
+    thread_ = std::thread([this] { Loop(); });
+  }
+
+  ~TraceDumper() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    Dump();
+  }
+
+ private:
+  void Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_),
+                         [this] { return stopped_; })) {
+      lock.unlock();
+      Dump();
+      lock.lock();
+    }
+  }
+
+  void Dump() {
+    auto snapshot = TakeTraceSnapshot();
+    auto path = string::Sprintf("%s.%d.json", path_, dump_count_++);
+    std::ofstream fout(path);
+    if (!fout) {
+      LOG(WARNING) << "Cannot open " << path << " to dump the trace events.";
+      return;
+    }
+    fout << TraceSnapshotToChromeJson(snapshot);
+    VLOG(3) << "Dump " << snapshot.events.size() << " trace events to "
+            << path << ", dropped " << snapshot.dropped;
+  }
+
+  std::string path_;
+  int interval_ms_;
+  int dump_count_{0};
+  bool stopped_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+
+static std::mutex g_trace_dumper_mutex;
+static std::unique_ptr<TraceDumper> g_trace_dumper;
+
+void EnableTraceProfiler(const TraceProfilerConfig &config) {
+  PADDLE_ENFORCE_GT(config.buffer_size, 0UL,
+                    "The buffer size of the trace profiler should be > 0.");
+  PADDLE_ENFORCE_GT(config.sample_period, 0,
+                    "The sample period of the trace profiler should be > 0.");
+  std::lock_guard<std::mutex> dumper_guard(g_trace_dumper_mutex);
+  g_trace_dumper.reset();
+  {
+    std::lock_guard<std::mutex> guard(g_trace_mutex);
+    g_trace_config = config;
+    g_trace_buffers.clear();
+    g_trace_sample_period.store(config.sample_period,
+                                std::memory_order_relaxed);
+    g_trace_generation.fetch_add(1, std::memory_order_release);
+  }
+  if (!config.dump_path.empty()) {
+    PADDLE_ENFORCE_GT(config.dump_interval_ms, 0,
+                      "The dump interval of the trace profiler should be > 0.");
+    g_trace_dumper.reset(
+        new TraceDumper(config.dump_path, config.dump_interval_ms));
+  }
+  internal::g_trace_profiler_enabled.store(true, std::memory_order_relaxed);
+}
+
+void DisableTraceProfiler() {
+  internal::g_trace_profiler_enabled.store(false, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> dumper_guard(g_trace_dumper_mutex);
+  g_trace_dumper.reset();
+}
+
+static void AppendJsonString(const std::string &s, std::ostringstream *os) {
+  *os << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      *os << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      *os << string::Sprintf("\\u%04x", static_cast<int>(c));
+    } else {
+      *os << c;
+    }
+  }
+  *os << '"';
+}
+
+std::string TraceSnapshotToChromeJson(const TraceSnapshot &snapshot) {
+  std::unordered_map<uint32_t, std::string> names;
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  os << "{\"traceEvents\":[";
+  for (size_t i = 0; i < snapshot.events.size(); ++i) {
+    auto &event = snapshot.events[i];
+    auto iter = names.find(event.name_id);
+    if (iter == names.end()) {
+      iter = names.emplace(event.name_id, TraceName(event.name_id)).first;
+    }
+    os << (i == 0 ? "" : ",") << "\n{\"name\":";
+    AppendJsonString(iter->second, &os);
+    os << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread_id
+       << ",\"ts\":" << event.start_ns / 1000.0
+       << ",\"dur\":" << (event.end_ns - event.start_ns) / 1000.0 << "}";
+  }
+  os << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":"
+     << snapshot.dropped << "}}\n";
+  return os.str();
+}
+
+static constexpr int kTraceHistogramSize = 64;
+
+uint64_t TraceEventStat::PercentileNs(double fraction) const {
+  if (calls == 0) return 0;
+  int64_t rank = static_cast<int64_t>(std::ceil(fraction * calls));
+  rank = std::max<int64_t>(rank, 1);
+  int64_t count = 0;
+  for (size_t k = 0; k < histogram.size(); ++k) {
+    count += histogram[k];
+    if (count >= rank) {
+      uint64_t upper = k + 1 < 64 ? (1ULL << (k + 1)) - 1 : max_ns;
+      return std::min(upper, max_ns);
+    }
+  }
+  return max_ns;
+}
+
+std::vector<TraceEventStat> AggregateTraceSnapshot(
+    const TraceSnapshot &snapshot) {
+  std::unordered_map<uint32_t, TraceEventStat> stats;
+  for (auto &event : snapshot.events) {
+    uint64_t duration = event.end_ns - event.start_ns;
+    auto &stat = stats[event.name_id];
+    if (stat.calls == 0) {
+      stat.histogram.resize(kTraceHistogramSize, 0);
+      stat.min_ns = duration;
+    }
+    ++stat.calls;
+    stat.total_ns += duration;
+    stat.min_ns = std::min(stat.min_ns, duration);
+    stat.max_ns = std::max(stat.max_ns, duration);
+    int bucket = 0;
+    while (bucket + 1 < kTraceHistogramSize && (duration >> (bucket + 1))) {
+      ++bucket;
+    }
+    ++stat.histogram[bucket];
+  }
+  std::vector<TraceEventStat> result;
+  result.reserve(stats.size());
+  for (auto &pair : stats) {
+    pair.second.name = TraceName(pair.first);
+    result.emplace_back(std::move(pair.second));
+  }
+  std::sort(result.begin(), result.end(),
+            [](const TraceEventStat &a, const TraceEventStat &b) {
+              return a.total_ns > b.total_ns ||
+                     (a.total_ns == b.total_ns && a.name < b.name);
+            });
+  return result;
+}
+
+std::string TraceEventStatsToString(const std::vector<TraceEventStat> &stats) {
+  size_t name_width = 5;
+  for (auto &stat : stats) {
+    name_width = std::max(name_width, stat.name.size());
+  }
+  name_width += 2;
+  std::ostringstream os;
+  os << std::left << std::setw(name_width) << "Event" << std::setw(10)
+     << "Calls" << std::setw(14) << "Total(ms)" << std::setw(12) << "Ave(us)"
+     << std::setw(12) << "Min(us)" << std::setw(12) << "Max(us)"
+     << std::setw(12) << "P50(us)" << std::setw(12) << "P99(us)"
+     << "\n";
+  os << std::fixed << std::setprecision(3);
+  for (auto &stat : stats) {
+    os << std::setw(name_width) << stat.name << std::setw(10) << stat.calls
+       << std::setw(14) << stat.total_ns / 1e6 << std::setw(12)
+       << stat.total_ns / 1e3 / stat.calls << std::setw(12)
+       << stat.min_ns / 1e3 << std::setw(12) << stat.max_ns / 1e3
+       << std::setw(12) << stat.PercentileNs(0.5) / 1e3 << std::setw(12)
+       << stat.PercentileNs(0.99) / 1e3 << "\n";
+  }
+  return os.str();
+}
+
+}  // namespace platform
+}  // namespace paddle
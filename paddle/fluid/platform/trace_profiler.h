@@ -0,0 +1,151 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace platform {
+
+// The trace profiler is a low overhead tracer that can be left on in the
+// production jobs, unlike the profiler in profiler.h which records every
+// event with its name and only reports when it is disabled.
+//
+// The names of the events are interned to ids once, e.g. when an operator is
+// created. Every thread records the complete events (name id, start, end) into
+// its own fixed size ring buffer without locks, the oldest events are
+// overwritten when the buffer is full. Only one of every `sample_period`
+// events of a thread is recorded. TakeTraceSnapshot collects the events
+// recorded since the last snapshot from all the threads while they are still
+// running, and the snapshot can be exported as the Chrome trace JSON or
+// aggregated into a histogram of the durations of every event name.
+//
+// Usage:
+//
+//   // once
+//   static uint32_t name_id = InternTraceName("my_event");
+//   {
+//     RecordTraceEvent trace_event(name_id);
+//     ...
+//   }
+
+struct TraceProfilerConfig {
+  // The ring buffer of every thread keeps at least the last buffer_size
+  // events.
+  size_t buffer_size{1 << 16};
+  // Record one of every sample_period events of a thread.
+  int sample_period{1};
+  // If not empty, a background thread writes a snapshot every
+  // dump_interval_ms to <dump_path>.<n>.json as the Chrome trace JSON.
+  std::string dump_path;
+  int dump_interval_ms{60000};
+
+  // The config set by FLAGS_trace_profiler_*.
+  static TraceProfilerConfig FromFlags();
+};
+
+// An event recorded by the trace profiler.
+struct TraceEvent {
+  uint32_t name_id;
+  uint32_t thread_id;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+struct TraceSnapshot {
+  // The events recorded since the last snapshot, ordered by thread and start.
+  std::vector<TraceEvent> events;
+  // The number of the events overwritten before being collected.
+  uint64_t dropped{0};
+};
+
+// The duration statistics of the events of one name.
+struct TraceEventStat {
+  std::string name;
+  int64_t calls{0};
+  uint64_t total_ns{0};
+  uint64_t min_ns{0};
+  uint64_t max_ns{0};
+  // histogram[k] counts the events whose duration is in [2^k, 2^(k+1)) ns,
+  // histogram[0] also counts the events shorter than 1 ns.
+  std::vector<int64_t> histogram;
+
+  // The upper bound of the duration of the given fraction (0, 1] of the
+  // events, estimated from the histogram.
+  uint64_t PercentileNs(double fraction) const;
+};
+
+// Returns the id of the name, the same name always gets the same id.
+uint32_t InternTraceName(const std::string &name);
+std::string TraceName(uint32_t name_id);
+
+namespace internal {
+extern std::atomic<bool> g_trace_profiler_enabled;
+}  // namespace internal
+
+inline bool IsTraceProfilerEnabled() {
+  return internal::g_trace_profiler_enabled.load(std::memory_order_relaxed);
+}
+
+// Enables the trace profiler, dropping the events of the former session.
+void EnableTraceProfiler(const TraceProfilerConfig &config);
+// Disables the trace profiler. The events recorded before are kept for the
+// next snapshot.
+void DisableTraceProfiler();
+
+// Collects the events recorded since the last snapshot. Note that the
+// background dumping of TraceProfilerConfig::dump_path also takes snapshots.
+TraceSnapshot TakeTraceSnapshot();
+
+std::string TraceSnapshotToChromeJson(const TraceSnapshot &snapshot);
+
+// The statistics of every event name, sorted by the total duration.
+std::vector<TraceEventStat> AggregateTraceSnapshot(
+    const TraceSnapshot &snapshot);
+
+std::string TraceEventStatsToString(const std::vector<TraceEventStat> &stats);
+
+class RecordTraceEvent {
+ public:
+  explicit RecordTraceEvent(uint32_t name_id) : name_id_(name_id) {
+    if (UNLIKELY(IsTraceProfilerEnabled())) {
+      Begin();
+    }
+  }
+
+  ~RecordTraceEvent() {
+    if (UNLIKELY(start_ns_ != 0)) {
+      End();
+    }
+  }
+
+ private:
+  void Begin();
+  void End();
+
+  uint32_t name_id_;
+  // 0 if the event is not recorded
+  uint64_t start_ns_{0};
+
+  DISABLE_COPY_AND_ASSIGN(RecordTraceEvent);
+};
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,164 @@
+/* Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/trace_profiler.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace platform {
+
+static TraceProfilerConfig SmallConfig() {
+  TraceProfilerConfig config;
+  config.buffer_size = 64;
+  return config;
+}
+
+TEST(TraceProfiler, intern_name) {
+  uint32_t a = InternTraceName("trace_a");
+  uint32_t b = InternTraceName("trace_b");
+  ASSERT_NE(a, b);
+  ASSERT_EQ(InternTraceName("trace_a"), a);
+  ASSERT_EQ(TraceName(a), "trace_a");
+  ASSERT_EQ(TraceName(b), "trace_b");
+}
+
+TEST(TraceProfiler, record_and_snapshot) {
+  uint32_t outer = InternTraceName("outer");
+  uint32_t inner = InternTraceName("inner \"quoted\"");
+  { RecordTraceEvent disabled(outer); }
+
+  EnableTraceProfiler(SmallConfig());
+  ASSERT_TRUE(IsTraceProfilerEnabled());
+  for (int i = 0; i < 3; ++i) {
+    RecordTraceEvent outer_event(outer);
+    RecordTraceEvent inner_event(inner);
+  }
+  auto snapshot = TakeTraceSnapshot();
+  ASSERT_EQ(snapshot.events.size(), 6UL);
+  ASSERT_EQ(snapshot.dropped, 0UL);
+  for (size_t i = 1; i < snapshot.events.size(); ++i) {
+    ASSERT_LE(snapshot.events[i - 1].start_ns, snapshot.events[i].start_ns);
+  }
+  // the events are only collected once
+  ASSERT_TRUE(TakeTraceSnapshot().events.empty());
+
+  auto stats = AggregateTraceSnapshot(snapshot);
+  ASSERT_EQ(stats.size(), 2UL);
+  for (auto &stat : stats) {
+    ASSERT_EQ(stat.calls, 3);
+    ASSERT_LE(stat.min_ns, stat.max_ns);
+    ASSERT_GE(stat.total_ns, stat.max_ns);
+    ASSERT_LE(stat.PercentileNs(0.5), stat.max_ns);
+    ASSERT_EQ(stat.PercentileNs(1.0), stat.max_ns);
+  }
+  ASSERT_NE(TraceEventStatsToString(stats).find("outer"), std::string::npos);
+
+  auto json = TraceSnapshotToChromeJson(snapshot);
+  ASSERT_NE(json.find("\"traceEvents\""), std::string::npos);
+  ASSERT_NE(json.find("\"name\":\"inner \\\"quoted\\\"\""), std::string::npos);
+
+  DisableTraceProfiler();
+  ASSERT_FALSE(IsTraceProfilerEnabled());
+  { RecordTraceEvent disabled(outer); }
+  ASSERT_TRUE(TakeTraceSnapshot().events.empty());
+}
+
+TEST(TraceProfiler, sample_and_overwrite) {
+  uint32_t name = InternTraceName("sampled");
+  auto config = SmallConfig();
+  config.sample_period = 4;
+  EnableTraceProfiler(config);
+  for (int i = 0; i < 64; ++i) {
+    RecordTraceEvent event(name);
+  }
+  ASSERT_EQ(TakeTraceSnapshot().events.size(), 16UL);
+
+  // the ring buffer keeps at least the last 64 events
+  EnableTraceProfiler(SmallConfig());
+  for (int i = 0; i < 1000; ++i) {
+    RecordTraceEvent event(name);
+  }
+  auto snapshot = TakeTraceSnapshot();
+  ASSERT_GE(snapshot.events.size(), 64UL);
+  ASSERT_LT(snapshot.events.size(), 1000UL);
+  ASSERT_EQ(snapshot.events.size() + snapshot.dropped, 1000UL);
+  DisableTraceProfiler();
+}
+
+TEST(TraceProfiler, multi_thread) {
+  uint32_t name = InternTraceName("multi_thread");
+  auto config = SmallConfig();
+  config.buffer_size = 1 << 10;
+  EnableTraceProfiler(config);
+  const int thread_num = 4;
+  const int event_num = 20000;
+  std::atomic<int> finished{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < event_num; ++i) {
+        RecordTraceEvent event(name);
+      }
+      ++finished;
+    });
+  }
+  // snapshot while the threads are recording
+  uint64_t collected = 0, dropped = 0;
+  while (finished < thread_num) {
+    auto snapshot = TakeTraceSnapshot();
+    for (auto &event : snapshot.events) {
+      ASSERT_EQ(event.name_id, name);
+      ASSERT_LE(event.start_ns, event.end_ns);
+    }
+    collected += snapshot.events.size();
+    dropped += snapshot.dropped;
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto snapshot = TakeTraceSnapshot();
+  collected += snapshot.events.size();
+  dropped += snapshot.dropped;
+  ASSERT_EQ(collected + dropped,
+            static_cast<uint64_t>(thread_num) * event_num);
+  DisableTraceProfiler();
+}
+
+TEST(TraceProfiler, dump) {
+  uint32_t name = InternTraceName("dumped");
+  std::string path = "trace_profiler_test_dump";
+  auto config = SmallConfig();
+  config.dump_path = path;
+  config.dump_interval_ms = 1000000;
+  EnableTraceProfiler(config);
+  { RecordTraceEvent event(name); }
+  // disabling writes the last snapshot
+  DisableTraceProfiler();
+  std::ifstream fin(path + ".0.json");
+  ASSERT_TRUE(fin.good());
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  ASSERT_NE(ss.str().find("\"name\":\"dumped\""), std::string::npos);
+  std::remove((path + ".0.json").c_str());
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -16,9 +16,13 @@ limitations under the License. */
 
 #include <Python.h>
 #include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
 
 #include "paddle/fluid/framework/program_desc.h"
 #include "pybind11/pybind11.h"
+#include "pybind11/stl.h"
 
 #include "paddle/fluid/operators/distributed/communicator.h"
 
@@ -41,7 +45,19 @@ void BindCommunicator(py::module* m) {
       }))
       .def("stop", &Communicator::Stop)
       .def("start", &Communicator::Start)
-      .def("is_running", &Communicator::IsRunning);
+      .def("is_running", &Communicator::IsRunning)
+      // {var_name: (merged_num, send_num, merge_us, send_us)}
+      .def("send_stats", [](const Communicator& self) {
+        std::unordered_map<std::string,
+                           std::tuple<int64_t, int64_t, double, double>>
+            stats;
+        for (auto& iter : self.GetSendStats()) {
+          auto& stat = iter.second;
+          stats[iter.first] = std::make_tuple(stat.merged_num, stat.send_num,
+                                              stat.merge_us, stat.send_us);
+        }
+        return stats;
+      });
 }
 
 }  // namespace pybind
@@ -51,6 +51,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/init.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
+#include "paddle/fluid/platform/trace_profiler.h"
 #include "paddle/fluid/pybind/box_helper_py.h"
 #include "paddle/fluid/pybind/const_value.h"
 #include "paddle/fluid/pybind/data_set_py.h"
@@ -1147,6 +1148,29 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_profiler", platform::DisableProfiler);
   m.def("is_profiler_enabled", platform::IsProfileEnabled);
   m.def("reset_profiler", platform::ResetProfiler);
+
+  m.def("enable_trace_profiler",
+        [](size_t buffer_size, int sample_period, const std::string &dump_path,
+           int dump_interval_ms) {
+          platform::TraceProfilerConfig config;
+          config.buffer_size = buffer_size;
+          config.sample_period = sample_period;
+          config.dump_path = dump_path;
+          config.dump_interval_ms = dump_interval_ms;
+          platform::EnableTraceProfiler(config);
+        },
+        py::arg("buffer_size") = 1 << 16, py::arg("sample_period") = 1,
+        py::arg("dump_path") = "", py::arg("dump_interval_ms") = 60000);
+  m.def("disable_trace_profiler", platform::DisableTraceProfiler);
+  m.def("is_trace_profiler_enabled", platform::IsTraceProfilerEnabled);
+  // Returns the events recorded since the last snapshot as the Chrome trace
+  // JSON and the statistics of every event name.
+  m.def("trace_profiler_snapshot", []() {
+    auto snapshot = platform::TakeTraceSnapshot();
+    return std::make_pair(platform::TraceSnapshotToChromeJson(snapshot),
+                          platform::TraceEventStatsToString(
+                              platform::AggregateTraceSnapshot(snapshot)));
+  });
   m.def("get_pass", [](const std::string &pass_type) {
     auto pass = framework::ir::PassRegistry::Instance().Get(pass_type);
     return std::shared_ptr<framework::ir::Pass>(std::move(pass));
@@ -1670,6 +1694,28 @@ All parameter, weight, gradient are variables in Paddle.
           "cache_runtime_context",
           [](const BuildStrategy &self) { return self.cache_runtime_context_; },
           [](BuildStrategy &self, bool b) { self.cache_runtime_context_ = b; })
+      .def_property(
+          "cache_shape_signature",
+          [](const BuildStrategy &self) { return self.cache_shape_signature_; },
+          [](BuildStrategy &self, bool b) {
+            PADDLE_ENFORCE_EQ(!self.IsFinalized(), true,
+                              "BuildStrategy is finlaized.");
+            self.cache_shape_signature_ = b;
+          },
+          R"DOC(The type is BOOL. If set True, the operators skip InferShape
+                and the data transform checks while the shapes, LoD, data
+                types and places of their inputs are the same as in the last
+                run, e.g. for the models with fixed input shapes. Only the
+                operators whose output shapes depend on the input shapes
+                alone are cached. Default False.
+
+                Examples:
+                    .. code-block:: python
+
+                        import paddle.fluid as fluid
+                        build_strategy = fluid.BuildStrategy()
+                        build_strategy.cache_shape_signature = True
+          )DOC")
       .def_property(
           "mkldnn_enabled_op_types",
           [](const BuildStrategy &self) {
@@ -160,7 +160,10 @@ def __bootstrap__():
         'reader_queue_speed_test_mode', 'print_sub_graph_dir',
         'pe_profile_fname', 'inner_op_parallelism', 'enable_parallel_graph',
         'fuse_parameter_groups_size', 'multiple_of_cupti_buffer_size',
-        'fuse_parameter_memory_size', 'tracer_profile_fname', 'dygraph_debug'
+        'fuse_parameter_memory_size', 'tracer_profile_fname', 'dygraph_debug',
+        'enable_trace_profiler', 'trace_profiler_buffer_size',
+        'trace_profiler_sample_period', 'trace_profiler_dump_path',
+        'trace_profiler_dump_interval_ms'
     ]
     if 'Darwin' not in sysstr:
         read_env_flags.append('use_pinned_memory')
@@ -193,6 +196,13 @@ def __bootstrap__():
         read_env_flags.append('communicator_fake_rpc')
         read_env_flags.append('communicator_send_wait_times')
         read_env_flags.append('communicator_merge_sparse_grad')
+        read_env_flags.append('communicator_merge_grad_on_arrival')
+        read_env_flags.append('communicator_send_bucket_size')
+        if os.name != 'nt':
+            read_env_flags += [
+                'cpu_comm_use_shm', 'cpu_comm_tree_threshold_bytes',
+                'cpu_comm_shm_buffer_bytes', 'cpu_comm_timeout_ms'
+            ]
         if core.is_compiled_with_brpc():
             read_env_flags.append('max_body_size')
             #set brpc max body size
@@ -91,6 +91,35 @@ class DatasetBase(object):
         """
         self.proto_desc.pipe_command = pipe_command
 
+    def set_parse_mode(self, parse_mode, parse_thread_num=0):
+        """
+        Set how the data files are parsed. "line" reads files line by line
+        through pipe_command, "mmap" maps local files into memory and parses
+        them with parse_thread_num threads per file. Files that are remote,
+        gzipped or need a pipe_command other than "cat" are always parsed
+        by "line".
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_parse_mode("mmap", 8)
+
+        Args:
+            parse_mode(str): "line" or "mmap", default is "line"
+            parse_thread_num(int): threads to parse one file in "mmap" mode,
+                                   0 means the number of cpu cores
+                                   divided by the thread num of the
+                                   dataset.
+
+        """
+        if parse_mode not in ("line", "mmap"):
+            raise ValueError("parse_mode should be line or mmap, but got %s" %
+                             parse_mode)
+        self.proto_desc.parse_mode = parse_mode
+        self.proto_desc.parse_thread_num = parse_thread_num
+
     def set_fea_eval(self, record_candidate_size, fea_eval=True):
         """
         set fea eval mode for slots shuffle to debug the importance level of
@@ -79,6 +79,24 @@ class Hogwild(DeviceWorker):
         Init.
         """
         super(Hogwild, self).__init__()
+        self._local_sgd_steps = 0
+        self._local_sgd_shared_vars = []
+        self._local_sgd_bind_numa = False
+
+    def _set_local_sgd(self, steps, shared_vars=None, bind_numa=False):
+        """
+        Set local SGD, every thread trains private copies of the dense
+        parameters, which are averaged every steps batches.
+
+        Args:
+            steps(int): the batches between two averagings, 0 disables it
+            shared_vars(list|None): the parameters trained by all the threads,
+                                    besides the sparse ones
+            bind_numa(bool): whether to bind the threads to the NUMA nodes
+        """
+        self._local_sgd_steps = steps
+        self._local_sgd_shared_vars = shared_vars or []
+        self._local_sgd_bind_numa = bind_numa
 
     def _gen_worker_desc(self, trainer_desc):
         """
@@ -91,6 +109,12 @@ class Hogwild(DeviceWorker):
         if self._infer:
             # just ignore feed op for inference model
             trainer_desc.hogwild_param.skip_ops.extend(["feed"])
+        elif self._local_sgd_steps > 0:
+            hogwild_param = trainer_desc.hogwild_param
+            hogwild_param.local_sgd_steps = self._local_sgd_steps
+            hogwild_param.local_sgd_shared_vars.extend(
+                self._local_sgd_shared_vars)
+            hogwild_param.local_sgd_bind_numa = self._local_sgd_bind_numa
 
 
 class DownpourSGD(DeviceWorker):
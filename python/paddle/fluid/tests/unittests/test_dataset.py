@@ -185,6 +185,55 @@ class TestDataset(unittest.TestCase):
         os.remove("./test_in_memory_dataset_run_a.txt")
         os.remove("./test_in_memory_dataset_run_b.txt")
 
+    def test_in_memory_dataset_run_mmap(self):
+        """
+        Testcase for InMemoryDataset which parses files by mmap.
+        """
+        with open("test_in_memory_dataset_run_mmap_a.txt", "w") as f:
+            data = "1 1 2 3 3 4 5 5 5 5 1 1\n"
+            data += "1 2 2 3 4 4 6 6 6 6 1 2\n"
+            data += "1 3 2 3 5 4 7 7 7 7 1 3\n"
+            f.write(data)
+        with open("test_in_memory_dataset_run_mmap_b.txt", "w") as f:
+            data = "1 4 2 3 3 4 5 5 5 5 1 4\n"
+            data += "1 5 2 3 4 4 6 6 6 6 1 5\n"
+            data += "1 6 2 3 5 4 7 7 7 7 1 6\n"
+            data += "1 7 2 3 6 4 8 8 8 8 1 7"
+            f.write(data)
+
+        slots = ["slot1", "slot2", "slot3", "slot4"]
+        slots_vars = []
+        for slot in slots:
+            var = fluid.layers.data(
+                name=slot, shape=[1], dtype="int64", lod_level=1)
+            slots_vars.append(var)
+
+        dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+        dataset.set_batch_size(32)
+        dataset.set_thread(2)
+        dataset.set_filelist([
+            "test_in_memory_dataset_run_mmap_a.txt",
+            "test_in_memory_dataset_run_mmap_b.txt"
+        ])
+        dataset.set_pipe_command("cat")
+        dataset.set_parse_mode("mmap", 2)
+        dataset.set_use_var(slots_vars)
+        dataset.load_into_memory()
+        self.assertEqual(dataset.get_memory_data_size(), 7)
+        dataset.local_shuffle()
+
+        exe = fluid.Executor(fluid.CPUPlace())
+        exe.run(fluid.default_startup_program())
+        try:
+            exe.train_from_dataset(fluid.default_main_program(), dataset)
+        except ImportError as e:
+            pass
+        except Exception as e:
+            self.assertTrue(False)
+
+        os.remove("./test_in_memory_dataset_run_mmap_a.txt")
+        os.remove("./test_in_memory_dataset_run_mmap_b.txt")
+
     def test_in_memory_dataset_run_2(self):
         """
         Testcase for InMemoryDataset from create to run.
@@ -688,6 +688,28 @@ class TestDistLookupTableSliceSize(TestDistLookupTableBase):
         self.assertEqual(row_size, calc_row_size)
 
 
+class TestDistShardedLookupTable(TestDistLookupTableBase):
+    def net_conf(self):
+        self.network_with_table(is_sparse=True, is_distributed=True)
+
+    def transpiler_test_impl(self):
+        config = fluid.DistributeTranspilerConfig()
+        config.sharded_sparse_table = True
+        config.sparse_table_admit_count = 2
+        config.sparse_table_max_rows = 100000
+        pserver1, _ = self.get_pserver(self.pserver1_ep, config)
+
+        lookup_op = pserver1.blocks[4].ops[0]
+        self.assertEqual(lookup_op.type, "lookup_sparse_table")
+        self.assertTrue(lookup_op.attr("use_sharded_table"))
+        self.assertEqual(lookup_op.attr("shard_num"), 64)
+        self.assertEqual(lookup_op.attr("admit_count"), 2)
+        self.assertEqual(lookup_op.attr("max_rows"), 100000)
+        # the new rows are initialized like the xavier initialized table
+        self.assertGreater(lookup_op.attr("max"), 0.0)
+        self.assertAlmostEqual(lookup_op.attr("min"), -lookup_op.attr("max"))
+
+
 class TestDistArgsInProgram(TestDistLookupTableBase):
     def net_conf(self):
         self.network_with_table(is_sparse=True, is_distributed=True)
@@ -811,6 +833,43 @@ class TestNCCL2Transpile(TranspilerTest):
             pass
 
 
+class TestCollectiveCPUTranspile(TranspilerTest):
+    def test_collective_cpu_transpile(self):
+        main = fluid.Program()
+        startup = fluid.Program()
+        with fluid.program_guard(main, startup):
+            self.net_conf()
+
+        config = fluid.DistributeTranspilerConfig()
+        config.mode = "collective"
+        config.collective_mode = "grad_allreduce"
+        config.collective_use_cpu = True
+        config.nccl_comm_num = 2
+        config.wait_port = False
+        t = fluid.DistributeTranspiler(config=config)
+        endpoints = ["127.0.0.1:6174", "127.0.0.1:6175"]
+        t.transpile(
+            1,
+            trainers=",".join(endpoints),
+            current_endpoint=endpoints[1],
+            startup_program=startup,
+            program=main)
+        op_types = [op.type for op in startup.global_block().ops]
+        self.assertNotIn("c_gen_nccl_id", op_types)
+        comm_init_ops = [
+            op for op in startup.global_block().ops
+            if op.type == "c_comm_init"
+        ]
+        self.assertEqual(len(comm_init_ops), 2)
+        for ring_id, op in enumerate(comm_init_ops):
+            self.assertEqual(op.input_arg_names, [])
+            self.assertEqual(op.attr("endpoints"), endpoints)
+            self.assertEqual(op.attr("rank"), 1)
+            self.assertEqual(op.attr("nranks"), 2)
+            self.assertEqual(op.attr("ring_id"), ring_id)
+        gc.collect()
+
+
 # test for remote prefetch
 class TestRemoteLookupTable(TestDistLookupTableBase):
     def net_conf(self):
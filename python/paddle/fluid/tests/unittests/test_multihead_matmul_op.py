@@ -0,0 +1,95 @@
+#   Copyright (c) 2019 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import unittest
+import numpy as np
+from op_test import OpTest
+
+
+def stable_softmax(x):
+    e = np.exp(x - np.max(x, axis=-1, keepdims=True))
+    return e / np.sum(e, axis=-1, keepdims=True)
+
+
+class TestMultiHeadMatMulOp(OpTest):
+    def setUp(self):
+        self.op_type = 'multihead_matmul'
+        self.batch_size = 2
+        self.seq_len = 16
+        self.head_number = 4
+        self.size_per_head = 8
+        self.alpha = 1.0 / np.sqrt(self.size_per_head)
+        self.set_conf()
+        hidden = self.head_number * self.size_per_head
+        shape = (self.batch_size, self.seq_len, hidden)
+        q = np.random.random(shape).astype("float32")
+        k = np.random.random(shape).astype("float32")
+        v = np.random.random(shape).astype("float32")
+        bias_q = np.random.random(hidden).astype("float32")
+        bias_k = np.random.random(hidden).astype("float32")
+        bias_v = np.random.random(hidden).astype("float32")
+        bias_qk = np.random.random(self.bias_qk_shape()).astype("float32")
+
+        def split_heads(x, bias):
+            x = (x + bias).reshape(self.batch_size, self.seq_len,
+                                   self.head_number, self.size_per_head)
+            return x.transpose(0, 2, 1, 3)
+
+        qk = np.matmul(
+            split_heads(q, bias_q) * self.alpha,
+            split_heads(k, bias_k).transpose(0, 1, 3, 2))
+        qkv = np.matmul(stable_softmax(qk + bias_qk), split_heads(v, bias_v))
+        out = qkv.transpose(0, 2, 1, 3).reshape(shape)
+
+        self.inputs = {
+            'Q': q,
+            'K': k,
+            'V': v,
+            'BiasQ': bias_q,
+            'BiasK': bias_k,
+            'BiasV': bias_v,
+            'BiasQK': bias_qk
+        }
+        self.outputs = {'Out': out}
+        self.attrs = {'alpha': self.alpha, 'head_number': self.head_number}
+
+    def set_conf(self):
+        pass
+
+    def bias_qk_shape(self):
+        return (self.batch_size, self.head_number, self.seq_len,
+                self.seq_len)
+
+    def test_check_output(self):
+        self.check_output(atol=1e-5)
+
+
+class TestMultiHeadMatMulOpBroadcastBias(TestMultiHeadMatMulOp):
+    def bias_qk_shape(self):
+        return (self.batch_size, 1, 1, self.seq_len)
+
+
+class TestMultiHeadMatMulOpOneHead(TestMultiHeadMatMulOp):
+    def set_conf(self):
+        self.batch_size = 3
+        self.seq_len = 7
+        self.head_number = 1
+        self.size_per_head = 24
+        self.alpha = 0.3
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -16,6 +16,7 @@ from __future__ import print_function
 
 import unittest
 import os
+import json
 import tempfile
 import numpy as np
 import paddle.fluid as fluid
@@ -125,6 +126,29 @@ class TestProfiler(unittest.TestCase):
         self.net_profiler('All')
         self.net_profiler('All', use_parallel_executor=True)
 
+    def test_trace_profiler(self):
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            x = fluid.layers.data(name='x', shape=[784], dtype='float32')
+            hidden = fluid.layers.fc(input=x, size=64, act='relu')
+            loss = fluid.layers.mean(hidden)
+        exe = fluid.Executor(fluid.CPUPlace())
+        exe.run(startup_program)
+        core.enable_trace_profiler(sample_period=1)
+        self.assertTrue(core.is_trace_profiler_enabled())
+        for _ in range(3):
+            exe.run(main_program,
+                    feed={'x': np.random.random((8, 784)).astype('float32')},
+                    fetch_list=[loss])
+        trace_json, stats = core.trace_profiler_snapshot()
+        core.disable_trace_profiler()
+        self.assertFalse(core.is_trace_profiler_enabled())
+        events = json.loads(trace_json)['traceEvents']
+        self.assertEqual(
+            len([event for event in events if event['name'] == 'mul']), 3)
+        self.assertIn('relu', stats)
+
 
 if __name__ == '__main__':
     unittest.main()
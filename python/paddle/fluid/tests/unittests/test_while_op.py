@@ -15,6 +15,7 @@
 from __future__ import print_function
 
 import unittest
+import paddle.fluid as fluid
 import paddle.fluid.layers as layers
 from paddle.fluid.executor import Executor
 import paddle.fluid.core as core
@@ -96,6 +97,39 @@ class TestWhileOp(unittest.TestCase):
                        fetch_list=[sum_result])
         self.assertAlmostEqual(numpy.sum(d), numpy.sum(outs[0]), delta=0.01)
 
+    def test_forward_is_test_with_program_cache(self):
+        # The cached while op reuses its operators and step scope between runs.
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            x = layers.data(
+                "x", shape=[10], append_batch_size=False, dtype='float32')
+            n = layers.data(
+                "n", shape=[1], append_batch_size=False, dtype='int64')
+            i = layers.zeros(shape=[1], dtype='int64')
+            acc = layers.zeros(shape=[10], dtype='float32')
+            cond = layers.less_than(x=i, y=n)
+            while_op = layers.While(cond=cond, is_test=True)
+            with while_op.block():
+                step = layers.scale(x, scale=2.0)
+                layers.sums(input=[acc, step], out=acc)
+                layers.increment(x=i, in_place=True)
+                layers.less_than(x=i, y=n, cond=cond)
+
+        exe = Executor(core.CPUPlace())
+        for steps in [3, 1, 5, 0]:
+            x_data = numpy.random.random(size=[10]).astype('float32')
+            outs = exe.run(main_program,
+                           feed={
+                               'x': x_data,
+                               'n': numpy.array([steps]).astype('int64')
+                           },
+                           fetch_list=[acc],
+                           use_program_cache=True)
+            self.assertTrue(
+                numpy.allclose(
+                    outs[0], 2.0 * steps * x_data, atol=1e-5))
+
 
 if __name__ == '__main__':
     unittest.main()
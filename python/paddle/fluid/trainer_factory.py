@@ -35,6 +35,11 @@ class TrainerFactory(object):
             device_worker_class = opt_info["device_worker"]
             trainer = globals()[trainer_class]()
             device_worker = globals()[device_worker_class]()
+            if "local_sgd_steps" in opt_info:
+                device_worker._set_local_sgd(
+                    opt_info["local_sgd_steps"],
+                    opt_info.get("local_sgd_shared_vars"),
+                    opt_info.get("local_sgd_bind_numa", False))
             if "fleet_desc" in opt_info:
                 device_worker._set_fleet_desc(opt_info["fleet_desc"])
                 trainer._set_fleet_desc(opt_info["fleet_desc"])
@@ -43,14 +43,27 @@ class Collective(object):
         self.current_endpoint = None
         self.nranks = None
         self.rank = None
+        self.use_cpu = False
         self.startup_program = None
         self.main_program = None
         op_maker = core.op_proto_and_checker_maker
         self.op_role_key = op_maker.kOpRoleAttrName()
         self.op_role_var_key = op_maker.kOpRoleVarAttrName()
 
-    def transpile(self, startup_program, main_program, rank, endpoints,
-                  current_endpoint, wait_port):
+    def transpile(self,
+                  startup_program,
+                  main_program,
+                  rank,
+                  endpoints,
+                  current_endpoint,
+                  wait_port,
+                  use_cpu=None):
+        # the CPU trainers connect by the endpoints instead of NCCL ids, by
+        # default if paddle is not compiled with CUDA
+        if use_cpu is None:
+            use_cpu = not core.is_compiled_with_cuda()
+        self.use_cpu = use_cpu
+
         # in case of '127.0.0.1:6700,127.0.0.1:6701,...'
         if isinstance(endpoints, str):
             endpoints = endpoints.split(',')
@@ -99,12 +112,27 @@ class Collective(object):
     def _init_communicator(self, program, current_endpoint, endpoints, rank,
                            ring_id, wait_port):
         nranks = len(endpoints)
+        block = program.global_block()
+        if self.use_cpu:
+            # c_comm_init connects the ranks and retries until they listen
+            block.append_op(
+                type='c_comm_init',
+                inputs={},
+                outputs={},
+                attrs={
+                    'nranks': nranks,
+                    'rank': rank,
+                    'ring_id': ring_id,
+                    'endpoints': endpoints,
+                    self.op_role_key: OpRole.Forward
+                })
+            return
+
         other_endpoints = endpoints[:]
         other_endpoints.remove(current_endpoint)
         if rank == 0 and wait_port:
             wait_server_ready(other_endpoints)
 
-        block = program.global_block()
         nccl_id_var = block.create_var(
             name=unique_name.generate('nccl_id'),
             persistable=True,
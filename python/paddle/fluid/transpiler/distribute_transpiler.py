@@ -176,6 +176,19 @@ class DistributeTranspilerConfig(object):
     # if mode is collective
     # supported modes: grad_allreduce, local_sgd
     collective_mode = None
+    # whether the collective trainers run on CPU, None means to run on CPU
+    # if paddle is not compiled with CUDA
+    collective_use_cpu = None
+
+    # keep the distributed lookup table of the pserver in a sharded table,
+    # which has a lock per shard and grows without reallocating the rows.
+    # A new id gets a row after it is looked up sparse_table_admit_count
+    # times, and the least recently used rows are evicted above
+    # sparse_table_max_rows rows (0 means unlimited).
+    sharded_sparse_table = False
+    sparse_table_shard_num = 64
+    sparse_table_admit_count = 0
+    sparse_table_max_rows = 0
 
     def __init__(self):
         pass
@@ -377,7 +390,8 @@ class DistributeTranspiler(object):
             rank=trainer_id,
             endpoints=endpoints,
             current_endpoint=current_endpoint,
-            wait_port=wait_port)
+            wait_port=wait_port,
+            use_cpu=self.config.collective_use_cpu)
 
     def _get_all_remote_sparse_update_op(self, main_program):
         sparse_update_ops = []
@@ -1682,15 +1696,33 @@ class DistributeTranspiler(object):
             inputs={'Ids': pserver_ids,
                     "W": table_var},
             outputs={"Out": pserver_out},
-            attrs={
-                "is_sparse": True,  # has no effect on lookup_table op
-                "is_distributed": True,
-                "padding_idx": -1
-            })
+            attrs=self._lookup_sparse_table_attrs())
         prefetch_var_name_to_block_id.append(trainer_ids.name + ":" + str(
             prefetch_block.idx))
         return prefetch_var_name_to_block_id
 
+    def _lookup_sparse_table_attrs(self):
+        attrs = {
+            "is_sparse": True,  # has no effect on lookup_table op
+            "is_distributed": True,
+            "padding_idx": -1
+        }
+        if not self.config.sharded_sparse_table:
+            return attrs
+        attrs["use_sharded_table"] = True
+        attrs["shard_num"] = self.config.sparse_table_shard_num
+        attrs["admit_count"] = self.config.sparse_table_admit_count
+        attrs["max_rows"] = self.config.sparse_table_max_rows
+        # the new rows are initialized like the rows of the startup program,
+        # or zeros if the table is not initialized by uniform_random
+        for op in self.origin_startup_program.global_block().ops:
+            if op.type == "uniform_random" and \
+                    self.table_name in op.output_arg_names:
+                attrs["min"] = op.attr("min")
+                attrs["max"] = op.attr("max")
+                attrs["seed"] = op.attr("seed")
+        return attrs
+
     def _create_table_optimize_block(self, pserver_index, pserver_program,
                                      pre_block_idx, grad_to_block_id):
         # STEP: create table optimize block